@@ -42,6 +42,9 @@
 /* mod_python implementation */
 #include <turbulence.h>
 
+/* TBC_ATOMIC_* (lock free read of profile path states) */
+#include <turbulence-ctx-private.h>
+
 /* include py-turbulence */
 #include <py_turbulence.h>
 
@@ -55,8 +58,56 @@ TurbulenceCtx * ctx = NULL;
 /* reference to the last configuration file loaded */
 axlDoc       * mod_python_conf = NULL;
 
-/* reference to the last site configuration file loaded */
-axlDoc       * mod_python_site_conf = NULL;
+/* signals if the system python.conf was already searched (so a
+ * missing python.conf is not searched again) */
+axl_bool       mod_python_conf_probed = axl_false;
+
+/* site configuration files (python.conf found at profile path
+ * work-dir) indexed by work-dir. Work dirs without python.conf are
+ * also recorded (with NULL value) to avoid checking them again */
+axlHash      * mod_python_site_confs = NULL;
+
+/** 
+ * @internal Per profile path state, to avoid loading configuration
+ * and initializing applications on each profile path selected.
+ */
+typedef struct _ModPythonPPathState {
+	/* configuration was loaded for this profile path */
+	axl_bool   loaded;
+	/* site python.conf used by this profile path (NULL if not
+	 * found). BORROWED from mod_python_site_confs */
+	axlDoc   * site_conf;
+	/* nothing is pending to be initialized for this profile path
+	 * whatever the serverName (read without lock, see
+	 * mod_python_ppath_selected) */
+	axl_bool   done;
+	/* nothing is pending for serverNames not declared by any
+	 * application and for serverNames found at done_names
+	 * (declared by some application). Only used with
+	 * mod_python_top_init acquired */
+	axl_bool   done_unbound;
+	axlHash  * done_names;
+} ModPythonPPathState;
+
+/** 
+ * @internal Profile path states indexed by profile path id.
+ */
+typedef struct _ModPythonPPaths {
+	/* number of items (ids from 1 to count - 1) */
+	int                   count;
+	ModPythonPPathState * items;
+} ModPythonPPaths;
+
+/* current profile path states. States are only modified with
+ * mod_python_top_init acquired but done flag is read without lock by
+ * mod_python_ppath_selected (a stale value just takes the locked
+ * path), which counts itself at mod_python_ppaths_readers while it
+ * uses them. Rebuilt on reconf (profile paths may have been added or
+ * removed): states replaced are kept at mod_python_ppaths_retired
+ * until no lock free reader is found */
+ModPythonPPaths     * mod_python_ppaths         = NULL;
+axlList             * mod_python_ppaths_retired = NULL;
+int                   mod_python_ppaths_readers = 0;
 
 /* mutex used to control application top level initialization */
 VortexMutex    mod_python_top_init;
@@ -231,6 +282,16 @@ axl_bool mod_python_init_app (TurbulenceCtx * ctx, PyObject * init_function, axl
  * configuration file. The function returns axl_true if the module can
  * continue signaling its proper start up.
  */
+/** 
+ * @internal Checks if the provided <application> applies to
+ * serverName: applications without serverName attribute apply to
+ * all of them, and all applications apply when serverName is NULL.
+ */
+axl_bool mod_python_app_applies (axlNode * node, const char * serverName)
+{
+	return ! (serverName && HAS_ATTR (node, "serverName") && ! HAS_ATTR_VALUE (node, "serverName", serverName));
+}
+
 axl_bool mod_python_init_applications (TurbulenceCtx     * ctx, 
 				       axlDoc            * python_conf,
 				       const char        * workDir, 
@@ -252,7 +313,7 @@ axl_bool mod_python_init_applications (TurbulenceCtx     * ctx,
 
 		/* check if node has serverName attribute and compare
 		   it with serverName defined (and only if defined) */
-		if (serverName && HAS_ATTR (node, "serverName") && ! HAS_ATTR_VALUE (node, "serverName", serverName)) {
+		if (! mod_python_app_applies (node, serverName)) {
 			msg ("  -> no match for serverName=%s (app serverName=%s)", serverName, ATTR_VALUE (node, "serverName"));
 			/* found serverName defined, but application spec states other serverName, skipping this application */
 			/* get next node */
@@ -400,6 +461,52 @@ void mod_python_too_long_notifier (const char * msg_string, axlPointer data)
 }
 
 /* mod_python init handler */
+/** 
+ * @internal Creates profile path states for the profile paths
+ * currently installed (ids start at 1).
+ */
+ModPythonPPaths * mod_python_ppaths_new (TurbulenceCtx * ctx)
+{
+	ModPythonPPaths * paths = axl_new (ModPythonPPaths, 1);
+
+	paths->count = 1;
+	while (turbulence_ppath_find_by_id (ctx, paths->count))
+		paths->count++;
+	paths->items = axl_new (ModPythonPPathState, paths->count);
+
+	return paths;
+}
+
+/** 
+ * @internal Releases profile path states.
+ */
+void mod_python_ppaths_free (axlPointer _paths)
+{
+	ModPythonPPaths * paths = _paths;
+	int               iterator;
+
+	if (paths == NULL)
+		return;
+	for (iterator = 0; iterator < paths->count; iterator++)
+		axl_hash_free (paths->items[iterator].done_names);
+	axl_free (paths->items);
+	axl_free (paths);
+	return;
+}
+
+/** 
+ * @internal Releases current and retired profile path states (called
+ * with mod_python_top_init acquired).
+ */
+void mod_python_ppaths_cleanup (void)
+{
+	mod_python_ppaths_free (mod_python_ppaths);
+	mod_python_ppaths = NULL;
+	axl_list_free (mod_python_ppaths_retired);
+	mod_python_ppaths_retired = NULL;
+	return;
+}
+
 static int  mod_python_init (TurbulenceCtx * _ctx) {
 	/* configure the module */
 	TBC_MOD_PREPARE (_ctx);
@@ -420,6 +527,12 @@ static int  mod_python_init (TurbulenceCtx * _ctx) {
 	vortex_mutex_create (&mod_python_top_init);
 	mod_python_py_init = axl_false;
 
+	/* init configuration caches: profile paths are already loaded
+	 * at this point (ids start at 1) */
+	mod_python_site_confs     = axl_hash_new (axl_hash_string, axl_hash_equal_string);
+	mod_python_ppaths         = mod_python_ppaths_new (ctx);
+	mod_python_ppaths_retired = axl_list_new (axl_list_always_return_1, mod_python_ppaths_free);
+
 	/* start handler watcher here */
 	py_vortex_ctx_start_handler_watcher (TBC_VORTEX_CTX (_ctx), 5, mod_python_too_long_notifier, _ctx);
 
@@ -467,37 +580,18 @@ void mod_python_close_module (axlNode * node, axlNode * location)
 	return;
 }
 
-/* mod_python close handler */
-static void mod_python_close (TurbulenceCtx * _ctx) {
+/** 
+ * @internal Notifies close to all applications started from the
+ * provided configuration.
+ */
+void mod_python_close_applications (axlDoc * python_conf)
+{
 	axlNode           * node;
 	axlNode           * location;
-	PyGILState_STATE    state;
-	VortexCtx         * vortex_ctx = turbulence_ctx_get_vortex_ctx (_ctx);
 	PyTurbulenceCtx   * py_tbc_ctx;
 
-	/* lock python top init mutex */
-	vortex_mutex_lock (&mod_python_top_init);
-
-	/* check if the module was initialized */
-	if (! mod_python_py_init) {
-		/* release mutex */
-		vortex_mutex_unlock (&mod_python_top_init);
-		return;
-	}
-
-	msg ("mod_python_close: starting module close..");
-
-	/* say we are closing */
-	mod_python_py_init = axl_false;
-
-	/* signal py-vortex to stop firing events into python */
-	vortex_ctx_set_data (vortex_ctx, "py:vo:ctx:de", INT_TO_PTR (axl_true));
-
-	/* acquire the GIL */
-	state = PyGILState_Ensure();
-
 	/* call to notify close on all apps */
-	node = axl_doc_get (mod_python_conf, "/mod-python/application");
+	node = axl_doc_get (python_conf, "/mod-python/application");
 	while (node) {
 		/* check for initialized applications */
 		if (! PTR_TO_INT (axl_node_annotate_get (node, "app-started", axl_false))) {
@@ -509,6 +603,7 @@ static void mod_python_close (TurbulenceCtx * _ctx) {
 		/* find location node */
 		location = axl_node_get_child_called (node, "location");
 		if (location == NULL) {
+			node = axl_node_get_next_called (node, "application");
 			continue;
 		} /* end if */
 
@@ -527,14 +622,67 @@ static void mod_python_close (TurbulenceCtx * _ctx) {
 		node = axl_node_get_next_called (node, "application");
 	} /* end while */
 
+	return;
+}
+
+/** 
+ * @internal axl_hash_foreach handler used to notify close to
+ * applications started from site configurations.
+ */
+axl_bool mod_python_close_site_applications (axlPointer key, axlPointer data, axlPointer user_data)
+{
+	if (data)
+		mod_python_close_applications ((axlDoc *) data);
+	return axl_false; /* do not stop foreach process */
+}
+
+/* mod_python close handler */
+static void mod_python_close (TurbulenceCtx * _ctx) {
+	PyGILState_STATE    state;
+	VortexCtx         * vortex_ctx = turbulence_ctx_get_vortex_ctx (_ctx);
+
+	/* lock python top init mutex */
+	vortex_mutex_lock (&mod_python_top_init);
+
+	/* check if the module was initialized */
+	if (! mod_python_py_init) {
+		/* release configuration caches */
+		axl_hash_free (mod_python_site_confs);
+		mod_python_site_confs = NULL;
+		axl_doc_free (mod_python_conf);
+		mod_python_conf = NULL;
+		mod_python_ppaths_cleanup ();
+
+		/* release mutex */
+		vortex_mutex_unlock (&mod_python_top_init);
+		return;
+	}
+
+	msg ("mod_python_close: starting module close..");
+
+	/* say we are closing */
+	mod_python_py_init = axl_false;
+
+	/* signal py-vortex to stop firing events into python */
+	vortex_ctx_set_data (vortex_ctx, "py:vo:ctx:de", INT_TO_PTR (axl_true));
+
+	/* acquire the GIL */
+	state = PyGILState_Ensure();
+
+	/* call to notify close on all apps */
+	mod_python_close_applications (mod_python_conf);
+	axl_hash_foreach (mod_python_site_confs, mod_python_close_site_applications, NULL);
+
 	msg ("mod_python_close: apps close notification finished..");
 
 	/* terminate configuration */
 	axl_doc_free (mod_python_conf);
 	mod_python_conf = NULL;
 
-	axl_doc_free (mod_python_site_conf);
-	mod_python_site_conf = NULL;
+	axl_hash_free (mod_python_site_confs);
+	mod_python_site_confs = NULL;
+
+	mod_python_ppaths_cleanup ();
  
 	/* unlock */
 	vortex_mutex_unlock (&mod_python_top_init);
@@ -552,9 +700,59 @@ static void mod_python_close (TurbulenceCtx * _ctx) {
 
 } /* end mod_python_close */
 
+/** 
+ * @internal axl_hash_foreach handler used by reconf to collect work
+ * dirs recorded without python.conf.
+ */
+axl_bool mod_python_collect_missing_site (axlPointer key, axlPointer data, axlPointer user_data)
+{
+	if (data == NULL)
+		axl_list_append ((axlList *) user_data, key);
+	return axl_false; /* do not stop foreach process */
+}
+
 /* mod_python reconf handler */
 static void mod_python_reconf (TurbulenceCtx * _ctx) {
-	/* received reconf signal */
+	axlList         * missing;
+	int               iterator;
+	ModPythonPPaths * previous;
+
+	/* received reconf signal: invalidate configuration cached so
+	 * python.conf files not found are searched again and profile
+	 * paths are checked again on next selection. Configurations
+	 * already loaded are kept because they hold references to
+	 * applications started */
+	vortex_mutex_lock (&mod_python_top_init);
+
+	if (mod_python_conf == NULL)
+		mod_python_conf_probed = axl_false;
+
+	if (mod_python_site_confs) {
+		missing = axl_list_new (axl_list_always_return_1, NULL);
+		axl_hash_foreach (mod_python_site_confs, mod_python_collect_missing_site, missing);
+		for (iterator = 0; iterator < axl_list_length (missing); iterator++)
+			axl_hash_remove (mod_python_site_confs, axl_list_get_nth (missing, iterator));
+		axl_list_free (missing);
+	} /* end if */
+
+	/* profile paths were installed again (ids may now refer to
+	 * other definitions or be added/removed): start from clean
+	 * states sized for the profile paths installed. States
+	 * replaced are released once no lock free reader is found
+	 * after publishing the new ones (a reader arriving later
+	 * only finds the new ones) */
+	if (mod_python_ppaths_retired) {
+		previous = mod_python_ppaths;
+		TBC_ATOMIC_STORE (mod_python_ppaths, mod_python_ppaths_new (_ctx));
+		axl_list_append (mod_python_ppaths_retired, previous);
+		TBC_ATOMIC_FENCE ();
+		if (TBC_ATOMIC_LOAD (mod_python_ppaths_readers) == 0) {
+			axl_list_free (mod_python_ppaths_retired);
+			mod_python_ppaths_retired = axl_list_new (axl_list_always_return_1, mod_python_ppaths_free);
+		} /* end if */
+	} /* end if */
+
+	vortex_mutex_unlock (&mod_python_top_init);
 	return;
 } /* end mod_python_reconf */
 
@@ -591,17 +789,25 @@ void mod_python_initialize (void)
 }
 
 /** 
- * @internal Check and load mod-python configuration (python.conf).
+ * @internal Check and load mod-python configuration (python.conf):
+ * system configuration is searched only once and site configuration
+ * (python.conf at the work dir) once for each work dir, recording
+ * also when it is not found. Must be called with mod_python_top_init
+ * acquired.
+ *
+ * @return Site configuration found for the provided work dir or NULL
+ * if it is not defined.
  */
-void mod_python_load_config (TurbulenceCtx    * ctx, 
-			     const char       * workDir, 
-			     const char       * serverName) 
+axlDoc * mod_python_load_config (TurbulenceCtx    * ctx, 
+				 const char       * workDir) 
 {
 	char     * config;
 	axlError * err = NULL;
+	axlDoc   * site_conf;
 
-	if (mod_python_conf == NULL) {
+	if (! mod_python_conf_probed) {
 		/* python.conf not loaded */
+		mod_python_conf_probed = axl_true;
 		vortex_support_add_domain_search_path_ref (TBC_VORTEX_CTX(ctx), axl_strdup ("python"), 
 							   vortex_support_build_filename (turbulence_sysconfdir (ctx), "turbulence", "python", NULL));
 
@@ -623,31 +829,123 @@ void mod_python_load_config (TurbulenceCtx    * ctx,
 		msg ("mod-python config already loaded..");
 	} /* end if */
 
-	/* check if site config was not loaded */
-	if (mod_python_site_conf == NULL && workDir) {
+	/* check site config */
+	if (workDir == NULL)
+		return NULL;
 
-		config = axl_strdup_printf ("%s/python.conf", workDir);
-		msg ("Checking to load site python.conf at %s", config);
-		if (vortex_support_file_test (config, FILE_EXISTS)) {
+	/* check if this work dir was already checked */
+	if (axl_hash_exists (mod_python_site_confs, (axlPointer) workDir))
+		return axl_hash_get (mod_python_site_confs, (axlPointer) workDir);
+
+	site_conf = NULL;
+	config    = axl_strdup_printf ("%s/python.conf", workDir);
+	msg ("Checking to load site python.conf at %s", config);
+	if (vortex_support_file_test (config, FILE_EXISTS)) {
 			
-			msg ("Found site %s/python.conf, loading..", workDir);
-			mod_python_site_conf  = axl_doc_parse_from_file (config, &err);
+		msg ("Found site %s/python.conf, loading..", workDir);
+		site_conf  = axl_doc_parse_from_file (config, &err);
+
+		/* check parse result */
+		if (site_conf == NULL) {
+			error ("failed to load mod-python site configuration file at %s, error found was: %s", 
+			       config, axl_error_get (err));
+			axl_error_free (err);
+		} /* end if */
 
-			/* check parse result */
-			if (mod_python_site_conf == NULL) {
-				error ("failed to load mod-python site configuration file at %s, error found was: %s", 
-				       config, axl_error_get (err));
-				axl_error_free (err);
-			} /* end if */
+	} /* end if */
+	axl_free (config);
 
-		} /* end if */
-		axl_free (config);
+	/* record result (also when not found) */
+	axl_hash_insert_full (mod_python_site_confs, 
+			      axl_strdup (workDir), axl_free, 
+			      site_conf, site_conf ? (axlDestroyFunc) axl_doc_free : NULL);
+
+	return site_conf;
+}
+
+/** 
+ * @internal Returns axl_true if the provided configuration has
+ * applications not started yet among those applying to serverName
+ * (all of them if NULL, see mod_python_app_applies).
+ */
+axl_bool mod_python_applications_pending (axlDoc * python_conf, const char * serverName)
+{
+	axlNode * node = axl_doc_get (python_conf, "/mod-python/application");
+	while (node) {
+		if (mod_python_app_applies (node, serverName) && 
+		    ! PTR_TO_INT (axl_node_annotate_get (node, "app-started", axl_false)))
+			return axl_true;
+		node = axl_node_get_next_called (node, "application");
+	} /* end while */
+	return axl_false;
+}
+
+/** 
+ * @internal Returns axl_true if some application of the provided
+ * configuration is bound to serverName (serverName attribute).
+ */
+axl_bool mod_python_server_name_bound (axlDoc * python_conf, const char * serverName)
+{
+	axlNode * node = axl_doc_get (python_conf, "/mod-python/application");
+	while (node) {
+		if (HAS_ATTR_VALUE (node, "serverName", serverName))
+			return axl_true;
+		node = axl_node_get_next_called (node, "application");
+	} /* end while */
+	return axl_false;
+}
+
+/** 
+ * @internal Checks if nothing is pending to be initialized on the
+ * provided profile path for serverName (see
+ * mod_python_ppath_state_set_done). Must be called with
+ * mod_python_top_init acquired.
+ */
+axl_bool mod_python_ppath_state_is_done (ModPythonPPathState * ppath_state, axlDoc * site_conf, const char * serverName)
+{
+	if (ppath_state->done)
+		return axl_true;
+	if (serverName == NULL)
+		return axl_false;
+	if (ppath_state->done_names && axl_hash_exists (ppath_state->done_names, (axlPointer) serverName))
+		return axl_true;
+	return ppath_state->done_unbound && 
+		! mod_python_server_name_bound (mod_python_conf, serverName) && 
+		! mod_python_server_name_bound (site_conf, serverName);
+}
+
+/** 
+ * @internal Records what is no longer pending to be initialized on
+ * the provided profile path after serving serverName: the profile
+ * path as a whole when no application is pending, otherwise
+ * serverName if none of the applications applying to it is pending
+ * (serverNames not declared by any application are recorded as a
+ * whole so names sent by clients are not accumulated). Must be
+ * called with mod_python_top_init acquired.
+ */
+void mod_python_ppath_state_set_done (ModPythonPPathState * ppath_state, axlDoc * site_conf, const char * serverName)
+{
+	if (! mod_python_applications_pending (mod_python_conf, NULL) && 
+	    ! mod_python_applications_pending (site_conf, NULL)) {
+		TBC_ATOMIC_STORE (ppath_state->done, axl_true);
+		return;
 	} /* end if */
 
-	/* now ensure all applications inside serverName or all of
-	 * them not */
-	
+	if (serverName == NULL ||
+	    mod_python_applications_pending (mod_python_conf, serverName) || 
+	    mod_python_applications_pending (site_conf, serverName))
+		return;
+
+	if (! mod_python_server_name_bound (mod_python_conf, serverName) && 
+	    ! mod_python_server_name_bound (site_conf, serverName)) {
+		ppath_state->done_unbound = axl_true;
+		return;
+	} /* end if */
 
+	if (ppath_state->done_names == NULL)
+		ppath_state->done_names = axl_hash_new (axl_hash_string, axl_hash_equal_string);
+	if (! axl_hash_exists (ppath_state->done_names, (axlPointer) serverName))
+		axl_hash_insert_full (ppath_state->done_names, axl_strdup (serverName), axl_free, NULL, NULL);
 	return;
 }
 
@@ -666,12 +964,27 @@ static axl_bool mod_python_ppath_selected (TurbulenceCtx      * ctx,
 					   TurbulencePPathDef * ppath_selected, 
 					   VortexConnection   * conn) {
 
-	const char       * serverName;
+	const char          * serverName;
 
 	/* get work directory and serverName */
-	const char       * workDir;
-	PyGILState_STATE   state = 0;
-	axl_bool           initialization_done = axl_false;
+	const char          * workDir;
+	PyGILState_STATE      state = 0;
+	axl_bool              initialization_done = axl_false;
+	int                   id = turbulence_ppath_get_id (ppath_selected);
+	ModPythonPPathState * ppath_state = NULL;
+	ModPythonPPaths     * paths;
+	axlDoc              * site_conf;
+	axl_bool              done;
+
+	/* check if there is nothing to initialize for this profile
+	 * path (no config found or all applications started) without
+	 * acquiring the mutex */
+	TBC_ATOMIC_ADD (mod_python_ppaths_readers, 1);
+	paths = TBC_ATOMIC_LOAD (mod_python_ppaths);
+	done  = paths && id > 0 && id < paths->count && TBC_ATOMIC_LOAD (paths->items[id].done);
+	TBC_ATOMIC_ADD (mod_python_ppaths_readers, -1);
+	if (done) 
+		return axl_true;
 
 	serverName = turbulence_ppath_get_server_name (conn);
 	workDir    = turbulence_ppath_get_work_dir (ctx, ppath_selected);
@@ -679,16 +992,38 @@ static axl_bool mod_python_ppath_selected (TurbulenceCtx      * ctx,
 	/* lock to check and initialize */
 	vortex_mutex_lock (&mod_python_top_init);
 
-	/* check and load mod-python system config */
-	mod_python_load_config (ctx, workDir, serverName);
+	/* get profile path state (if known) */
+	paths = mod_python_ppaths;
+	if (paths && id > 0 && id < paths->count)
+		ppath_state = &(paths->items[id]);
+
+	/* check and load mod-python system config and site config */
+	if (ppath_state && ppath_state->loaded)
+		site_conf = ppath_state->site_conf;
+	else {
+		site_conf = mod_python_load_config (ctx, workDir);
+		if (ppath_state) {
+			ppath_state->site_conf = site_conf;
+			ppath_state->loaded    = axl_true;
+		} /* end if */
+	} /* end if */
 
 	/* if no configuration was loaded, just return */
-	if (mod_python_conf == NULL && mod_python_site_conf == NULL) {
+	if (mod_python_conf == NULL && site_conf == NULL) {
 		msg ("mod-python: no system or site config was found, not starting any python app");
+		if (ppath_state)
+			TBC_ATOMIC_STORE (ppath_state->done, axl_true);
 		vortex_mutex_unlock (&mod_python_top_init);
 		return axl_true; 
 	} /* end if */
 
+	/* applications applying to this serverName already started
+	 * (no need to enter python) */
+	if (ppath_state && mod_python_ppath_state_is_done (ppath_state, site_conf, serverName)) {
+		vortex_mutex_unlock (&mod_python_top_init);
+		return axl_true;
+	} /* end if */
+
 	if (mod_python_py_init) { 
 		/* python engine was initialized previously so this is
 		 * a different thread, acquire the GIL state */
@@ -713,7 +1048,7 @@ static axl_bool mod_python_ppath_selected (TurbulenceCtx      * ctx,
 	}
 
 	/* now load python applications at the working dir if it is found */
-	if (! mod_python_init_applications (ctx, mod_python_site_conf, workDir, serverName, conn)) {
+	if (! mod_python_init_applications (ctx, site_conf, workDir, serverName, conn)) {
 		/* release python gil */
 		__mod_python_release_gil ();
 		vortex_mutex_unlock (&mod_python_top_init);
@@ -722,6 +1057,13 @@ static axl_bool mod_python_ppath_selected (TurbulenceCtx      * ctx,
 
 	msg ("mod-python applications initialized");
 
+	/* record if all applications for this profile path (or
+	 * those applying to this serverName) are started
+	 * (applications that failed to start are checked again on
+	 * next selection) */
+	if (ppath_state)
+		mod_python_ppath_state_set_done (ppath_state, site_conf, serverName);
+
 	/* let other threads to enter inside python engine: this must
 	   be the last call: release the GIL */
 	/* release python gil */
@@ -894,6 +1236,34 @@ END_C_DECLS
  *   isolation level.
  *
  * 
+ * \section turbulence_mod_python_workers Running python apps on several cores
+ *
+ * Python code running inside a process is serialized by the python
+ * global interpreter lock, so a busy python profile uses at most one
+ * core on each turbulence process. Python sub-interpreters do not
+ * help here because they share the same global lock (and PyVortex
+ * handlers enter python through the PyGILState API which only
+ * supports the main interpreter).
+ *
+ * To spread a python application over several cores, run it on
+ * several worker processes by combining separate="yes", reuse="yes"
+ * and reuse-workers="N" on its profile path. Each worker is a child
+ * process with its own python engine where applications are
+ * initialized. Connections are spread over workers and all channels
+ * (and so all frames) of a connection are handled by the same
+ * worker:
+ *
+ * \code
+ * <path-def server-name="core-admin" src=".*" path-name="core-admin" 
+ *           separate="yes" reuse="yes" reuse-workers="4"
+ *           work-dir="/home/acinom/programas/core-admin/server-component" >
+ *    <!-- more declarations -->
+ * </path-def>
+ * \endcode
+ *
+ * Note that state kept by the python application is not shared
+ * between workers.
+ *
  * \section turbulence_mod_python_add_path Adding path to python application
  *
  * It may be useful to allow including additional path from which to
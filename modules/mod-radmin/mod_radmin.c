@@ -56,12 +56,23 @@ VortexMutex    commands_mutex;
 
 typedef axlDoc * (*ModRadminCommandHandler) (const char * arguments, axlPointer user_data, axl_bool * result);
 
+/** 
+ * @internal Handler for commands that stream their results. The
+ * handler sends its results as ANS frames over the channel provided
+ * (finishing with NUL) and returns NULL. If it fails before sending
+ * anything, it returns an error document and sets result to
+ * axl_false. When channel is NULL, results are returned as a single
+ * document.
+ */
+typedef axlDoc * (*ModRadminStreamCommandHandler) (const char * arguments, VortexChannel * channel, int msg_no, axl_bool * result);
+
 typedef struct _ModRadminCommandItem {
-	char                     * command;
-	int                        length;
-	char                     * description;
-	ModRadminCommandHandler    handler;
-	axlPointer                 user_data;
+	char                          * command;
+	int                             length;
+	char                          * description;
+	ModRadminCommandHandler         handler;
+	ModRadminStreamCommandHandler   stream_handler;
+	axlPointer                      user_data;
 } ModRadminCommandItem;
 
 void mod_radmin_command_item_free (axlPointer data) {
@@ -261,7 +272,14 @@ void mod_radmin_handle_command (VortexConnection * conn,
 
 	/* ok, now call to handle command and return content */
 	status = axl_false;
-	result = cmd->handler (command, cmd->user_data, &status);
+	if (cmd->stream_handler) {
+		/* streamed command, results are already sent unless
+		 * an error is returned */
+		result = cmd->stream_handler (command + cmd->length, channel, vortex_frame_get_msgno (frame), &status);
+		if (result == NULL)
+			return;
+	} else
+		result = cmd->handler (command, cmd->user_data, &status);
 
 	/* call to handle reply */
 	mod_radmin_handle_command_reply (status, result, conn, channel, frame);
@@ -353,84 +371,155 @@ const char * mod_radmin_role_to_string (VortexPeerRole role)
 	return "unknown";
 }
 
-typedef void (*ModRadminChildCommandHandler) (TurbulenceCtx * ctx, const char * content, axl_bool status, axlPointer user_data);
+/** 
+ * @internal Handler called for each child reply received during a
+ * fan-out command (\ref mod_radmin_run_command_on_childs). When the
+ * child did not reply (the command deadline expired or the command
+ * could not be sent to it) the handler is called with content set to
+ * NULL, status set to axl_false and failure describing what happened
+ * (NULL otherwise).
+ */
+typedef void (*ModRadminChildCommandHandler) (TurbulenceCtx * ctx, int pid, const char * content, axl_bool status, const char * failure, axlPointer user_data);
 
+/** 
+ * @internal Default deadline (in milliseconds) applied to commands
+ * sent to all childs. Childs that do not reply before it expires are
+ * reported as timed out.
+ */
+#define MOD_RADMIN_CHILD_COMMAND_TIMEOUT 5000
 
 /** 
- * @internal Function that allows to send a command to a particular
- * child using internal conn mgr connection.
- *
- * @param ctx The context where the module is working.
- *
- * @param child The child process that will receive the command.
- *
- * @param queue Reference to the queue used to receive the reply or
- * NULL to make the function to create and release a queue internally.
- *
- * @param command The command to send.
+ * @internal Connection data flagging a child connection whose radmin
+ * channel pool is being created (asynchronously).
+ */
+#define MOD_RADMIN_POOL_CREATING "mod-radmin:pool-creating"
+
+/** 
+ * @internal State associated to a command sent to a child as part
+ * of a fan-out operation.
+ */
+typedef struct _ModRadminChildCall {
+	int                  id;
+	int                  pid;
+	TurbulenceChild    * child;
+	const char         * command;
+	VortexConnection   * conn;
+	/* pool the channel was taken from (NULL if the channel was
+	 * opened for this call) */
+	VortexChannelPool  * pool;
+	VortexChannel      * channel;
+	VortexAsyncQueue   * queue;
+	VortexFrame        * reply;
+	/* the command could not be sent (no channel or send failed) */
+	axl_bool             send_failed;
+} ModRadminChildCall;
+
+/** 
+ * @internal Data passed to the asynchronous creation of a channel
+ * pool on behalf of a call.
+ */
+typedef struct _ModRadminChildOpen {
+	int                  id;
+	VortexConnection   * conn;
+} ModRadminChildOpen;
+
+/* calls waiting for a reply, indexed by call id. Replies arriving
+ * for a call no longer found here (command deadline expired) are
+ * dropped */
+axlHash      * pending_calls;
+VortexMutex    pending_calls_mutex;
+int            pending_calls_next_id = 1;
+
+/** 
+ * @internal Acquires a reference to the child conn mgr connection and
+ * a ready channel from the internal radmin channel pool, creating the
+ * pool if required.
  *
- * @return The function returns the frame reply from child or NULL if
- * it fails.
+ * @return The channel ready to be used or NULL if it fails. On
+ * success, the caller must release the channel into the pool and
+ * the reference to the connection (conn).
  */
-VortexFrame * mod_radmin_run_command_on_child (TurbulenceCtx * ctx, TurbulenceChild * child, VortexAsyncQueue * queue, const char * command)
+VortexChannel * mod_radmin_child_get_channel (TurbulenceCtx * ctx, TurbulenceChild * child, VortexConnection ** conn, VortexChannelPool ** pool)
 {
-	VortexChannelPool * pool;
-	VortexConnection  * conn;
-	VortexChannel     * channel;
-	VortexFrame       * reply;
-	axl_bool            release_queue = (queue == NULL);
-	
-	/* create a queue if not defined */
-	if (queue == NULL)
-		queue = vortex_async_queue_new ();
+	VortexChannel * channel;
 
 	/* acquire a reference to the child connection and use local
 	   reference to avoid having child closed in the middle (kill
 	   child) */
-	conn  = child->conn_mgr;
-	if (! vortex_connection_ref (conn, "begin mod-radmin run child cmd")) {
+	(*conn)  = child->conn_mgr;
+	if (! vortex_connection_ref ((*conn), "begin mod-radmin run child cmd")) {
 		error ("Failed to create channel pool to send commands to childs..");
-		if (release_queue)
-			vortex_async_queue_unref (queue);
 		return NULL;
 	}
 
 	/* check if we have a pool created */
-	pool = vortex_connection_get_channel_pool (conn, 1);
-	if (pool == NULL) {
+	(*pool) = vortex_connection_get_channel_pool ((*conn), 1);
+	if ((*pool) == NULL) {
 		/* pool not created, create one */
-		pool = vortex_channel_pool_new (conn, 
-						RADMIN_URI_INTERNAL,
-						/* one channel initially */
-						1, 
-						/* on close handler */
-						NULL, NULL,
-						/* on frame received handler */
-						NULL, NULL,
-						/* on channel created */
-						NULL, NULL);
-		if (pool == NULL) {
+		(*pool) = vortex_channel_pool_new ((*conn), 
+						   RADMIN_URI_INTERNAL,
+						   /* one channel initially */
+						   1, 
+						   /* on close handler */
+						   NULL, NULL,
+						   /* on frame received handler */
+						   NULL, NULL,
+						   /* on channel created */
+						   NULL, NULL);
+		if ((*pool) == NULL) {
 			error ("Failed to create channel pool to send commands to childs..");
-			if (release_queue)
-				vortex_async_queue_unref (queue);
 
 			/* release connection */
-			vortex_connection_unref (conn, "end mod-radmin run child cmd");
+			vortex_connection_unref ((*conn), "end mod-radmin run child cmd");
 			return NULL;
 		} /* end if */
 	} /* end if */
 
 	/* get a channel from the pool */
-	channel = vortex_channel_pool_get_next_ready (pool, axl_true);
+	channel = vortex_channel_pool_get_next_ready ((*pool), axl_true);
 	if (channel == NULL) {
 		error ("Unable to get a channel ready from the pool to send command to child..");
-		if (release_queue)
-			vortex_async_queue_unref (queue);
 		/* release connection */
-		vortex_connection_unref (conn, "end mod-radmin run child cmd");
+		vortex_connection_unref ((*conn), "end mod-radmin run child cmd");
 		return NULL;
 	} /* end if */
 
+	return channel;
+}
+
+/** 
+ * @internal Function that allows to send a command to a particular
+ * child using internal conn mgr connection.
+ *
+ * @param ctx The context where the module is working.
+ *
+ * @param child The child process that will receive the command.
+ *
+ * @param queue Reference to the queue used to receive the reply or
+ * NULL to make the function to create and release a queue internally.
+ *
+ * @param command The command to send.
+ *
+ * @return The function returns the frame reply from child or NULL if
+ * it fails.
+ */
+VortexFrame * mod_radmin_run_command_on_child (TurbulenceCtx * ctx, TurbulenceChild * child, VortexAsyncQueue * queue, const char * command)
+{
+	VortexChannelPool * pool;
+	VortexConnection  * conn;
+	VortexChannel     * channel;
+	VortexFrame       * reply;
+	axl_bool            release_queue = (queue == NULL);
+
+	/* get a channel to the child */
+	channel = mod_radmin_child_get_channel (ctx, child, &conn, &pool);
+	if (channel == NULL)
+		return NULL;
+	
+	/* create a queue if not defined */
+	if (queue == NULL)
+		queue = vortex_async_queue_new ();
+
 	/* configure frame received */
 	vortex_channel_set_received_handler (channel, vortex_channel_queue_reply, queue);
 
@@ -440,7 +529,8 @@ VortexFrame * mod_radmin_run_command_on_child (TurbulenceCtx * ctx, TurbulenceCh
 		if (release_queue)
 			vortex_async_queue_unref (queue);
 
-		/* release connection */
+		/* release the channel and the connection */
+		vortex_channel_pool_release_channel (pool, channel);
 		vortex_connection_unref (conn, "end mod-radmin run child cmd");
 		return NULL;
 	} /* end if */
@@ -459,72 +549,811 @@ VortexFrame * mod_radmin_run_command_on_child (TurbulenceCtx * ctx, TurbulenceCh
 	return reply;
 }
 
+/** 
+ * @internal Frame received handler installed on channels used by a
+ * fan-out command. The reply is attached to its call (if it is still
+ * waiting) and the call is pushed into the queue shared by all calls
+ * of the same command to wake up the collector.
+ */
+void mod_radmin_child_call_reply (VortexChannel    * channel, 
+				  VortexConnection * connection, 
+				  VortexFrame      * frame, 
+				  axlPointer         user_data)
+{
+	ModRadminChildCall * call;
+
+	vortex_mutex_lock (&pending_calls_mutex);
+	call = axl_hash_get (pending_calls, user_data);
+	if (call != NULL && call->reply == NULL) {
+		/* get a copy of the frame: it is released by vortex
+		 * after this handler finishes */
+		call->reply = vortex_frame_copy (frame);
+		vortex_async_queue_push (call->queue, call);
+	} /* end if */
+	vortex_mutex_unlock (&pending_calls_mutex);
 
-void mod_radmin_run_command_on_childs (TurbulenceCtx * ctx, const char * command,
-				       ModRadminChildCommandHandler handler, axlPointer user_data)
+	return;
+}
+
+/** 
+ * @internal Sends the command of the provided call on the channel,
+ * waking up the collector if it fails. Must be called with
+ * pending_calls_mutex acquired.
+ */
+void mod_radmin_child_call_send (ModRadminChildCall * call, VortexChannelPool * pool, VortexChannel * channel)
 {
-	axlList          * childs;
-	axlListCursor    * cursor;
-	TurbulenceChild  * child;
-	VortexAsyncQueue * queue;
-	VortexFrame      * reply;
+	call->pool    = pool;
+	call->channel = channel;
+
+	/* configure frame received and send command */
+	vortex_channel_set_received_handler (channel, mod_radmin_child_call_reply, INT_TO_PTR (call->id));
+	if (vortex_channel_send_msg (channel, call->command, strlen (call->command), NULL))
+		return;
+
+	error ("Unable to send command to child process %d..", call->pid);
+	call->send_failed = axl_true;
+	vortex_async_queue_push (call->queue, call);
+	return;
+}
+
+/** 
+ * @internal Flags the provided call as failed because no channel
+ * could be opened, waking up the collector. Must be called with
+ * pending_calls_mutex acquired.
+ */
+void mod_radmin_child_call_no_channel (ModRadminChildCall * call)
+{
+	error ("Unable to get a channel to send command to child %d..", call->pid);
+	call->send_failed = axl_true;
+	vortex_async_queue_push (call->queue, call);
+	return;
+}
+
+/** 
+ * @internal Async close notification of channels dropped by
+ * mod_radmin_child_channel_keep (nothing to do).
+ */
+void mod_radmin_child_channel_closed (VortexConnection * conn, int channel_num, axl_bool was_closed, 
+				      const char * code, const char * msg, axlPointer user_data)
+{
+	return;
+}
+
+/** 
+ * @internal Keeps a channel opened for a call, once the call
+ * finished, into the radmin pool of the child so next commands
+ * reuse it (it is closed if the pool is not available).
+ */
+void mod_radmin_child_channel_keep (VortexConnection * conn, VortexChannel * channel)
+{
+	VortexChannelPool * pool = vortex_connection_get_channel_pool (conn, 1);
+
+	if (pool != NULL) {
+		vortex_channel_pool_attach (pool, channel);
+		return;
+	} /* end if */
+	vortex_channel_close_full (channel, mod_radmin_child_channel_closed, NULL);
+	return;
+}
+
+/** 
+ * @internal Async notification of the radmin channel pool created
+ * for a child: the call that requested it sends its command (if it
+ * is still waiting).
+ */
+void mod_radmin_child_pool_created (VortexChannelPool * pool, axlPointer user_data)
+{
+	ModRadminChildOpen * open    = user_data;
+	ModRadminChildCall * call;
+	VortexChannel      * channel = NULL;
+
+	vortex_mutex_lock (&pending_calls_mutex);
+	vortex_connection_set_data (open->conn, MOD_RADMIN_POOL_CREATING, NULL);
+	call = axl_hash_get (pending_calls, INT_TO_PTR (open->id));
+	if (call != NULL) {
+		if (pool != NULL)
+			channel = vortex_channel_pool_get_next_ready (pool, axl_false);
+		if (channel != NULL)
+			mod_radmin_child_call_send (call, pool, channel);
+		else
+			mod_radmin_child_call_no_channel (call);
+	} /* end if */
+	vortex_mutex_unlock (&pending_calls_mutex);
+
+	vortex_connection_unref (open->conn, "mod-radmin child pool");
+	axl_free (open);
+	return;
+}
+
+/** 
+ * @internal Async notification of a channel opened for a call: the
+ * call sends its command (if it is still waiting, otherwise the
+ * channel is kept for next commands).
+ */
+void mod_radmin_child_channel_created (int channel_num, VortexChannel * channel, VortexConnection * conn, axlPointer user_data)
+{
+	ModRadminChildCall * call;
+
+	vortex_mutex_lock (&pending_calls_mutex);
+	call = axl_hash_get (pending_calls, user_data);
+	if (call != NULL) {
+		if (channel != NULL)
+			mod_radmin_child_call_send (call, NULL, channel);
+		else
+			mod_radmin_child_call_no_channel (call);
+	} /* end if */
+	vortex_mutex_unlock (&pending_calls_mutex);
+
+	if (call == NULL && channel != NULL)
+		mod_radmin_child_channel_keep (conn, channel);
+	return;
+}
+
+/** 
+ * @internal Sends the command of the provided call (already
+ * registered at pending_calls) without blocking: a channel ready in
+ * the radmin pool of the child is used when found, otherwise the
+ * pool (first command) or an additional channel is created
+ * asynchronously and the command is sent once it is available. The
+ * time taken counts against the command deadline because the call is
+ * waited as any other.
+ */
+void mod_radmin_child_call_start (ModRadminChildCall * call)
+{
+	VortexChannelPool  * pool;
+	VortexChannel      * channel = NULL;
+	ModRadminChildOpen * open;
+
+	/* channel ready in the pool (do not create one here) */
+	pool = vortex_connection_get_channel_pool (call->conn, 1);
+	if (pool != NULL)
+		channel = vortex_channel_pool_get_next_ready (pool, axl_false);
+	if (channel != NULL) {
+		vortex_mutex_lock (&pending_calls_mutex);
+		mod_radmin_child_call_send (call, pool, channel);
+		vortex_mutex_unlock (&pending_calls_mutex);
+		return;
+	} /* end if */
+
+	/* no pool: create it (only once for concurrent commands) */
+	if (pool == NULL) {
+		vortex_mutex_lock (&pending_calls_mutex);
+		open = NULL;
+		if (! vortex_connection_get_data (call->conn, MOD_RADMIN_POOL_CREATING)) {
+			vortex_connection_set_data (call->conn, MOD_RADMIN_POOL_CREATING, INT_TO_PTR (axl_true));
+			open       = axl_new (ModRadminChildOpen, 1);
+			open->id   = call->id;
+			open->conn = call->conn;
+		} /* end if */
+		vortex_mutex_unlock (&pending_calls_mutex);
+
+		if (open != NULL && vortex_connection_ref (open->conn, "mod-radmin child pool")) {
+			vortex_channel_pool_new (call->conn, 
+						 RADMIN_URI_INTERNAL,
+						 /* one channel initially */
+						 1, 
+						 /* on close handler */
+						 NULL, NULL,
+						 /* on frame received handler */
+						 NULL, NULL,
+						 /* on pool created (async) */
+						 mod_radmin_child_pool_created, open);
+			return;
+		} /* end if */
+		if (open != NULL) {
+			vortex_mutex_lock (&pending_calls_mutex);
+			vortex_connection_set_data (call->conn, MOD_RADMIN_POOL_CREATING, NULL);
+			mod_radmin_child_call_no_channel (call);
+			vortex_mutex_unlock (&pending_calls_mutex);
+			axl_free (open);
+			return;
+		} /* end if */
+	} /* end if */
+
+	/* pool busy or being created: open one more channel */
+	vortex_channel_new (call->conn, 0, RADMIN_URI_INTERNAL,
+			    /* no close handler */
+			    NULL, NULL,
+			    /* frame received */
+			    mod_radmin_child_call_reply, INT_TO_PTR (call->id),
+			    /* on channel created (async) */
+			    mod_radmin_child_channel_created, INT_TO_PTR (call->id));
+	return;
+}
+
+/** 
+ * @internal Returns remaining microseconds until the provided
+ * deadline (or 0 if it has expired).
+ */
+long mod_radmin_deadline_remaining (struct timeval * deadline)
+{
+	struct timeval now;
+	long           remaining;
+
+	gettimeofday (&now, NULL);
+	remaining = (deadline->tv_sec - now.tv_sec) * 1000000 + (deadline->tv_usec - now.tv_usec);
+	return remaining > 0 ? remaining : 0;
+}
+
+/** 
+ * @internal qsort comparison used to order fan-out calls by child pid.
+ */
+int mod_radmin_child_call_cmp (const void * a, const void * b)
+{
+	return ((const ModRadminChildCall *) a)->pid - ((const ModRadminChildCall *) b)->pid;
+}
+
+/** 
+ * @internal Sends the provided command to all childs concurrently
+ * and calls the handler for each reply received. Commands are first
+ * sent to every child (without waiting for replies) and then replies
+ * are gathered as they arrive until all childs replied or timeout
+ * milliseconds have elapsed. Childs that did not reply in time, or
+ * whose command could not be sent, are notified to the handler with
+ * content set to NULL and a failure description, so a slow or hung
+ * child no longer blocks the whole command and a broken child
+ * channel is told apart from a slow child. The handler is called for
+ * each child in ascending pid order.
+ *
+ * @param ctx The context where the module is working.
+ *
+ * @param command The command to send to childs.
+ *
+ * @param timeout Deadline in milliseconds applied to the whole
+ * command. Values <= 0 selects \ref MOD_RADMIN_CHILD_COMMAND_TIMEOUT.
+ *
+ * @param handler The handler called for each child.
+ *
+ * @param user_data User defined pointer passed to the handler.
+ *
+ * @return Number of childs that did not reply (timed out or command
+ * not sent).
+ */
+int mod_radmin_run_command_on_childs (TurbulenceCtx * ctx, const char * command, long timeout,
+				      ModRadminChildCommandHandler handler, axlPointer user_data)
+{
+	axlList             * childs;
+	TurbulenceChild     * child;
+	VortexAsyncQueue    * queue;
+	ModRadminChildCall  * calls;
+	ModRadminChildCall  * call;
+	struct timeval        deadline;
+	long                  remaining;
+	int                   length;
+	int                   iterator;
+	int                   pending = 0;
+	int                   timed_out = 0;
+	int                   failed    = 0;
 
 	/* get list of childs */
 	childs = turbulence_process_child_list (ctx);
-	if (axl_list_length (childs) == 0) {
+	length = axl_list_length (childs);
+	if (length == 0) {
 		/* no childs, finish */
 		axl_list_free (childs);
-		return;
+		return 0;
 	} /* end if */
 
-	/* init queue */
+	/* compute command deadline */
+	if (timeout <= 0)
+		timeout = MOD_RADMIN_CHILD_COMMAND_TIMEOUT;
+	gettimeofday (&deadline, NULL);
+	deadline.tv_sec  += timeout / 1000;
+	deadline.tv_usec += (timeout % 1000) * 1000;
+	if (deadline.tv_usec >= 1000000) {
+		deadline.tv_sec++;
+		deadline.tv_usec -= 1000000;
+	} /* end if */
+
+	/* init queue shared by all calls and call state */
 	queue = vortex_async_queue_new ();
+	calls = axl_new (ModRadminChildCall, length);
+
+	/* sort childs by pid so handlers are always notified in the
+	 * same order (used by listings to build their cursor) */
+	for (iterator = 0; iterator < length; iterator++) {
+		calls[iterator].child = axl_list_get_nth (childs, iterator);
+		calls[iterator].pid   = calls[iterator].child->pid;
+	} /* end for */
+	qsort (calls, length, sizeof (ModRadminChildCall), mod_radmin_child_call_cmp);
+
+	/* first phase: send command to all childs without waiting
+	 * (channels not ready are opened asynchronously, see
+	 * mod_radmin_child_call_start) */
+	for (iterator = 0; iterator < length; iterator++) {
+		call          = &(calls[iterator]);
+		child         = call->child;
+		call->queue   = queue;
+		call->command = command;
+
+		/* acquire a reference to the child connection to
+		 * avoid having child closed in the middle (kill
+		 * child) */
+		msg ("Running command %s on child %d", command, child->pid);
+		call->conn = child->conn_mgr;
+		if (! vortex_connection_ref (call->conn, "begin mod-radmin run child cmd")) {
+			call->conn        = NULL;
+			call->send_failed = axl_true;
+			continue;
+		} /* end if */
 
-	/* now for each child, call the handler */
-	cursor = axl_list_cursor_new (childs);
-	while (axl_list_cursor_has_item (cursor)) {
+		/* register call before sending so the reply (or the
+		 * channel creation) always finds it */
+		vortex_mutex_lock (&pending_calls_mutex);
+		call->id = pending_calls_next_id++;
+		axl_hash_insert (pending_calls, INT_TO_PTR (call->id), call);
+		vortex_mutex_unlock (&pending_calls_mutex);
+
+		/* the call is waited until it is replied or it
+		 * fails (both wake up the collector) */
+		pending++;
+		mod_radmin_child_call_start (call);
+	} /* end for */
+
+	/* second phase: gather replies (or failures) until all childs
+	 * replied or the deadline expires */
+	while (pending > 0) {
+		remaining = mod_radmin_deadline_remaining (&deadline);
+		if (remaining == 0)
+			break;
+		if (vortex_async_queue_timedpop (queue, remaining) == NULL)
+			break;
+		pending--;
+	} /* end while */
 
-		/* get child */
-		child = axl_list_cursor_get (cursor);
+	/* unregister all calls: from now on late replies are dropped
+	 * and call->reply can be read without locking */
+	vortex_mutex_lock (&pending_calls_mutex);
+	for (iterator = 0; iterator < length; iterator++) {
+		if (calls[iterator].id > 0)
+			axl_hash_remove (pending_calls, INT_TO_PTR (calls[iterator].id));
+	} /* end for */
+	vortex_mutex_unlock (&pending_calls_mutex);
 
-		/* run the command on the child */
-		msg ("Running command %s on child %d", command, child->pid);
-		reply = mod_radmin_run_command_on_child (ctx, child, queue, command);
+	/* notify results */
+	for (iterator = 0; iterator < length; iterator++) {
+		call = &(calls[iterator]);
 
-		if (reply) {
+		if (call->reply) {
 			/* notify on the handler */
-			handler (ctx, 
+			handler (ctx, call->pid,
 				 /* content */
-				 (const char *) vortex_frame_get_payload (reply), 
+				 (const char *) vortex_frame_get_payload (call->reply), 
 				 /* status */
-				 vortex_frame_get_type (reply) == VORTEX_FRAME_TYPE_RPY,
-				 user_data);
+				 vortex_frame_get_type (call->reply) == VORTEX_FRAME_TYPE_RPY,
+				 NULL, user_data);
+
+			/* release frame */
+			vortex_frame_unref (call->reply);
+		} else if (call->send_failed) {
+			/* command not sent: child channel broken */
+			wrn ("Unable to send command %s to child %d", command, call->pid);
+			handler (ctx, call->pid, NULL, axl_false, "command could not be sent", user_data);
+			failed++;
+		} else if (call->id > 0) {
+			/* command sent but no reply in time */
+			wrn ("Child %d did not reply to command %s before %ld ms deadline", call->pid, command, timeout);
+			handler (ctx, call->pid, NULL, axl_false, "did not reply in time", user_data);
+			timed_out++;
 		} /* end if */
 
-		/* release frame */
-		vortex_frame_unref (reply);
-
-		/* next item */
-		axl_list_cursor_next (cursor);
-	} /* end while */
+		/* release the channel (if a reply arrives later, the
+		 * channel is not ready until then and the pool will not
+		 * return it) and the connection. Channels opened for
+		 * this call are kept into the pool */
+		if (call->channel) {
+			if (call->pool)
+				vortex_channel_pool_release_channel (call->pool, call->channel);
+			else
+				mod_radmin_child_channel_keep (call->conn, call->channel);
+		} /* end if */
+		if (call->conn)
+			vortex_connection_unref (call->conn, "end mod-radmin run child cmd");
+	} /* end for */
 
 	/* release queue */
-	msg ("Command %s on childs finished, release queue and child list", command);
+	msg ("Command %s on childs finished (%d timed out, %d not sent), release queue and child list", command, timed_out, failed);
 	vortex_async_queue_unref (queue);
+	axl_free (calls);
 	axl_list_free (childs);
-	axl_list_cursor_free (cursor);
 
+	return timed_out + failed;
+}
+
+/** 
+ * @internal Number of rows sent on each ANS frame by streamed
+ * listings.
+ */
+#define MOD_RADMIN_STREAM_CHUNK 100
+
+/** 
+ * @internal Filter and cursor configuration used by listing commands
+ * (show connections, show channels). It is parsed from the arguments
+ * following the command:
+ *
+ * ppath=<name> profile=<uri> remote=<addr-prefix> idle=<secs> from=<pid>:<conn-id> limit=<n>
+ */
+typedef struct _ModRadminListFilter {
+	char     * ppath;
+	char     * profile;
+	char     * remote;
+	long       idle;
+	/* cursor: only connections after (from_key, from_id) are
+	 * reported. from_key is -1 when no cursor was provided */
+	int        from_key;
+	int        from_id;
+	/* max number of connections to report (0 means no limit) */
+	int        limit;
+	/* raw arguments, forwarded to childs */
+	char     * args;
+} ModRadminListFilter;
+
+/** 
+ * @internal State used to report rows of a listing. When channel is
+ * defined, rows are streamed to the caller as ANS frames holding up
+ * to MOD_RADMIN_STREAM_CHUNK rows (master). Otherwise rows are
+ * accumulated on doc which is returned as a single reply (childs,
+ * already bounded by the filter limit).
+ */
+typedef struct _ModRadminStream {
+	VortexChannel       * channel;
+	int                   msg_no;
+	axlDoc              * doc;
+	int                   chunk_rows;
+	ModRadminListFilter * filter;
+	/* connections accepted so far and if more were found after
+	 * reaching the limit */
+	int                   accepted;
+	axl_bool              more;
+	/* number of columns of the table */
+	int                   columns;
+	int                   last_pid;
+	int                   last_id;
+} ModRadminStream;
+
+/** 
+ * @internal Returns the key used to order processes on listings:
+ * master process goes first (0) and childs go after it, ordered by
+ * pid.
+ */
+int mod_radmin_process_key (int pid)
+{
+	int master_pid = turbulence_ctx_is_child (ctx) ? getppid () : vortex_getpid ();
+	return (pid == master_pid) ? 0 : pid;
+}
+
+void mod_radmin_list_filter_free (ModRadminListFilter * filter)
+{
+	if (filter == NULL)
+		return;
+	axl_free (filter->ppath);
+	axl_free (filter->profile);
+	axl_free (filter->remote);
+	axl_free (filter->args);
+	axl_free (filter);
 	return;
 }
 
-void mod_radmin_child_show_connections_handler (TurbulenceCtx * ctx, const char * content, axl_bool status, axlPointer user_data)
+/** 
+ * @internal Parses listing arguments (see \ref ModRadminListFilter).
+ *
+ * @return A newly allocated filter or NULL if an unknown or malformed
+ * argument is found.
+ */
+ModRadminListFilter * mod_radmin_list_filter_parse (const char * args)
 {
-	axlDoc   * child_doc;
-	axlDoc   * doc = user_data;
-	axlError * err = NULL;
-	axlNode  * node;
-	axlNode  * child_node;
-	axlNode  * aux;
+	ModRadminListFilter  * filter = axl_new (ModRadminListFilter, 1);
+	char                ** items;
+	char                 * value;
+	int                    iterator;
+
+	filter->from_key = -1;
+	filter->args     = axl_strdup (args ? args : "");
+	axl_stream_trim (filter->args);
+	if (strlen (filter->args) == 0)
+		return filter;
+
+	items    = axl_split (filter->args, 1, " ");
+	iterator = 0;
+	while (items && items[iterator]) {
+		/* skip empty items produced by repeated spaces */
+		if (strlen (items[iterator]) == 0) {
+			iterator++;
+			continue;
+		} /* end if */
+
+		value = strstr (items[iterator], "=");
+		if (value == NULL) 
+			goto bad_argument;
+		value[0] = 0;
+		value++;
+
+		if (axl_cmp (items[iterator], "ppath")) {
+			axl_free (filter->ppath);
+			filter->ppath = axl_strdup (value);
+		} else if (axl_cmp (items[iterator], "profile")) {
+			axl_free (filter->profile);
+			filter->profile = axl_strdup (value);
+		} else if (axl_cmp (items[iterator], "remote")) {
+			axl_free (filter->remote);
+			filter->remote = axl_strdup (value);
+		} else if (axl_cmp (items[iterator], "idle")) {
+			filter->idle = atol (value);
+		} else if (axl_cmp (items[iterator], "limit")) {
+			filter->limit = atoi (value);
+		} else if (axl_cmp (items[iterator], "from")) {
+			if (strstr (value, ":") == NULL)
+				goto bad_argument;
+			filter->from_key = mod_radmin_process_key (atoi (value));
+			filter->from_id  = atoi (strstr (value, ":") + 1);
+		} else
+			goto bad_argument;
+
+		iterator++;
+	} /* end while */
+
+	axl_freev (items);
+	return filter;
+
+ bad_argument:
+	error ("Unknown or malformed listing argument: %s", items[iterator]);
+	axl_freev (items);
+	mod_radmin_list_filter_free (filter);
+	return NULL;
+}
+
+/** 
+ * @internal Channel selector used to find channels running the
+ * profile provided (compared case-insensitively because commands are
+ * lowered before being handled).
+ */
+axl_bool mod_radmin_channel_profile_match (VortexChannel * channel, axlPointer user_data)
+{
+	return axl_casecmp (vortex_channel_get_profile (channel), (const char *) user_data);
+}
+
+/** 
+ * @internal Checks if the connection matches filters configured
+ * (cursor and limit are checked by \ref mod_radmin_stream_accept).
+ */
+axl_bool mod_radmin_list_filter_match (ModRadminListFilter * filter, VortexConnection * conn)
+{
+	TurbulencePPathDef * ppath;
+	long                 bytes_sent;
+	long                 bytes_recv;
+	long                 activity_stamp;
+	const char         * host;
+
+	if (filter->ppath) {
+		ppath = turbulence_ppath_selected (conn);
+		if (ppath == NULL || ! axl_casecmp (turbulence_ppath_get_name (ppath), filter->ppath))
+			return axl_false;
+	} /* end if */
+
+	if (filter->profile) {
+		if (vortex_connection_get_channel_by_func (conn, mod_radmin_channel_profile_match, filter->profile) == NULL)
+			return axl_false;
+	} /* end if */
+
+	if (filter->remote) {
+		host = vortex_connection_get_host (conn);
+		if (host == NULL || ! axl_memcmp (host, filter->remote, strlen (filter->remote)))
+			return axl_false;
+	} /* end if */
+
+	if (filter->idle > 0) {
+		vortex_connection_get_receive_stamp (conn, &bytes_recv, &bytes_sent, &activity_stamp);
+		if ((time (NULL) - activity_stamp) < filter->idle)
+			return axl_false;
+	} /* end if */
+
+	return axl_true;
+}
+
+/** 
+ * @internal Creates a new stream to report a listing.
+ *
+ * @param channel The channel where to stream results or NULL to
+ * accumulate them into the header document.
+ *
+ * @param msg_no The message being replied (when channel is defined).
+ *
+ * @param filter The filter applied to the listing.
+ *
+ * @param header The table header (title, column-description and an
+ * empty content). Ownership is taken by the stream.
+ */
+ModRadminStream * mod_radmin_stream_new (VortexChannel * channel, int msg_no, ModRadminListFilter * filter, axlDoc * header)
+{
+	ModRadminStream * stream = axl_new (ModRadminStream, 1);
+	char            * str_result;
+	int               str_size;
+
+	axlNode         * column;
+
+	stream->channel = channel;
+	stream->msg_no  = msg_no;
+	stream->filter  = filter;
+
+	/* count columns */
+	column = axl_doc_get (header, "/table/column-description/column");
+	while (column) {
+		stream->columns++;
+		column = axl_node_get_next_called (column, "column");
+	} /* end while */
+
+	if (channel == NULL) {
+		/* rows are accumulated on the header document */
+		stream->doc = header;
+		return stream;
+	} /* end if */
+
+	/* send header right now so the caller can start rendering */
+	if (axl_doc_dump (header, &str_result, &str_size)) {
+		vortex_channel_send_ans_rpy (channel, str_result, str_size, msg_no);
+		axl_free (str_result);
+	} /* end if */
+	axl_doc_free (header);
+
+	return stream;
+}
+
+/** 
+ * @internal Sends rows pending on the current chunk (only when
+ * streaming to a channel).
+ */
+void mod_radmin_stream_flush (ModRadminStream * stream)
+{
+	char * str_result;
+	int    str_size;
+
+	if (stream->channel == NULL || stream->doc == NULL)
+		return;
+
+	if (axl_doc_dump (stream->doc, &str_result, &str_size)) {
+		vortex_channel_send_ans_rpy (stream->channel, str_result, str_size, stream->msg_no);
+		axl_free (str_result);
+	} /* end if */
+
+	axl_doc_free (stream->doc);
+	stream->doc        = NULL;
+	stream->chunk_rows = 0;
+	return;
+}
+
+/** 
+ * @internal Checks if the connection identified by pid and conn id
+ * must be reported according to the cursor and limit configured,
+ * updating stream state if accepted. Connections must be provided in
+ * (process key, conn id) order.
+ */
+axl_bool mod_radmin_stream_accept (ModRadminStream * stream, int pid, int conn_id)
+{
+	ModRadminListFilter * filter = stream->filter;
+	int                   key    = mod_radmin_process_key (pid);
+
+	/* check cursor */
+	if (filter->from_key > key || (filter->from_key == key && filter->from_id >= conn_id))
+		return axl_false;
+
+	/* check limit */
+	if (filter->limit > 0 && stream->accepted >= filter->limit) {
+		stream->more = axl_true;
+		return axl_false;
+	} /* end if */
+
+	stream->accepted++;
+	stream->last_pid = pid;
+	stream->last_id  = conn_id;
+	return axl_true;
+}
+
+/** 
+ * @internal Adds the row to the listing, taking ownership of it.
+ */
+void mod_radmin_stream_push (ModRadminStream * stream, axlNode * row)
+{
+	if (stream->doc == NULL)
+		stream->doc = axl_doc_parse_strings (NULL, "<table><content></content></table>", NULL);
+
+	axl_node_set_child (axl_doc_get (stream->doc, "/table/content"), row);
+	stream->chunk_rows++;
+
+	if (stream->chunk_rows >= MOD_RADMIN_STREAM_CHUNK)
+		mod_radmin_stream_flush (stream);
+	return;
+}
+
+/** 
+ * @internal Finishes the listing, reporting the cursor to continue
+ * with if the limit was reached. When streaming, the NUL frame is
+ * sent and NULL is returned. Otherwise the accumulated document is
+ * returned.
+ */
+axlDoc * mod_radmin_stream_finish (ModRadminStream * stream)
+{
+	axlDoc  * doc = NULL;
+	axlNode * node;
+	char    * next;
+
+	mod_radmin_stream_flush (stream);
+
+	if (stream->more) {
+		if (stream->doc == NULL)
+			stream->doc = axl_doc_parse_strings (NULL, "<table></table>", NULL);
+		node = axl_node_create ("cursor");
+		next = axl_strdup_printf ("%d:%d", stream->last_pid, stream->last_id);
+		axl_node_set_attribute (node, "next", next);
+		axl_free (next);
+		axl_node_set_child (axl_doc_get_root (stream->doc), node);
+		mod_radmin_stream_flush (stream);
+	} /* end if */
+
+	if (stream->channel)
+		vortex_channel_finalize_ans_rpy (stream->channel, stream->msg_no);
+	else
+		doc = stream->doc;
+
+	axl_free (stream);
+	return doc;
+}
+
+/** 
+ * @internal Adds a row to the listing reporting that the child did
+ * not reply (failure describes why). The row has the same number of
+ * columns as the table (first column is the proc-id). It is counted
+ * against the limit as the child first entry (conn-id 0), so a
+ * cursor pointing to it continues with the child connections.
+ */
+void mod_radmin_stream_add_failed (ModRadminStream * stream, int pid, const char * failure)
+{
+	axlNode * node;
+	axlNode * row;
+	int       columns = stream->columns;
+
+	/* check cursor and limit */
+	if (! mod_radmin_stream_accept (stream, pid, 0))
+		return;
+
+	row = axl_node_create ("row");
+	node = axl_node_create ("d");
+	axl_node_set_content_ref (node, axl_strdup_printf ("%d", pid), -1);
+	axl_node_set_child (row, node);
+	node = axl_node_create ("d");
+	axl_node_set_content_ref (node, axl_strdup_printf ("** child %s **", failure), -1);
+	axl_node_set_child (row, node);
+	columns -= 2;
+	while (columns > 0) {
+		axl_node_set_child (row, axl_node_create ("d"));
+		columns--;
+	} /* end while */
+
+	mod_radmin_stream_push (stream, row);
+	return;
+}
+
+/** 
+ * @internal Handler used to merge listing rows received from childs
+ * into the stream. First and second columns of each row are proc-id
+ * and conn-id, which are used to apply cursor and limit.
+ */
+void mod_radmin_child_listing_handler (TurbulenceCtx * ctx, int pid, const char * content, axl_bool status, const char * failure, axlPointer user_data)
+{
+	axlDoc          * child_doc;
+	ModRadminStream * stream = user_data;
+	axlError        * err = NULL;
+	axlNode         * child_node;
+	axlNode         * aux;
+	axlNode         * column;
+	int               conn_id;
+	int               last_id  = -1;
+	axl_bool          accepted = axl_false;
+
+	/* child did not reply, report it */
+	if (content == NULL) {
+		mod_radmin_stream_add_failed (stream, pid, failure);
+		return;
+	} /* end if */
 
 	/* parse child doc */
 	child_doc = axl_doc_parse (content, -1, &err);
@@ -534,140 +1363,135 @@ void mod_radmin_child_show_connections_handler (TurbulenceCtx * ctx, const char
 		return;
 	} /* end if */
 
-	/* get reference to first connection row */
+	/* get reference to first row */
 	child_node = axl_doc_get (child_doc, "/table/content/row");
-	node       = axl_doc_get (doc, "/table/content");
 	while (child_node) {
 		/* configure current pointer and get next */
 		aux = axl_node_get_next_called (child_node, "row");
 
-		/* move child_node from document */
-		child_node = axl_node_copy (child_node, axl_true, axl_true);
+		/* get conn id (second column) */
+		column  = axl_node_get_child_called (child_node, "d");
+		column  = column ? axl_node_get_next_called (column, "d") : NULL;
+		conn_id = column ? atoi (axl_node_get_content (column, NULL)) : -1;
 
-		/* set as child of the parent document */
-		axl_node_set_child (node, child_node);
+		/* check cursor and limit once per connection */
+		if (conn_id != last_id) {
+			accepted = mod_radmin_stream_accept (stream, pid, conn_id);
+			last_id  = conn_id;
+		} /* end if */
+
+		/* move child_node into the stream */
+		if (accepted)
+			mod_radmin_stream_push (stream, axl_node_copy (child_node, axl_true, axl_true));
 		
 		/* next node */
 		child_node = aux;
 	}
 
+	/* child reached the limit: more rows may be available */
+	if (axl_doc_get (child_doc, "/table/cursor"))
+		stream->more = axl_true;
+
 	/* free document parsed */
 	axl_doc_free (child_doc);
 
 	return;
 }
-				       
 
-axlDoc * mod_radmin_command_show_connections (const char * line, axlPointer user_data, axl_bool * status)
+/** 
+ * @internal qsort comparison used to order connections by id.
+ */
+int mod_radmin_conn_cmp (const void * a, const void * b)
 {
-	axlDoc           * doc;
-	axlError         * err       = NULL;
-	axlList          * conn_list = NULL;
-	axlNode          * node;
-	axlNode          * content;
-	axlListCursor    * cursor;
-	VortexConnection * conn;
-	const char       * role;
-	long               bytes_sent;
-	long               bytes_recv;
-	long               activity_stamp;
-	char             * time_str;
+	return vortex_connection_get_id (*(VortexConnection **) a) - vortex_connection_get_id (*(VortexConnection **) b);
+}
 
-	/* get the list of connections */
-	conn_list = turbulence_conn_mgr_conn_list (ctx, -1, NULL);
-	
-	if (conn_list == NULL) {
-		(* status) = axl_false;
-		return NULL;
-	} /* end if */
+/** 
+ * @internal Returns connections registered on the current process
+ * ordered by connection id (references are owned by the list
+ * returned, which must be released by the caller with axl_list_free).
+ */
+VortexConnection ** mod_radmin_conn_list_sorted (axlList * conn_list, int * length)
+{
+	VortexConnection ** conns;
+	int                 iterator;
 
-	/* result document */
-	doc = axl_doc_parse_strings (&err, 
-				     "<table>",
-				     " <title>Connection list</title>",
-				     " <column-description>",
-				     "   <column name='proc-id' description='Process ID' />",
-				     "   <column name='conn-id' description='Conn ID' />",
-				     "   <column name='role' description='Connection role' />",
-				     "   <column name='source' description='Source' />",
-				     "   <column name='dest' description='Source' />",
-				     "   <column name='channels opened' description='Channels opened' />",
-				     "   <column name='ppath' description='Profile path' />",
-				     "   <column name='auth id' description='Auth id on this connection or - if not selected' />",
-				     "   <column name='last activity' description='When was last activity detected on this connection' />",
-				     "   <column name='bytes recv' description='Bytes received on this connection' />",
-				     "   <column name='bytes sent' description='Bytes sent on this connection' />",
-				     " </column-description>",
-				     " <content></content>",
-				     "</table>", NULL);
+	(*length) = axl_list_length (conn_list);
+	conns     = axl_new (VortexConnection *, (*length) + 1);
+	for (iterator = 0; iterator < (*length); iterator++)
+		conns[iterator] = axl_list_get_nth (conn_list, iterator);
+	qsort (conns, (*length), sizeof (VortexConnection *), mod_radmin_conn_cmp);
 
-	if (doc == NULL) {
-		/* free list */
-		axl_list_free (conn_list);
+	return conns;
+}
 
+/** 
+ * @internal Common listing implementation for show connections and
+ * show channels: reports local connections (filtered and ordered)
+ * and, at the master process, merges rows from childs.
+ */
+axlDoc * mod_radmin_list (const char * command, const char * args, axlDoc * header, 
+			  void (*add_rows) (ModRadminStream * stream, VortexConnection * conn),
+			  VortexChannel * channel, int msg_no, axl_bool * status)
+{
+	axlList             * conn_list;
+	VortexConnection   ** conns;
+	ModRadminListFilter * filter;
+	ModRadminStream     * stream;
+	axlDoc              * doc;
+	char                * child_cmd;
+	int                   length;
+	int                   iterator;
+
+	/* parse arguments */
+	filter = mod_radmin_list_filter_parse (args);
+	if (filter == NULL) {
+		axl_doc_free (header);
 		(* status) = axl_false;
-		return NULL;
+		return mod_radmin_error_msg (550, "Unknown or malformed argument. Allowed: ppath=<name> profile=<uri> remote=<addr> idle=<secs> from=<pid>:<conn-id> limit=<n>");
 	} /* end if */
 
-	/* get the content node and populate it */
-	content = axl_doc_get (doc, "/table/content");
-	cursor  = axl_list_cursor_new (conn_list);
-	while (axl_list_cursor_has_item (cursor)) {
-
-		/* get item */
-		conn = axl_list_cursor_get (cursor);
+	/* get the list of connections */
+	conn_list = turbulence_conn_mgr_conn_list (ctx, -1, NULL);
+	if (conn_list == NULL) {
+		axl_doc_free (header);
+		mod_radmin_list_filter_free (filter);
+		(* status) = axl_false;
+		/* NULL would mean results were already streamed */
+		return mod_radmin_error_msg (550, "Unable to get the connection list");
+	} /* end if */
 
-		role = mod_radmin_role_to_string (vortex_connection_get_role (conn));
+	/* from now on, report rows */
+	stream = mod_radmin_stream_new (channel, msg_no, filter, header);
 
-		/* get connection activity status */
-		vortex_connection_get_receive_stamp (conn, &bytes_recv, &bytes_sent, &activity_stamp);
-		if (activity_stamp == 0)
-			time_str = axl_strdup ("-");
-		else
-			time_str = axl_strdup (ctime (&activity_stamp));
-		axl_stream_trim (time_str);
-
-		/* build node */
-		node = axl_node_parse (NULL, "<row><d>%d</d><d>%d</d><d>%s</d><d>%s:%s</d><d>%s:%s</d><d>%d</d><d>%s</d><d>%s</d><d>%s</d><d>%ld</d><d>%ld</d></row>", 
-				       vortex_getpid (),
-				       vortex_connection_get_id (conn),
-				       role,
-				       vortex_connection_get_host (conn), vortex_connection_get_port (conn),
-				       vortex_connection_get_local_addr (conn), vortex_connection_get_local_port (conn),
-				       vortex_connection_channels_count (conn),
-				       /* ppath */
-				       turbulence_ppath_selected (conn) ? turbulence_ppath_get_name (turbulence_ppath_selected (conn)) : "-",
-				       /* user (if any) */
-				       AUTH_ID_FROM_CONN (conn) ? AUTH_ID_FROM_CONN (conn) : "-",
-				       /* last activity */
-				       time_str,
-				       /* bytes received */
-				       bytes_recv,
-				       /* bytes_sent */
-				       bytes_sent);
-
-		/* free time string */
-		axl_free (time_str);
-				       
-		/* add node to the content */
-		axl_node_set_child (content, node);
-		
-		/* next item */
-		axl_list_cursor_next (cursor);
-	}
+	/* report local connections in connection id order */
+	conns = mod_radmin_conn_list_sorted (conn_list, &length);
+	for (iterator = 0; iterator < length; iterator++) {
+		if (! mod_radmin_list_filter_match (filter, conns[iterator]))
+			continue;
+		if (! mod_radmin_stream_accept (stream, vortex_getpid (), vortex_connection_get_id (conns[iterator])))
+			continue;
+		add_rows (stream, conns[iterator]);
+	} /* end for */
 
-	/* free list and cursor */
-	axl_list_cursor_free (cursor);
+	/* free list and sorted copy */
+	axl_free (conns);
 	axl_list_free (conn_list);
 
-	/* now get connections on childs */
+	/* now get rows from childs (ordered by pid) */
 	if (! turbulence_ctx_is_child (ctx)) {
-		/* get connectiosn from childs */
-		msg ("Getting connections from childs..");
-		mod_radmin_run_command_on_childs (ctx, "show connections", 
-						  mod_radmin_child_show_connections_handler, doc);
+		msg ("Getting %s from childs..", command);
+		/* local rows are sent before childs are queried */
+		mod_radmin_stream_flush (stream);
+		child_cmd = axl_strdup_printf ("%s %s", command, filter->args);
+		mod_radmin_run_command_on_childs (ctx, child_cmd, MOD_RADMIN_CHILD_COMMAND_TIMEOUT,
+						  mod_radmin_child_listing_handler, stream);
+		axl_free (child_cmd);
 	} /* end if */
-	
+
+	/* finish listing */
+	doc = mod_radmin_stream_finish (stream);
+	mod_radmin_list_filter_free (filter);
 
 	/* signal command returned proper status */
 	(*status) = axl_true;
@@ -675,12 +1499,102 @@ axlDoc * mod_radmin_command_show_connections (const char * line, axlPointer user
 	return doc;
 }
 
-axl_bool mod_radmin_command_show_channels_foreach (axlPointer key, axlPointer data, axlPointer user_data)
+void mod_radmin_show_connections_add_rows (ModRadminStream * stream, VortexConnection * conn)
 {
-	axlNode          * content = user_data;
 	axlNode          * node;
-	VortexChannel    * channel = data;
-	VortexConnection * conn = vortex_channel_get_connection (channel);
+	const char       * role;
+	long               bytes_sent;
+	long               bytes_recv;
+	long               activity_stamp;
+	char             * time_str;
+
+	role = mod_radmin_role_to_string (vortex_connection_get_role (conn));
+
+	/* get connection activity status */
+	vortex_connection_get_receive_stamp (conn, &bytes_recv, &bytes_sent, &activity_stamp);
+	if (activity_stamp == 0)
+		time_str = axl_strdup ("-");
+	else
+		time_str = axl_strdup (ctime (&activity_stamp));
+	axl_stream_trim (time_str);
+
+	/* build node */
+	node = axl_node_parse (NULL, "<row><d>%d</d><d>%d</d><d>%s</d><d>%s:%s</d><d>%s:%s</d><d>%d</d><d>%s</d><d>%s</d><d>%s</d><d>%ld</d><d>%ld</d><d>%d</d></row>", 
+			       vortex_getpid (),
+			       vortex_connection_get_id (conn),
+			       role,
+			       vortex_connection_get_host (conn), vortex_connection_get_port (conn),
+			       vortex_connection_get_local_addr (conn), vortex_connection_get_local_port (conn),
+			       vortex_connection_channels_count (conn),
+			       /* ppath */
+			       turbulence_ppath_selected (conn) ? turbulence_ppath_get_name (turbulence_ppath_selected (conn)) : "-",
+			       /* user (if any) */
+			       AUTH_ID_FROM_CONN (conn) ? AUTH_ID_FROM_CONN (conn) : "-",
+			       /* last activity */
+			       time_str,
+			       /* bytes received */
+			       bytes_recv,
+			       /* bytes_sent */
+			       bytes_sent,
+			       /* memory reserved by the connection arena */
+			       turbulence_conn_mgr_get_bytes (conn));
+
+	/* free time string */
+	axl_free (time_str);
+				       
+	/* add node to the listing */
+	mod_radmin_stream_push (stream, node);
+	return;
+}
+
+axlDoc * mod_radmin_show_connections_header (void)
+{
+	return axl_doc_parse_strings (NULL, 
+				      "<table>",
+				      " <title>Connection list</title>",
+				      " <column-description>",
+				      "   <column name='proc-id' description='Process ID' />",
+				      "   <column name='conn-id' description='Conn ID' />",
+				      "   <column name='role' description='Connection role' />",
+				      "   <column name='source' description='Source' />",
+				      "   <column name='dest' description='Source' />",
+				      "   <column name='channels opened' description='Channels opened' />",
+				      "   <column name='ppath' description='Profile path' />",
+				      "   <column name='auth id' description='Auth id on this connection or - if not selected' />",
+				      "   <column name='last activity' description='When was last activity detected on this connection' />",
+				      "   <column name='bytes recv' description='Bytes received on this connection' />",
+				      "   <column name='bytes sent' description='Bytes sent on this connection' />",
+				      "   <column name='memory' description='Bytes reserved by the connection arena' />",
+				      " </column-description>",
+				      " <content></content>",
+				      "</table>", NULL);
+}
+
+/** 
+ * @internal Streamed implementation of show connections (master
+ * process).
+ */
+axlDoc * mod_radmin_command_show_connections (const char * line, VortexChannel * channel, int msg_no, axl_bool * status)
+{
+	return mod_radmin_list ("show connections", line, mod_radmin_show_connections_header (), 
+				mod_radmin_show_connections_add_rows, channel, msg_no, status);
+}
+
+typedef struct _ModRadminChannelRows {
+	ModRadminStream * stream;
+	const char      * profile;
+} ModRadminChannelRows;
+
+axl_bool mod_radmin_command_show_channels_foreach (axlPointer key, axlPointer data, axlPointer user_data)
+{
+	ModRadminChannelRows * rows = user_data;
+	axlNode              * node;
+	VortexChannel        * channel = data;
+	VortexConnection     * conn = vortex_channel_get_connection (channel);
+
+	/* check profile filter */
+	if (rows->profile && ! axl_casecmp (vortex_channel_get_profile (channel), rows->profile))
+		return axl_false; /* do not stop foreach process */
 
 	/* build node */
 	node = axl_node_parse (NULL, "<row><d>%d</d><d>%d</d><d>%d</d><d>%s</d><d>%s</d><d>%s</d></row>", 
@@ -697,92 +1611,59 @@ axl_bool mod_radmin_command_show_channels_foreach (axlPointer key, axlPointer da
 			       /* send-ready */
 			       vortex_channel_is_ready (channel) ? "ready" : "busy");
 
-	/* add node to the content */
-	axl_node_set_child (content, node);
+	/* add node to the listing */
+	mod_radmin_stream_push (rows->stream, node);
 	
 	return axl_false; /* do not stop foreach process */
 }
 
-axlDoc * mod_radmin_command_show_channels (const char * line, axlPointer user_data, axl_bool * status)
+void mod_radmin_show_channels_add_rows (ModRadminStream * stream, VortexConnection * conn)
 {
-	axlDoc           * doc;
-	axlError         * err       = NULL;
-	axlList          * conn_list = NULL;
-	axlNode          * content;
-	axlListCursor    * cursor;
-	VortexConnection * conn;
-
-	/* get the list of connections */
-	conn_list = turbulence_conn_mgr_conn_list (ctx, -1, NULL);
-	
-	if (conn_list == NULL) {
-		(* status) = axl_false;
-		return NULL;
-	} /* end if */
-
-	/* result document */
-	doc = axl_doc_parse_strings (&err, 
-				     "<table>",
-				     " <title>Connection list</title>",
-				     " <column-description>",
-				     "   <column name='proc-id' description='Process ID' />",
-				     "   <column name='conn-id' description='Conn ID' />",
-				     "   <column name='chann num' description='Channel number' />",
-				     "   <column name='profile' description='Source' />",
-				     "   <column name='recv-ready' description='Ready to receive' />",
-				     "   <column name='send-ready' description='Ready to send' />",
-				     " </column-description>",
-				     " <content></content>",
-				     "</table>", NULL);
-
-	if (doc == NULL) {
-		/* free list */
-		axl_list_free (conn_list);
-
-		(* status) = axl_false;
-		return NULL;
-	} /* end if */
-
-	/* get the content node and populate it */
-	content = axl_doc_get (doc, "/table/content");
-	cursor  = axl_list_cursor_new (conn_list);
-	while (axl_list_cursor_has_item (cursor)) {
-
-		/* get item */
-		conn = axl_list_cursor_get (cursor);
-
-		/* skip master listeners */
-		if (vortex_connection_get_role (conn) == VortexRoleMasterListener) {
-			axl_list_cursor_next (cursor);
-			continue;
-		}
+	ModRadminChannelRows rows;
 
-		/* add separator to see channels from same connection */
-		axl_node_set_child (content, axl_node_parse (NULL, "<row><d></d><d></d><d></d><d>---- conn-id: %d from: %s:%s ----</d><d></d><d></d></row>", 
-							     vortex_connection_get_id (conn), vortex_connection_get_host (conn), vortex_connection_get_port (conn)));
-
-		/* now, for each connection, show each channel */
-		vortex_connection_foreach_channel (conn, mod_radmin_command_show_channels_foreach, content);
-
-		/* next item */
-		axl_list_cursor_next (cursor);
-	}
+	/* skip master listeners */
+	if (vortex_connection_get_role (conn) == VortexRoleMasterListener) 
+		return;
 
-	/* free list and cursor */
-	axl_list_cursor_free (cursor);
-	axl_list_free (conn_list);
+	/* add separator to see channels from same connection (proc-id
+	 * and conn-id are kept to allow merging rows from childs) */
+	mod_radmin_stream_push (stream, axl_node_parse (NULL, "<row><d>%d</d><d>%d</d><d></d><d>---- conn-id: %d from: %s:%s ----</d><d></d><d></d></row>", 
+							vortex_getpid (), vortex_connection_get_id (conn),
+							vortex_connection_get_id (conn), vortex_connection_get_host (conn), vortex_connection_get_port (conn)));
 
-	/* now get connections on childs */
-	if (! turbulence_ctx_is_child (ctx)) {
-		/* now get channels from childs */
-		mod_radmin_run_command_on_childs (ctx, "show channels", 
-						  mod_radmin_child_show_connections_handler, doc);
-	} /* end if */
+	/* now, for each connection, show each channel */
+	rows.stream  = stream;
+	rows.profile = stream->filter->profile;
+	vortex_connection_foreach_channel (conn, mod_radmin_command_show_channels_foreach, &rows);
+	return;
+}
 
-	/* signal command returned proper status */
-	(*status) = axl_true;
+axlDoc * mod_radmin_show_channels_header (void)
+{
+	return axl_doc_parse_strings (NULL, 
+				      "<table>",
+				      " <title>Connection list</title>",
+				      " <column-description>",
+				      "   <column name='proc-id' description='Process ID' />",
+				      "   <column name='conn-id' description='Conn ID' />",
+				      "   <column name='chann num' description='Channel number' />",
+				      "   <column name='profile' description='Source' />",
+				      "   <column name='recv-ready' description='Ready to receive' />",
+				      "   <column name='send-ready' description='Ready to send' />",
+				      " </column-description>",
+				      " <content></content>",
+				      "</table>", NULL);
+}
 
-	return doc;
+/** 
+ * @internal Streamed implementation of show channels (master
+ * process). Limit and cursor apply to connections: all channels of a
+ * connection are reported on the same page.
+ */
+axlDoc * mod_radmin_command_show_channels (const char * line, VortexChannel * channel, int msg_no, axl_bool * status)
+{
+	return mod_radmin_list ("show channels", line, mod_radmin_show_channels_header (), 
+				mod_radmin_show_channels_add_rows, channel, msg_no, status);
 }
 
 
@@ -795,11 +1676,13 @@ axl_bool mod_radmin_add_childs (axlPointer item, axlPointer user_data)
 	msg ("Adding child..");
 
 	/* add child process */
-	node = axl_node_parse (NULL, "<row><d>%d</d><d>%s</d><d>%d</d><d>%s</d></row>", 
+	node = axl_node_parse (NULL, "<row><d>%d</d><d>%s</d><d>%d</d><d>%s</d><d>%s</d><d>%d</d></row>", 
 			       child->pid,
 			       "child",
 			       -1,
-			       turbulence_ppath_get_name (child->ppath));
+			       turbulence_ppath_get_name (child->ppath),
+			       child->affinity ? child->affinity : "",
+			       child->numa_node);
 	axl_node_set_child (content, node);
 
 	return axl_false; /* keep foreach loop */
@@ -823,6 +1706,8 @@ axlDoc * mod_radmin_command_show_childs (const char * line, axlPointer user_data
 				     "   <column name='proc-type' description='Process type' />",
 				     "   <column name='conn-num' description='Connections handled by the process' />",
 				     "   <column name='profile-path' description='Profile path selected for the process' />",
+				     "   <column name='cpu-affinity' description='Cpus the process is bound to (empty if not bound)' />",
+				     "   <column name='numa-node' description='NUMA node the process prefers memory from (-1 if not set)' />",
 				     " </column-description>",
 				     " <content></content>",
 				     "</table>", NULL);
@@ -847,11 +1732,11 @@ axlDoc * mod_radmin_command_show_childs (const char * line, axlPointer user_data
 	connection_number = axl_list_length (childs);
 
 	/* add master process */
-	node = axl_node_parse (NULL, "<row><d>%d</d><d>%s</d><d>%d</d><d>%s</d></row>",
+	node = axl_node_parse (NULL, "<row><d>%d</d><d>%s</d><d>%d</d><d>%s</d><d>%s</d><d>%d</d></row>",
 			       vortex_getpid (),
 			       "master",
 			       connection_number,
-			       "");
+			       "", "", -1);
 	axl_node_set_child (content, node);
 
 	/* iterate all childs declared */
@@ -1110,6 +1995,35 @@ void mod_radmin_install_command (const char               * command,
 	return;
 }
 
+/** 
+ * @internal Function used to install commands that stream their
+ * results (see \ref ModRadminStreamCommandHandler).
+ */
+void mod_radmin_install_stream_command (const char                    * command, 
+					const char                    * description,
+					ModRadminStreamCommandHandler   handler)
+{
+	ModRadminCommandItem * cmd;
+
+	/* lock mutex */
+	vortex_mutex_lock (&commands_mutex);
+
+	/* create command handler */
+	cmd                 = axl_new (ModRadminCommandItem, 1);
+	cmd->command        = axl_strdup (command);
+	cmd->length         = strlen (command);
+	cmd->description    = axl_strdup (description);
+	cmd->stream_handler = handler;
+
+	/* install it */
+	axl_list_append (commands, cmd);
+
+	/* unlock mutex */
+	vortex_mutex_unlock (&commands_mutex);
+	
+	return;
+}
+
 /** 
  * @internal Function that install default support commands for remote
  * admin.
@@ -1125,12 +2039,12 @@ void mod_radmin_install_default_commands (void) {
 	mod_radmin_install_command ("kill conn", 
 				    "Allows to terminate the provided connection on the selected process:\n               Usage:\n                 > kill conn [pid:conn-id]\n                 Get connection ids (conn-id) and pids using:\n                 > show connections", 
 				    mod_radmin_command_kill_connection, NULL);
-	mod_radmin_install_command ("show connections",
-				    "Allows to get all connections being handled by turbulence at this moment", 
-				    mod_radmin_command_show_connections, NULL);
-	mod_radmin_install_command ("show channels",
-				    "Allows to get all channels being handled by turbulence at this moment", 
-				    mod_radmin_command_show_channels, NULL);
+	mod_radmin_install_stream_command ("show connections",
+					   "Allows to get all connections being handled by turbulence at this moment:\n               Usage:\n                 > show connections [ppath=<name>] [profile=<uri>] [remote=<addr>] [idle=<secs>] [limit=<n>] [from=<pid>:<conn-id>]", 
+					   mod_radmin_command_show_connections);
+	mod_radmin_install_stream_command ("show channels",
+					   "Allows to get all channels being handled by turbulence at this moment:\n               Usage:\n                 > show channels [ppath=<name>] [profile=<uri>] [remote=<addr>] [idle=<secs>] [limit=<n>] [from=<pid>:<conn-id>]", 
+					   mod_radmin_command_show_channels);
 	mod_radmin_install_command ("kill child", 
 				    "Allows to terminate the child identified with the provided pid:\n               Usage:\n                 > kill child [pid]\n                 Get child pids using:\n                 > show childs", 
 				    mod_radmin_command_kill_child, NULL);
@@ -1261,15 +2175,15 @@ void mod_radmin_internal_frame_received  (VortexChannel    * channel,
 	} /* end if */
 	
 	/* check command */
-	if (axl_cmp ("show connections", command)) {
-		/* reuse function */
-		doc = mod_radmin_command_show_connections (NULL, NULL, &status);
+	if (axl_memcmp ("show connections", command, 16)) {
+		/* reuse function (filters are received after the command) */
+		doc = mod_radmin_command_show_connections (command + 16, NULL, 0, &status);
 
 		/* now handle reply */
 		mod_radmin_handle_command_reply (status, doc, conn, channel, frame);
-	} else if (axl_cmp ("show channels", command)) {
-		/* reuse function */
-		doc = mod_radmin_command_show_channels (NULL, NULL, &status);
+	} else if (axl_memcmp ("show channels", command, 13)) {
+		/* reuse function (filters are received after the command) */
+		doc = mod_radmin_command_show_channels (command + 13, NULL, 0, &status);
 
 		/* now handle reply */
 		mod_radmin_handle_command_reply (status, doc, conn, channel, frame);
@@ -1300,6 +2214,10 @@ static int  mod_radmin_init (TurbulenceCtx * _ctx) {
 		/* init commands support */
 		commands = axl_list_new (axl_list_always_return_1, mod_radmin_command_item_free);
 		vortex_mutex_create (&commands_mutex);
+
+		/* init calls pending reply from childs */
+		pending_calls = axl_hash_new (axl_hash_int, axl_hash_equal_int);
+		vortex_mutex_create (&pending_calls_mutex);
 	
 		/* install default commands */
 		mod_radmin_install_default_commands ();
@@ -1340,6 +2258,10 @@ static void mod_radmin_close (TurbulenceCtx * _ctx) {
 	/* terminate mutex */
 	vortex_mutex_destroy (&commands_mutex);
 
+	/* terminate calls pending reply */
+	axl_hash_free (pending_calls);
+	vortex_mutex_destroy (&pending_calls_mutex);
+
 	/* unregister profile */
 	vortex_profiles_unregister (turbulence_ctx_get_vortex_ctx (_ctx), RADMIN_URI);
 
@@ -1483,6 +2405,26 @@ TurbulenceModDef module_def = {
  * 28702     7         listener   127.0.0.1:43022   127.0.0.1:602   3                 core-admin     -         Tue Aug 23 17:17:58 2011   1041         603     
  * \endcode
  *
+ * Listings (show connections and show channels) are streamed as they
+ * are produced (local connections first, then childs ordered by
+ * pid) and accept the following filters, evaluated by each process:
+ *
+ * - <b>ppath=name</b>: only connections handled by the provided profile path.
+ * - <b>profile=uri</b>: only connections with a channel running the provided profile.
+ * - <b>remote=addr</b>: only connections whose remote address starts with the value provided.
+ * - <b>idle=secs</b>: only connections without activity during the provided number of seconds.
+ * - <b>limit=n</b>: report at most n connections. When more are available, a cursor is reported.
+ * - <b>from=pid:conn-id</b>: cursor returned by a previous limited listing to get the next page.
+ *
+ * \code
+ * tbc-ctl:localhost:602> show connections ppath=core-admin limit=50
+ * \endcode
+ *
+ * Childs that do not reply before the command deadline are reported
+ * with a row marked "child did not reply in time", and childs the
+ * command could not be sent to (broken internal channel) with a row
+ * marked "child command could not be sent".
+ *
  * Write "help" or press to autocomplete two times to get commands autocompleted.
  *
  * \section turbulence_mod_radmin_problems Usual problems found while using mod-radmin
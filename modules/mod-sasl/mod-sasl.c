@@ -41,6 +41,8 @@ SaslAuthBackend * sasl_backend     = NULL;
 VortexMutex       sasl_db_mutex;
 VortexMutex       sasl_top_mutex;
 TurbulenceCtx   * ctx              = NULL;
+TurbulenceMetric * sasl_auth_ok     = NULL;
+TurbulenceMetric * sasl_auth_failed = NULL;
 
 axlPointer      mod_sasl_validation  (VortexConnection * connection,
 				      VortexSaslProps  * props,
@@ -63,12 +65,14 @@ axlPointer      mod_sasl_validation  (VortexConnection * connection,
 					   props->password,
 					   serverName,
 					   &sasl_db_mutex)) {
+			turbulence_metric_inc (sasl_auth_ok, 1);
 			return INT_TO_PTR (axl_true);
 		} /* end if */
 	} /* end if */
 
         /* deny SASL request to authenticate remote peer */
 	error ("auth failed for auth_id=%s", props->auth_id);
+	turbulence_metric_inc (sasl_auth_failed, 1);
         return INT_TO_PTR (axl_false);
 }
 
@@ -149,6 +153,12 @@ static int  mod_sasl_init (TurbulenceCtx * _ctx)
 	vortex_mutex_create (&sasl_db_mutex);
 	vortex_mutex_create (&sasl_top_mutex);
 
+	/* register SASL outcome counters */
+	sasl_auth_ok     = turbulence_metrics_get (ctx, TBC_METRIC_COUNTER, "turbulence_sasl_auth_total", 
+						   "result=\"ok\"", "SASL authentication outcomes");
+	sasl_auth_failed = turbulence_metrics_get (ctx, TBC_METRIC_COUNTER, "turbulence_sasl_auth_total", 
+						   "result=\"failed\"", "SASL authentication outcomes");
+
 	return axl_true;
 }
 
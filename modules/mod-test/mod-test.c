@@ -45,8 +45,30 @@ BEGIN_C_DECLS
 #define MOD_TEST_URI3 "http://turbulence.ws/profiles/test3"
 #define MOD_TEST_URI4 "http://turbulence.ws/profiles/test4"
 
+/* replies each message with its content (used by tbc-bench) */
+#define MOD_TEST_ECHO_URI "http://turbulence.ws/profiles/echo"
+
 TurbulenceCtx * ctx = NULL;
 
+/** 
+ * @brief Frame received handler for the echo profile: replies each
+ * message received with the same content.
+ */
+static void test_echo_frame_received (VortexChannel    * channel,
+				      VortexConnection * conn,
+				      VortexFrame      * frame,
+				      axlPointer         user_data)
+{
+	if (vortex_frame_get_type (frame) != VORTEX_FRAME_TYPE_MSG)
+		return;
+
+	vortex_channel_send_rpy (channel, 
+				 vortex_frame_get_payload (frame), 
+				 vortex_frame_get_payload_size (frame), 
+				 vortex_frame_get_msgno (frame));
+	return;
+}
+
 /** 
  * @brief Init function, perform all the necessary code to register
  * profiles, configure Vortex, and any other init task. The function
@@ -88,6 +110,13 @@ static int  test_init (TurbulenceCtx * _ctx)
 				  NULL, NULL,
 				  NULL, NULL);
 
+	/* echo profile */
+	vortex_profiles_register (TBC_VORTEX_CTX (ctx),
+				  MOD_TEST_ECHO_URI,
+				  NULL, NULL,
+				  NULL, NULL,
+				  test_echo_frame_received, NULL);
+
 	return axl_true;
 }
 
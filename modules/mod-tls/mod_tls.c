@@ -38,9 +38,29 @@
 /* mod_tls implementation */
 #include <turbulence.h>
 
+/* serverName matching of <certificate-select> */
+#include <mod_tls_select.h>
+
 /* include support for tls */
 #include <vortex_tls.h>
 #include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <openssl/pem.h>
+#include <openssl/rand.h>
+#include <openssl/evp.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+/* HMAC_CTX ticket callback is deprecated: EVP_MAC based one is used */
+#include <openssl/core_names.h>
+#define MOD_TLS_TICKET_HMAC_CTX EVP_MAC_CTX
+#else
+#include <openssl/hmac.h>
+#define MOD_TLS_TICKET_HMAC_CTX HMAC_CTX
+#endif
+
+#if defined(AXL_OS_UNIX)
+#include <sys/mman.h>
+#include <fcntl.h>
+#endif
 
 /* use this declarations to avoid c++ compilers to mangle exported
  * names. */
@@ -52,6 +72,143 @@ TurbulenceCtx * ctx = NULL;
 /* reference to the module configuration */
 axlDoc * mod_tls_conf = NULL;
 
+/** 
+ * @internal Max size (DER encoded) of a session that fits into a
+ * shared cache slot. Bigger sessions (for example those carrying a
+ * long client certificate chain) are not cached.
+ */
+#define MOD_TLS_SESSION_DER_SIZE 2048
+
+/** 
+ * @internal Default values for the <session-cache> declaration.
+ */
+#define MOD_TLS_SESSION_CACHE_SIZE 1024
+#define MOD_TLS_SESSION_CACHE_TTL  300
+
+/** 
+ * @internal Default period (in seconds) to check if certificate or
+ * private key files changed (see <certificate-reload>).
+ */
+#define MOD_TLS_RELOAD_PERIOD 60
+
+/** 
+ * @internal One entry of the shared session cache.
+ */
+typedef struct _ModTlsSessionSlot {
+	unsigned char id[SSL_MAX_SSL_SESSION_ID_LENGTH];
+	int           id_length;
+	long          expires;
+	int           length;
+	unsigned char der[MOD_TLS_SESSION_DER_SIZE];
+} ModTlsSessionSlot;
+
+/** 
+ * @internal Header placed at the start of the shared session cache
+ * file. Slots follow it. Handshake counters are kept here so they
+ * are aggregated across the master and all childs.
+ */
+typedef struct _ModTlsSessionHeader {
+	int  size;
+	int  ttl;
+	long full_handshakes;
+	long resumed_handshakes;
+} ModTlsSessionHeader;
+
+/** 
+ * @internal Session ticket key as declared by <ticket-key>: 16
+ * bytes of name, 16 bytes of HMAC secret and 16 bytes of AES key.
+ */
+typedef struct _ModTlsTicketKey {
+	unsigned char name[16];
+	unsigned char hmac_key[16];
+	unsigned char aes_key[16];
+} ModTlsTicketKey;
+
+/** 
+ * @internal File identity checked to detect certificate changes:
+ * modification time alone has a one second resolution, so a file
+ * replaced twice within the same second is also told by its size or
+ * inode (a file moved into place).
+ */
+typedef struct _ModTlsFileStamp {
+	long mtime;
+	long size;
+	long inode;
+} ModTlsFileStamp;
+
+/** 
+ * @internal Certificate (and chain) and private key already parsed,
+ * ready to be attached to each SSL_CTX created. It is replaced when
+ * files change (see mod_tls_reload_check) while handshakes may still
+ * use the previous one, so it is reference counted and taken with
+ * mod_tls_material_get.
+ */
+typedef struct _ModTlsMaterial {
+	int               ref_count;
+	X509            * x509;
+	STACK_OF(X509)  * chain;
+	EVP_PKEY        * pkey;
+	/* identity of files parsed (zeroed if preloaded) */
+	ModTlsFileStamp   cert_stamp;
+	ModTlsFileStamp   key_stamp;
+} ModTlsMaterial;
+
+/** 
+ * @internal <certificate-select> declaration compiled into the
+ * configuration snapshot (see mod_tls_certificates_build).
+ */
+typedef struct _ModTlsCertificate {
+	char           * serverName;
+	char           * cert;
+	char           * key;
+	/* content preloaded at childs (NULL if not preloaded) */
+	char           * content_cert;
+	char           * content_key;
+	/* files found for cert and key (NULL at childs) */
+	char           * cert_file;
+	char           * key_file;
+	/* material parsed (protected by mod_tls_material_mutex) */
+	ModTlsMaterial * material;
+	axl_bool         close_on_failure;
+	axl_bool         close_on_failure_declared;
+} ModTlsCertificate;
+
+/** 
+ * @internal All <certificate-select> declarations indexed by
+ * serverName.
+ */
+typedef struct _ModTlsCertificates {
+	/* serverName -> declaration (see mod_tls_select_lookup) */
+	ModTlsSelect      * selection;
+	/* all declarations (owns them) */
+	axlList           * all;
+} ModTlsCertificates;
+
+/* shared session cache state */
+int                   mod_tls_cache_fd      = -1;
+ModTlsSessionHeader * mod_tls_cache         = NULL;
+ModTlsSessionSlot   * mod_tls_cache_slots   = NULL;
+long                  mod_tls_cache_length  = 0;
+VortexMutex           mod_tls_cache_mutex;
+
+/* session tickets state: first key issues tickets, the rest are
+ * only accepted */
+ModTlsTicketKey     * mod_tls_ticket_keys   = NULL;
+int                   mod_tls_ticket_keys_num = 0;
+axl_bool              mod_tls_tickets       = axl_false;
+VortexMutex           mod_tls_ticket_mutex;
+
+/* handshake counters for this process */
+long                  mod_tls_full_handshakes    = 0;
+long                  mod_tls_resumed_handshakes = 0;
+VortexMutex           mod_tls_stats_mutex;
+
+/* parsed material and background reload of changed files */
+VortexMutex           mod_tls_material_mutex;
+VortexThread          mod_tls_reload_thread;
+VortexAsyncQueue    * mod_tls_reload_queue  = NULL;
+int                   mod_tls_reload_period = MOD_TLS_RELOAD_PERIOD;
+
 /** 
  * @internal Load tls.conf file.
  */
@@ -94,55 +251,313 @@ axl_bool mod_tls_accept_query (VortexConnection * conn,
 	return axl_true;
 }
 
-axlNode * mod_tls_find_certificate_node (VortexConnection * conn, const char * serverName)
+/** 
+ * @internal Finds the file pointed by a cert or key attribute: full
+ * paths are used as is, the rest are looked up at tls locations.
+ */
+char * mod_tls_resolve_file (const char * path, const char * name)
 {
-	axlNode * node = axl_doc_get (mod_tls_conf, "/mod-tls/certificate-select");
+	char * file;
 
-	msg ("Finding certificate/key material for serverName=%s conn-id=%d",
-	     serverName ? serverName : "N/A", vortex_connection_get_id (conn));
+	if (path == NULL)
+		return NULL;
 
-	while (node) {
+	/* check if the file is relativate or full path */
+	if (! turbulence_file_is_fullpath (path)) {
+		file = vortex_support_domain_find_data_file (TBC_VORTEX_CTX (ctx), "tls", path);
+		if (file == NULL) {
+			error ("Unable to find %s file %s under configured directories", name, path);
+			return NULL;
+		}
+	} else {
+		/* seems path is absolute, return full path */
+		if (! vortex_support_file_test (path, FILE_EXISTS)) {
+			error ("File %s do not exists, failed to return %s", path, name);
+			return NULL;
+		}
+		/* file exists, copy it */
+		file = axl_strdup (path);
+	}	
+
+	return file;
+}
+
+/** 
+ * @internal Fills the identity of the provided file (zeroed if it
+ * can't be accessed).
+ */
+void mod_tls_file_stamp (const char * file, ModTlsFileStamp * stamp)
+{
+	struct stat buf;
+
+	memset (stamp, 0, sizeof (ModTlsFileStamp));
+	if (file == NULL || stat (file, &buf) != 0)
+		return;
+	stamp->mtime = (long) buf.st_mtime;
+	stamp->size  = (long) buf.st_size;
+	stamp->inode = (long) buf.st_ino;
+	return;
+}
+
+/** 
+ * @internal Checks if both stamps identify the same file content.
+ */
+axl_bool mod_tls_file_stamp_equal (ModTlsFileStamp * a, ModTlsFileStamp * b)
+{
+	return a->mtime == b->mtime && a->size == b->size && a->inode == b->inode;
+}
 
-		/* check serverName value */
-		if (HAS_ATTR_VALUE (node, "serverName", "*"))
-			return node;
+void mod_tls_material_unref (ModTlsMaterial * material)
+{
+	if (material == NULL)
+		return;
+
+	vortex_mutex_lock (&mod_tls_material_mutex);
+	material->ref_count--;
+	if (material->ref_count > 0) {
+		vortex_mutex_unlock (&mod_tls_material_mutex);
+		return;
+	} /* end if */
+	vortex_mutex_unlock (&mod_tls_material_mutex);
 
-		/* check if it matches the name */
-		if (HAS_ATTR_VALUE (node, "serverName", serverName))
-			return node;
+	X509_free (material->x509);
+	if (material->chain)
+		sk_X509_pop_free (material->chain, X509_free);
+	EVP_PKEY_free (material->pkey);
+	axl_free (material);
+	return;
+}
+
+/** 
+ * @internal Opens a BIO for the cert or key provided, that is,
+ * preloaded PEM content or a file.
+ */
+BIO * mod_tls_material_bio (const char * value)
+{
+	if (strncmp (value, "-----BEGIN", 10) == 0)
+		return BIO_new_mem_buf ((void *) value, -1);
+	return BIO_new_file (value, "r");
+}
+
+/** 
+ * @internal Parses certificate (followed by its chain) and private
+ * key, either preloaded content or files. Returns NULL (reporting
+ * the error) if something fails or they do not match.
+ */
+ModTlsMaterial * mod_tls_material_parse (const char * cert, const char * key)
+{
+	ModTlsMaterial * material;
+	BIO            * bio;
+	X509           * x509;
+
+	material            = axl_new (ModTlsMaterial, 1);
+	material->ref_count = 1;
+
+	/* certificate and chain */
+	bio = mod_tls_material_bio (cert);
+	if (bio == NULL) 
+		goto failed;
+	material->x509 = PEM_read_bio_X509 (bio, NULL, NULL, NULL);
+	if (material->x509 != NULL) {
+		material->chain = sk_X509_new_null ();
+		while ((x509 = PEM_read_bio_X509 (bio, NULL, NULL, NULL)) != NULL) 
+			sk_X509_push (material->chain, x509);
+	} /* end if */
+	BIO_free (bio);
+	if (material->x509 == NULL)
+		goto failed;
+
+	/* private key */
+	bio = mod_tls_material_bio (key);
+	if (bio == NULL) 
+		goto failed;
+	material->pkey = PEM_read_bio_PrivateKey (bio, NULL, NULL, NULL);
+	BIO_free (bio);
+	if (material->pkey == NULL || ! X509_check_private_key (material->x509, material->pkey))
+		goto failed;
+	ERR_clear_error ();
+
+	return material;
+ failed:
+	ERR_clear_error ();
+	mod_tls_material_unref (material);
+	return NULL;
+}
+
+/** 
+ * @internal Returns a reference to the material parsed for the
+ * declaration (NULL if none). Release it with
+ * mod_tls_material_unref.
+ */
+ModTlsMaterial * mod_tls_material_get (ModTlsCertificate * cert)
+{
+	ModTlsMaterial * material;
+
+	vortex_mutex_lock (&mod_tls_material_mutex);
+	material = cert->material;
+	if (material)
+		material->ref_count++;
+	vortex_mutex_unlock (&mod_tls_material_mutex);
+
+	return material;
+}
+
+/** 
+ * @internal Replaces the material of the declaration, releasing the
+ * previous one (handshakes using it keep their reference).
+ */
+void mod_tls_material_set (ModTlsCertificate * cert, ModTlsMaterial * material)
+{
+	ModTlsMaterial * previous;
+
+	vortex_mutex_lock (&mod_tls_material_mutex);
+	previous       = cert->material;
+	cert->material = material;
+	vortex_mutex_unlock (&mod_tls_material_mutex);
+
+	mod_tls_material_unref (previous);
+	return;
+}
+
+void mod_tls_certificate_free (axlPointer _cert)
+{
+	ModTlsCertificate * cert = _cert;
+
+	axl_free (cert->serverName);
+	axl_free (cert->cert);
+	axl_free (cert->key);
+	axl_free (cert->content_cert);
+	axl_free (cert->content_key);
+	axl_free (cert->cert_file);
+	axl_free (cert->key_file);
+	mod_tls_material_unref (cert->material);
+	axl_free (cert);
+	return;
+}
+
+void mod_tls_certificates_free (axlPointer _certs)
+{
+	ModTlsCertificates * certs = _certs;
+
+	mod_tls_select_free (certs->selection);
+	axl_list_free (certs->all);
+	axl_free (certs);
+	return;
+}
+
+/** 
+ * @internal Schema build handler (see
+ * turbulence_config_register_schema) that compiles all
+ * <certificate-select> declarations so they are found without
+ * walking tls.conf on each connection.
+ */
+axlPointer mod_tls_certificates_build (TurbulenceCtx * _ctx, axlDoc * config, axlPointer user_data)
+{
+	ModTlsCertificates * certs;
+	ModTlsCertificate  * cert;
+	axlNode            * node;
+
+	/* try to load configuration file */
+	if (! mod_tls_load_config ()) 
+		return NULL;
+
+	certs            = axl_new (ModTlsCertificates, 1);
+	certs->selection = mod_tls_select_new ();
+	certs->all       = axl_list_new (axl_list_always_return_1, mod_tls_certificate_free);
+
+	node = axl_doc_get (mod_tls_conf, "/mod-tls/certificate-select");
+	while (node) {
+		cert                            = axl_new (ModTlsCertificate, 1);
+		cert->serverName                = axl_strdup (ATTR_VALUE (node, "serverName"));
+		cert->cert                      = axl_strdup (ATTR_VALUE (node, "cert"));
+		cert->key                       = axl_strdup (ATTR_VALUE (node, "key"));
+		cert->close_on_failure          = HAS_ATTR_VALUE (node, "close-on-failure", "yes");
+		cert->close_on_failure_declared = HAS_ATTR (node, "close-on-failure");
+
+		/* content preloaded (see mod_tls_preload_certificates) */
+		cert->content_cert = axl_strdup (axl_node_annotate_get (node, "content-certificate", axl_false));
+		cert->content_key  = axl_strdup (axl_node_annotate_get (node, "content-key", axl_false));
+		axl_list_append (certs->all, cert);
+
+		/* parse material now so handshakes only attach it:
+		 * childs only have the content preloaded for its
+		 * serverName (the rest is handled as before) while
+		 * the master parses all files */
+		if (cert->content_cert && cert->content_key) 
+			cert->material = mod_tls_material_parse (cert->content_cert, cert->content_key);
+		else if (! turbulence_ctx_is_child (_ctx)) {
+			cert->cert_file = mod_tls_resolve_file (cert->cert, "certificate");
+			cert->key_file  = mod_tls_resolve_file (cert->key, "private key");
+			if (cert->cert_file && cert->key_file) {
+				cert->material = mod_tls_material_parse (cert->cert_file, cert->key_file);
+				if (cert->material) {
+					mod_tls_file_stamp (cert->cert_file, &cert->material->cert_stamp);
+					mod_tls_file_stamp (cert->key_file, &cert->material->key_stamp);
+				} /* end if */
+			} /* end if */
+		} /* end if */
+		if ((cert->content_cert || cert->cert_file) && cert->material == NULL)
+			error ("TLS: failed to parse certificate/key material for serverName=%s (cert=%s, key=%s)",
+			       cert->serverName ? cert->serverName : "N/A", cert->cert ? cert->cert : "N/A", cert->key ? cert->key : "N/A");
+
+		/* index it: only the first declaration for a name is
+		 * reachable, the same as walking the document */
+		mod_tls_select_add (certs->selection, cert->serverName, cert);
 
 		/* get next node called "certificate-select" */
 		node = axl_node_get_next_called (node, "certificate-select");
-	} /* end node */
+	} /* end while */
 
-	if (node == NULL) {
+	msg ("TLS: compiled %d <certificate-select> declarations", axl_list_length (certs->all));
+	return certs;
+}
+
+/** 
+ * @internal Returns the declaration selected for serverName: the
+ * first in document order among the exact name, the wildcard
+ * matching it ("*.example.com" matches "www.example.com" but not
+ * "example.com" or "a.www.example.com") and serverName="*".
+ */
+ModTlsCertificate * mod_tls_certificates_lookup (ModTlsCertificates * certs, const char * serverName)
+{
+	return mod_tls_select_lookup (certs->selection, serverName);
+}
+
+/** 
+ * @internal Finds the <certificate-select> declaration for the
+ * provided serverName. The declaration returned is owned by the
+ * snapshot returned, which must be released by the caller (even when
+ * NULL is returned) with turbulence_config_snapshot_unref.
+ */
+ModTlsCertificate * mod_tls_find_certificate (VortexConnection          * conn, 
+					      const char                * serverName, 
+					      TurbulenceConfigSnapshot ** snapshot)
+{
+	ModTlsCertificates * certs;
+	ModTlsCertificate  * cert = NULL;
+
+	msg ("Finding certificate/key material for serverName=%s conn-id=%d",
+	     serverName ? serverName : "N/A", vortex_connection_get_id (conn));
+
+	(*snapshot) = turbulence_config_snapshot (ctx);
+	certs       = turbulence_config_snapshot_module (*snapshot, "mod-tls");
+	if (certs) 
+		cert = mod_tls_certificates_lookup (certs, serverName);
+
+	if (cert == NULL) {
 		error ("Unable to find <certificate-select> node declaration that matches serverName=%s on conn-id=%d",
 		       serverName ? serverName : "N/A", vortex_connection_get_id (conn));
 	} /* end if */
 
-	return node;
+	return cert;
 }
 
-char * mod_tls_check_file_exists (VortexConnection * conn, axlNode * node, const char * key, const char * name)
+char * mod_tls_check_file_exists (VortexConnection * conn, const char * path, const char * name)
 {
-	char * file;
+	char * file = mod_tls_resolve_file (path, name);
 
-	/* check if the file is relativate or full path */
-	if (! turbulence_file_is_fullpath (ATTR_VALUE (node, key))) {
-		file = vortex_support_domain_find_data_file (CONN_CTX (conn), "tls", ATTR_VALUE (node, key));
-		if (file == NULL) {
-			error ("Unable to find %s file %s under configured directories", name, ATTR_VALUE (node, "cert"));
-			return NULL;
-		}
-	} else {
-		/* seems path is absolute, return full path */
-		if (! vortex_support_file_test (ATTR_VALUE (node, key), FILE_EXISTS)) {
-			error ("File %s do not exists, failed to return %s", ATTR_VALUE (node, key), name);
-			return NULL;
-		}
-		/* file exists, copy it */
-		file = axl_strdup (ATTR_VALUE (node, key));
-	}	
+	if (file == NULL)
+		return NULL;
 
 	msg ("Found %s file %s conn-id=%d", name, file, vortex_connection_get_id (conn));
 	return file;
@@ -151,26 +566,30 @@ char * mod_tls_check_file_exists (VortexConnection * conn, axlNode * node, const
 char * mod_tls_certificate_handler (VortexConnection * conn,
 				    const char       * serverName) {
 
-	/* find the certificate node */
-	axlNode * node = mod_tls_find_certificate_node (conn, serverName);
-	char    * file;
+	/* find the certificate declaration */
+	TurbulenceConfigSnapshot * snapshot;
+	ModTlsCertificate        * cert = mod_tls_find_certificate (conn, serverName, &snapshot);
+	char                     * file = NULL;
 
-	/* check if the node is null or it has no "cert" attribute */
-	if (node == NULL || ! HAS_ATTR (node, "cert"))
+	/* check if the declaration is null or it has no "cert" attribute */
+	if (cert == NULL || cert->cert == NULL) {
+		turbulence_config_snapshot_unref (snapshot);
 		return NULL;
+	} /* end if */
 
 	/* return a copy to the certificate */
 	msg ("Selecting certificate file: %s (conn-id=%d, serverName: %s)",
-	     ATTR_VALUE (node, "cert"), vortex_connection_get_id (conn), serverName ? serverName : "none");
-
-	/* check if we have the key preloaded */
-	if (axl_node_annotate_get (node, "content-certificate", axl_false)) {
-		/* found content, return certificate content instead of the path */
-		return axl_strdup (axl_node_annotate_get (node, "content-certificate", axl_false));
+	     cert->cert, vortex_connection_get_id (conn), serverName ? serverName : "none");
+
+	/* check if we have the key preloaded: return certificate
+	 * content instead of the path */
+	if (cert->content_cert) 
+		file = axl_strdup (cert->content_cert);
+	else {
+		/* ensure file exists */
+		file = mod_tls_check_file_exists (conn, cert->cert, "certificate");
 	} /* end if */
-
-	/* ensure file exists */
-	file = mod_tls_check_file_exists (conn, node, "cert", "certificate");
+	turbulence_config_snapshot_unref (snapshot);
 	
 	/* return file found */
 	return file;
@@ -178,26 +597,30 @@ char * mod_tls_certificate_handler (VortexConnection * conn,
 
 char * mod_tls_private_key_handler (VortexConnection * conn,
 				    const char       * serverName) {
-	/* find the certificate node */
-	axlNode * node = mod_tls_find_certificate_node (conn, serverName);
-	char    * file;
-
-	/* check if the node is null or it has no "cert" attribute */
-	if (node == NULL || ! HAS_ATTR (node, "key"))
+	/* find the certificate declaration */
+	TurbulenceConfigSnapshot * snapshot;
+	ModTlsCertificate        * cert = mod_tls_find_certificate (conn, serverName, &snapshot);
+	char                     * file = NULL;
+
+	/* check if the declaration is null or it has no "key" attribute */
+	if (cert == NULL || cert->key == NULL) {
+		turbulence_config_snapshot_unref (snapshot);
 		return NULL;
+	} /* end if */
 
 	/* return a copy to the certificate */
 	msg ("Selecting private key file: %s (conn-id=%d, serverName: %s)",
-	     ATTR_VALUE (node, "key"), vortex_connection_get_id (conn), serverName ? serverName : "none");
-
-	/* check if we have the key preloaded */
-	if (axl_node_annotate_get (node, "content-key", axl_false)) {
-		/* found content, return private key content instead of the path */
-		return axl_strdup (axl_node_annotate_get (node, "content-key", axl_false));
+	     cert->key, vortex_connection_get_id (conn), serverName ? serverName : "none");
+
+	/* check if we have the key preloaded: return private key
+	 * content instead of the path */
+	if (cert->content_key) 
+		file = axl_strdup (cert->content_key);
+	else {
+		/* ensure file exists */
+		file = mod_tls_check_file_exists (conn, cert->key, "private key");
 	} /* end if */
-
-	/* ensure file exists */
-	file = mod_tls_check_file_exists (conn, node, "key", "private key");
+	turbulence_config_snapshot_unref (snapshot);
 	
 	/* return file found */
 	return file;
@@ -205,12 +628,13 @@ char * mod_tls_private_key_handler (VortexConnection * conn,
 
 void mod_tls_failure_handler (VortexConnection * conn, const char * error_message, axlPointer _ctx)
 {
-	char            log_buffer [512];
-	unsigned long   err;
-	const char    * serverName = vortex_connection_get_server_name (conn);
-	TurbulenceCtx * ctx = _ctx;
-	axlNode       * node = mod_tls_find_certificate_node (conn, serverName);
-	axl_bool        close_on_failure = HAS_ATTR_VALUE (node, "close-on-failure", "yes");
+	char                       log_buffer [512];
+	unsigned long              err;
+	const char               * serverName = vortex_connection_get_server_name (conn);
+	TurbulenceCtx            * ctx = _ctx;
+	TurbulenceConfigSnapshot * snapshot;
+	ModTlsCertificate        * cert = mod_tls_find_certificate (conn, serverName, &snapshot);
+	axl_bool                   close_on_failure = cert && cert->close_on_failure;
 
 	error ("Found connection id=%d (from %s:%s, serverName: %s, close-on-failure: %d) TLS error: %s", vortex_connection_get_id (conn), 
 	       vortex_connection_get_host (conn), vortex_connection_get_port (conn), serverName ? serverName : "", close_on_failure,
@@ -225,10 +649,11 @@ void mod_tls_failure_handler (VortexConnection * conn, const char * error_messag
 	 * assume yes for security reasons. It is better to close the
 	 * connection after a TLS connection handling failure to avoid
 	 * any possibility of tricking the server */
-	if (node && ! close_on_failure && ! HAS_ATTR (node, "close-on-failure")) {
+	if (cert && ! close_on_failure && ! cert->close_on_failure_declared) {
 		error ("TLS failure found, assuing close-on-failure='yes' because it wasn't defined");
 		close_on_failure = axl_true;
 	} /* end if */
+	turbulence_config_snapshot_unref (snapshot);
 
 	/* fulminate this connection if signaled */
 	if (close_on_failure) {
@@ -300,9 +725,10 @@ axl_bool mod_tls_preload_certificates (TurbulenceCtx * ctx)
 	msg ("TLS: Preload certificate for %s", turbulence_child_get_serverName (ctx));
 	node = axl_doc_get (mod_tls_conf, "/mod-tls/certificate-select");
 	while (node) {
-		/* check if there is a certificate declaration with
-		   the provided serverName */
-		if (HAS_ATTR_VALUE (node, "serverName", turbulence_child_get_serverName (ctx))) {
+		/* check if this is the certificate declaration
+		   selected for the provided serverName (the first one
+		   matching in document order) */
+		if (mod_tls_name_matches (ATTR_VALUE (node, "serverName"), turbulence_child_get_serverName (ctx))) {
 			/* get file pointed by the node: CERTIFICATE */
 			file         = vortex_support_domain_find_data_file (TBC_VORTEX_CTX (ctx), "tls", ATTR_VALUE (node, "cert"));
 			file_content = mod_tls_load_file_content (ctx, file);
@@ -340,6 +766,897 @@ axl_bool mod_tls_preload_certificates (TurbulenceCtx * ctx)
 	return axl_true;
 }
 
+#if defined(AXL_OS_UNIX)
+/** 
+ * @internal Locks (or unlocks) the provided region of the shared
+ * session cache file. Record locks are owned by the process so
+ * threads inside the same process are serialized with
+ * mod_tls_cache_mutex before calling this.
+ */
+void mod_tls_cache_lock (long offset, long length, axl_bool lock)
+{
+	struct flock region;
+
+	memset (&region, 0, sizeof (struct flock));
+	region.l_type   = lock ? F_WRLCK : F_UNLCK;
+	region.l_whence = SEEK_SET;
+	region.l_start  = offset;
+	region.l_len    = length;
+
+	while (fcntl (mod_tls_cache_fd, F_SETLKW, &region) != 0) {
+		if (errno != EINTR) {
+			error ("Unable to %s shared TLS session cache region (errno=%d : %s)",
+			       lock ? "lock" : "unlock", errno, vortex_errno_get_error (errno));
+			return;
+		} /* end if */
+	} /* end while */
+	return;
+}
+#endif
+
+/** 
+ * @internal Returns the slot used to store the session with the
+ * provided id. Session ids are random so folding its bytes is enough
+ * to spread them over the cache.
+ */
+ModTlsSessionSlot * mod_tls_cache_slot (const unsigned char * id, int id_length, long * offset)
+{
+	unsigned int hash = 2166136261u;
+	int          iterator;
+
+	for (iterator = 0; iterator < id_length; iterator++) {
+		hash ^= id[iterator];
+		hash *= 16777619u;
+	} /* end for */
+
+	hash     = hash % mod_tls_cache->size;
+	(*offset) = sizeof (ModTlsSessionHeader) + (hash * sizeof (ModTlsSessionSlot));
+	return &mod_tls_cache_slots[hash];
+}
+
+/** 
+ * @internal Acquires the provided region of the shared cache for
+ * this thread.
+ */
+void mod_tls_cache_acquire (long offset, long length)
+{
+	vortex_mutex_lock (&mod_tls_cache_mutex);
+#if defined(AXL_OS_UNIX)
+	mod_tls_cache_lock (offset, length, axl_true);
+#endif
+	return;
+}
+
+/** 
+ * @internal Releases a region acquired with mod_tls_cache_acquire.
+ */
+void mod_tls_cache_release (long offset, long length)
+{
+#if defined(AXL_OS_UNIX)
+	mod_tls_cache_lock (offset, length, axl_false);
+#endif
+	vortex_mutex_unlock (&mod_tls_cache_mutex);
+	return;
+}
+
+/** 
+ * @internal OpenSSL handler called when a new session is
+ * established: the session is stored into the shared cache so any
+ * other child can resume it.
+ */
+int mod_tls_session_new (SSL * ssl, SSL_SESSION * session)
+{
+	ModTlsSessionSlot   * slot;
+	const unsigned char * id;
+	unsigned int          id_length;
+	unsigned char       * der;
+	int                   length;
+	long                  offset;
+
+	/* get session id and DER length */
+	id     = SSL_SESSION_get_id (session, &id_length);
+	length = i2d_SSL_SESSION (session, NULL);
+	if (length <= 0 || length > MOD_TLS_SESSION_DER_SIZE || id_length > SSL_MAX_SSL_SESSION_ID_LENGTH) {
+		msg2 ("TLS session not cached (der size %d, max %d)", length, MOD_TLS_SESSION_DER_SIZE);
+		return 0;
+	} /* end if */
+
+	slot = mod_tls_cache_slot (id, id_length, &offset);
+	mod_tls_cache_acquire (offset, sizeof (ModTlsSessionSlot));
+
+	/* store session (overwriting any previous one that was
+	 * using the same slot) */
+	der             = slot->der;
+	slot->length    = i2d_SSL_SESSION (session, &der);
+	slot->id_length = id_length;
+	slot->expires   = time (NULL) + mod_tls_cache->ttl;
+	memcpy (slot->id, id, id_length);
+
+	mod_tls_cache_release (offset, sizeof (ModTlsSessionSlot));
+
+	/* no reference is kept to the session */
+	return 0;
+}
+
+/** 
+ * @internal OpenSSL handler called to find a session the client is
+ * trying to resume.
+ */
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+SSL_SESSION * mod_tls_session_get (SSL * ssl, const unsigned char * id, int id_length, int * copy)
+#else
+SSL_SESSION * mod_tls_session_get (SSL * ssl, unsigned char * id, int id_length, int * copy)
+#endif
+{
+	ModTlsSessionSlot   * slot;
+	SSL_SESSION         * session = NULL;
+	unsigned char         der[MOD_TLS_SESSION_DER_SIZE];
+	const unsigned char * aux;
+	int                   length  = 0;
+	long                  offset;
+
+	/* session returned is owned by the caller */
+	(*copy) = 0;
+	if (id_length <= 0 || id_length > SSL_MAX_SSL_SESSION_ID_LENGTH)
+		return NULL;
+
+	slot = mod_tls_cache_slot (id, id_length, &offset);
+	mod_tls_cache_acquire (offset, sizeof (ModTlsSessionSlot));
+
+	/* check the slot holds this session and it is not expired */
+	if (slot->id_length == id_length && memcmp (slot->id, id, id_length) == 0) {
+		if (slot->expires >= time (NULL) && slot->length > 0 && slot->length <= MOD_TLS_SESSION_DER_SIZE) {
+			length = slot->length;
+			memcpy (der, slot->der, length);
+		} else {
+			/* expired, release the slot */
+			slot->id_length = 0;
+		} /* end if */
+	} /* end if */
+
+	mod_tls_cache_release (offset, sizeof (ModTlsSessionSlot));
+
+	/* decode outside the lock */
+	if (length > 0) {
+		aux     = der;
+		session = d2i_SSL_SESSION (NULL, &aux, length);
+	} /* end if */
+
+	return session;
+}
+
+/** 
+ * @internal OpenSSL handler called when a session must be removed
+ * (for example, after a failure found on a connection using it).
+ */
+void mod_tls_session_remove (SSL_CTX * ssl_ctx, SSL_SESSION * session)
+{
+	ModTlsSessionSlot   * slot;
+	const unsigned char * id;
+	unsigned int          id_length;
+	long                  offset;
+
+	id = SSL_SESSION_get_id (session, &id_length);
+	if (id_length == 0 || id_length > SSL_MAX_SSL_SESSION_ID_LENGTH)
+		return;
+
+	slot = mod_tls_cache_slot (id, id_length, &offset);
+	mod_tls_cache_acquire (offset, sizeof (ModTlsSessionSlot));
+	if (slot->id_length == (int) id_length && memcmp (slot->id, id, id_length) == 0)
+		slot->id_length = 0;
+	mod_tls_cache_release (offset, sizeof (ModTlsSessionSlot));
+
+	return;
+}
+
+/** 
+ * @internal Maps the shared session cache declared by
+ * <session-cache>. The master creates (and resets) the cache file
+ * and childs map the same file so sessions established on any
+ * process can be resumed on any other.
+ */
+axl_bool mod_tls_session_cache_init (TurbulenceCtx * ctx)
+{
+	axlNode * node = axl_doc_get (mod_tls_conf, "/mod-tls/session-cache");
+	char    * file;
+	int       size = MOD_TLS_SESSION_CACHE_SIZE;
+	int       ttl  = MOD_TLS_SESSION_CACHE_TTL;
+#if defined(AXL_OS_UNIX)
+	struct stat   buf;
+	axl_bool      child = turbulence_ctx_is_child (ctx);
+#endif
+
+	/* cache not declared */
+	if (node == NULL)
+		return axl_true;
+
+	/* get size and ttl */
+	if (HAS_ATTR (node, "size"))
+		size = atoi (ATTR_VALUE (node, "size"));
+	if (HAS_ATTR (node, "ttl"))
+		ttl = atoi (ATTR_VALUE (node, "ttl"));
+	if (size <= 0 || ttl <= 0) {
+		error ("Wrong <session-cache> declaration found (size=%d, ttl=%d), both must be bigger than 0, session cache disabled", 
+		       size, ttl);
+		return axl_false;
+	} /* end if */
+
+#if defined(AXL_OS_UNIX)
+	/* get cache file */
+	if (HAS_ATTR (node, "file"))
+		file = axl_strdup (ATTR_VALUE (node, "file"));
+	else
+		file = axl_strdup_printf ("%s%s%s%s%s", turbulence_runtime_datadir (ctx), VORTEX_FILE_SEPARATOR, 
+					  "turbulence", VORTEX_FILE_SEPARATOR, "mod-tls-sessions.cache");
+
+	mod_tls_cache_length = sizeof (ModTlsSessionHeader) + ((long) size * sizeof (ModTlsSessionSlot));
+
+	/* the master creates the file from scratch, childs open the
+	 * one created by the master */
+	if (child) 
+		mod_tls_cache_fd = open (file, O_RDWR);
+	else
+		mod_tls_cache_fd = open (file, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (mod_tls_cache_fd < 0) {
+		error ("Unable to open TLS session cache file %s (errno=%d : %s), session cache disabled", 
+		       file, errno, vortex_errno_get_error (errno));
+		axl_free (file);
+		return axl_false;
+	} /* end if */
+
+	if (! child && ftruncate (mod_tls_cache_fd, mod_tls_cache_length) != 0) {
+		error ("Unable to size TLS session cache file %s (errno=%d : %s), session cache disabled", 
+		       file, errno, vortex_errno_get_error (errno));
+		goto failed;
+	} /* end if */
+
+	/* check the file has the size expected (it may be using a
+	 * configuration changed after the master started) */
+	if (fstat (mod_tls_cache_fd, &buf) != 0 || buf.st_size != mod_tls_cache_length) {
+		error ("TLS session cache file %s has an unexpected size (configuration changed without restarting?), session cache disabled", file);
+		goto failed;
+	} /* end if */
+
+	mod_tls_cache = mmap (NULL, mod_tls_cache_length, PROT_READ | PROT_WRITE, MAP_SHARED, mod_tls_cache_fd, 0);
+	if (mod_tls_cache == MAP_FAILED) {
+		mod_tls_cache = NULL;
+		error ("Unable to map TLS session cache file %s (errno=%d : %s), session cache disabled", 
+		       file, errno, vortex_errno_get_error (errno));
+		goto failed;
+	} /* end if */
+	mod_tls_cache_slots = (ModTlsSessionSlot *) (((char *) mod_tls_cache) + sizeof (ModTlsSessionHeader));
+
+	/* initialize header */
+	if (! child) {
+		mod_tls_cache->size = size;
+		mod_tls_cache->ttl  = ttl;
+	} /* end if */
+
+	msg ("TLS session cache enabled at %s (size=%d, ttl=%d)", file, mod_tls_cache->size, mod_tls_cache->ttl);
+	axl_free (file);
+	return axl_true;
+
+ failed:
+	close (mod_tls_cache_fd);
+	mod_tls_cache_fd = -1;
+	axl_free (file);
+	return axl_false;
+#else
+	wrn ("Shared TLS session cache is not supported on this platform, <session-cache> ignored");
+	return axl_false;
+#endif
+}
+
+/** 
+ * @internal Translates an hexadecimal digit into its value or -1 if
+ * it is not valid.
+ */
+int mod_tls_hex_value (char digit)
+{
+	if (digit >= '0' && digit <= '9')
+		return digit - '0';
+	if (digit >= 'a' && digit <= 'f')
+		return digit - 'a' + 10;
+	if (digit >= 'A' && digit <= 'F')
+		return digit - 'A' + 10;
+	return -1;
+}
+
+/** 
+ * @internal Parses all <ticket-key> declarations found on the
+ * provided tls.conf document. Returns axl_false if some key is not
+ * valid (96 hexadecimal digits).
+ */
+axl_bool mod_tls_ticket_keys_parse (TurbulenceCtx * ctx, axlDoc * doc, ModTlsTicketKey ** keys, int * keys_num)
+{
+	axlNode         * node = axl_doc_get (doc, "/mod-tls/session-tickets/ticket-key");
+	const char      * value;
+	unsigned char   * raw;
+	int               iterator;
+	int               high;
+	int               low;
+
+	(*keys)     = NULL;
+	(*keys_num) = 0;
+
+	/* count keys */
+	while (node) {
+		(*keys_num)++;
+		node = axl_node_get_next_called (node, "ticket-key");
+	} /* end while */
+	if ((*keys_num) == 0)
+		return axl_true;
+
+	(*keys) = axl_new (ModTlsTicketKey, (*keys_num));
+	node    = axl_doc_get (doc, "/mod-tls/session-tickets/ticket-key");
+	raw     = (unsigned char *) (*keys);
+	while (node) {
+		value = ATTR_VALUE (node, "key");
+		if (value == NULL || strlen (value) != (sizeof (ModTlsTicketKey) * 2)) {
+			error ("Wrong <ticket-key> declaration found, key attribute must have %d hexadecimal digits",
+			       (int) sizeof (ModTlsTicketKey) * 2);
+			goto failed;
+		} /* end if */
+
+		for (iterator = 0; iterator < (int) sizeof (ModTlsTicketKey); iterator++) {
+			high = mod_tls_hex_value (value[iterator * 2]);
+			low  = mod_tls_hex_value (value[iterator * 2 + 1]);
+			if (high < 0 || low < 0) {
+				error ("Wrong <ticket-key> declaration found, key attribute contains non hexadecimal values");
+				goto failed;
+			} /* end if */
+			raw[iterator] = (high << 4) | low;
+		} /* end for */
+
+		/* next key */
+		raw += sizeof (ModTlsTicketKey);
+		node = axl_node_get_next_called (node, "ticket-key");
+	} /* end while */
+
+	return axl_true;
+ failed:
+	axl_free (*keys);
+	(*keys)     = NULL;
+	(*keys_num) = 0;
+	return axl_false;
+}
+
+/** 
+ * @internal Loads session tickets configuration from the provided
+ * document replacing current keys (used at startup and on reload to
+ * rotate keys).
+ */
+void mod_tls_ticket_keys_load (TurbulenceCtx * ctx, axlDoc * doc)
+{
+	ModTlsTicketKey * keys;
+	ModTlsTicketKey * old;
+	int               keys_num;
+
+	if (axl_doc_get (doc, "/mod-tls/session-tickets") == NULL) {
+		/* tickets not declared, keep current state */
+		return;
+	} /* end if */
+
+	if (! mod_tls_ticket_keys_parse (ctx, doc, &keys, &keys_num)) {
+		error ("Keeping previous session ticket keys because new declaration has errors");
+		return;
+	} /* end if */
+
+	/* swap keys */
+	vortex_mutex_lock (&mod_tls_ticket_mutex);
+	old                     = mod_tls_ticket_keys;
+	mod_tls_ticket_keys     = keys;
+	mod_tls_ticket_keys_num = keys_num;
+	vortex_mutex_unlock (&mod_tls_ticket_mutex);
+	axl_free (old);
+
+	msg ("TLS session tickets configured with %d key(s)", keys_num);
+	return;
+}
+
+/** 
+ * @internal OpenSSL handler used to encrypt and decrypt session
+ * tickets using the keys declared at tls.conf. The first key is used
+ * to issue new tickets while the rest are only accepted (and the
+ * ticket is renewed with the first key), which allows rotating keys
+ * by placing a new one on top and reloading.
+ *
+ * Installed with SSL_CTX_set_tlsext_ticket_key_evp_cb on OpenSSL 3
+ * (hmac is an EVP_MAC_CTX) and SSL_CTX_set_tlsext_ticket_key_cb on
+ * previous versions (hmac is an HMAC_CTX).
+ */
+int mod_tls_ticket_key_handler (SSL                     * ssl, 
+				unsigned char           * key_name, 
+				unsigned char           * iv, 
+				EVP_CIPHER_CTX          * cipher, 
+				MOD_TLS_TICKET_HMAC_CTX * hmac, 
+				int                       enc)
+{
+	ModTlsTicketKey key;
+	int             iterator;
+	int             result = 0;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	OSSL_PARAM      params[3];
+	char            digest[] = "SHA256";
+#endif
+
+	vortex_mutex_lock (&mod_tls_ticket_mutex);
+	if (enc) {
+		/* issue ticket with first key */
+		if (mod_tls_ticket_keys_num > 0) {
+			memcpy (&key, &mod_tls_ticket_keys[0], sizeof (ModTlsTicketKey));
+			result = 1;
+		} /* end if */
+	} else {
+		/* find key used by the ticket */
+		for (iterator = 0; iterator < mod_tls_ticket_keys_num; iterator++) {
+			if (memcmp (key_name, mod_tls_ticket_keys[iterator].name, 16) == 0) {
+				memcpy (&key, &mod_tls_ticket_keys[iterator], sizeof (ModTlsTicketKey));
+				/* ask to renew the ticket if it was not issued
+				 * with the current key */
+				result = (iterator == 0) ? 1 : 2;
+				break;
+			} /* end if */
+		} /* end for */
+	} /* end if */
+	vortex_mutex_unlock (&mod_tls_ticket_mutex);
+
+	/* no key available (enc) or ticket key unknown (dec): full
+	 * handshake */
+	if (result == 0)
+		return 0;
+
+	if (enc) {
+		if (RAND_bytes (iv, EVP_MAX_IV_LENGTH) <= 0)
+			return -1;
+		memcpy (key_name, key.name, 16);
+		EVP_EncryptInit_ex (cipher, EVP_aes_128_cbc (), NULL, key.aes_key, iv);
+	} else {
+		EVP_DecryptInit_ex (cipher, EVP_aes_128_cbc (), NULL, key.aes_key, iv);
+	} /* end if */
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	params[0] = OSSL_PARAM_construct_octet_string (OSSL_MAC_PARAM_KEY, key.hmac_key, 16);
+	params[1] = OSSL_PARAM_construct_utf8_string (OSSL_MAC_PARAM_DIGEST, digest, 0);
+	params[2] = OSSL_PARAM_construct_end ();
+	if (! EVP_MAC_CTX_set_params (hmac, params))
+		return -1;
+#else
+	HMAC_Init_ex (hmac, key.hmac_key, 16, EVP_sha256 (), NULL);
+#endif
+
+	return result;
+}
+
+/** 
+ * @internal Attaches material already parsed to the provided SSL_CTX
+ * (it takes its own references so material can be released later).
+ */
+axl_bool mod_tls_ctx_attach_material (SSL_CTX * ssl_ctx, ModTlsMaterial * material)
+{
+	int    iterator;
+#if OPENSSL_VERSION_NUMBER < 0x10002000L
+	X509 * x509;
+#endif
+
+	if (SSL_CTX_use_certificate (ssl_ctx, material->x509) <= 0)
+		return axl_false;
+	for (iterator = 0; iterator < sk_X509_num (material->chain); iterator++) {
+#if OPENSSL_VERSION_NUMBER >= 0x10002000L
+		if (SSL_CTX_add1_chain_cert (ssl_ctx, sk_X509_value (material->chain, iterator)) <= 0)
+			return axl_false;
+#else
+		/* ctx owns the chain certificate */
+		x509 = X509_dup (sk_X509_value (material->chain, iterator));
+		if (x509 == NULL || SSL_CTX_add_extra_chain_cert (ssl_ctx, x509) <= 0) {
+			X509_free (x509);
+			return axl_false;
+		} /* end if */
+#endif
+	} /* end for */
+
+	/* key already checked against the certificate when parsed */
+	return SSL_CTX_use_PrivateKey (ssl_ctx, material->pkey) > 0;
+}
+
+/** 
+ * @internal Configures certificate and private key on the provided
+ * SSL_CTX. Material parsed by the certificate store is attached as
+ * is, otherwise handlers may return a path or the content
+ * preloaded.
+ */
+axl_bool mod_tls_ctx_use_material (SSL_CTX * ssl_ctx, VortexConnection * conn, const char * serverName)
+{
+	TurbulenceConfigSnapshot * snapshot;
+	ModTlsCertificate        * found;
+	ModTlsMaterial           * material;
+	char                     * cert;
+	char                     * key;
+	BIO                      * bio;
+	X509                     * x509;
+	EVP_PKEY                 * pkey;
+	axl_bool                   result = axl_false;
+
+	/* material parsed (usual case) */
+	found    = mod_tls_find_certificate (conn, serverName, &snapshot);
+	material = found ? mod_tls_material_get (found) : NULL;
+	turbulence_config_snapshot_unref (snapshot);
+	if (found == NULL)
+		return axl_false;
+	if (material) {
+		result = mod_tls_ctx_attach_material (ssl_ctx, material);
+		mod_tls_material_unref (material);
+		return result;
+	} /* end if */
+
+	cert = mod_tls_certificate_handler (conn, serverName);
+	key  = mod_tls_private_key_handler (conn, serverName);
+	if (cert == NULL || key == NULL)
+		goto end;
+
+	/* certificate (and chain) */
+	if (strncmp (cert, "-----BEGIN", 10) == 0) {
+		bio  = BIO_new_mem_buf (cert, -1);
+		x509 = PEM_read_bio_X509 (bio, NULL, NULL, NULL);
+		if (x509 == NULL || SSL_CTX_use_certificate (ssl_ctx, x509) <= 0) {
+			X509_free (x509);
+			BIO_free (bio);
+			goto end;
+		} /* end if */
+		X509_free (x509);
+		while ((x509 = PEM_read_bio_X509 (bio, NULL, NULL, NULL)) != NULL) {
+			/* ctx owns the chain certificate */
+			if (SSL_CTX_add_extra_chain_cert (ssl_ctx, x509) <= 0)
+				X509_free (x509);
+		} /* end while */
+		ERR_clear_error ();
+		BIO_free (bio);
+	} else if (SSL_CTX_use_certificate_chain_file (ssl_ctx, cert) <= 0) 
+		goto end;
+
+	/* private key */
+	if (strncmp (key, "-----BEGIN", 10) == 0) {
+		bio  = BIO_new_mem_buf (key, -1);
+		pkey = PEM_read_bio_PrivateKey (bio, NULL, NULL, NULL);
+		BIO_free (bio);
+		if (pkey == NULL || SSL_CTX_use_PrivateKey (ssl_ctx, pkey) <= 0) {
+			EVP_PKEY_free (pkey);
+			goto end;
+		} /* end if */
+		EVP_PKEY_free (pkey);
+	} else if (SSL_CTX_use_PrivateKey_file (ssl_ctx, key, SSL_FILETYPE_PEM) <= 0)
+		goto end;
+
+	result = SSL_CTX_check_private_key (ssl_ctx);
+ end:
+	axl_free (cert);
+	axl_free (key);
+	return result;
+}
+
+/** 
+ * @internal SSL_CTX creation handler. Vortex creates a new SSL_CTX
+ * for each connection so certificates are attached from the
+ * certificate store and resumption state lives outside it: sessions
+ * into the shared cache and tickets keys into mod_tls_ticket_keys.
+ */
+axlPointer mod_tls_ctx_creation (VortexConnection * conn, axlPointer user_data)
+{
+	SSL_CTX            * ssl_ctx;
+	const char         * serverName = vortex_connection_get_server_name (conn);
+	TurbulencePPathDef * ppath_def  = turbulence_ppath_selected (conn);
+	char               * sid_ctx;
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+	ssl_ctx = SSL_CTX_new (TLS_server_method ());
+#else
+	ssl_ctx = SSL_CTX_new (SSLv23_server_method ());
+#endif
+	if (ssl_ctx == NULL) {
+		error ("Unable to create SSL_CTX for conn-id=%d", vortex_connection_get_id (conn));
+		return NULL;
+	} /* end if */
+	SSL_CTX_set_options (ssl_ctx, SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3);
+
+	if (! mod_tls_ctx_use_material (ssl_ctx, conn, serverName)) {
+		error ("Unable to configure certificate/key material for serverName=%s conn-id=%d",
+		       serverName ? serverName : "N/A", vortex_connection_get_id (conn));
+		SSL_CTX_free (ssl_ctx);
+		return NULL;
+	} /* end if */
+
+	/* sessions are only resumed inside the same profile path and
+	 * serverName */
+	sid_ctx = axl_strdup_printf ("%d:%s", ppath_def ? turbulence_ppath_get_id (ppath_def) : 0, 
+				     serverName ? serverName : "");
+	SSL_CTX_set_session_id_context (ssl_ctx, (unsigned char *) sid_ctx, 
+					strlen (sid_ctx) > SSL_MAX_SID_CTX_LENGTH ? SSL_MAX_SID_CTX_LENGTH : strlen (sid_ctx));
+	axl_free (sid_ctx);
+
+	/* shared session cache */
+	if (mod_tls_cache) {
+		SSL_CTX_set_session_cache_mode (ssl_ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+		SSL_CTX_set_timeout (ssl_ctx, mod_tls_cache->ttl);
+		SSL_CTX_sess_set_new_cb (ssl_ctx, mod_tls_session_new);
+		SSL_CTX_sess_set_get_cb (ssl_ctx, mod_tls_session_get);
+		SSL_CTX_sess_set_remove_cb (ssl_ctx, mod_tls_session_remove);
+	} else
+		SSL_CTX_set_session_cache_mode (ssl_ctx, SSL_SESS_CACHE_OFF);
+
+	/* session tickets: keys generated by OpenSSL are local to the
+	 * SSL_CTX (one per connection) so tickets are disabled unless
+	 * keys are declared */
+	if (mod_tls_tickets) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+		SSL_CTX_set_tlsext_ticket_key_evp_cb (ssl_ctx, mod_tls_ticket_key_handler);
+#else
+		SSL_CTX_set_tlsext_ticket_key_cb (ssl_ctx, mod_tls_ticket_key_handler);
+#endif
+	} else
+		SSL_CTX_set_options (ssl_ctx, SSL_OP_NO_TICKET);
+
+	return ssl_ctx;
+}
+
+/** 
+ * @internal Updates handshake counters.
+ */
+void mod_tls_count_handshake (axl_bool resumed)
+{
+	vortex_mutex_lock (&mod_tls_stats_mutex);
+	if (resumed)
+		mod_tls_resumed_handshakes++;
+	else
+		mod_tls_full_handshakes++;
+	vortex_mutex_unlock (&mod_tls_stats_mutex);
+
+	/* aggregate counters across processes */
+	if (mod_tls_cache) {
+		mod_tls_cache_acquire (0, sizeof (ModTlsSessionHeader));
+		if (resumed)
+			mod_tls_cache->resumed_handshakes++;
+		else
+			mod_tls_cache->full_handshakes++;
+		mod_tls_cache_release (0, sizeof (ModTlsSessionHeader));
+	} /* end if */
+
+	return;
+}
+
+/** 
+ * @internal Returns current handshake counters: aggregated across
+ * all processes when the shared cache is enabled, otherwise the ones
+ * of this process.
+ */
+void mod_tls_get_handshakes (long * full, long * resumed)
+{
+	if (mod_tls_cache) {
+		mod_tls_cache_acquire (0, sizeof (ModTlsSessionHeader));
+		(*full)    = mod_tls_cache->full_handshakes;
+		(*resumed) = mod_tls_cache->resumed_handshakes;
+		mod_tls_cache_release (0, sizeof (ModTlsSessionHeader));
+		return;
+	} /* end if */
+
+	vortex_mutex_lock (&mod_tls_stats_mutex);
+	(*full)    = mod_tls_full_handshakes;
+	(*resumed) = mod_tls_resumed_handshakes;
+	vortex_mutex_unlock (&mod_tls_stats_mutex);
+	return;
+}
+
+/** 
+ * @internal mod-radmin "show tls" command.
+ */
+axlDoc * mod_tls_command_show_tls (const char * line, axlPointer user_data, axl_bool * status)
+{
+	axlDoc   * doc;
+	axlError * err = NULL;
+	axlNode  * node;
+	long       full;
+	long       resumed;
+
+	/* signal command returned proper status */
+	(*status) = axl_true;
+
+	mod_tls_get_handshakes (&full, &resumed);
+
+	doc = axl_doc_parse_strings (&err, 
+				     "<table>",
+				     " <title>TLS status</title>",
+				     " <column-description>",
+				     "   <column name='Indicator' description='Status code' />",
+				     "   <column name='Value' description='Status message' />",
+				     " </column-description>",
+				     " <content>", 
+				     " </content>",
+				     "</table>", NULL);
+	node = axl_doc_get (doc, "/table/content");
+	if (node) {
+		axl_node_set_child (node, axl_node_parse (NULL, "<row><d>Full handshakes</d><d>%ld</d></row>", full));
+		axl_node_set_child (node, axl_node_parse (NULL, "<row><d>Resumed handshakes</d><d>%ld</d></row>", resumed));
+		axl_node_set_child (node, axl_node_parse (NULL, "<row><d>Session cache</d><d>%s</d></row>", 
+							  mod_tls_cache ? "shared" : "disabled"));
+		axl_node_set_child (node, axl_node_parse (NULL, "<row><d>Session cache size</d><d>%d</d></row>", 
+							  mod_tls_cache ? mod_tls_cache->size : 0));
+		axl_node_set_child (node, axl_node_parse (NULL, "<row><d>Session cache ttl</d><d>%d</d></row>", 
+							  mod_tls_cache ? mod_tls_cache->ttl : 0));
+		axl_node_set_child (node, axl_node_parse (NULL, "<row><d>Ticket keys</d><d>%d</d></row>", mod_tls_ticket_keys_num));
+	} /* end if */
+
+	return doc;
+}
+
+/** 
+ * @internal Prepares session resumption support (shared cache and
+ * session tickets) according to tls.conf.
+ */
+void mod_tls_session_init (TurbulenceCtx * ctx)
+{
+	vortex_mutex_create (&mod_tls_cache_mutex);
+	vortex_mutex_create (&mod_tls_ticket_mutex);
+	vortex_mutex_create (&mod_tls_stats_mutex);
+
+	/* try to load configuration file */
+	if (! mod_tls_load_config ())
+		return;
+
+	/* configure shared session cache and tickets */
+	mod_tls_session_cache_init (ctx);
+	mod_tls_ticket_keys_load (ctx, mod_tls_conf);
+	mod_tls_tickets = (mod_tls_ticket_keys_num > 0);
+
+	/* install our SSL_CTX creation so certificates parsed are
+	 * attached (it also disables resumption not enabled) */
+	vortex_tls_set_default_ctx_creation (TBC_VORTEX_CTX (ctx), mod_tls_ctx_creation, NULL);
+
+	/* report handshake counters through mod-radmin if available */
+	if (! turbulence_ctx_is_child (ctx) && turbulence_mediator_plug_exits (ctx, "mod-radmin", "command-install")) {
+		turbulence_mediator_call_api (ctx, "mod-radmin", "command-install", 
+					      "show tls", 
+					      "Allows to get TLS handshake counters (full vs resumed) and session resumption status", 
+					      mod_tls_command_show_tls, NULL);
+	} /* end if */
+
+	return;
+}
+
+/** 
+ * @internal Releases session resumption resources.
+ */
+void mod_tls_session_cleanup (void)
+{
+#if defined(AXL_OS_UNIX)
+	if (mod_tls_cache) {
+		munmap (mod_tls_cache, mod_tls_cache_length);
+		mod_tls_cache       = NULL;
+		mod_tls_cache_slots = NULL;
+	} /* end if */
+	if (mod_tls_cache_fd >= 0) {
+		close (mod_tls_cache_fd);
+		mod_tls_cache_fd = -1;
+	} /* end if */
+#endif
+	axl_free (mod_tls_ticket_keys);
+	mod_tls_ticket_keys     = NULL;
+	mod_tls_ticket_keys_num = 0;
+
+	vortex_mutex_destroy (&mod_tls_cache_mutex);
+	vortex_mutex_destroy (&mod_tls_ticket_mutex);
+	vortex_mutex_destroy (&mod_tls_stats_mutex);
+	return;
+}
+
+/** 
+ * @internal Parses again certificate and key files that changed
+ * since they were parsed. If the new files can't be parsed (for
+ * example, only one of them was replaced yet) the previous material
+ * is kept and it is retried on next check.
+ */
+void mod_tls_reload_check (void)
+{
+	TurbulenceConfigSnapshot * snapshot = turbulence_config_snapshot (ctx);
+	ModTlsCertificates       * certs    = turbulence_config_snapshot_module (snapshot, "mod-tls");
+	ModTlsCertificate        * cert;
+	ModTlsMaterial           * material;
+	ModTlsFileStamp            cert_stamp;
+	ModTlsFileStamp            key_stamp;
+	int                        iterator;
+
+	for (iterator = 0; certs && iterator < axl_list_length (certs->all); iterator++) {
+		cert = axl_list_get_nth (certs->all, iterator);
+		if (cert->cert_file == NULL || cert->key_file == NULL)
+			continue;
+
+		/* check files against material parsed */
+		mod_tls_file_stamp (cert->cert_file, &cert_stamp);
+		mod_tls_file_stamp (cert->key_file, &key_stamp);
+		material = mod_tls_material_get (cert);
+		if (material && mod_tls_file_stamp_equal (&material->cert_stamp, &cert_stamp) && 
+		    mod_tls_file_stamp_equal (&material->key_stamp, &key_stamp)) {
+			mod_tls_material_unref (material);
+			continue;
+		} /* end if */
+		mod_tls_material_unref (material);
+
+		material = mod_tls_material_parse (cert->cert_file, cert->key_file);
+		if (material == NULL) {
+			error ("TLS: certificate/key changed for serverName=%s but failed to parse them (cert=%s, key=%s), keeping previous",
+			       cert->serverName ? cert->serverName : "N/A", cert->cert_file, cert->key_file);
+			continue;
+		} /* end if */
+		material->cert_stamp = cert_stamp;
+		material->key_stamp  = key_stamp;
+		mod_tls_material_set (cert, material);
+		msg ("TLS: reloaded certificate/key for serverName=%s (cert=%s, key=%s)",
+		     cert->serverName ? cert->serverName : "N/A", cert->cert_file, cert->key_file);
+	} /* end for */
+
+	turbulence_config_snapshot_unref (snapshot);
+	return;
+}
+
+/** 
+ * @internal Thread checking for certificate changes each
+ * mod_tls_reload_period seconds until something is pushed into the
+ * queue.
+ */
+axlPointer mod_tls_reload_run (axlPointer _queue)
+{
+	VortexAsyncQueue * queue = _queue;
+
+	while (vortex_async_queue_timedpop (queue, (long) mod_tls_reload_period * 1000000) == NULL) 
+		mod_tls_reload_check ();
+
+	return NULL;
+}
+
+/** 
+ * @internal Starts background reload of certificate files changed
+ * (only at the master, childs only have content preloaded).
+ */
+void mod_tls_reload_start (TurbulenceCtx * ctx)
+{
+	axlNode * node;
+
+	if (turbulence_ctx_is_child (ctx) || mod_tls_conf == NULL)
+		return;
+
+	/* <certificate-reload period="60" />, 0 disables it */
+	node = axl_doc_get (mod_tls_conf, "/mod-tls/certificate-reload");
+	if (node && HAS_ATTR (node, "period"))
+		mod_tls_reload_period = atoi (ATTR_VALUE (node, "period"));
+	if (mod_tls_reload_period <= 0) {
+		msg ("TLS: background certificate reload disabled");
+		return;
+	} /* end if */
+
+	mod_tls_reload_queue = vortex_async_queue_new ();
+	if (! vortex_thread_create (&mod_tls_reload_thread,
+				    (VortexThreadFunc) mod_tls_reload_run,
+				    mod_tls_reload_queue,
+				    VORTEX_THREAD_CONF_END)) {
+		error ("Failed to start TLS certificate reload thread, changed certificates will require a reload");
+		vortex_async_queue_unref (mod_tls_reload_queue);
+		mod_tls_reload_queue = NULL;
+	} /* end if */
+	return;
+}
+
+/** 
+ * @internal Stops background reload.
+ */
+void mod_tls_reload_stop (void)
+{
+	if (mod_tls_reload_queue == NULL)
+		return;
+
+	vortex_async_queue_push (mod_tls_reload_queue, INT_TO_PTR (1));
+	vortex_thread_destroy (&mod_tls_reload_thread, axl_false);
+	vortex_async_queue_unref (mod_tls_reload_queue);
+	mod_tls_reload_queue = NULL;
+	return;
+}
+
 /* mod_tls init handler */
 static axl_bool  mod_tls_init (TurbulenceCtx * _ctx) {
 
@@ -358,6 +1675,18 @@ static axl_bool  mod_tls_init (TurbulenceCtx * _ctx) {
 	if (! mod_tls_preload_certificates (_ctx))
 		return axl_false;
 
+	/* configure session cache and session tickets (done before
+	   uid/gid change for the same reason) */
+	mod_tls_session_init (_ctx);
+
+	/* compile <certificate-select> declarations (with the content
+	   preloaded) into the configuration snapshot, parsing
+	   certificates and keys once, and check for files changed */
+	vortex_mutex_create (&mod_tls_material_mutex);
+	if (! turbulence_config_register_schema (_ctx, "mod-tls", mod_tls_certificates_build, mod_tls_certificates_free, NULL))
+		error ("Failed to register mod-tls configuration schema, certificates will not be found");
+	mod_tls_reload_start (_ctx);
+
 	/* enable accepting TLS activation */
 	if (! vortex_tls_accept_negotiation (TBC_VORTEX_CTX (_ctx), 
 					     mod_tls_accept_query,
@@ -383,18 +1712,55 @@ static axl_bool  mod_tls_init (TurbulenceCtx * _ctx) {
 
 /* mod_tls close handler */
 static void mod_tls_close (TurbulenceCtx * _ctx) {
+	/* stop checking for certificate changes */
+	mod_tls_reload_stop ();
+
 	/* clean mod tls module */
 	vortex_tls_cleanup (TBC_VORTEX_CTX (_ctx));
 
+	/* release session cache and ticket keys */
+	mod_tls_session_cleanup ();
+
 	/* clear configuration */
 	axl_doc_free (mod_tls_conf);
+	vortex_mutex_destroy (&mod_tls_material_mutex);
 
 	return;
 } /* end mod_tls_close */
 
 /* mod_tls reconf handler */
 static void mod_tls_reconf (TurbulenceCtx * _ctx) {
-	/* reload configuration file */
+	char     * config;
+	axlDoc   * doc;
+	axlError * error = NULL;
+
+	/* reload session ticket keys to allow rotating them and, at
+	 * the master, <certificate-select> declarations (compiled
+	 * again into the configuration snapshot after this handler).
+	 * Childs keep the rest of tls.conf as loaded at startup */
+	if (! mod_tls_tickets && turbulence_ctx_is_child (_ctx))
+		return;
+	config = vortex_support_domain_find_data_file (TBC_VORTEX_CTX(ctx), "tls", "tls.conf");
+	if (config == NULL) 
+		return;
+	doc = axl_doc_parse_from_file (config, &error);
+	axl_free (config);
+	if (doc == NULL) {
+		error ("failed to reload mod-tls configuration file, error found was: %s", 
+		       axl_error_get (error));
+		axl_error_free (error);
+		return;
+	} /* end if */
+	if (mod_tls_tickets)
+		mod_tls_ticket_keys_load (ctx, doc);
+	if (turbulence_ctx_is_child (_ctx)) {
+		axl_doc_free (doc);
+		return;
+	} /* end if */
+
+	/* nobody else walks tls.conf at the master at this point */
+	axl_doc_free (mod_tls_conf);
+	mod_tls_conf = doc;
 	return;
 } /* end mod_tls_reconf */
 
@@ -410,6 +1776,9 @@ axl_bool mod_tls_post_check (VortexConnection * conn,
 {
 	TurbulencePPathDef   * ppath_def = user_data;
 
+	/* update handshake counters */
+	mod_tls_count_handshake (SSL_session_reused ((SSL *) _ssl));
+
 	/* restore turbulence state (profile path selected) */
 	msg ("Restoring turbulence profile path (%d:%s) on TLS connection id=%d",
 	     turbulence_ppath_get_id (ppath_def), turbulence_ppath_get_name (ppath_def), 
@@ -463,6 +1832,7 @@ END_C_DECLS
  * - \ref turbulence_mod_tls_configuration
  * - \ref turbulence_mod_tls_paths
  * - \ref turbulence_mod_tls_profile_path
+ * - \ref turbulence_mod_tls_session_resumption
  *
  * \section turbulence_mod_tls_intro Introduction
  *
@@ -504,6 +1874,23 @@ END_C_DECLS
  * <b>serverName="*"</b> which means that, if no previous stanza
  * matches the requested serverName, then this will be used. 
  *
+ * A wildcard like <b>serverName="*.example.com"</b> matches any
+ * serverName with one label more (www.example.com or
+ * mail.example.com, but not example.com or a.www.example.com).
+ *
+ * Declarations are indexed and certificates and private keys are
+ * parsed once at startup (and when turbulence is reloaded), so many
+ * <b>certificate-select</b> stanzas do not add cost to each TLS
+ * handshake. Every 60 seconds files are checked and those modified
+ * are parsed again (if a certificate and its key do not match yet,
+ * the previous ones are kept until they do). Use the following
+ * inside <b>mod-tls</b> node to change the period (in seconds) or
+ * disable it with 0:
+ *
+ * \code
+ * <certificate-reload period="60" />
+ * \endcode
+ *
  * Here is an example to create a private key and an unsigned public
  * certificate associated:
  * \code
@@ -547,6 +1934,49 @@ END_C_DECLS
  *
  * \htmlinclude tls-sasl-example.xml-tmp
  *
+ * \section turbulence_mod_tls_session_resumption Session cache and session tickets
+ *
+ * By default each TLS connection requires a full handshake. To allow
+ * clients that reconnect frequently to resume their previous session
+ * you can enable a shared session cache and/or session tickets by
+ * placing the following inside <b>mod-tls</b> node:
+ *
+ * \code
+ * <session-cache size="1024" ttl="300" />
+ * <session-tickets>
+ *    <ticket-key key="...96 hexadecimal digits..." />
+ * </session-tickets>
+ * \endcode
+ *
+ * <b>session-cache</b> configures a session cache shared by the
+ * master and all childs (it is a file mapped by all processes,
+ * located by default at ${runtime_datadir}/turbulence/mod-tls-sessions.cache,
+ * use <b>file</b> attribute to change it). <b>size</b> is the number
+ * of sessions that can be stored and <b>ttl</b> is the number of
+ * seconds a session can be resumed. Changing any of them requires
+ * restarting turbulence.
+ *
+ * <b>session-tickets</b> enables stateless session tickets (RFC
+ * 5077) using the keys declared. Each key is 48 random bytes written
+ * in hexadecimal (16 bytes of key name, 16 bytes of HMAC secret and
+ * 16 bytes of AES key), for example:
+ *
+ * \code
+ * >> openssl rand -hex 48
+ * \endcode
+ *
+ * The first <b>ticket-key</b> is used to issue new tickets and the
+ * rest are only accepted (clients presenting them get a new ticket
+ * issued with the first key). To rotate keys, place a new
+ * <b>ticket-key</b> on top, keep the previous one below for a while
+ * and reload turbulence. Remove old keys once they are no longer
+ * needed. Sessions are only resumed inside the same profile path and
+ * serverName.
+ *
+ * Handshake counters (full vs resumed) are available through
+ * mod-radmin with the command <b>show tls</b>. When the session
+ * cache is enabled, they are aggregated across all childs.
+ *
  * \section turbulence_mod_tls_search_path Configuring mod-tls search path
  *
  * Currently, mod-tls searches for tls.conf looking for it in the following other:
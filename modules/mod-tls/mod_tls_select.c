@@ -0,0 +1,143 @@
+/* mod_tls_select implementation: see mod_tls_select.h */
+
+#include <mod_tls_select.h>
+#include <string.h>
+
+/** 
+ * @internal Pattern added with its position (document order).
+ */
+typedef struct _ModTlsSelectItem {
+	int          position;
+	axlPointer   data;
+} ModTlsSelectItem;
+
+struct _ModTlsSelect {
+	/* declarations added so far */
+	int                count;
+	/* serverName -> first declaration with that name */
+	axlHash          * names;
+	/* domain -> first "*.domain" declaration */
+	axlHash          * wildcards;
+	/* first "*" declaration */
+	ModTlsSelectItem * any;
+	/* all items (owns them) */
+	axlList          * all;
+};
+
+/** 
+ * @brief Checks if the serverName declared by a <certificate-select>
+ * (pattern) selects the serverName provided: "*" matches any name
+ * (even NULL), "*.example.com" matches "www.example.com" but not
+ * "example.com" or "a.www.example.com", and any other pattern must be
+ * equal.
+ */
+axl_bool mod_tls_name_matches (const char * pattern, const char * serverName)
+{
+	const char * domain;
+
+	if (pattern == NULL)
+		return axl_false;
+	if (axl_cmp (pattern, "*"))
+		return axl_true;
+	if (serverName == NULL)
+		return axl_false;
+	if (pattern[0] == '*' && pattern[1] == '.' && pattern[2]) {
+		domain = strchr (serverName, '.');
+		return domain && domain != serverName && axl_cmp (domain + 1, pattern + 2);
+	} /* end if */
+	return axl_cmp (pattern, serverName);
+}
+
+/** 
+ * @brief Creates an empty index.
+ */
+ModTlsSelect * mod_tls_select_new (void)
+{
+	ModTlsSelect * selection;
+
+	selection            = axl_new (ModTlsSelect, 1);
+	selection->names     = axl_hash_new (axl_hash_string, axl_hash_equal_string);
+	selection->wildcards = axl_hash_new (axl_hash_string, axl_hash_equal_string);
+	selection->all       = axl_list_new (axl_list_always_return_1, axl_free);
+	return selection;
+}
+
+/** 
+ * @brief Adds the pattern declared by the next <certificate-select>
+ * (calls must follow document order). Only the first declaration for
+ * a pattern is reachable, the same as walking the document. The
+ * pattern must remain valid while the index is used.
+ *
+ * @param select The index.
+ * @param pattern The serverName declared (NULL is ignored).
+ * @param data The value returned by mod_tls_select_lookup.
+ */
+void           mod_tls_select_add     (ModTlsSelect * selection, const char * pattern, axlPointer data)
+{
+	ModTlsSelectItem * item;
+
+	if (selection == NULL || pattern == NULL)
+		return;
+
+	item           = axl_new (ModTlsSelectItem, 1);
+	item->position = selection->count++;
+	item->data     = data;
+	axl_list_append (selection->all, item);
+
+	if (axl_cmp (pattern, "*")) {
+		if (selection->any == NULL)
+			selection->any = item;
+	} else if (strlen (pattern) > 2 && pattern[0] == '*' && pattern[1] == '.') {
+		if (axl_hash_get (selection->wildcards, (axlPointer) (pattern + 2)) == NULL)
+			axl_hash_insert (selection->wildcards, (axlPointer) (pattern + 2), item);
+	} else if (axl_hash_get (selection->names, (axlPointer) pattern) == NULL)
+		axl_hash_insert (selection->names, (axlPointer) pattern, item);
+	return;
+}
+
+/** 
+ * @brief Returns the data of the declaration selected for serverName
+ * (see mod_tls_name_matches): the first in document order among the
+ * exact name, the wildcard matching it and "*". NULL if none matches.
+ */
+axlPointer     mod_tls_select_lookup  (ModTlsSelect * selection, const char * serverName)
+{
+	ModTlsSelectItem * item;
+	ModTlsSelectItem * found;
+	const char       * domain;
+
+	if (selection == NULL)
+		return NULL;
+
+	item = selection->any;
+	if (serverName != NULL) {
+		/* exact name */
+		found = axl_hash_get (selection->names, (axlPointer) serverName);
+		if (found && (item == NULL || found->position < item->position))
+			item = found;
+
+		/* wildcard: only the first label is replaced */
+		domain = strchr (serverName, '.');
+		if (domain && domain != serverName && domain[1]) {
+			found = axl_hash_get (selection->wildcards, (axlPointer) (domain + 1));
+			if (found && (item == NULL || found->position < item->position))
+				item = found;
+		} /* end if */
+	} /* end if */
+
+	return item ? item->data : NULL;
+}
+
+/** 
+ * @brief Releases the index (data added is not released).
+ */
+void           mod_tls_select_free    (ModTlsSelect * selection)
+{
+	if (selection == NULL)
+		return;
+	axl_hash_free (selection->names);
+	axl_hash_free (selection->wildcards);
+	axl_list_free (selection->all);
+	axl_free (selection);
+	return;
+}
@@ -0,0 +1,31 @@
+/* mod_tls_select: serverName matching of <certificate-select>
+ *
+ * Rules applied to select the <certificate-select> declaration for a
+ * serverName: exact names, "*.domain" wildcards (replacing only the
+ * first label) and "*". The first declaration in document order that
+ * matches wins.
+ *
+ * It depends on libaxl alone (no OpenSSL, vortex or turbulence
+ * context), so it is exercised directly by test_01 (test_22b).
+ */
+#ifndef __MOD_TLS_SELECT_H__
+#define __MOD_TLS_SELECT_H__
+
+#include <axl.h>
+
+/**
+ * @brief Index of serverName patterns (see mod_tls_select_add).
+ */
+typedef struct _ModTlsSelect ModTlsSelect;
+
+axl_bool       mod_tls_name_matches   (const char * pattern, const char * serverName);
+
+ModTlsSelect * mod_tls_select_new     (void);
+
+void           mod_tls_select_add     (ModTlsSelect * selection, const char * pattern, axlPointer data);
+
+axlPointer     mod_tls_select_lookup  (ModTlsSelect * selection, const char * serverName);
+
+void           mod_tls_select_free    (ModTlsSelect * selection);
+
+#endif
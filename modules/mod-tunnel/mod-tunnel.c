@@ -36,50 +36,144 @@
  */
 #include <mod-tunnel.h>
 
-axlDoc          * mod_tunnel_resolver = NULL;
 axlDoc          * tunnel_conf         = NULL;
 TurbulenceCtx   * ctx              = NULL;
 
-int  find_and_replace (const char * conf, axlNode * node)
+/** 
+ * @internal Next hop a <match> declaration translates to.
+ */
+typedef struct _ModTunnelRoute {
+	char * ip4;
+	char * fqdn;
+	char * port;
+} ModTunnelRoute;
+
+/** 
+ * @internal resolver.xml compiled into the configuration snapshot
+ * (see mod_tunnel_routes_build).
+ */
+typedef struct _ModTunnelRoutes {
+	/* endpoint -> first <match endpoint> declared */
+	axlHash * endpoints;
+	/* profile -> first <match profile> declared */
+	axlHash * profiles;
+	/* all routes (owns them) */
+	axlList * all;
+} ModTunnelRoutes;
+
+void mod_tunnel_route_free (axlPointer _route)
 {
-	axlNode    * db;
-	const char * value = ATTR_VALUE (node, conf);
-
-	/* lookup for the value at the provided conf */
-	db = axl_doc_get (mod_tunnel_resolver, "/tunnel-resolver/match");
-	while (db != NULL) {
-		/* check node found */
-		if (HAS_ATTR_VALUE (db, conf, value)) {
-			/* remove current node */
-			axl_node_remove_attribute (node, conf);
-
-			/* configure new values, check host */
-			value = ATTR_VALUE (node, "host");
-			if (axl_memcmp (value, "ip4:", 4)) {
-				/* ip4 case */
-				axl_node_set_attribute (node, "ip4", value + 4);
-
-			} else if (axl_memcmp (value, "fqdn:", 5)) {
-				/* fqdn case */
-				axl_node_set_attribute (node, "fqdn", value + 5);
-
-			} else {
-				/* ip4 case, default */
-				axl_node_set_attribute (node, "ip4", value + 4);
-			}
-
-			/* configure new values, check port */
-			value = ATTR_VALUE (node, "port");
-			axl_node_set_attribute (node, "port", value);
-
-			return true;
-		} /* node found ! */
+	ModTunnelRoute * route = _route;
 
-		/* get next node */
-		db = axl_node_get_next (db);
+	axl_free (route->ip4);
+	axl_free (route->fqdn);
+	axl_free (route->port);
+	axl_free (route);
+	return;
+}
+
+void mod_tunnel_routes_free (axlPointer _routes)
+{
+	ModTunnelRoutes * routes = _routes;
+
+	axl_hash_free (routes->endpoints);
+	axl_hash_free (routes->profiles);
+	axl_list_free (routes->all);
+	axl_free (routes);
+	return;
+}
+
+/** 
+ * @internal Loads the resolver file configured at tunnel.conf (NULL
+ * if none is configured or it fails to load).
+ */
+axlDoc * mod_tunnel_load_resolver (void)
+{
+	axlNode  * node;
+	axlDoc   * doc;
+	axlError * error = NULL;
+	char     * config;
+
+	node = axl_doc_get (tunnel_conf, "/mod-tunnel/tunnel-resolver");
+	if (! HAS_ATTR_VALUE (node, "type", "xml") || ! HAS_ATTR (node, "location"))
+		return NULL;
+
+	/* find the file to load */
+	config = vortex_support_domain_find_data_file (TBC_VORTEX_CTX(ctx), "tunnel", ATTR_VALUE (node, "location"));
+	if (config == NULL) {
+		error ("failed to find resolver file %s, TUNNEL translation settings will not be applied", 
+		       ATTR_VALUE (node, "location"));
+		return NULL;
 	} /* end if */
+	doc = axl_doc_parse_from_file (config, &error);
+	if (doc == NULL) {
+		error ("failed to open resolver file, TUNNEL translation settings will not be applied, error: %s",
+		       axl_error_get (error));
+		axl_error_free (error);
+	} else
+		msg ("database resolver for TUNNEL loaded: %s", config);
+	axl_free (config);
+
+	return doc;
+}
+
+/** 
+ * @internal Schema build handler (see
+ * turbulence_config_register_schema) that indexes resolver.xml
+ * <match> declarations by endpoint and profile so TUNNEL requests
+ * are translated without walking the file.
+ */
+axlPointer mod_tunnel_routes_build (TurbulenceCtx * _ctx, axlDoc * config, axlPointer user_data)
+{
+	ModTunnelRoutes * routes;
+	ModTunnelRoute  * route;
+	axlDoc          * doc;
+	axlNode         * node;
+	const char      * host;
+
+	doc = mod_tunnel_load_resolver ();
+	if (doc == NULL)
+		return NULL;
+
+	routes            = axl_new (ModTunnelRoutes, 1);
+	routes->endpoints = axl_hash_new (axl_hash_string, axl_hash_equal_string);
+	routes->profiles  = axl_hash_new (axl_hash_string, axl_hash_equal_string);
+	routes->all       = axl_list_new (axl_list_always_return_1, mod_tunnel_route_free);
+
+	node = axl_doc_get (doc, "/tunnel-resolver/match");
+	while (node != NULL) {
+		if (! NODE_CMP_NAME (node, "match") || ! HAS_ATTR (node, "host") || ! HAS_ATTR (node, "port")) {
+			/* get next node */
+			node = axl_node_get_next (node);
+			continue;
+		} /* end if */
 
-	return false;
+		/* translate host: ip4:, fqdn: or a name */
+		route       = axl_new (ModTunnelRoute, 1);
+		host        = ATTR_VALUE (node, "host");
+		if (axl_memcmp (host, "ip4:", 4))
+			route->ip4  = axl_strdup (host + 4);
+		else if (axl_memcmp (host, "fqdn:", 5))
+			route->fqdn = axl_strdup (host + 5);
+		else
+			route->fqdn = axl_strdup (host);
+		route->port = axl_strdup (ATTR_VALUE (node, "port"));
+		axl_list_append (routes->all, route);
+
+		/* index it: only the first declaration for a value is
+		 * reachable, the same as walking the file */
+		if (HAS_ATTR (node, "endpoint") && axl_hash_get (routes->endpoints, (axlPointer) ATTR_VALUE (node, "endpoint")) == NULL)
+			axl_hash_insert_full (routes->endpoints, axl_strdup (ATTR_VALUE (node, "endpoint")), axl_free, route, NULL);
+		if (HAS_ATTR (node, "profile") && axl_hash_get (routes->profiles, (axlPointer) ATTR_VALUE (node, "profile")) == NULL)
+			axl_hash_insert_full (routes->profiles, axl_strdup (ATTR_VALUE (node, "profile")), axl_free, route, NULL);
+
+		/* get next node */
+		node = axl_node_get_next (node);
+	} /* end while */
+	axl_doc_free (doc);
+
+	msg ("TUNNEL: indexed %d resolver <match> declarations", axl_list_length (routes->all));
+	return routes;
 }
 
 /** 
@@ -91,30 +185,57 @@ VortexTunnelSettings * tunnel_resolver (const char * profile_content,
 					axlPointer   user_data)
 {
 	
-	axlNode              * node = NULL;
-	char                 * content;
-	int                    size;
-	VortexTunnelSettings * settings;
+	axlNode                  * node = NULL;
+	char                     * content;
+	int                        size;
+	VortexTunnelSettings     * settings;
+	TurbulenceConfigSnapshot * snapshot;
+	ModTunnelRoutes          * routes;
+	ModTunnelRoute           * route = NULL;
 
 	/* get root, that is, the next hop */
 	node = axl_doc_get_root (doc);
 
 	/* check profile and endpoint */
-	if (! HAS_ATTR (node, "endpoing") && ! HAS_ATTR (node, "profile"))
+	if (! HAS_ATTR (node, "endpoint") && ! HAS_ATTR (node, "profile"))
 		return NULL;
 
-	/* check and translate */
-	if (HAS_ATTR (node, "endpoint")) {
-		/* try to translate endpoing */
-		find_and_replace ("endpoint", node);
+	/* find the next hop: endpoint is checked first */
+	snapshot = turbulence_config_snapshot (ctx);
+	routes   = turbulence_config_snapshot_module (snapshot, "mod-tunnel");
+	if (routes && HAS_ATTR (node, "endpoint"))
+		route = axl_hash_get (routes->endpoints, (axlPointer) ATTR_VALUE (node, "endpoint"));
+	if (routes && route == NULL && HAS_ATTR (node, "profile"))
+		route = axl_hash_get (routes->profiles, (axlPointer) ATTR_VALUE (node, "profile"));
+	if (route == NULL) {
+		/* nothing to translate */
+		turbulence_config_snapshot_unref (snapshot);
+		return NULL;
 	} /* end if */
 
-	/* check and translate */
-	if (HAS_ATTR (node, "profile")) {
-		/* try to translate endpoing */
-		find_and_replace ("profile", node);
+	/* usual case: only the next hop is requested, so settings are
+	 * built from the route without dumping the request */
+	if (axl_node_get_first_child (node) == NULL) {
+		settings = vortex_tunnel_settings_new (TBC_VORTEX_CTX(ctx));
+		if (route->ip4)
+			vortex_tunnel_settings_add_hop (settings, TUNNEL_IP4, route->ip4, TUNNEL_PORT, route->port, TUNNEL_END_CONF);
+		else
+			vortex_tunnel_settings_add_hop (settings, TUNNEL_FQDN, route->fqdn, TUNNEL_PORT, route->port, TUNNEL_END_CONF);
+		turbulence_config_snapshot_unref (snapshot);
+		return settings;
 	} /* end if */
 
+	/* more hops requested: translate the next hop and let vortex
+	 * parse the rest */
+	axl_node_remove_attribute (node, "endpoint");
+	axl_node_remove_attribute (node, "profile");
+	if (route->ip4)
+		axl_node_set_attribute (node, "ip4", route->ip4);
+	else
+		axl_node_set_attribute (node, "fqdn", route->fqdn);
+	axl_node_set_attribute (node, "port", route->port);
+	turbulence_config_snapshot_unref (snapshot);
+
 	/* dump the content translated, and free document */
 	axl_doc_dump (doc, &content, &size);
 
@@ -132,7 +253,6 @@ VortexTunnelSettings * tunnel_resolver (const char * profile_content,
  */
 static int  tunnel_init (TurbulenceCtx * _ctx)
 {
-	axlNode  * node;
 	axlError * error;
 	char     * config;
 
@@ -156,21 +276,10 @@ static int  tunnel_init (TurbulenceCtx * _ctx)
 		return false;
 	} /* end if */
 	
-	/* init translation database */
-	node                = axl_doc_get (tunnel_conf, "/mod-tunnel/tunnel-resolver");
-	if (HAS_ATTR_VALUE (node, "type", "xml") &&
-	    HAS_ATTR (node, "location")) {
-		/* find the file to load */
-		config              = vortex_support_domain_find_data_file (TBC_VORTEX_CTX(ctx), "tunnel", ATTR_VALUE (node, "location"));
-		mod_tunnel_resolver = axl_doc_parse_from_file (config, NULL);
-		if (mod_tunnel_resolver == NULL) {
-			error ("failed to open resolver file, TUNNEL translation settings will not be applied, error: %s",
-			       axl_error_get (error));
-			axl_error_free (error);
-		} /* end if */
-		msg ("database resolver for TUNNEL loaded: %s", config);
-		axl_free (config);
-	} /* end if */
+	/* init translation database: resolver.xml is indexed into the
+	 * configuration snapshot (loaded again on reload) */
+	if (! turbulence_config_register_schema (ctx, "mod-tunnel", mod_tunnel_routes_build, mod_tunnel_routes_free, NULL))
+		error ("failed to register mod-tunnel configuration schema, TUNNEL translation settings will not be applied");
 
 	/* activates the tunnel profile to accept connections
 	 * (tunneling them or forwarding them to the next hop) */
@@ -194,7 +303,6 @@ static void tunnel_close (TurbulenceCtx * ctx)
 {
 	msg ("turbulence TUNNEL close");
 	axl_doc_free (tunnel_conf);
-	axl_doc_free (mod_tunnel_resolver);
 }
 
 /**
@@ -265,4 +373,13 @@ TurbulenceModDef module_def = {
  * 
  * \htmlinclude resolver.xml-tmp
  *
+ * <b>host</b> may be prefixed with <b>ip4:</b> or <b>fqdn:</b>
+ * (a name is used if no prefix is found). When several
+ * <b>match</b> declarations apply, the first one found is used, and
+ * <b>endpoint</b> is checked before <b>profile</b>.
+ *
+ * <b>resolver.xml</b> is indexed when the module is loaded and again
+ * when turbulence is reloaded, so changes to it are applied by
+ * reloading turbulence (no TUNNEL request reads the file).
+ *
  */
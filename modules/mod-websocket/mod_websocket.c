@@ -237,20 +237,102 @@ void __mod_websocket_nopoll_log (noPollCtx * nopoll_ctx, noPollDebugLevel level,
 	return;
 }
 
-/* mod_websocket init handler */
-static int  mod_websocket_init (TurbulenceCtx * _ctx) {
-	axlNode    * node;
-	const char * port;
-	axl_bool     enable_tls;
+/** 
+ * @internal Configures logging and certificates on a noPoll context.
+ */
+void mod_websocket_ctx_prepare (TurbulenceCtx * _ctx, noPollCtx * _nopoll_ctx)
+{
+	/* enable nopoll log by default */
+	nopoll_log_enable (_nopoll_ctx, nopoll_true);
+	nopoll_log_color_enable (_nopoll_ctx, nopoll_true);
+	nopoll_log_set_handler (_nopoll_ctx, __mod_websocket_nopoll_log, _ctx);
+
+	/* read all certificates */
+	mod_websocket_load_certificate_locations (_nopoll_ctx);
+	return;
+}
+
+/** 
+ * @internal Releases a noPoll context.
+ */
+void mod_websocket_ctx_release (axlPointer _nopoll_ctx)
+{
+	/* configure log handling */
+	nopoll_log_enable (_nopoll_ctx, nopoll_false);
+	nopoll_log_color_enable (_nopoll_ctx, nopoll_false);
+	nopoll_log_set_handler (_nopoll_ctx, NULL, NULL);
 
+	nopoll_ctx_unref (_nopoll_ctx);
+	return;
+}
+
+/** 
+ * @internal Associates a noPoll listener to BEEP.
+ */
+axl_bool mod_websocket_listener_start (TurbulenceCtx * _ctx, noPollConn * nopoll_listener)
+{
+	VortexConnection * listener;
+
+	/* now associate that listener to BEEP */
+	listener = vortex_websocket_listener_new (TBC_VORTEX_CTX (_ctx), nopoll_listener, NULL, NULL);
+	if (! vortex_connection_is_ok (listener, axl_false)) {
+		error ("ERROR: expected to find proper BEEP listener over Websocket creation but failure was found..\n");
+		return axl_false;
+	} /* end if */
+
+	msg ("Websocket (noPoll) listener socket started at: %s:%s", vortex_connection_get_host (listener), vortex_connection_get_port (listener));
+	return axl_true;
+}
+
+/** 
+ * @internal Starts the listener declared by a <port> node, bound to
+ * its address (by default all addresses).
+ */
+axl_bool mod_websocket_start_port (TurbulenceCtx * _ctx, axlNode * node)
+{
+	const char   * port;
+	const char   * address;
+	axl_bool       enable_tls;
 
 	/* cert and key path to be used on each particular host */
 	const char * cert;
 	const char * key;
 	noPollConn * nopoll_listener;
-	
-	/* listener */
-	VortexConnection * listener;
+
+	/* get port and address to bind */
+	port       = axl_node_get_content_trim (node, NULL);
+	address    = HAS_ATTR (node, "address") ? ATTR_VALUE (node, "address") : "0.0.0.0";
+	enable_tls = HAS_ATTR_VALUE (node, "enable-tls", "yes");
+	if (! port || strlen (port) == 0) 
+		return axl_true;
+
+	/* get cert and key */
+	cert = ATTR_VALUE (node, "cert");
+	key  = ATTR_VALUE (node, "key");
+
+	msg ("Websocket (noPoll): attempting to starting listener port on %s:%s, enable-tls=%d%s%s%s%s", 
+	     address, port, enable_tls,
+	     cert ? ", cert=" : "",
+	     cert ? cert : "",
+	     key ? ", key=" : "",
+	     key ? key : "");
+
+	/* create the noPoll listener */
+	if (enable_tls) {
+		nopoll_listener = nopoll_listener_tls_new (nopoll_ctx, address, port); 
+
+		/* set listener certificate */
+		if (cert && key)
+			nopoll_listener_set_certificate (nopoll_listener, cert, key, NULL);
+	} else
+		nopoll_listener = nopoll_listener_new (nopoll_ctx, address, port);
+
+	return mod_websocket_listener_start (_ctx, nopoll_listener);
+}
+
+/* mod_websocket init handler */
+static int  mod_websocket_init (TurbulenceCtx * _ctx) {
+	axlNode    * node;
 
 	/* configure the module */
 	TBC_MOD_PREPARE (_ctx);
@@ -277,58 +359,19 @@ static int  mod_websocket_init (TurbulenceCtx * _ctx) {
 	/* check and install port share config (even in child) */
 	__mod_websocket_check_and_enable_port_sharing (_ctx, mod_websocket_conf, nopoll_ctx); 
 
-	/* enable nopoll log by default */
-	nopoll_log_enable (nopoll_ctx, nopoll_true);
-	nopoll_log_color_enable (nopoll_ctx, nopoll_true);
-	nopoll_log_set_handler (nopoll_ctx, __mod_websocket_nopoll_log, _ctx);
-
 	/* check for debug enable=yes */
 	node = axl_doc_get (mod_websocket_conf, "/mod-websocket/general-settings/debug");
 	if (HAS_ATTR_VALUE (node, "enable", "yes"))
 		__mod_websocket_nopoll_log_enabled = axl_true;
 
-
-	/* read all certificates */
-	mod_websocket_load_certificate_locations (nopoll_ctx);
+	/* configure log and read all certificates */
+	mod_websocket_ctx_prepare (_ctx, nopoll_ctx);
 
 	/* now for each listener start it */
 	node = axl_doc_get (mod_websocket_conf, "/mod-websocket/ports/port");
 	while (node) {
-		/* get port */
-		port       = axl_node_get_content_trim (node, NULL);
-		enable_tls = HAS_ATTR_VALUE (node, "enable-tls", "yes");
-		if (! port) 
-			continue;
-
-		/* get cert and key */
-		cert = ATTR_VALUE (node, "cert");
-		key  = ATTR_VALUE (node, "key");
-
-		msg ("Websocket (noPoll): attempting to starting listener port on %s, enable-tls=%d%s%s%s%s", 
-		     port, enable_tls,
-		     cert ? ", cert=" : "",
-		     cert ? cert : "",
-		     key ? ", key=" : "",
-		     key ? key : "");
-
-		/* create the noPoll listener */
-		if (enable_tls) {
-			nopoll_listener = nopoll_listener_tls_new (nopoll_ctx, "0.0.0.0", port); 
-
-			/* set listener certificate */
-			if (cert && key)
-				nopoll_listener_set_certificate (nopoll_listener, cert, key, NULL);
-		} else
-			nopoll_listener = nopoll_listener_new (nopoll_ctx, "0.0.0.0", port);
-
-		/* now associate that listener to BEEP */
-		listener = vortex_websocket_listener_new (TBC_VORTEX_CTX (_ctx), nopoll_listener, NULL, NULL);
-		if (! vortex_connection_is_ok (listener, axl_false)) {
-			error ("ERROR: expected to find proper BEEP listener over Websocket creation but failure was found..\n");
+		if (! mod_websocket_start_port (_ctx, node))
 			return axl_false;
-		} /* end if */
-
-		msg ("Websocket (noPoll) listener socket started at: %s:%s", vortex_connection_get_host (listener), vortex_connection_get_port (listener));
 
 		/* get next port */
 		node = axl_node_get_next_called (node, "port");
@@ -348,12 +391,9 @@ static void mod_websocket_close (TurbulenceCtx * _ctx) {
 	axl_doc_free (mod_websocket_conf);
 	mod_websocket_conf = NULL;
 
-	/* configure log handling */
-	nopoll_log_enable (nopoll_ctx, nopoll_false);
-	nopoll_log_color_enable (nopoll_ctx, nopoll_false);
-	nopoll_log_set_handler (nopoll_ctx, NULL, NULL);
-
-	nopoll_ctx_unref (nopoll_ctx);
+	/* release noPoll context */
+	if (nopoll_ctx)
+		mod_websocket_ctx_release (nopoll_ctx);
 	nopoll_ctx = NULL;
 
 	/* cleanup library */
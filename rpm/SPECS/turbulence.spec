@@ -84,6 +84,8 @@ Development headers required to create turbulence modules or
 tools.
 %files -n libturbulence-dev
    /usr/include/turbulence/exarg.h
+   /usr/include/turbulence/turbulence-affinity.h
+   /usr/include/turbulence/turbulence-arena.h
    /usr/include/turbulence/turbulence-child.h
    /usr/include/turbulence/turbulence-config.h
    /usr/include/turbulence/turbulence-conn-mgr.h
@@ -95,13 +97,16 @@ tools.
    /usr/include/turbulence/turbulence-log.h
    /usr/include/turbulence/turbulence-loop.h
    /usr/include/turbulence/turbulence-mediator.h
+   /usr/include/turbulence/turbulence-metrics.h
    /usr/include/turbulence/turbulence-moddef.h
    /usr/include/turbulence/turbulence-module.h
    /usr/include/turbulence/turbulence-ppath.h
    /usr/include/turbulence/turbulence-process.h
    /usr/include/turbulence/turbulence-run.h
+   /usr/include/turbulence/turbulence-shaper.h
    /usr/include/turbulence/turbulence-signal.h
    /usr/include/turbulence/turbulence-support.h
+   /usr/include/turbulence/turbulence-trace.h
    /usr/include/turbulence/turbulence-types.h
    /usr/include/turbulence/turbulence.h
    /usr/lib/pkgconfig/sasl-radmin.pc
@@ -276,6 +281,7 @@ Requires: readline
 %description  -n turbulence-utils
 Utils to manage turbulence features.
 %files -n turbulence-utils
+   /usr/bin/tbc-bench
    /usr/bin/tbc-dblist-mgr
    /usr/bin/tbc-mod-gen
 
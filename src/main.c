@@ -56,6 +56,9 @@ int  main_init_exarg (int argc, char ** argv)
 	/* set starting process name */
 	turbulence_process_set_file_path (argv[0]);
 
+	/* save command line to run it again on binary upgrade */
+	turbulence_process_set_argv (argv);
+
 	/* install headers for help */
 	exarg_add_usage_header  (HELP_HEADER);
 	exarg_add_help_header   (HELP_HEADER);
@@ -101,6 +104,9 @@ int  main_init_exarg (int argc, char ** argv)
 	exarg_install_arg ("child", NULL, EXARG_STRING,
 			   "Internal flag used to create childs by the master process.");
 
+	exarg_install_arg ("upgrade", NULL, EXARG_STRING,
+			   "Internal flag used by the master process to pass listeners and childs to a new binary on upgrade (SIGUSR2).");
+
 	exarg_install_arg ("child-cmd-prefix", NULL, EXARG_STRING,
 			   "Allows to configure an optional command prefix appended to the child starting command");
 
@@ -366,6 +372,10 @@ int main (int argc, char ** argv)
 		turbulence_place_pidfile ();
 	}
 
+	/* check if we are the new binary started by an upgrade */
+	if (exarg_is_defined ("upgrade")) 
+		turbulence_process_upgrade_prepare (ctx, exarg_get_string ("upgrade"));
+
 	
 
 	/* init libraries */
@@ -382,7 +392,7 @@ int main (int argc, char ** argv)
 	if (! vortex_log_is_enabled (vortex_ctx)) {
 		/* notify we are enabling this to inform child process
 		 * to avoid enabling this on command line */
-		turbulence_ctx_set_data (ctx, "debug-was-not-requested", INT_TO_PTR (axl_true));
+		turbulence_ctx_slot_set (ctx, ctx->debug_not_requested_slot, INT_TO_PTR (axl_true));
 
 		/* enable log */
 		vortex_log_enable (vortex_ctx, axl_true); 
@@ -0,0 +1,302 @@
+/*  Turbulence BEEP application server
+ *  Copyright (C) 2025 Advanced Software Production Line, S.L.
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; version 2.1 of the
+ *  License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free
+ *  Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307 USA
+ *  
+ *  You may find a copy of the license under this software is released
+ *  at COPYING file. This is LGPL software: you are welcome to develop
+ *  proprietary applications using this library without any royalty or
+ *  fee but returning back any change, improvement or addition in the
+ *  form of source code, project image, documentation patches, etc.
+ *
+ *  For commercial support on build BEEP enabled solutions, supporting
+ *  turbulence based solutions, etc, contact us:
+ *          
+ *      Postal address:
+ *         Advanced Software Production Line, S.L.
+ *         C/ Antonio Suarez Nº10, Edificio Alius A, Despacho 102
+ *         Alcala de Henares, 28802 (MADRID)
+ *         Spain
+ *
+ *      Email address:
+ *         info@aspl.es - http://www.aspl.es/turbulence
+ */
+#if defined(__linux__)
+/* required for sched_setaffinity and cpu_set_t */
+#define _GNU_SOURCE
+#endif
+#include <turbulence.h>
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+/* numa memory policy (see set_mempolicy(2)), defined here to avoid
+ * depending on libnuma headers */
+#define TBC_MPOL_PREFERRED 1
+
+/** 
+ * \defgroup turbulence_affinity Turbulence Affinity: CPU and NUMA placement for childs and loops
+ */
+
+/** 
+ * \addtogroup turbulence_affinity
+ * @{
+ */
+
+#if defined(__linux__)
+/** 
+ * @internal Parses a cpu list (like "0-3,8,10-11") into the provided
+ * set. Returns axl_false if the list is not valid or it is empty.
+ */
+axl_bool __turbulence_affinity_parse (const char * cpus, cpu_set_t * set)
+{
+	char ** items;
+	char  * end;
+	int     iterator;
+	long    first;
+	long    last;
+	int     count = 0;
+
+	CPU_ZERO (set);
+	if (cpus == NULL)
+		return axl_false;
+
+	items = axl_split (cpus, 1, ",");
+	if (items == NULL)
+		return axl_false;
+
+	for (iterator = 0; items[iterator]; iterator++) {
+		axl_stream_trim (items[iterator]);
+		first = strtol (items[iterator], &end, 10);
+		if (end == items[iterator] || first < 0)
+			break;
+		last = first;
+		if (end[0] == '-')
+			last = strtol (end + 1, &end, 10);
+		if (end[0] != 0 || last < first || last >= CPU_SETSIZE)
+			break;
+
+		while (first <= last) {
+			CPU_SET (first, set);
+			first++;
+			count++;
+		} /* end while */
+	} /* end for */
+
+	/* check all items were parsed */
+	if (items[iterator] != NULL)
+		count = 0;
+	axl_freev (items);
+
+	return count > 0;
+}
+
+/** 
+ * @internal Builds the cpu list representing the provided set.
+ */
+char * __turbulence_affinity_to_string (cpu_set_t * set)
+{
+	char * result = NULL;
+	char * aux;
+	char * range;
+	int    first;
+	int    cpu    = 0;
+
+	while (cpu < CPU_SETSIZE) {
+		if (! CPU_ISSET (cpu, set)) {
+			cpu++;
+			continue;
+		} /* end if */
+
+		/* find range end */
+		first = cpu;
+		while (cpu + 1 < CPU_SETSIZE && CPU_ISSET (cpu + 1, set))
+			cpu++;
+		if (first == cpu)
+			range = axl_strdup_printf ("%d", first);
+		else
+			range = axl_strdup_printf ("%d-%d", first, cpu);
+
+		/* append */
+		aux    = result;
+		result = aux ? axl_strdup_printf ("%s,%s", aux, range) : axl_strdup (range);
+		axl_free (aux);
+		axl_free (range);
+		cpu++;
+	} /* end while */
+
+	return result;
+}
+#endif
+
+/** 
+ * @brief Binds the calling thread to the provided cpu list (like
+ * "0-3,8"). Threads and processes created after the call (including
+ * programs run with exec) inherit the affinity.
+ *
+ * @param ctx The turbulence context.
+ * @param cpus The cpu list.
+ *
+ * @return axl_true if the affinity was applied, otherwise axl_false
+ * is returned (wrong cpu list or not supported).
+ */
+axl_bool          turbulence_affinity_apply (TurbulenceCtx * ctx, const char * cpus)
+{
+#if defined(__linux__)
+	cpu_set_t set;
+
+	if (! __turbulence_affinity_parse (cpus, &set)) {
+		error ("wrong cpu list '%s', affinity not applied", cpus ? cpus : "");
+		return axl_false;
+	} /* end if */
+
+	if (sched_setaffinity (0, sizeof (set), &set) != 0) {
+		error ("failed to set affinity to cpus %s, errno=%d:%s", cpus, errno, vortex_errno_get_last_error ());
+		return axl_false;
+	} /* end if */
+	return axl_true;
+#else
+	error ("cpu affinity is not supported on this platform, ignoring cpus %s", cpus ? cpus : "");
+	return axl_false;
+#endif
+}
+
+/** 
+ * @brief Returns the number of NUMA nodes available (1 when the
+ * system is not NUMA or it can't be found).
+ *
+ * @param ctx The turbulence context.
+ */
+int               turbulence_affinity_numa_nodes (TurbulenceCtx * ctx)
+{
+	int    nodes = 0;
+
+	while (turbulence_file_test_v ("/sys/devices/system/node/node%d", FILE_IS_DIR, nodes))
+		nodes++;
+
+	return nodes > 0 ? nodes : 1;
+}
+
+/** 
+ * @brief Returns the cpu list of the provided NUMA node, optionally
+ * restricted to cpus found in restrict_to.
+ *
+ * @param ctx The turbulence context.
+ * @param node The NUMA node.
+ * @param restrict_to Optional cpu list to intersect with node cpus.
+ *
+ * @return A newly allocated cpu list or NULL if the node is not found
+ * or it has no cpu (or no cpu in restrict_to).
+ */
+char            * turbulence_affinity_numa_cpus (TurbulenceCtx * ctx, int node, const char * restrict_to)
+{
+#if defined(__linux__)
+	char      * path;
+	FILE      * file;
+	char        buffer[1024];
+	cpu_set_t   set;
+	cpu_set_t   restricted;
+
+	path = axl_strdup_printf ("/sys/devices/system/node/node%d/cpulist", node);
+	file = fopen (path, "r");
+	axl_free (path);
+	if (file == NULL)
+		return NULL;
+	if (fgets (buffer, sizeof (buffer), file) == NULL) {
+		fclose (file);
+		return NULL;
+	} /* end if */
+	fclose (file);
+
+	/* remove trailing new line */
+	axl_stream_trim (buffer);
+	if (! __turbulence_affinity_parse (buffer, &set))
+		return NULL;
+
+	if (restrict_to) {
+		if (! __turbulence_affinity_parse (restrict_to, &restricted))
+			return NULL;
+		CPU_AND (&set, &set, &restricted);
+		if (CPU_COUNT (&set) == 0)
+			return NULL;
+	} /* end if */
+
+	return __turbulence_affinity_to_string (&set);
+#else
+	return NULL;
+#endif
+}
+
+/** 
+ * @brief Makes memory allocated by the calling thread (and processes
+ * it creates) to be preferably taken from the provided NUMA node.
+ *
+ * @param ctx The turbulence context.
+ * @param node The NUMA node.
+ *
+ * @return axl_true if the policy was applied, otherwise axl_false.
+ */
+axl_bool          turbulence_affinity_numa_prefer (TurbulenceCtx * ctx, int node)
+{
+#if defined(__linux__) && defined(SYS_set_mempolicy)
+	unsigned long mask;
+
+	if (node < 0 || node >= (int) (sizeof (mask) * 8))
+		return axl_false;
+
+	mask = 1UL << node;
+	if (syscall (SYS_set_mempolicy, TBC_MPOL_PREFERRED, &mask, sizeof (mask) * 8) != 0) {
+		error ("failed to set memory policy to prefer numa node %d, errno=%d:%s", node, errno, vortex_errno_get_last_error ());
+		return axl_false;
+	} /* end if */
+	return axl_true;
+#else
+	return axl_false;
+#endif
+}
+
+/** 
+ * @brief Configures the affinity of the provided loop according to
+ * the attribute with the provided name found at
+ * <b>/turbulence/global-settings/loop-affinity</b> (if any).
+ *
+ * @param ctx The turbulence context.
+ * @param loop The loop to configure.
+ * @param name The loop name (for example log-manager or proxy).
+ */
+void              turbulence_affinity_configure_loop (TurbulenceCtx  * ctx, 
+						      TurbulenceLoop * loop, 
+						      const char     * name)
+{
+	axlNode * node;
+
+	if (ctx == NULL || loop == NULL || name == NULL)
+		return;
+
+	node = axl_doc_get (turbulence_config_get (ctx), "/turbulence/global-settings/loop-affinity");
+	if (! HAS_ATTR (node, name))
+		return;
+
+	msg ("configuring %s loop affinity to cpus %s", name, ATTR_VALUE (node, name));
+	turbulence_loop_set_affinity (loop, ATTR_VALUE (node, name));
+	return;
+}
+
+/** 
+ * @}
+ */
@@ -0,0 +1,269 @@
+/*  Turbulence BEEP application server
+ *  Copyright (C) 2025 Advanced Software Production Line, S.L.
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; version 2.1 of the
+ *  License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free
+ *  Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307 USA
+ *  
+ *  You may find a copy of the license under this software is released
+ *  at COPYING file. This is LGPL software: you are welcome to develop
+ *  proprietary applications using this library without any royalty or
+ *  fee but returning back any change, improvement or addition in the
+ *  form of source code, project image, documentation patches, etc.
+ *
+ *  For commercial support on build BEEP enabled solutions, supporting
+ *  turbulence based solutions, etc, contact us:
+ *          
+ *      Postal address:
+ *         Advanced Software Production Line, S.L.
+ *         C/ Antonio Suarez Nº10, Edificio Alius A, Despacho 102
+ *         Alcala de Henares, 28802 (MADRID)
+ *         Spain
+ *
+ *      Email address:
+ *         info@aspl.es - http://www.aspl.es/turbulence
+ */
+#include <turbulence.h>
+
+/** 
+ * \defgroup turbulence_arena Turbulence Arena: per connection memory allocation
+ */
+
+/** 
+ * \addtogroup turbulence_arena
+ * @{
+ */
+
+/* every allocation (and every chunk header) is rounded to this
+ * boundary so the memory returned is suitable for any type */
+#define TBC_ARENA_ALIGN(size) (((size) + 15) & ~15)
+
+/* default amount of memory reserved by the first chunk (the one
+ * embedded into the arena block) when no size hint is provided */
+#define TBC_ARENA_FIRST_CHUNK_SIZE 128
+
+/* upper bound for the chunks reserved once the first one is
+ * exhausted: each new chunk doubles the previous one until this
+ * size is reached */
+#define TBC_ARENA_CHUNK_SIZE       1024
+
+typedef struct _TurbulenceArenaChunk TurbulenceArenaChunk;
+
+struct _TurbulenceArenaChunk {
+	TurbulenceArenaChunk * next;
+	int                    size;
+	int                    used;
+};
+
+struct _TurbulenceArena {
+	VortexMutex            mutex;
+
+	/* list of chunks, the first one is the chunk currently used
+	 * to serve allocations and the last one is the chunk
+	 * embedded into the arena block itself */
+	TurbulenceArenaChunk * chunks;
+
+	/* bytes reserved from the system by this arena */
+	int                    bytes;
+};
+
+#define TBC_ARENA_HEADER_SIZE     TBC_ARENA_ALIGN (sizeof (TurbulenceArena))
+#define TBC_ARENA_CHUNK_HEAD_SIZE TBC_ARENA_ALIGN (sizeof (TurbulenceArenaChunk))
+#define TBC_ARENA_CHUNK_DATA(chunk) (((char *) (chunk)) + TBC_ARENA_CHUNK_HEAD_SIZE)
+
+/** 
+ * @brief Creates a new arena, a memory pool that serves small
+ * allocations that are never released individually but all at once
+ * by \ref turbulence_arena_free.
+ *
+ * The arena and its first chunk are reserved with a single
+ * allocation so small users (like the state created for each
+ * connection accepted) only touch the heap once. The first chunk is
+ * sized from the hint provided, so callers that know how much they
+ * will store do not pay for a full chunk; further chunks grow as
+ * needed.
+ *
+ * @param size_hint Amount of memory expected to be allocated from
+ * the arena. Use 0 to get a small default size.
+ *
+ * @return A newly created arena or NULL if it fails.
+ */
+TurbulenceArena * turbulence_arena_new (int size_hint)
+{
+	TurbulenceArena * arena;
+
+	if (size_hint <= 0)
+		size_hint = TBC_ARENA_FIRST_CHUNK_SIZE;
+	size_hint = TBC_ARENA_ALIGN (size_hint);
+
+	arena = axl_calloc (TBC_ARENA_HEADER_SIZE + TBC_ARENA_CHUNK_HEAD_SIZE + size_hint, 1);
+	if (arena == NULL)
+		return NULL;
+
+	/* configure embedded chunk */
+	arena->chunks       = (TurbulenceArenaChunk *) (((char *) arena) + TBC_ARENA_HEADER_SIZE);
+	arena->chunks->size = size_hint;
+	arena->bytes        = TBC_ARENA_HEADER_SIZE + TBC_ARENA_CHUNK_HEAD_SIZE + size_hint;
+	vortex_mutex_create (&arena->mutex);
+
+	return arena;
+}
+
+/** 
+ * @brief Allocates memory from the provided arena. The memory
+ * returned is zeroed and it is released when the arena is finished
+ * (it must not be passed to axl_free).
+ *
+ * The function is thread safe.
+ *
+ * @param arena The arena where the memory is taken.
+ * @param size The amount of memory requested.
+ *
+ * @return A reference to the memory or NULL if it fails.
+ */
+axlPointer turbulence_arena_alloc (TurbulenceArena * arena, int size)
+{
+	TurbulenceArenaChunk * chunk;
+	axlPointer             result;
+	int                    chunk_size;
+
+	if (arena == NULL || size <= 0)
+		return NULL;
+	size = TBC_ARENA_ALIGN (size);
+
+	vortex_mutex_lock (&arena->mutex);
+
+	/* serve from the current chunk if possible */
+	chunk = arena->chunks;
+	if ((chunk->size - chunk->used) >= size) {
+		result       = TBC_ARENA_CHUNK_DATA (chunk) + chunk->used;
+		chunk->used += size;
+		vortex_mutex_unlock (&arena->mutex);
+		return result;
+	} /* end if */
+
+	/* reserve a new chunk, doubling the current one up to
+	 * TBC_ARENA_CHUNK_SIZE */
+	chunk_size = chunk->size * 2;
+	if (chunk_size > TBC_ARENA_CHUNK_SIZE)
+		chunk_size = TBC_ARENA_CHUNK_SIZE;
+	if (size > chunk_size)
+		chunk_size = size;
+	chunk      = axl_calloc (TBC_ARENA_CHUNK_HEAD_SIZE + chunk_size, 1);
+	if (chunk == NULL) {
+		vortex_mutex_unlock (&arena->mutex);
+		return NULL;
+	} /* end if */
+	chunk->size   = chunk_size;
+	chunk->used   = size;
+	arena->bytes += TBC_ARENA_CHUNK_HEAD_SIZE + chunk_size;
+
+	if (chunk_size == size) {
+		/* oversized request: keep the current chunk serving
+		 * small allocations */
+		chunk->next          = arena->chunks->next;
+		arena->chunks->next  = chunk;
+	} else {
+		chunk->next          = arena->chunks;
+		arena->chunks        = chunk;
+	} /* end if */
+
+	vortex_mutex_unlock (&arena->mutex);
+
+	return TBC_ARENA_CHUNK_DATA (chunk);
+}
+
+/** 
+ * @brief Allocates a copy of the provided string from the arena.
+ *
+ * @param arena The arena where the memory is taken.
+ * @param string The string to copy.
+ *
+ * @return A copy of the string (released with the arena) or NULL if
+ * it fails or string is NULL.
+ */
+char * turbulence_arena_strdup (TurbulenceArena * arena, const char * string)
+{
+	char * result;
+	int    length;
+
+	if (string == NULL)
+		return NULL;
+
+	length = strlen (string);
+	result = turbulence_arena_alloc (arena, length + 1);
+	if (result == NULL)
+		return NULL;
+	memcpy (result, string, length);
+
+	return result;
+}
+
+/** 
+ * @brief Returns the amount of memory reserved from the system by
+ * the provided arena (including its internal headers).
+ *
+ * @param arena The arena to check.
+ *
+ * @return Bytes reserved or 0 if a NULL reference is received.
+ */
+int turbulence_arena_bytes (TurbulenceArena * arena)
+{
+	int bytes;
+
+	if (arena == NULL)
+		return 0;
+
+	vortex_mutex_lock (&arena->mutex);
+	bytes = arena->bytes;
+	vortex_mutex_unlock (&arena->mutex);
+
+	return bytes;
+}
+
+/** 
+ * @brief Releases the arena and all memory allocated from it in one
+ * step. The function has the axlDestroyFunc signature so it can be
+ * directly installed as destroy function.
+ *
+ * @param _arena The arena to finish.
+ */
+void turbulence_arena_free (axlPointer _arena)
+{
+	TurbulenceArena      * arena = _arena;
+	TurbulenceArenaChunk * chunk;
+	TurbulenceArenaChunk * next;
+	TurbulenceArenaChunk * embedded;
+
+	if (arena == NULL)
+		return;
+
+	/* release all chunks but the one embedded */
+	embedded = (TurbulenceArenaChunk *) (((char *) arena) + TBC_ARENA_HEADER_SIZE);
+	chunk    = arena->chunks;
+	while (chunk) {
+		next = chunk->next;
+		if (chunk != embedded)
+			axl_free (chunk);
+		chunk = next;
+	} /* end while */
+
+	vortex_mutex_destroy (&arena->mutex);
+	axl_free (arena);
+	return;
+}
+
+/** 
+ * @}
+ */
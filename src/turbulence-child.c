@@ -96,9 +96,23 @@ TurbulenceChild * turbulence_child_new (TurbulenceCtx * ctx, TurbulencePPathDef
 	/* free temporal directory */
 	axl_free (temp_dir);
 	
-	/* set profile path and context */
+	/* set profile path (referenced while the child object is
+	 * alive) and context */
 	result->ppath = def;
 	result->ctx   = ctx;
+	__turbulence_ppath_def_ref (def);
+
+	/* no log pipes registered yet */
+	result->log_pipes[0] = -1;
+	result->log_pipes[1] = -1;
+	result->log_pipes[2] = -1;
+	result->log_pipes[3] = -1;
+
+	/* record creation stamp (child lifetime) */
+	result->started_stamp = time (NULL);
+
+	/* no NUMA node selected yet */
+	result->numa_node     = -1;
 
 	/* create listener connection used for child management */
 	result->conn_mgr = vortex_listener_new_full (ctx->vortex_ctx, "0.0.0.0", "0", NULL, NULL);
@@ -216,6 +230,12 @@ void              turbulence_child_unref (TurbulenceChild * child)
 	/* release server name */
 	axl_free (child->serverName);
 
+	/* release affinity applied */
+	axl_free (child->affinity);
+
+	/* release profile path reference */
+	__turbulence_ppath_def_unref (child->ppath);
+
 	/* destroy mutex */
 	vortex_mutex_destroy (&child->mutex);
 
@@ -420,6 +440,9 @@ axl_bool          turbulence_child_post_init (TurbulenceCtx * ctx)
 	msg ("  Set profile path: '%s'", turbulence_ppath_get_name (def));
 	ctx->child->ppath = def;
 
+	/* register search nodes before any connection is handled */
+	__turbulence_ppath_load_search_nodes (ctx, def);
+
 	/* check here to change root path, in the case it is defined
 	 * now we still have privileges: a failure is fatal, the child
 	 * would keep running outside the root the profile path configured
@@ -467,6 +490,10 @@ axl_bool          turbulence_child_post_init (TurbulenceCtx * ctx)
 	}
 	msg ("CHILD: child<->master BEEP link started..OK");
 
+	/* child startup completed (reported with the connection that
+	 * caused its creation) */
+	child->trace_ready = turbulence_trace_now ();
+
 	/* check if we have to restore the connection or skip this
 	 * step */
 	len = strlen (child->init_string_items[11]);
@@ -44,6 +44,14 @@
 
 /** 
  * \defgroup turbulence_config Turbulence Config: files to access to run-time Turbulence Config
+ *
+ * Once loaded, the configuration is compiled into a \ref
+ * TurbulenceConfigSnapshot which holds typed values that can be
+ * used from hot paths without traversing the document (see \ref
+ * turbulence_config_snapshot). The snapshot is rebuilt and swapped
+ * on every reload (SIGHUP). Modules can compile their own
+ * configuration into it by registering a schema with \ref
+ * turbulence_config_register_schema.
  */
 
 /**
@@ -71,7 +79,7 @@ axl_bool turbulence_config_find_include_nodes (axlNode    * node,
 			  * visited */
 }
 
-void turbulence_config_load_expand_nodes (TurbulenceCtx * ctx)
+void __turbulence_config_expand_nodes (TurbulenceCtx * ctx, axlDoc * doc)
 {
 	axlList    * include_nodes;
 	int          iterator;
@@ -89,7 +97,7 @@ void turbulence_config_load_expand_nodes (TurbulenceCtx * ctx)
 
 	/* create the list and iterate over all nodes */
 	include_nodes = axl_list_new (axl_list_always_return_1, NULL);
-	axl_doc_iterate (ctx->config, DEEP_ITERATION, turbulence_config_find_include_nodes, include_nodes);
+	axl_doc_iterate (doc, DEEP_ITERATION, turbulence_config_find_include_nodes, include_nodes);
 	msg ("Found include nodes %d, expanding..", axl_list_length (include_nodes));
 
 	/* next position */
@@ -186,34 +194,433 @@ void turbulence_config_load_expand_nodes (TurbulenceCtx * ctx)
 	return;
 }
 
+void turbulence_config_load_expand_nodes (TurbulenceCtx * ctx)
+{
+	__turbulence_config_expand_nodes (ctx, ctx->config);
+	return;
+}
+
 
 /** 
- * @internal Loads the turbulence main file, which has all definitions to make
- * turbulence to start.
- * 
- * @param config The configuration file to load by the provided
- * turbulence context.
- * 
- * @return axl_true if the configuration file looks ok and it is
- * syntactically correct.
+ * @internal Module schema registered through \ref
+ * turbulence_config_register_schema.
  */
-axl_bool  turbulence_config_load (TurbulenceCtx * ctx, const char * config)
+typedef struct _TurbulenceConfigSchema {
+	char                        * name;
+	TurbulenceConfigSchemaBuild   build;
+	axlDestroyFunc                destroy;
+	axlPointer                    user_data;
+} TurbulenceConfigSchema;
+
+void __turbulence_config_schema_free (axlPointer _schema)
+{
+	TurbulenceConfigSchema * schema = _schema;
+
+	axl_free (schema->name);
+	axl_free (schema);
+	return;
+}
+
+/** 
+ * @internal Parses all numeric attributes found at the childs of
+ * /turbulence/global-settings into the snapshot so \ref
+ * turbulence_config_get_number does not have to traverse the
+ * document. Values that are not a number are stored as -1 (the
+ * value turbulence_config_get_number reports for them).
+ */
+void __turbulence_config_snapshot_numbers (TurbulenceCtx            * ctx,
+					   TurbulenceConfigSnapshot * snapshot)
+{
+	axlNode       * node;
+	axlAttrCursor * cursor;
+	axlHash       * attrs;
+	const char    * value;
+	char          * error;
+	int           * number;
+
+	node = axl_doc_get (ctx->config, "/turbulence/global-settings");
+	if (node == NULL)
+		return;
+	node = axl_node_get_first_child (node);
+	while (node) {
+		/* only the first node with a name is reachable by
+		 * path (the same as axl_doc_get does) */
+		if (axl_hash_get (snapshot->numbers, (axlPointer) axl_node_get_name (node))) {
+			node = axl_node_get_next (node);
+			continue;
+		} /* end if */
+
+		attrs  = axl_hash_new (axl_hash_string, axl_hash_equal_string);
+		cursor = axl_node_attr_cursor_new (node);
+		while (axl_node_attr_cursor_has_item (cursor)) {
+			/* translate value */
+			value   = axl_node_attr_cursor_get_value (cursor);
+			error   = NULL;
+			number  = axl_new (int, 1);
+			*number = vortex_support_strtod (value, &error);
+			if (error && strlen (error) > 0)
+				*number = -1;
+
+			axl_hash_insert_full (attrs, 
+					      axl_strdup (axl_node_attr_cursor_get_key (cursor)), axl_free,
+					      number, axl_free);
+
+			/* next attribute */
+			axl_node_attr_cursor_next (cursor);
+		} /* end while */
+		axl_node_attr_cursor_free (cursor);
+
+		axl_hash_insert_full (snapshot->numbers,
+				      axl_strdup_printf ("/turbulence/global-settings/%s", axl_node_get_name (node)), axl_free,
+				      attrs, (axlDestroyFunc) axl_hash_free);
+
+		/* next node */
+		node = axl_node_get_next (node);
+	} /* end while */
+
+	return;
+}
+
+/** 
+ * @internal Finds a value compiled by __turbulence_config_snapshot_numbers.
+ */
+axl_bool __turbulence_config_snapshot_lookup (TurbulenceConfigSnapshot * snapshot,
+					      const char               * path,
+					      const char               * attr_name,
+					      int                      * value)
+{
+	axlHash * attrs;
+	int     * number;
+
+	attrs = axl_hash_get (snapshot->numbers, (axlPointer) path);
+	if (attrs == NULL)
+		return axl_false;
+	number = axl_hash_get (attrs, (axlPointer) attr_name);
+	if (number == NULL)
+		return axl_false;
+
+	(*value) = (*number);
+	return axl_true;
+}
+
+/** 
+ * @internal Returns the value configured or the default value
+ * provided when it is not configured or it is not a positive value.
+ */
+int __turbulence_config_snapshot_positive (TurbulenceConfigSnapshot * snapshot,
+					   const char               * path,
+					   const char               * attr_name,
+					   int                        default_value)
+{
+	int value;
+
+	if (__turbulence_config_snapshot_lookup (snapshot, path, attr_name, &value) && value > 0)
+		return value;
+	return default_value;
+}
+
+/** 
+ * @internal Compiles current configuration (ctx->config) and all
+ * registered module schemas into a new snapshot.
+ */
+TurbulenceConfigSnapshot * __turbulence_config_snapshot_build (TurbulenceCtx * ctx)
+{
+	TurbulenceConfigSnapshot * snapshot;
+	TurbulenceConfigSchema   * schema;
+	axlNode                  * node;
+	axlPointer                 data;
+	int                        iterator;
+
+	snapshot = axl_new (TurbulenceConfigSnapshot, 1);
+	if (snapshot == NULL)
+		return NULL;
+	snapshot->ref_count = 1;
+	snapshot->numbers   = axl_hash_new (axl_hash_string, axl_hash_equal_string);
+	snapshot->modules   = axl_hash_new (axl_hash_string, axl_hash_equal_string);
+
+	/* global settings */
+	__turbulence_config_snapshot_numbers (ctx, snapshot);
+	snapshot->thread_pool_max_limit   = __turbulence_config_snapshot_positive (snapshot, "/turbulence/global-settings/thread-pool", "max-limit", 40);
+	snapshot->thread_pool_step_period = __turbulence_config_snapshot_positive (snapshot, "/turbulence/global-settings/thread-pool", "step-period", 5);
+	snapshot->thread_pool_step_add    = __turbulence_config_snapshot_positive (snapshot, "/turbulence/global-settings/thread-pool", "step-add", 1);
+	snapshot->server_backlog          = __turbulence_config_snapshot_positive (snapshot, "/turbulence/global-settings/server-backlog", "value", 50);
+	snapshot->global_child_limit      = __turbulence_config_snapshot_positive (snapshot, "/turbulence/global-settings/global-child-limit", "value", 100);
+	snapshot->max_complete_flag_limit = __turbulence_config_snapshot_positive (snapshot, "/turbulence/global-settings/max-incoming-complete-frame-limit", "value", 32768);
+
+	node = axl_doc_get (ctx->config, "/turbulence/global-settings/kill-childs-on-exit");
+	snapshot->kill_childs_on_exit = HAS_ATTR_VALUE (node, "value", "yes");
+
+	node = axl_doc_get (ctx->config, "/turbulence/global-settings/on-bad-signal");
+	if (HAS_ATTR_VALUE (node, "action", "hold"))
+		snapshot->on_bad_signal = TBC_BAD_SIGNAL_HOLD;
+	else if (HAS_ATTR_VALUE (node, "action", "ignore"))
+		snapshot->on_bad_signal = TBC_BAD_SIGNAL_IGNORE;
+	else if (HAS_ATTR_VALUE (node, "action", "backtrace"))
+		snapshot->on_bad_signal = TBC_BAD_SIGNAL_BACKTRACE;
+	else if (HAS_ATTR_VALUE (node, "action", "quit") || HAS_ATTR_VALUE (node, "action", "exit"))
+		snapshot->on_bad_signal = TBC_BAD_SIGNAL_EXIT;
+	if (HAS_ATTR (node, "mail-to"))
+		snapshot->on_bad_signal_mail_to = axl_strdup (ATTR_VALUE (node, "mail-to"));
+
+	/* module schemas */
+	vortex_mutex_lock (&ctx->config_schemas_mutex);
+	iterator = 0;
+	while (iterator < axl_list_length (ctx->config_schemas)) {
+		schema = axl_list_get_nth (ctx->config_schemas, iterator);
+		data   = schema->build (ctx, ctx->config, schema->user_data);
+		if (data) 
+			axl_hash_insert_full (snapshot->modules, axl_strdup (schema->name), axl_free, data, schema->destroy);
+
+		/* next position */
+		iterator++;
+	} /* end while */
+	vortex_mutex_unlock (&ctx->config_schemas_mutex);
+
+	return snapshot;
+}
+
+/** 
+ * @brief Compiles current configuration into a new snapshot and
+ * installs it as the snapshot used by the provided context.
+ *
+ * Readers that acquired the previous snapshot keep using it until
+ * they release it (\ref turbulence_config_snapshot_unref). This is
+ * called by Turbulence at startup and on every reload.
+ *
+ * @param ctx The context where the snapshot is rebuilt.
+ *
+ * @return axl_true if the snapshot was rebuilt, otherwise axl_false
+ * is returned (the previous snapshot is kept).
+ */
+axl_bool            turbulence_config_snapshot_rebuild (TurbulenceCtx * ctx)
+{
+	TurbulenceConfigSnapshot * snapshot;
+	TurbulenceConfigSnapshot * previous;
+	int                        slot;
+
+	v_return_val_if_fail (ctx && ctx->config, axl_false);
+
+	snapshot = __turbulence_config_snapshot_build (ctx);
+	if (snapshot == NULL) {
+		error ("Unable to build configuration snapshot, keeping previous one");
+		return axl_false;
+	} /* end if */
+
+	vortex_mutex_lock (&ctx->config_snapshot_mutex);
+
+	/* copy values used by the fault handler: mail-to is written
+	 * into the buffer not currently published */
+	TBC_ATOMIC_STORE (ctx->bad_signal_action, snapshot->on_bad_signal);
+	slot = -1;
+	if (snapshot->on_bad_signal_mail_to) {
+		slot = (TBC_ATOMIC_LOAD (ctx->bad_signal_mail_to_slot) == 0) ? 1 : 0;
+		snprintf (ctx->bad_signal_mail_to[slot], TBC_BAD_SIGNAL_MAIL_TO_MAX, "%s", snapshot->on_bad_signal_mail_to);
+	} /* end if */
+	TBC_ATOMIC_STORE (ctx->bad_signal_mail_to_slot, slot);
+
+	/* swap: readers starting from now get the new snapshot */
+	previous = ctx->config_snapshot;
+	TBC_ATOMIC_STORE (ctx->config_snapshot, snapshot);
+
+	/* wait for readers that may have loaded the previous
+	 * snapshot but not referenced it yet (a window of a few
+	 * instructions, see turbulence_config_snapshot) */
+	TBC_ATOMIC_FENCE ();
+	while (TBC_ATOMIC_LOAD (ctx->config_snapshot_readers) != 0)
+		turbulence_ctx_wait (ctx, 10);
+
+	vortex_mutex_unlock (&ctx->config_snapshot_mutex);
+
+	/* release the reference the context had */
+	turbulence_config_snapshot_unref (previous);
+
+	msg ("Configuration snapshot installed (%d module schemas)", axl_hash_items (snapshot->modules));
+	return axl_true;
+}
+
+/** 
+ * @brief Allows to get a reference to the configuration snapshot
+ * currently installed.
+ *
+ * The snapshot holds configuration already compiled into typed
+ * values so it can be used from hot paths without traversing the
+ * configuration document. The reference returned must be released
+ * with \ref turbulence_config_snapshot_unref. No lock is taken: the
+ * snapshot is read with an acquire load and referenced with an
+ * atomic increment.
+ *
+ * @param ctx The context where the snapshot is requested.
+ *
+ * @return A reference to the snapshot or NULL if no configuration is
+ * loaded.
+ */
+TurbulenceConfigSnapshot * turbulence_config_snapshot (TurbulenceCtx * ctx)
+{
+	TurbulenceConfigSnapshot * snapshot;
+
+	v_return_val_if_fail (ctx, NULL);
+
+	/* flag a reader is running so a rebuild does not release the
+	 * snapshot between loading and referencing it */
+	TBC_ATOMIC_ADD (ctx->config_snapshot_readers, 1);
+	snapshot = TBC_ATOMIC_LOAD (ctx->config_snapshot);
+	if (snapshot)
+		TBC_ATOMIC_ADD (snapshot->ref_count, 1);
+	TBC_ATOMIC_ADD (ctx->config_snapshot_readers, -1);
+
+	return snapshot;
+}
+
+/** 
+ * @brief Releases a reference acquired with \ref turbulence_config_snapshot.
+ *
+ * @param snapshot The snapshot to release.
+ */
+void                turbulence_config_snapshot_unref (TurbulenceConfigSnapshot * snapshot)
+{
+	if (snapshot == NULL)
+		return;
+
+	/* previous value was 1: last reference */
+	if (TBC_ATOMIC_ADD (snapshot->ref_count, -1) > 1)
+		return;
+
+	/* release all data */
+	axl_hash_free (snapshot->modules);
+	axl_hash_free (snapshot->numbers);
+	axl_free (snapshot->on_bad_signal_mail_to);
+	axl_free (snapshot);
+	return;
+}
+
+/** 
+ * @brief Allows to get the data compiled by a module schema into the
+ * provided snapshot (see \ref turbulence_config_register_schema).
+ *
+ * @param snapshot The snapshot where the data is looked up.
+ *
+ * @param name The schema name.
+ *
+ * @return A reference to the data compiled or NULL if it is not
+ * found. The reference is valid while the snapshot is referenced.
+ */
+axlPointer          turbulence_config_snapshot_module (TurbulenceConfigSnapshot * snapshot,
+						       const char               * name)
+{
+	if (snapshot == NULL || name == NULL)
+		return NULL;
+	return axl_hash_get (snapshot->modules, (axlPointer) name);
+}
+
+/** 
+ * @brief Allows to get a numeric value compiled into the snapshot
+ * from /turbulence/global-settings.
+ *
+ * @param snapshot The snapshot where the value is looked up.
+ *
+ * @param path The path to the node (for example /turbulence/global-settings/thread-pool).
+ *
+ * @param attr_name The attribute name.
+ *
+ * @param value Reference where the value is returned.
+ *
+ * @return axl_true if the value was found, otherwise axl_false is returned.
+ */
+axl_bool            turbulence_config_snapshot_get_number (TurbulenceConfigSnapshot * snapshot,
+							   const char               * path,
+							   const char               * attr_name,
+							   int                      * value)
+{
+	if (snapshot == NULL || path == NULL || attr_name == NULL || value == NULL)
+		return axl_false;
+	return __turbulence_config_snapshot_lookup (snapshot, path, attr_name, value);
+}
+
+/** 
+ * @brief Allows modules to compile their configuration into the
+ * configuration snapshot.
+ *
+ * The build handler is called each time a snapshot is built (now,
+ * and on every reload) so the module can read its configuration once
+ * and then use the result from hot paths through \ref
+ * turbulence_config_snapshot_module. Registering a schema with a
+ * name already registered replaces it.
+ *
+ * @param ctx The context where the schema is registered.
+ *
+ * @param name The schema name (usually the module name).
+ *
+ * @param build The handler that compiles module configuration.
+ *
+ * @param destroy Optional handler used to release data compiled.
+ *
+ * @param user_data User defined pointer passed to the build handler.
+ *
+ * @return axl_true if the schema was registered and the snapshot
+ * rebuilt, otherwise axl_false is returned.
+ */
+axl_bool            turbulence_config_register_schema (TurbulenceCtx               * ctx,
+						       const char                  * name,
+						       TurbulenceConfigSchemaBuild   build,
+						       axlDestroyFunc                destroy,
+						       axlPointer                    user_data)
+{
+	TurbulenceConfigSchema * schema;
+	int                      iterator;
+
+	v_return_val_if_fail (ctx && name && build, axl_false);
+
+	vortex_mutex_lock (&ctx->config_schemas_mutex);
+	if (ctx->config_schemas == NULL)
+		ctx->config_schemas = axl_list_new (axl_list_always_return_1, __turbulence_config_schema_free);
+
+	/* remove previous registration */
+	iterator = 0;
+	while (iterator < axl_list_length (ctx->config_schemas)) {
+		schema = axl_list_get_nth (ctx->config_schemas, iterator);
+		if (axl_cmp (schema->name, name)) {
+			axl_list_remove_at (ctx->config_schemas, iterator);
+			break;
+		} /* end if */
+		iterator++;
+	} /* end while */
+
+	schema            = axl_new (TurbulenceConfigSchema, 1);
+	schema->name      = axl_strdup (name);
+	schema->build     = build;
+	schema->destroy   = destroy;
+	schema->user_data = user_data;
+	axl_list_append (ctx->config_schemas, schema);
+	vortex_mutex_unlock (&ctx->config_schemas_mutex);
+
+	msg ("Registered configuration schema: %s", name);
+	return turbulence_config_snapshot_rebuild (ctx);
+}
+
+/** 
+ * @internal Loads the provided configuration file, expanding
+ * <include> nodes and validating it, without installing it.
+ *
+ * @param config The configuration file to load.
+ *
+ * @return A reference to the document loaded or NULL if it is not
+ * syntactically correct or it is not valid.
+ */
+axlDoc  * turbulence_config_parse (TurbulenceCtx * ctx, const char * config)
 {
 	axlError   * error;
 	axlDtd     * dtd_file;
+	axlDoc     * doc;
 
 	/* check null value */
 	if (config == NULL) {
 		error ("config file not defined, terminating turbulence");
-		return axl_false;
+		return NULL;
 	} /* end if */
 
-	/* get a reference to the configuration path used for this context */
-	ctx->config_path = axl_strdup (config);
-
 	/* load the file */
-	ctx->config = axl_doc_parse_from_file (config, &error);
-	if (ctx->config == NULL) {
+	doc = axl_doc_parse_from_file (config, &error);
+	if (doc == NULL) {
 		error ("unable to load file (%s), it seems a xml error: %s", 
 		       config, axl_error_get (error));
 
@@ -221,7 +628,7 @@ axl_bool  turbulence_config_load (TurbulenceCtx * ctx, const char * config)
 		axl_error_free (error);
 
 		/* call to finish turbulence */
-		return axl_false;
+		return NULL;
 
 	} /* end if */
 
@@ -229,27 +636,26 @@ axl_bool  turbulence_config_load (TurbulenceCtx * ctx, const char * config)
 	msg ("file %s loaded, ok", config);
 
 	/* now process inclusions */
-	turbulence_config_load_expand_nodes (ctx);
+	__turbulence_config_expand_nodes (ctx, doc);
 
 	/* found dtd file */
 	dtd_file = axl_dtd_parse (TURBULENCE_CONFIG_DTD, -1, &error);
 	if (dtd_file == NULL) {
-		axl_doc_free (ctx->config);
+		axl_doc_free (doc);
 		error ("unable to load DTD to validate turbulence configuration, error: %s", axl_error_get (error));
 		axl_error_free (error);
-		return axl_false;
+		return NULL;
 	} /* end if */
 
-	if (! axl_dtd_validate (ctx->config, dtd_file, &error)) {
+	if (! axl_dtd_validate (doc, dtd_file, &error)) {
 		abort_error ("unable to validate server configuration, something is wrong: %s", 
 			     axl_error_get (error));
 
-		/* free and set a null reference */
-		axl_doc_free (ctx->config);
-		ctx->config = NULL;
-
+		/* free resources */
+		axl_doc_free (doc);
+		axl_dtd_free (dtd_file);
 		axl_error_free (error);
-		return axl_false;
+		return NULL;
 	} /* end if */
 
 	msg ("server configuration is valid..");
@@ -257,7 +663,164 @@ axl_bool  turbulence_config_load (TurbulenceCtx * ctx, const char * config)
 	/* free resources */
 	axl_dtd_free (dtd_file);
 
-	return axl_true;
+	return doc;
+}
+
+/** 
+ * @internal Loads the turbulence main file, which has all definitions to make
+ * turbulence to start.
+ * 
+ * @param config The configuration file to load by the provided
+ * turbulence context.
+ * 
+ * @return axl_true if the configuration file looks ok and it is
+ * syntactically correct.
+ */
+axl_bool  turbulence_config_load (TurbulenceCtx * ctx, const char * config)
+{
+	/* load and validate the file */
+	ctx->config = turbulence_config_parse (ctx, config);
+	if (ctx->config == NULL)
+		return axl_false;
+
+	/* the context holds a reference on the running document */
+	turbulence_config_doc_ref (ctx, ctx->config);
+
+	/* get a reference to the configuration path used for this context */
+	ctx->config_path = axl_strdup (config);
+
+	/* compile configuration into the snapshot used by hot paths */
+	return turbulence_config_snapshot_rebuild (ctx);
+}
+
+/** 
+ * @internal Reference count of a configuration document (see
+ * turbulence_config_doc_ref).
+ */
+typedef struct _TurbulenceConfigDocRef {
+	axlDoc * doc;
+	int      ref_count;
+} TurbulenceConfigDocRef;
+
+TurbulenceConfigDocRef * __turbulence_config_doc_find (TurbulenceCtx * ctx, axlDoc * doc)
+{
+	TurbulenceConfigDocRef * ref;
+	int                      iterator;
+
+	iterator = 0;
+	while (ctx->config_docs && iterator < axl_list_length (ctx->config_docs)) {
+		ref = axl_list_get_nth (ctx->config_docs, iterator);
+		if (ref->doc == doc)
+			return ref;
+		iterator++;
+	} /* end while */
+
+	return NULL;
+}
+
+/** 
+ * @internal Acquires a reference on the provided configuration
+ * document. The context holds one on the running document and each
+ * profile path definition another one on the document it was built
+ * from (they borrow its values, see turbulence_ppath_build).
+ *
+ * Once a document is referenced, its lifetime is controlled by these
+ * references: it is released by the last call to
+ * turbulence_config_doc_unref (or by turbulence_config_cleanup).
+ */
+void      turbulence_config_doc_ref (TurbulenceCtx * ctx, axlDoc * doc)
+{
+	TurbulenceConfigDocRef * ref;
+
+	v_return_if_fail (ctx && doc);
+
+	vortex_mutex_lock (&ctx->config_docs_mutex);
+	if (ctx->config_docs == NULL)
+		ctx->config_docs = axl_list_new (axl_list_always_return_1, axl_free);
+	ref = __turbulence_config_doc_find (ctx, doc);
+	if (ref == NULL) {
+		ref      = axl_new (TurbulenceConfigDocRef, 1);
+		ref->doc = doc;
+		axl_list_append (ctx->config_docs, ref);
+	} /* end if */
+	ref->ref_count++;
+	vortex_mutex_unlock (&ctx->config_docs_mutex);
+
+	return;
+}
+
+/** 
+ * @internal Releases a reference acquired with
+ * turbulence_config_doc_ref, releasing the document if it was the
+ * last one.
+ */
+void      turbulence_config_doc_unref (TurbulenceCtx * ctx, axlDoc * doc)
+{
+	TurbulenceConfigDocRef * ref;
+
+	if (ctx == NULL || doc == NULL)
+		return;
+
+	vortex_mutex_lock (&ctx->config_docs_mutex);
+	ref = __turbulence_config_doc_find (ctx, doc);
+	if (ref == NULL || --ref->ref_count > 0) {
+		/* still referenced (or already released by
+		 * turbulence_config_cleanup) */
+		vortex_mutex_unlock (&ctx->config_docs_mutex);
+		return;
+	} /* end if */
+	axl_list_remove_ptr (ctx->config_docs, ref);
+	vortex_mutex_unlock (&ctx->config_docs_mutex);
+
+	msg ("released configuration document %p, no profile path uses it", doc);
+	axl_doc_free (doc);
+	return;
+}
+
+/** 
+ * @internal Checks if the provided document (loaded with
+ * turbulence_config_parse) dumps the same content as the running
+ * configuration. This is used to skip reloading an unchanged
+ * configuration.
+ */
+axl_bool  turbulence_config_is_running (TurbulenceCtx * ctx, axlDoc * doc)
+{
+	char     * running      = NULL;
+	char     * loaded       = NULL;
+	int        running_size = 0;
+	int        loaded_size  = 0;
+	axl_bool   result       = axl_false;
+
+	v_return_val_if_fail (ctx && doc, axl_false);
+
+	if (ctx->config && axl_doc_dump (ctx->config, &running, &running_size) && axl_doc_dump (doc, &loaded, &loaded_size))
+		result = running_size == loaded_size && memcmp (running, loaded, running_size) == 0;
+
+	axl_free (running);
+	axl_free (loaded);
+	return result;
+}
+
+/** 
+ * @internal Installs the provided configuration document (loaded
+ * with turbulence_config_parse) as the configuration used by the
+ * provided context. This is used to reload configuration.
+ *
+ * The document replaced is released once profile paths built from it
+ * (still used by connections accepted and childs) are gone, see
+ * turbulence_config_doc_ref.
+ */
+void      turbulence_config_replace (TurbulenceCtx * ctx, axlDoc * doc)
+{
+	axlDoc * previous;
+
+	v_return_if_fail (ctx && doc);
+
+	turbulence_config_doc_ref (ctx, doc);
+	previous    = ctx->config;
+	ctx->config = doc;
+	turbulence_config_doc_unref (ctx, previous);
+	return;
 }
 
 /** 
@@ -318,6 +881,9 @@ axl_bool            turbulence_config_set      (TurbulenceCtx * ctx,
 	/* set attribute */
 	axl_node_remove_attribute (node, attr_name);
 	axl_node_set_attribute (node, attr_name, attr_value);
+
+	/* compile the change into the snapshot */
+	turbulence_config_snapshot_rebuild (ctx);
 	
 	return axl_true;
 }
@@ -402,13 +968,24 @@ int             turbulence_config_get_number (TurbulenceCtx * ctx,
 					      const char    * path,
 					      const char    * attr_name)
 {
-	axlNode * node;
-	int       value;
-	char    * error = NULL;
+	axlNode                  * node;
+	int                        value;
+	char                     * error = NULL;
+
+	TurbulenceConfigSnapshot * snapshot;
 
 	/* check values received */
 	v_return_val_if_fail (ctx && path && attr_name, -2);
 
+	/* values under /turbulence/global-settings are already
+	 * compiled into the snapshot */
+	snapshot = turbulence_config_snapshot (ctx);
+	if (snapshot && __turbulence_config_snapshot_lookup (snapshot, path, attr_name, &value)) {
+		turbulence_config_snapshot_unref (snapshot);
+		return value;
+	} /* end if */
+	turbulence_config_snapshot_unref (snapshot);
+
 	msg ("Getting value at path %s (%s)", path, attr_name);
 
 	/* get the node */
@@ -433,14 +1010,43 @@ int             turbulence_config_get_number (TurbulenceCtx * ctx,
  */
 void turbulence_config_cleanup (TurbulenceCtx * ctx)
 {
+	TurbulenceConfigSnapshot * snapshot;
+	TurbulenceConfigDocRef   * ref;
+
 	/* do not operate */
 	if (ctx == NULL)
 		return;
 
-	/* free previous state */
-	if (ctx->config)
-		axl_doc_free (ctx->config);
-	ctx->config = NULL;
+	/* release the snapshot installed (readers still holding a
+	 * reference keep it until they release it) and registered
+	 * schemas */
+	vortex_mutex_lock (&ctx->config_snapshot_mutex);
+	snapshot = ctx->config_snapshot;
+	TBC_ATOMIC_STORE (ctx->config_snapshot, NULL);
+	TBC_ATOMIC_FENCE ();
+	while (TBC_ATOMIC_LOAD (ctx->config_snapshot_readers) != 0)
+		turbulence_ctx_wait (ctx, 10);
+	vortex_mutex_unlock (&ctx->config_snapshot_mutex);
+	turbulence_config_snapshot_unref (snapshot);
+
+	vortex_mutex_lock (&ctx->config_schemas_mutex);
+	axl_list_free (ctx->config_schemas);
+	ctx->config_schemas = NULL;
+	vortex_mutex_unlock (&ctx->config_schemas_mutex);
+
+	/* free previous state: documents still referenced by profile
+	 * paths are released here too (definitions do not touch them
+	 * when they are released) */
+	vortex_mutex_lock (&ctx->config_docs_mutex);
+	while (ctx->config_docs && axl_list_length (ctx->config_docs) > 0) {
+		ref = axl_list_get_first (ctx->config_docs);
+		axl_doc_free (ref->doc);
+		axl_list_remove_first (ctx->config_docs);
+	} /* end while */
+	axl_list_free (ctx->config_docs);
+	ctx->config_docs = NULL;
+	ctx->config      = NULL;
+	vortex_mutex_unlock (&ctx->config_docs_mutex);
 	if (ctx->config_path)
 		axl_free (ctx->config_path);
 	ctx->config_path = NULL;
@@ -23,7 +23,9 @@
                     server-backlog?,                                                      \
                     max-incoming-complete-frame-limit?,                                   \
                     thread-pool?,                                                         \
-                    close-conn-on-start-failure?)>                                        \
+                    close-conn-on-start-failure?,                                         \
+                    loop-affinity?,                                                       \
+                    metrics?)>                                                            \
                                                                                           \
 <!ELEMENT ports           (port+)>                                                        \
 <!ELEMENT port            (#PCDATA)>                                                      \
@@ -59,6 +61,14 @@
 <!ELEMENT kill-childs-on-exit   EMPTY>                                                    \
 <!ATTLIST kill-childs-on-exit   value  (yes|no) #REQUIRED>                                \
                                                                                           \
+<!ELEMENT loop-affinity   EMPTY>                                                          \
+<!ATTLIST loop-affinity   log-manager CDATA #IMPLIED                                      \
+                          proxy       CDATA #IMPLIED>                                     \
+                                                                                          \
+<!ELEMENT metrics         EMPTY>                                                          \
+<!ATTLIST metrics         listen      CDATA #IMPLIED                                      \
+                          port        CDATA #REQUIRED>                                    \
+                                                                                          \
 <!ELEMENT system-paths   (path|search)*)>                                                 \
 <!ELEMENT path        EMPTY>                                                              \
 <!ATTLIST path        name  CDATA #REQUIRED                                               \
@@ -128,6 +138,7 @@
                                                                                           \
 <!-- listener to be started -->                                                           \
 <!ELEMENT listener    (name+)>                                                            \
+<!ATTLIST listener    acceptors CDATA #IMPLIED>                                           \
 <!ELEMENT name        (#PCDATA)>                                                          \
                                                                                           \
 <!-- profile-path-configuration support -->                                               \
@@ -149,6 +160,14 @@
    separate       CDATA #IMPLIED                                                          \
    child-limit    CDATA #IMPLIED                                                          \
    reuse          CDATA #IMPLIED                                                          \
+   reuse-workers  CDATA #IMPLIED                                                          \
+   idle-timeout   CDATA #IMPLIED                                                          \
+   max-connections-served CDATA #IMPLIED                                                  \
+   max-rss        CDATA #IMPLIED                                                          \
+   cpu-affinity   CDATA #IMPLIED                                                          \
+   numa-spread    CDATA #IMPLIED                                                          \
+   max-rate       CDATA #IMPLIED                                                          \
+   max-burst      CDATA #IMPLIED                                                          \
    chroot         CDATA #IMPLIED                                                          \
           work-dir       CDATA #IMPLIED>                                                  \
                                                                                           \
@@ -157,12 +176,18 @@
           profile      CDATA #REQUIRED                                                    \
           connmark     CDATA #IMPLIED                                                     \
    max-per-conn CDATA #IMPLIED                                                            \
+   max-frame-size   CDATA #IMPLIED                                                        \
+   max-message-size CDATA #IMPLIED                                                        \
+   max-rate         CDATA #IMPLIED                                                        \
           preconnmark  CDATA #IMPLIED >                                                   \
                                                                                           \
 <!ATTLIST allow                                                                           \
    serverName   CDATA #IMPLIED                                                            \
           profile      CDATA #REQUIRED                                                    \
    max-per-conn CDATA #IMPLIED                                                            \
+   max-frame-size   CDATA #IMPLIED                                                        \
+   max-message-size CDATA #IMPLIED                                                        \
+   max-rate         CDATA #IMPLIED                                                        \
           preconnmark  CDATA #IMPLIED >                                                   \
                                                                                           \
 <!ATTLIST search                                                                          \
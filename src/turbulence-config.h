@@ -42,6 +42,21 @@
 axl_bool        turbulence_config_load     (TurbulenceCtx * ctx, 
 					    const char    * config);
 
+axlDoc        * turbulence_config_parse    (TurbulenceCtx * ctx,
+					    const char    * config);
+
+void            turbulence_config_replace  (TurbulenceCtx * ctx,
+					    axlDoc        * doc);
+
+void            turbulence_config_doc_ref   (TurbulenceCtx * ctx,
+					     axlDoc        * doc);
+
+void            turbulence_config_doc_unref (TurbulenceCtx * ctx,
+					     axlDoc        * doc);
+
+axl_bool        turbulence_config_is_running (TurbulenceCtx * ctx,
+					      axlDoc        * doc);
+
 void            turbulence_config_cleanup  (TurbulenceCtx * ctx);
 
 axlDoc        * turbulence_config_get      (TurbulenceCtx * ctx);
@@ -83,4 +98,24 @@ int             turbulence_config_get_number (TurbulenceCtx * ctx,
 					      const char    * path,
 					      const char    * attr_name);
 
+TurbulenceConfigSnapshot * turbulence_config_snapshot (TurbulenceCtx * ctx);
+
+void            turbulence_config_snapshot_unref (TurbulenceConfigSnapshot * snapshot);
+
+axl_bool        turbulence_config_snapshot_rebuild (TurbulenceCtx * ctx);
+
+axlPointer      turbulence_config_snapshot_module (TurbulenceConfigSnapshot * snapshot,
+						   const char               * name);
+
+axl_bool        turbulence_config_snapshot_get_number (TurbulenceConfigSnapshot * snapshot,
+						       const char               * path,
+						       const char               * attr_name,
+						       int                      * value);
+
+axl_bool        turbulence_config_register_schema (TurbulenceCtx               * ctx,
+						   const char                  * name,
+						   TurbulenceConfigSchemaBuild   build,
+						   axlDestroyFunc                destroy,
+						   axlPointer                    user_data);
+
 #endif
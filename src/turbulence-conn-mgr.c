@@ -64,6 +64,21 @@
  */
 #define TURBULENCE_CONN_MGR_PROXY_SEND_MAX_TRIES (100)
 
+/**
+ * @internal Connection key where the arena created by
+ * turbulence_conn_mgr_arena is stored.
+ */
+#define TURBULENCE_CONN_MGR_ARENA "tbc:arena"
+
+/** 
+ * @internal Size hint used to create connection arenas: the state
+ * every accepted connection stores there (conn mgr and profile path
+ * state, trace stamps and the requested serverName).
+ */
+#define TURBULENCE_CONN_MGR_ARENA_HINT (sizeof (TurbulenceConnMgrState) + \
+					sizeof (TurbulencePPathState) +	  \
+					sizeof (long) * TBC_TRACE_STAGES + 64)
+
 /** 
  * @internal Handler called once the connection is about to be closed,
  * used to drop its registration from the connection manager hash.
@@ -126,31 +141,38 @@ void turbulence_conn_mgr_unref (axlPointer data)
 	/* get a reference to the state */
 	TurbulenceConnMgrState * state = data;
 	TurbulenceCtx          * ctx   = state->ctx;
+	VortexConnection       * conn  = state->conn;
 
 	/* check connection status */
-	if (state->conn) {
+	if (conn) {
 		/* remove installed handlers */
-		vortex_connection_remove_handler (state->conn, CONNECTION_CHANNEL_ADD_HANDLER, state->added_channel_id);
-		vortex_connection_remove_handler (state->conn, CONNECTION_CHANNEL_REMOVE_HANDLER, state->removed_channel_id);
+		vortex_connection_remove_handler (conn, CONNECTION_CHANNEL_ADD_HANDLER, state->added_channel_id);
+		vortex_connection_remove_handler (conn, CONNECTION_CHANNEL_REMOVE_HANDLER, state->removed_channel_id);
 
 		/* uninstall on close full handler to avoid race conditions */
-		vortex_connection_remove_on_close_full (state->conn, turbulence_conn_mgr_on_close, ctx);
+		vortex_connection_remove_on_close_full (conn, turbulence_conn_mgr_on_close, ctx);
 
 		/* drop errors found on the connection */
-		__turbulence_conn_mgr_unref_show_errors (ctx, state->conn);
+		__turbulence_conn_mgr_unref_show_errors (ctx, conn);
 		
-		/* unref the connection */
 		msg ("Unregistering connection: %d (%p, socket: %d)", 
-		     vortex_connection_get_id ((VortexConnection*) state->conn), state->conn, vortex_connection_get_socket (state->conn));
-		vortex_connection_unref ((VortexConnection*) state->conn, "turbulence-conn-mgr");
+		     vortex_connection_get_id (conn), conn, vortex_connection_get_socket (conn));
 	} /* end if */
 
 	/* finish profiles running hash */
 	axl_hash_free (state->profiles_running);
 
-	/* nullify and free */
+	/* account connection unregistered */
+	turbulence_metric_inc (ctx->metrics_builtin[TBC_METRIC_CONNECTIONS], -1);
+
+	/* nullify: the state was allocated from the connection arena
+	 * (released along with the connection) so it must not be
+	 * touched after the unref below */
 	memset (state, 0, sizeof (TurbulenceConnMgrState));
-	axl_free (state);
+
+	/* unref the connection */
+	if (conn)
+		vortex_connection_unref (conn, "turbulence-conn-mgr");
 
 	/* check if we have to initiate child process termination */
 	if (ctx->child && ctx->started) {
@@ -202,6 +224,9 @@ void turbulence_conn_mgr_added_handler (VortexChannel * channel, axlPointer user
 		return;
 	} /* end if */
 
+	/* account channel started */
+	turbulence_metric_inc (ctx->metrics_builtin[TBC_METRIC_CHANNELS_STARTED], 1);
+
 	/* get channel count for the profile */
 	count = PTR_TO_INT (axl_hash_get (state->profiles_running, (axlPointer) running_profile));
 	count++;
@@ -214,6 +239,13 @@ void turbulence_conn_mgr_added_handler (VortexChannel * channel, axlPointer user
 	/* release the lock */
 	vortex_mutex_unlock (&ctx->conn_mgr_mutex);
 
+	/* limits declared at the profile path for this profile */
+	__turbulence_ppath_apply_limits (ctx, channel);
+
+	/* connection lifecycle trace: first channel reached */
+	if (vortex_channel_get_number (channel) > 0)
+		turbulence_trace_mark (ctx, conn, TBC_TRACE_FIRST_CHANNEL);
+
 	return;
 }
 
@@ -334,13 +366,13 @@ int turbulence_conn_mgr_notify (VortexCtx               * vortex_ctx,
 		} /* end if */
 	} /* end if */
 
-	/* create state */
-	state       = axl_new (TurbulenceConnMgrState, 1);
+	/* create state inside the connection arena so it is released
+	 * with the rest of the connection state in one step */
+	state       = TBC_ARENA_NEW (turbulence_conn_mgr_arena (ctx, conn), TurbulenceConnMgrState);
 	if (state == NULL)
 		return -1;
 	if (! vortex_connection_ref (conn, "turbulence-conn-mgr")) {
 		error ("Failed to acquire reference to connection during conn mgr notification, dropping");
-		axl_free (state);
 		return -1;
 	} /* end if */
 	state->conn = conn;
@@ -352,7 +384,6 @@ int turbulence_conn_mgr_notify (VortexCtx               * vortex_ctx,
 	if (state->profiles_running == NULL) {
 		error ("Failed to allocate profiles running hash during conn mgr notification, dropping");
 		vortex_connection_unref (conn, "turbulence-conn-mgr");
-		axl_free (state);
 		return -1;
 	} /* end if */
 
@@ -375,8 +406,8 @@ int turbulence_conn_mgr_notify (VortexCtx               * vortex_ctx,
 		     vortex_connection_get_id (conn));
 
 		axl_hash_free (state->profiles_running);
+		state->profiles_running = NULL;
 		vortex_connection_unref (conn, "turbulence-conn-mgr");
-		axl_free (state);
 		return 1;
 	} /* end if */
 
@@ -395,6 +426,13 @@ int turbulence_conn_mgr_notify (VortexCtx               * vortex_ctx,
 	/* unlock */
 	vortex_mutex_unlock (&ctx->conn_mgr_mutex);
 
+	/* account connection (connections accepted are only
+	 * accounted by the master: childs receive them already
+	 * accepted) */
+	turbulence_metric_inc (ctx->metrics_builtin[TBC_METRIC_CONNECTIONS], 1);
+	if (ctx->child == NULL && vortex_connection_get_role (conn) == VortexRoleListener)
+		turbulence_metric_inc (ctx->metrics_builtin[TBC_METRIC_CONNECTIONS_ACCEPTED], 1);
+
 	/* signal no error was found and the rest of handler can be
 	 * executed */
 	return 1;
@@ -1038,6 +1076,7 @@ axl_bool __turbulence_conn_proxy_reads_loop (TurbulenceLoop * loop,
 	VortexConnection * conn = ptr;
 	char buffer[4096];
 	int  bytes_read;
+	long wait;
 
 	/* read content */
 	bytes_read = recv (descriptor, buffer, 4096, 0);
@@ -1059,6 +1098,12 @@ axl_bool __turbulence_conn_proxy_reads_loop (TurbulenceLoop * loop,
 		return axl_false;
 	} /* end if */
 
+	/* bandwidth shaping: stop reading from the child until the
+	 * content sent is allowed by the connection rate */
+	wait = turbulence_shaper_consume (turbulence_shaper_conn_get (conn), bytes_read, axl_false);
+	if (wait > 0)
+		turbulence_loop_delay_descriptor (loop, descriptor, wait);
+
 	return axl_true; /* continue reading that socket */
 }
 
@@ -1150,8 +1195,12 @@ int        turbulence_conn_mgr_setup_proxy_on_parent (TurbulenceCtx * ctx, Vorte
 	} /* end if */
 
 	/* create the proxy loop watcher if it wasn't created yet */
-	if (ctx->proxy_loop == NULL)
+	if (ctx->proxy_loop == NULL) {
 		ctx->proxy_loop = turbulence_loop_create (ctx);
+
+		/* bind it to the cpus configured (if any) */
+		turbulence_affinity_configure_loop (ctx, ctx->proxy_loop, "proxy");
+	} /* end if */
 	if (ctx->proxy_loop == NULL) {
 		/* without the loop nothing would ever read descf[1], so
 		 * fail here instead of handing the caller a socket that
@@ -1352,6 +1401,125 @@ axlHashCursor    * turbulence_conn_mgr_profiles_stats (TurbulenceCtx    * ctx,
 	return cursor;
 }
 
+/** 
+ * @brief Returns the arena associated to the provided connection,
+ * creating it if it wasn't created yet. The arena is released in one
+ * step when the connection is finished, so it is the place where to
+ * allocate state that must live as long as the connection (see \ref
+ * turbulence_arena).
+ *
+ * Memory allocated from the arena must not be released by the
+ * caller, and no destroy function must be installed for it (for
+ * example with vortex_connection_set_data_full) because connection
+ * data is not released in any particular order.
+ *
+ * @param ctx The turbulence context.
+ * @param conn The connection whose arena is requested.
+ *
+ * @return A reference to the arena or NULL if it fails.
+ */
+TurbulenceArena  * turbulence_conn_mgr_arena (TurbulenceCtx    * ctx,
+					      VortexConnection * conn)
+{
+	TurbulenceArena * arena;
+
+	v_return_val_if_fail (ctx && conn, NULL);
+
+	/* connection data is protected by the connection itself, so
+	 * the common case (arena already created) does not need the
+	 * global lock */
+	arena = vortex_connection_get_data (conn, TURBULENCE_CONN_MGR_ARENA);
+	if (arena != NULL)
+		return arena;
+
+	/* lock to avoid creating two arenas for the same connection,
+	 * checking again once the lock is acquired */
+	vortex_mutex_lock (&ctx->conn_arena_mutex);
+
+	arena = vortex_connection_get_data (conn, TURBULENCE_CONN_MGR_ARENA);
+	if (arena == NULL) {
+		arena = turbulence_arena_new (TURBULENCE_CONN_MGR_ARENA_HINT);
+		if (arena == NULL)
+			error ("Failed to allocate arena for connection id=%d", vortex_connection_get_id (conn));
+		else
+			vortex_connection_set_data_full (conn, 
+							 /* the key and its associated value */
+							 TURBULENCE_CONN_MGR_ARENA, arena,
+							 /* destroy functions */
+							 NULL, turbulence_arena_free);
+	} /* end if */
+
+	vortex_mutex_unlock (&ctx->conn_arena_mutex);
+
+	return arena;
+}
+
+/** 
+ * @brief Returns the amount of memory (in bytes) reserved by the
+ * arena of the provided connection.
+ *
+ * @param conn The connection to check.
+ *
+ * @return Bytes reserved or 0 if the connection has no arena.
+ */
+int                turbulence_conn_mgr_get_bytes (VortexConnection * conn)
+{
+	if (conn == NULL)
+		return 0;
+	return turbulence_arena_bytes (vortex_connection_get_data (conn, TURBULENCE_CONN_MGR_ARENA));
+}
+
+axl_bool __turbulence_conn_mgr_ppath_bytes (axlPointer key, axlPointer data, axlPointer _ppath, axlPointer _bytes, axlPointer _connections)
+{
+	TurbulenceConnMgrState * state       = data;
+	TurbulencePPathDef     * ppath       = _ppath;
+	long                   * bytes       = _bytes;
+	int                    * connections = _connections;
+
+	/* skip connections running on a different profile path */
+	if (state->conn == NULL || (ppath && turbulence_ppath_selected (state->conn) != ppath))
+		return axl_false;
+
+	(*bytes)       += turbulence_conn_mgr_get_bytes (state->conn);
+	(*connections) += 1;
+
+	return axl_false; /* keep on iterating */
+}
+
+/** 
+ * @brief Returns the amount of memory (in bytes) reserved by the
+ * arenas of all connections registered running the provided profile
+ * path.
+ *
+ * @param ctx The turbulence context.
+ *
+ * @param ppath The profile path to account. If NULL is provided, all
+ * registered connections are accounted.
+ *
+ * @param connections Optional reference where the number of
+ * connections accounted is reported.
+ *
+ * @return Bytes reserved by all connections found.
+ */
+long               turbulence_conn_mgr_ppath_bytes (TurbulenceCtx      * ctx,
+						    TurbulencePPathDef * ppath,
+						    int                * connections)
+{
+	long bytes = 0;
+	int  count = 0;
+
+	v_return_val_if_fail (ctx, 0);
+
+	vortex_mutex_lock (&ctx->conn_mgr_mutex);
+	if (ctx->conn_mgr_hash)
+		axl_hash_foreach3 (ctx->conn_mgr_hash, __turbulence_conn_mgr_ppath_bytes, ppath, &bytes, &count);
+	vortex_mutex_unlock (&ctx->conn_mgr_mutex);
+
+	if (connections)
+		(*connections) = count;
+	return bytes;
+}
+
 /**
  * @internal Uninstall every handler the connection manager installed on
  * the connection associated to the state received.
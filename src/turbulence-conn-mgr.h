@@ -73,6 +73,15 @@ VortexConnection * turbulence_conn_mgr_find_by_id (TurbulenceCtx * ctx,
 axlHashCursor    * turbulence_conn_mgr_profiles_stats (TurbulenceCtx    * ctx,
 						       VortexConnection * conn);
 
+TurbulenceArena  * turbulence_conn_mgr_arena       (TurbulenceCtx      * ctx,
+						    VortexConnection   * conn);
+
+int                turbulence_conn_mgr_get_bytes   (VortexConnection   * conn);
+
+long               turbulence_conn_mgr_ppath_bytes (TurbulenceCtx      * ctx,
+						    TurbulencePPathDef * ppath,
+						    int                * connections);
+
 
 
 /* private API */
@@ -37,6 +37,75 @@
 #ifndef __TURBULENCE_CTX_PRIVATE_H__
 #define __TURBULENCE_CTX_PRIVATE_H__
 
+/* 
+ * @internal Word sized values shared between threads without a lock
+ * (slots, published snapshots, counters). A plain load could observe
+ * a counter or pointer before the memory it covers is initialized,
+ * so these macros provide acquire loads and release stores where the
+ * compiler has builtins for them, falling back to a full barrier
+ * around each access (GCC before 4.7 and win32). Other compilers get
+ * plain accesses and callers documented as lock-free need external
+ * synchronization there.
+ *
+ * TBC_ATOMIC_ADD adds to a counter and returns its previous value,
+ * and TBC_ATOMIC_FENCE orders a store before a later load (both are
+ * full barriers, required to check for readers after publishing a
+ * pointer, see turbulence-mediator.c).
+ */
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+#define TBC_ATOMIC_LOAD(ref)        __atomic_load_n (&(ref), __ATOMIC_ACQUIRE)
+#define TBC_ATOMIC_STORE(ref,value) __atomic_store_n (&(ref), (value), __ATOMIC_RELEASE)
+#define TBC_ATOMIC_ADD(ref,value)   __atomic_fetch_add (&(ref), (value), __ATOMIC_SEQ_CST)
+#define TBC_ATOMIC_FENCE()          __atomic_thread_fence (__ATOMIC_SEQ_CST)
+#else
+#if defined(__GNUC__)
+#define TBC_ATOMIC_BARRIER()        __sync_synchronize ()
+#elif defined(AXL_OS_WIN32)
+#define TBC_ATOMIC_BARRIER()        MemoryBarrier ()
+#else
+#define TBC_ATOMIC_BARRIER()        ((void) 0)
+#endif
+#define TBC_ATOMIC_LOAD(ref)        (TBC_ATOMIC_BARRIER (), (ref))
+#define TBC_ATOMIC_STORE(ref,value) do { TBC_ATOMIC_BARRIER (); (ref) = (value); } while (0)
+#define TBC_ATOMIC_FENCE()          TBC_ATOMIC_BARRIER ()
+#if defined(__GNUC__)
+#define TBC_ATOMIC_ADD(ref,value)   __sync_fetch_and_add (&(ref), (value))
+#elif defined(AXL_OS_WIN32)
+#define TBC_ATOMIC_ADD(ref,value)   InterlockedExchangeAdd ((LONG volatile *) &(ref), (value))
+#else
+#define TBC_ATOMIC_ADD(ref,value)   (((ref) += (value)) - (value))
+#endif
+#endif
+
+/** 
+ * @internal Max length of the <on-bad-signal mail-to> address copied
+ * for the fault handler (see turbulence_config_snapshot_rebuild).
+ */
+#define TBC_BAD_SIGNAL_MAIL_TO_MAX 256
+
+/** 
+ * @internal Metrics updated by turbulence core (see
+ * turbulence_metrics_init), cached at the context to avoid looking
+ * them up on each event.
+ */
+typedef enum {
+	TBC_METRIC_CONNECTIONS_ACCEPTED = 0,
+	TBC_METRIC_CONNECTIONS          = 1,
+	TBC_METRIC_CHILDS_CREATED       = 2,
+	TBC_METRIC_HANDOFF_SPAWN        = 3,
+	TBC_METRIC_HANDOFF_REUSE        = 4,
+	TBC_METRIC_CHANNELS_STARTED     = 5,
+	TBC_METRIC_LOG_RELAYED          = 6,
+	TBC_METRIC_LOG_BACKLOG          = 7,
+	TBC_METRIC_BUILTIN_MAX          = 8
+} TurbulenceMetricBuiltin;
+
+/** 
+ * @internal Immutable set of registered modules implementing a
+ * particular handler (see turbulence-module.c).
+ */
+typedef struct _TurbulenceModuleSet TurbulenceModuleSet;
+
 
 struct _TurbulenceCtx {
 	/* Reference to the turbulence vortex context associated.
@@ -46,6 +115,12 @@ struct _TurbulenceCtx {
 	/* default signal handlers */
 	TurbulenceSignalHandler signal_handler;
 
+	/* self-pipe where the signal handler writes signals whose
+	 * handling is not async-signal-safe (reload), served by the
+	 * signal_loop thread (see turbulence_signal_received) */
+	int                     signal_pipe[2];
+	TurbulenceLoop        * signal_loop;
+
 	/* track when turbulence was started (at least this context) */
 	long                    running_stamp;
 
@@ -85,6 +160,12 @@ struct _TurbulenceCtx {
 	int                  ppath_next_id;
 	TurbulencePPath    * paths;
 	axl_bool             all_rules_address_based;
+	/* paths is swapped on reload (see turbulence_ppath_install)
+	 * under paths_mutex, which also protects the reference count
+	 * of each set. A set replaced is released once threads
+	 * iterating it finish, and its definitions once connections
+	 * and childs pointing to them are gone */
+	VortexMutex          paths_mutex;
 	/* profile_attr_alias: this hash allows to establish a set of
 	 * alias that is used by profile path module to check for a
 	 * particular attribute found on the connection instead of the
@@ -108,18 +189,73 @@ struct _TurbulenceCtx {
 	axlDoc             * config;
 	char               * config_path;
 
+	/* configuration compiled into typed values (see
+	 * turbulence_config_snapshot): published with a release store
+	 * and acquired by readers without locking (counted on
+	 * config_snapshot_readers while they take their reference).
+	 * config_snapshot_mutex only serializes rebuilds. Schemas
+	 * registered by modules are protected by
+	 * config_schemas_mutex. config_docs holds the reference
+	 * count of documents in use (the running one and those
+	 * profile paths were built from, which borrow their values),
+	 * protected by config_docs_mutex */
+	axlList                  * config_docs;
+	VortexMutex                config_docs_mutex;
+	TurbulenceConfigSnapshot * config_snapshot;
+	int                        config_snapshot_readers;
+	VortexMutex                config_snapshot_mutex;
+
+	/* <on-bad-signal> values copied from the snapshot when it is
+	 * installed, so the fault handler never touches a snapshot
+	 * (it may be released by a concurrent reload). mail-to is
+	 * written into the buffer not published and then published
+	 * by bad_signal_mail_to_slot (-1 when not configured) */
+	int                        bad_signal_action;
+	char                       bad_signal_mail_to[2][TBC_BAD_SIGNAL_MAIL_TO_MAX];
+	int                        bad_signal_mail_to_slot;
+	axlList                  * config_schemas;
+	VortexMutex                config_schemas_mutex;
+
 	/* turbulence loading modules module */
 	axlList            * registered_modules;
 	VortexMutex          registered_modules_mutex;
+	/* modules implementing ppath_selected, rebuilt on each
+	 * (un)register under registered_modules_mutex and read
+	 * without locking (sets replaced are kept on retired until
+	 * modules cleanup) */
+	TurbulenceModuleSet * ppath_selected_modules;
+	TurbulenceModuleSet * ppath_selected_retired;
 
 	/* turbulence connection manager module */
 	VortexMutex          conn_mgr_mutex;
 	axlHash            * conn_mgr_hash; 
 
+	/* protects creation of per connection arenas, lookups of
+	 * arenas already created do not take it (see
+	 * turbulence_conn_mgr_arena) */
+	VortexMutex          conn_arena_mutex;
+
 	/* turbulence stored data */
 	axlHash            * data;
 	VortexMutex          data_mutex;
 
+	/* slot indexed data (see turbulence_ctx_slot_new): slots are
+	 * reserved under data_mutex and then read and written
+	 * without locking */
+	axlPointer           data_slots[TBC_CTX_MAX_SLOTS];
+	axlDestroyFunc       data_slots_destroy[TBC_CTX_MAX_SLOTS];
+	int                  data_slots_next;
+
+	/* per thread slots (see turbulence_ctx_thread_slot_new):
+	 * array of thread keys, allocated at turbulence_ctx_new,
+	 * thread_slots_next is published once the key is created */
+	axlPointer           thread_slots;
+	int                  thread_slots_next;
+
+	/* slot where main.c flags debug was not requested at
+	 * command line (child processes are started without it) */
+	int                  debug_not_requested_slot;
+
 	/* used to signal if the server was started */
 	axl_bool             started;
 
@@ -138,11 +274,68 @@ struct _TurbulenceCtx {
 	/*** turbulence mediator module ***/
 	axlHash            * mediator_hash;
 	VortexMutex          mediator_hash_mutex;
+	/* turbulence::module-registered plug, resolved at init */
+	TurbulenceMediatorPlug * mediator_module_registered;
 	
 	/*** support for proxy on parent ***/
 	TurbulenceLoop     * proxy_loop;
+
+	/*** bandwidth shaping (see turbulence-shaper.c) ***/
+	/* thread resuming connections blocked by their shaper and
+	 * queue used to hand them over, created on first use and
+	 * protected by shaper_mutex */
+	VortexMutex          shaper_mutex;
+	VortexThread         shaper_thread;
+	VortexAsyncQueue   * shaper_queue;
+
+	/*** turbulence metrics registry ***/
+	/* metrics registered in creation order (array of
+	 * metrics_count items) and indexed by name and labels */
+	TurbulenceMetric  ** metrics;
+	int                  metrics_count;
+	int                  metrics_size;
+	axlHash            * metrics_hash;
+	VortexMutex          metrics_mutex;
+	TurbulenceMetric   * metrics_builtin[TBC_METRIC_BUILTIN_MAX];
+	/* pending requests sent to childs to collect their metrics
+	 * (see turbulence_metrics_render), protected by metrics_mutex */
+	axlHash            * metrics_calls;
+	int                  metrics_calls_next;
+	/* loop serving metrics (master process) and clients it is
+	 * reading requests from (only used by the loop thread) */
+	TurbulenceLoop     * metrics_loop;
+	axlList            * metrics_clients;
+
+	/*** acceptor loops for listeners with several SO_REUSEPORT sockets ***/
+	axlList            * acceptors;
+
+	/*** support for binary upgrade ***/
+	/* listener sockets opened (TurbulenceListenerSocket), passed
+	 * to the new binary on upgrade */
+	axlList            * listener_sockets;
+	/* listener sockets and childs inherited from the previous
+	 * binary, pending to be adopted */
+	axlList            * inherited_listeners;
+	axlList            * inherited_childs;
+
+	/*** child supervision (SIGCHLD received through a signalfd
+	 * watched by this loop, see turbulence_signal_sigchld) ***/
+	TurbulenceLoop     * sigchld_loop;
 };
 
+/** 
+ * @internal Listening socket started by the master process.
+ */
+typedef struct _TurbulenceListenerSocket {
+	int                  socket;
+	char               * host;
+	char               * port;
+	/* vortex listener or acceptor loop watching the socket (one
+	 * of them) used to close it when it is no longer declared */
+	VortexConnection   * listener;
+	TurbulenceLoop     * acceptor;
+} TurbulenceListenerSocket;
+
 /** 
  * @brief Private definition that represents a child process created.
  */
@@ -167,6 +360,31 @@ struct _TurbulenceChild {
 	/* connection management */
 	VortexConnection   * conn_mgr;
 
+	/* read ends of the log pipes (general, error, access,
+	 * vortex) registered at the master log manager or -1 */
+	int                  log_pipes[4];
+
+	/* stamp when the child was created (or adopted), used to
+	 * report its lifetime when it finishes */
+	long                 started_stamp;
+
+	/* child recycling: connections sent to the child, when its
+	 * memory was last checked and if it was retired (no new
+	 * connection is sent to it) */
+	int                  connections_served;
+	long                 rss_stamp;
+	axl_bool             retired;
+
+	/* cpu list the child was bound to (or NULL) and the NUMA
+	 * node selected for it (or -1) */
+	char               * affinity;
+	int                  numa_node;
+
+	/* child side: monotonic stamp when the child completed its
+	 * startup, reported with the connection that caused its
+	 * creation (see turbulence_trace_restore) */
+	long                 trace_ready;
+
 	/* ref counting and mutex */
 	int                  ref_count;
 	VortexMutex          mutex;
@@ -197,14 +415,35 @@ struct _TurbulencePPathItem {
 	 * connection before accepting the profile. */
 	char * preconnmark;
 
+	/* optional limits applied to channels accepted by this item
+	 * (0 if not declared): max-frame-size and max-message-size */
+	int    max_frame_size;
+	int    max_message_size;
+
+	/* optional bandwidth (bytes per second) the connection is
+	 * limited to once a channel is accepted by this item (0 if
+	 * not declared): max-rate */
+	long   max_rate;
+
 	/* Another list for all profile path item found inside this
 	 * profile path item. This is only used by PROFILE_IF items */
 	TurbulencePPathItem ** ppath_items;
 	
 };
 
+/* limits declared by the profile path item that accepted a channel,
+ * stored on the connection until the channel is added (see
+ * __turbulence_ppath_apply_limits) */
+typedef struct _TurbulencePPathLimits {
+	int  max_frame_size;
+	int  max_message_size;
+	long max_rate;
+} TurbulencePPathLimits;
+
 /* profile path state associated to a connection, stored under the
- * TURBULENCE_PPATH_STATE connection key (see turbulence-ppath.c) */
+ * TURBULENCE_PPATH_STATE connection key (see turbulence-ppath.c).
+ * The connection holds a reference on the profile path selected
+ * (released with the connection, see __turbulence_ppath_state_select) */
 typedef struct _TurbulencePPathState {
 	/* a reference to the profile path selected for the
 	 * connection */
@@ -222,19 +461,23 @@ typedef struct _TurbulencePPathState {
  * This structure mixes owned and borrowed references on purpose, so
  * check which one you are touching before releasing anything:
  *
- * - OWNED (allocated by turbulence_ppath_init, released by
- *   turbulence_ppath_cleanup): path_name, serverName, src, dst and
+ * - OWNED (allocated by turbulence_ppath_build, released with the
+ *   last reference): path_name, serverName, src, dst and
  *   ppath_items.
  *
- * - BORROWED from the configuration document (ctx->config): chroot,
- *   work_dir and node. They are plain ATTR_VALUE()/axlNode pointers
- *   into the axlDoc, so they MUST NOT be released here: the document
- *   owns them and outlives the profile paths. Freeing any of them
+ * - BORROWED from the configuration document (doc): chroot,
+ *   work_dir, cpu_affinity and node. They are plain
+ *   ATTR_VALUE()/axlNode pointers into the axlDoc, so they MUST NOT
+ *   be released here: the document owns them. Freeing any of them
  *   causes a double free when the configuration document is released.
  *
  * The asymmetry is deliberate: node is needed to walk <search> nodes
- * lazily (__turbulence_ppath_load_search_nodes), which already forces
- * the document to outlive this structure.
+ * (__turbulence_ppath_load_search_nodes, at install time or child
+ * post init), so the definition holds a reference on doc
+ * (turbulence_config_doc_ref) which keeps it alive after a reload
+ * replaces it. The definition itself is reference counted: sets of
+ * profile paths holding it, connections that selected it and childs
+ * created for it (see __turbulence_ppath_def_unref).
  */
 struct _TurbulencePPathDef {
 	int    id;
@@ -279,14 +522,29 @@ struct _TurbulencePPathDef {
 	   are reused. */
 	axl_bool reuse;
 
+	/** 
+	 * number of childs reused to handle connections for this
+	 * profile path (reuse-workers attribute, only used when reuse
+	 * is enabled). Connections are spread over them (round robin)
+	 * and all channels of a connection are handled by the same
+	 * child. By default 1.
+	 */
+	int reuse_workers;
+
+	/** 
+	 * next reused child to be selected (round robin counter). On
+	 * child process it has no value.
+	 */
+	int reuse_next;
+
 	/* allows to change the process root directory to the provided
 	 * value.
-	 * BORROWED from ctx->config: do not release */
+	 * BORROWED from doc: do not release */
 	const char * chroot;
 
 	/* allows to configure a working directory associated to the
 	 * profile path.
-	 * BORROWED from ctx->config: do not release */
+	 * BORROWED from doc: do not release */
 	const char * work_dir;
 	
 	/** 
@@ -303,12 +561,102 @@ struct _TurbulencePPathDef {
 	 */
 	int childs_running;
 
+	/** 
+	 * child recycling: seconds an idle reused child waits for new
+	 * connections before finishing (idle-timeout, by default 30),
+	 * connections served (max-connections-served) and resident
+	 * memory in kilobytes (max-rss) after which a child is
+	 * retired: no new connection is sent to it and it finishes
+	 * once its connections are closed (-1 no limit).
+	 */
+	int  idle_timeout;
+	int  max_conn_served;
+	long max_rss;
+
+	/** 
+	 * number of childs running that were retired (included in
+	 * childs_running). On child process it has no value.
+	 */
+	int  childs_retired;
+
+	/** 
+	 * cpu list childs created for this profile path are bound to
+	 * (cpu-affinity) and if childs must be spread over NUMA nodes
+	 * (numa-spread), with the next node to use (round robin).
+	 * cpu_affinity is BORROWED from doc: do not release.
+	 */
+	const char * cpu_affinity;
+	axl_bool     numa_spread;
+	int          numa_next;
+
+	/** 
+	 * connections selected for this profile path
+	 * (turbulence_ppath_selected_total metric). Owned by the
+	 * metrics registry: do not release.
+	 */
+	TurbulenceMetric * metric_selected;
+
+	/** 
+	 * per stage latency of connections handled by this profile
+	 * path (turbulence_connection_stage_microseconds metric,
+	 * index 0 holds the total). Owned by the metrics registry: do
+	 * not release.
+	 */
+	TurbulenceMetric * metric_stages[TBC_TRACE_STAGES];
+
+	/** 
+	 * bandwidth shaping: bytes per second read from each
+	 * connection (and sent when proxied by the parent) and bytes
+	 * accepted at once after an idle period (max-rate and
+	 * max-burst, 0 if not declared).
+	 */
+	long max_rate;
+	long max_burst;
+
+	/** 
+	 * shaping counters: bytes accounted (index 0 incoming, 1
+	 * outgoing), delays and microseconds delayed. Owned by the
+	 * metrics registry: do not release.
+	 */
+	TurbulenceMetric * metric_shaping_bytes[2];
+	TurbulenceMetric * metric_shaping_delays;
+	TurbulenceMetric * metric_shaping_delay;
+
+	/** 
+	 * child supervision: number of childs finished (and how many
+	 * of them failed), how the last one finished and the number
+	 * of consecutive childs that failed shortly after being
+	 * created. While backoff_until is in the future no new child
+	 * is created for this profile path. On child process they
+	 * have no value.
+	 */
+	int  childs_finished;
+	int  childs_failed;
+	int  last_exit_status;
+	long last_exit_stamp;
+	int  failures_in_row;
+	long backoff_until;
+
 	/**
 	 * reference to the <ppath-def> that where this profile path was loaded.
-	 * BORROWED from ctx->config: do not release
+	 * BORROWED from doc: do not release
 	 */
 	axlNode * node;
 
+	/**
+	 * configuration document the definition was built from
+	 * (referenced) and context it belongs to.
+	 */
+	axlDoc        * doc;
+	TurbulenceCtx * ctx;
+
+	/**
+	 * reference counting (TBC_ATOMIC_ADD): one for each set of
+	 * profile paths, connection and child pointing to the
+	 * definition.
+	 */
+	int ref_count;
+
 	/** 
 	 * In the case profile <path-def> has search nodes configured,
 	 * this flag signal if they were loaded previously (to avoid
@@ -333,4 +681,41 @@ typedef struct _TurbulenceConnMgrState {
 	axlPointer         removed_channel_id;
 } TurbulenceConnMgrState;
 
+/** 
+ * @internal Configuration compiled by turbulence-config.c. Once
+ * built, a snapshot is never modified: a reload builds a new one
+ * which replaces the reference installed at the context.
+ */
+struct _TurbulenceConfigSnapshot {
+	/* reference counting (TBC_ATOMIC_ADD): the context holds one
+	 * reference and each reader acquires another one */
+	int                         ref_count;
+
+	/* <thread-pool> */
+	int                         thread_pool_max_limit;
+	int                         thread_pool_step_period;
+	int                         thread_pool_step_add;
+
+	/* <server-backlog>, <global-child-limit> and
+	 * <max-incoming-complete-frame-limit> (defaults applied) */
+	int                         server_backlog;
+	int                         global_child_limit;
+	int                         max_complete_flag_limit;
+
+	/* <kill-childs-on-exit> */
+	axl_bool                    kill_childs_on_exit;
+
+	/* <on-bad-signal>: mail_to is NULL when not configured */
+	TurbulenceBadSignalAction   on_bad_signal;
+	char                      * on_bad_signal_mail_to;
+
+	/* numeric values found at /turbulence/global-settings: a
+	 * hash indexed by node path that contains a hash indexed by
+	 * attribute name with int values */
+	axlHash                   * numbers;
+
+	/* data compiled by module schemas, indexed by schema name */
+	axlHash                   * modules;
+};
+
 #endif
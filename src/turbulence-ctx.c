@@ -36,6 +36,13 @@
  */
 #include <turbulence.h>
 
+#if defined(AXL_OS_UNIX)
+#include <pthread.h>
+typedef pthread_key_t TurbulenceThreadKey;
+#elif defined(AXL_OS_WIN32)
+typedef DWORD         TurbulenceThreadKey;
+#endif
+
 /* local include */
 #include <turbulence-ctx-private.h>
 
@@ -83,14 +90,33 @@ TurbulenceCtx * turbulence_ctx_new ()
 	ctx->data  = axl_hash_new (axl_hash_string, axl_hash_equal_string);
 	vortex_mutex_create (&ctx->data_mutex);
 
+	/* core slots, thread keys array is allocated here so readers
+	 * never see it change */
+	ctx->thread_slots             = axl_new (TurbulenceThreadKey, TBC_CTX_MAX_SLOTS);
+	ctx->debug_not_requested_slot = turbulence_ctx_slot_new (ctx, NULL);
+
+	/* configuration snapshot (see turbulence-config.c) */
+	vortex_mutex_create (&ctx->config_snapshot_mutex);
+	ctx->bad_signal_mail_to_slot = -1;
+	vortex_mutex_create (&ctx->config_schemas_mutex);
+	vortex_mutex_create (&ctx->config_docs_mutex);
+
 	/* set log descriptors to something not usable */
 	ctx->general_log = -1;
 	ctx->error_log   = -1;
 	ctx->access_log  = -1;
 	ctx->vortex_log  = -1;
 
+	/* no signal is deferred until turbulence_signal_install */
+	ctx->signal_pipe[0] = -1;
+	ctx->signal_pipe[1] = -1;
+
 	/* init ppath unique id assigment */
 	ctx->ppath_next_id = 1;
+	vortex_mutex_create (&ctx->paths_mutex);
+	vortex_mutex_create (&ctx->conn_arena_mutex);
+	vortex_mutex_create (&ctx->metrics_mutex);
+	vortex_mutex_create (&ctx->shaper_mutex);
 
 	/* init wait queue */
 	ctx->wait_queue    = vortex_async_queue_new ();
@@ -113,7 +139,10 @@ void           turbulence_ctx_reinit (TurbulenceCtx * ctx, TurbulenceChild * chi
 	ctx->child   = child;
 	child->ctx   = ctx;
 
-	/* record profile path selected */
+	/* record profile path selected (the child object holds a
+	 * reference on it) */
+	__turbulence_ppath_def_ref (def);
+	__turbulence_ppath_def_unref (ctx->child->ppath);
 	ctx->child->ppath = def;
 
 	/* re-init mutex */
@@ -125,6 +154,11 @@ void           turbulence_ctx_reinit (TurbulenceCtx * ctx, TurbulenceChild * chi
 	/* mutex on child object */
 	vortex_mutex_create (&ctx->child->mutex);
 
+	/* the bandwidth shaping resume thread is not inherited: it is
+	 * started again on first use */
+	vortex_mutex_create (&ctx->shaper_mutex);
+	ctx->shaper_queue = NULL;
+
 	/* clean child process list: reinit = axl_true */
 	turbulence_process_init (ctx, axl_true);
 
@@ -281,6 +315,226 @@ axlPointer      turbulence_ctx_get_data       (TurbulenceCtx * ctx,
 	return data;
 }
 
+/** 
+ * @brief Reserves a new data slot on the provided context.
+ *
+ * Slots are an alternative to \ref turbulence_ctx_set_data for data
+ * accessed on hot paths: the slot is reserved once (usually at
+ * module init) and then \ref turbulence_ctx_slot_get and \ref
+ * turbulence_ctx_slot_set access it by index, without locking and
+ * without hashing a string key.
+ *
+ * Reading a slot is an acquire load and writing it a release store,
+ * so a thread that gets a value from \ref turbulence_ctx_slot_get
+ * also sees the memory configured before it was stored with \ref
+ * turbulence_ctx_slot_set (configure the data before storing it).
+ * The same applies to slots reserved by other threads. A value
+ * replaced must not be released while other threads may still be
+ * using it. On compilers without GCC builtins nor win32 barriers,
+ * slot accesses are plain loads and stores and callers must
+ * synchronize them externally.
+ *
+ * @param ctx The \ref TurbulenceCtx where the slot is reserved.
+ *
+ * @param data_destroy Optional handler called to release the value
+ * stored on the slot when the context is finished.
+ *
+ * @return The slot reserved or -1 if it fails (NULL ctx or no more
+ * slots available, see \ref TBC_CTX_MAX_SLOTS).
+ */
+int             turbulence_ctx_slot_new       (TurbulenceCtx  * ctx,
+					       axlDestroyFunc   data_destroy)
+{
+	int slot = -1;
+
+	v_return_val_if_fail (ctx, -1);
+
+	vortex_mutex_lock (&ctx->data_mutex);
+	if (ctx->data_slots_next < TBC_CTX_MAX_SLOTS) {
+		slot                          = ctx->data_slots_next;
+		ctx->data_slots[slot]         = NULL;
+		ctx->data_slots_destroy[slot] = data_destroy;
+
+		/* publish the slot once initialized */
+		TBC_ATOMIC_STORE (ctx->data_slots_next, slot + 1);
+	} /* end if */
+	vortex_mutex_unlock (&ctx->data_mutex);
+
+	return slot;
+}
+
+/** 
+ * @brief Stores data on a slot reserved by \ref
+ * turbulence_ctx_slot_new.
+ *
+ * The value previously stored is not released (see \ref
+ * turbulence_ctx_slot_new).
+ *
+ * @param ctx The \ref TurbulenceCtx where the slot was reserved.
+ *
+ * @param slot The slot to configure.
+ *
+ * @param data The data to store or NULL to clear the slot.
+ */
+void            turbulence_ctx_slot_set       (TurbulenceCtx * ctx,
+					       int             slot,
+					       axlPointer      data)
+{
+	v_return_if_fail (ctx);
+	v_return_if_fail (slot >= 0 && slot < TBC_ATOMIC_LOAD (ctx->data_slots_next));
+
+	TBC_ATOMIC_STORE (ctx->data_slots[slot], data);
+	return;
+}
+
+/** 
+ * @brief Returns data stored on a slot reserved by \ref
+ * turbulence_ctx_slot_new.
+ *
+ * @param ctx The \ref TurbulenceCtx where the slot was reserved.
+ *
+ * @param slot The slot to read.
+ *
+ * @return The data stored or NULL if nothing was stored or the slot
+ * is not valid.
+ */
+axlPointer      turbulence_ctx_slot_get       (TurbulenceCtx * ctx,
+					       int             slot)
+{
+	if (ctx == NULL || slot < 0 || slot >= TBC_ATOMIC_LOAD (ctx->data_slots_next))
+		return NULL;
+	return TBC_ATOMIC_LOAD (ctx->data_slots[slot]);
+}
+
+/** 
+ * @brief Reserves a new per thread data slot on the provided context.
+ *
+ * Same as \ref turbulence_ctx_slot_new but each thread sees its own
+ * value on the slot, which is useful to implement caches without
+ * locking. 
+ *
+ * @param ctx The \ref TurbulenceCtx where the slot is reserved.
+ *
+ * @param data_destroy Optional handler called to release the value
+ * stored by a thread when it finishes. Values stored by threads
+ * still running when the context is finished are not released. 
+ *
+ * @return The slot reserved or -1 if it fails.
+ */
+int             turbulence_ctx_thread_slot_new (TurbulenceCtx  * ctx,
+						axlDestroyFunc   data_destroy)
+{
+	TurbulenceThreadKey * keys;
+	int                   slot = -1;
+	int                   next;
+
+	v_return_val_if_fail (ctx, -1);
+
+	vortex_mutex_lock (&ctx->data_mutex);
+	keys = ctx->thread_slots;
+	next = ctx->thread_slots_next;
+	if (keys != NULL && next < TBC_CTX_MAX_SLOTS) {
+#if defined(AXL_OS_UNIX)
+		if (pthread_key_create (&keys[next], data_destroy) == 0) 
+			slot = next;
+#elif defined(AXL_OS_WIN32)
+		/* no destroy handler support on this platform */
+		keys[next] = TlsAlloc ();
+		if (keys[next] != TLS_OUT_OF_INDEXES)
+			slot = next;
+#endif
+		/* publish the slot once its key is created */
+		if (slot != -1)
+			TBC_ATOMIC_STORE (ctx->thread_slots_next, next + 1);
+	} /* end if */
+	vortex_mutex_unlock (&ctx->data_mutex);
+
+	return slot;
+}
+
+/** 
+ * @brief Stores data for the calling thread on a slot reserved by
+ * \ref turbulence_ctx_thread_slot_new.
+ *
+ * @param ctx The \ref TurbulenceCtx where the slot was reserved.
+ *
+ * @param slot The slot to configure.
+ *
+ * @param data The data to store or NULL to clear the slot.
+ */
+void            turbulence_ctx_thread_slot_set (TurbulenceCtx * ctx,
+						int             slot,
+						axlPointer      data)
+{
+	TurbulenceThreadKey * keys;
+
+	v_return_if_fail (ctx);
+	v_return_if_fail (slot >= 0 && slot < TBC_ATOMIC_LOAD (ctx->thread_slots_next));
+
+	keys = ctx->thread_slots;
+#if defined(AXL_OS_UNIX)
+	pthread_setspecific (keys[slot], data);
+#elif defined(AXL_OS_WIN32)
+	TlsSetValue (keys[slot], data);
+#endif
+	return;
+}
+
+/** 
+ * @brief Returns data stored by the calling thread on a slot reserved
+ * by \ref turbulence_ctx_thread_slot_new.
+ *
+ * @param ctx The \ref TurbulenceCtx where the slot was reserved.
+ *
+ * @param slot The slot to read.
+ *
+ * @return The data stored by the calling thread or NULL.
+ */
+axlPointer      turbulence_ctx_thread_slot_get (TurbulenceCtx * ctx,
+						int             slot)
+{
+	TurbulenceThreadKey * keys;
+
+	if (ctx == NULL || slot < 0 || slot >= TBC_ATOMIC_LOAD (ctx->thread_slots_next))
+		return NULL;
+
+	keys = ctx->thread_slots;
+#if defined(AXL_OS_UNIX)
+	return pthread_getspecific (keys[slot]);
+#elif defined(AXL_OS_WIN32)
+	return TlsGetValue (keys[slot]);
+#endif
+}
+
+/** 
+ * @internal Releases slots reserved on the provided context.
+ */
+void __turbulence_ctx_slots_free (TurbulenceCtx * ctx)
+{
+	TurbulenceThreadKey * keys;
+	int                   iterator;
+
+	for (iterator = 0; iterator < ctx->data_slots_next; iterator++) {
+		if (ctx->data_slots[iterator] && ctx->data_slots_destroy[iterator])
+			ctx->data_slots_destroy[iterator] (ctx->data_slots[iterator]);
+		ctx->data_slots[iterator] = NULL;
+	} /* end for */
+	ctx->data_slots_next = 0;
+
+	keys = ctx->thread_slots;
+	for (iterator = 0; iterator < ctx->thread_slots_next; iterator++) {
+#if defined(AXL_OS_UNIX)
+		pthread_key_delete (keys[iterator]);
+#elif defined(AXL_OS_WIN32)
+		TlsFree (keys[iterator]);
+#endif
+	} /* end for */
+	axl_free (ctx->thread_slots);
+	ctx->thread_slots      = NULL;
+	ctx->thread_slots_next = 0;
+	return;
+}
+
 /** 
  * @brief Allows to implement a microseconds blocking wait.
  *
@@ -339,6 +593,19 @@ void            turbulence_ctx_free (TurbulenceCtx * ctx)
 	ctx->data = NULL;
 	vortex_mutex_destroy (&ctx->data_mutex);
 
+	/* terminate slots */
+	__turbulence_ctx_slots_free (ctx);
+
+	/* configuration snapshot mutexes (the snapshot and
+	 * documents are released by turbulence_config_cleanup) */
+	vortex_mutex_destroy (&ctx->config_snapshot_mutex);
+	vortex_mutex_destroy (&ctx->config_schemas_mutex);
+	vortex_mutex_destroy (&ctx->config_docs_mutex);
+
+	/* profile paths mutex (paths are released by
+	 * turbulence_ppath_cleanup) */
+	vortex_mutex_destroy (&ctx->paths_mutex);
+
 	/* release wait queue */
 	vortex_async_queue_unref (ctx->wait_queue);
 
@@ -364,6 +631,9 @@ void            turbulence_ctx_free (TurbulenceCtx * ctx)
 	 * be about to lock it. At this point vortex is already stopped so
 	 * no handler can be running anymore. */
 	vortex_mutex_destroy (&ctx->conn_mgr_mutex);
+	vortex_mutex_destroy (&ctx->conn_arena_mutex);
+	vortex_mutex_destroy (&ctx->metrics_mutex);
+	vortex_mutex_destroy (&ctx->shaper_mutex);
 
 	/* release the node itself */
 	msg ("Finishing TurbulenceCtx (%p)", ctx);
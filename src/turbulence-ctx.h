@@ -49,6 +49,13 @@
  */
 typedef struct _TurbulenceCtx TurbulenceCtx;
 
+/** 
+ * @brief Max number of slots that can be reserved on a \ref
+ * TurbulenceCtx (see \ref turbulence_ctx_slot_new and \ref
+ * turbulence_ctx_thread_slot_new).
+ */
+#define TBC_CTX_MAX_SLOTS 64
+
 TurbulenceCtx * turbulence_ctx_new            (void);
 
 void            turbulence_ctx_reinit         (TurbulenceCtx * ctx, 
@@ -95,6 +102,26 @@ void            turbulence_ctx_set_data_full  (TurbulenceCtx * ctx,
 axlPointer      turbulence_ctx_get_data       (TurbulenceCtx * ctx,
 					       const char    * key);
 
+int             turbulence_ctx_slot_new       (TurbulenceCtx  * ctx,
+					       axlDestroyFunc   data_destroy);
+
+void            turbulence_ctx_slot_set       (TurbulenceCtx * ctx,
+					       int             slot,
+					       axlPointer      data);
+
+axlPointer      turbulence_ctx_slot_get       (TurbulenceCtx * ctx,
+					       int             slot);
+
+int             turbulence_ctx_thread_slot_new (TurbulenceCtx  * ctx,
+						axlDestroyFunc   data_destroy);
+
+void            turbulence_ctx_thread_slot_set (TurbulenceCtx * ctx,
+						int             slot,
+						axlPointer      data);
+
+axlPointer      turbulence_ctx_thread_slot_get (TurbulenceCtx * ctx,
+						int             slot);
+
 void            turbulence_ctx_wait           (TurbulenceCtx * ctx,
 					       long microseconds);
 
@@ -113,6 +113,30 @@ typedef axl_bool (*TurbulenceLoopOnRead) (TurbulenceLoop * loop,
 					  axlPointer       ptr, 
 					  axlPointer       ptr2);
 
+/** 
+ * @brief Handler used by modules to compile their configuration into
+ * the configuration snapshot (see \ref turbulence_config_register_schema).
+ *
+ * The handler is called each time a new snapshot is built (at startup
+ * and on every reload). It must read the configuration once and
+ * return a structure that can be used later without having to
+ * traverse the configuration again.
+ *
+ * @param ctx The Turbulence context where the snapshot is being built.
+ *
+ * @param config The turbulence configuration document the snapshot is
+ * built from.
+ *
+ * @param user_data User defined pointer configured at \ref turbulence_config_register_schema.
+ *
+ * @return A reference to the data compiled or NULL if nothing is
+ * compiled. The data is released with the destroy function
+ * registered once the snapshot is finished.
+ */
+typedef axlPointer (*TurbulenceConfigSchemaBuild) (TurbulenceCtx * ctx,
+						   axlDoc        * config,
+						   axlPointer      user_data);
+
 #endif
 
 /**
@@ -37,6 +37,9 @@
 #include <turbulence.h>
 #include <stdlib.h>
 #include <syslog.h>
+#if defined(AXL_OS_UNIX)
+#include <sys/ioctl.h>
+#endif
 
 /* local include */
 #include <turbulence-ctx-private.h>
@@ -177,6 +180,9 @@ axl_bool __turbulence_log_manager_transfer_content (TurbulenceLoop * loop,
 	int     size_written;
 	char    buffer[4097];
 	int     output_sink = PTR_TO_INT (ptr);
+#if defined(FIONREAD)
+	int     pending;
+#endif
 
 	switch (output_sink) {
 	case LOG_REPORT_GENERAL:
@@ -212,6 +218,14 @@ axl_bool __turbulence_log_manager_transfer_content (TurbulenceLoop * loop,
 		       size, size_written,
 		       vortex_errno_get_last_error ());
 	} /* end if */
+	if (size_written > 0)
+		turbulence_metric_inc (ctx->metrics_builtin[TBC_METRIC_LOG_RELAYED], size_written);
+
+#if defined(FIONREAD)
+	/* account content still pending to be relayed */
+	if (ioctl (descriptor, FIONREAD, &pending) == 0)
+		turbulence_metric_observe (ctx->metrics_builtin[TBC_METRIC_LOG_BACKLOG], pending);
+#endif
 
 	return axl_true;
 }
@@ -236,6 +250,9 @@ void turbulence_log_manager_start (TurbulenceCtx * ctx)
 	/* create manager */
 	ctx->log_manager = turbulence_loop_create (ctx);
 
+	/* bind it to the cpus configured (if any) */
+	turbulence_affinity_configure_loop (ctx, ctx->log_manager, "log-manager");
+
 	msg ("log manager started");
 	return;
 }
@@ -36,6 +36,17 @@
  */
 #include <turbulence.h>
 
+/* TBC_ATOMIC_LOAD/TBC_ATOMIC_STORE */
+#include <turbulence-ctx-private.h>
+
+/**
+ * @internal Maximum period (microseconds) the loop waits for
+ * descriptors before checking registrations pending (it waits less
+ * when a descriptor is delayed, see
+ * turbulence_loop_delay_descriptor).
+ */
+#define TBC_LOOP_WAIT_PERIOD (500000L)
+
 /** 
  * \defgroup turbulence_loop Turbulence Loop: socket descriptor watcher
  */
@@ -50,7 +61,7 @@ struct _TurbulenceLoop {
 	VortexThread         thread;
 	axlList            * list;
 	axlListCursor      * cursor;
-	axlPointer           fileset;
+	fd_set               fileset;
 	VortexAsyncQueue   * queue;
 
 	/* read handler */
@@ -62,6 +73,18 @@ struct _TurbulenceLoop {
 	/* second pointer associated to the descriptor and to be
 	   passed to the handler */
 	axlPointer           ptr2;
+
+	/* cpu list the loop thread must be bound to (applied by the
+	 * loop thread itself when affinity_pending is set). Both are
+	 * accessed with TBC_ATOMIC_LOAD/TBC_ATOMIC_STORE. Values
+	 * replaced are kept in affinity_retired until the loop is
+	 * closed because the loop thread may be reading them */
+	char               * affinity;
+	int                  affinity_pending;
+	axlList            * affinity_retired;
+
+	/* descriptor being notified (only while its handler runs) */
+	struct _TurbulenceLoopDescriptor * current;
 };
 
 /** 
@@ -88,6 +111,10 @@ typedef struct _TurbulenceLoopDescriptor {
 	 */
 	axl_bool             remove;
 	VortexAsyncQueue   * queue_reply;
+
+	/* monotonic stamp (microseconds) until the descriptor is not
+	 * watched (see turbulence_loop_delay_descriptor) */
+	long                 resume_at;
 } TurbulenceLoopDescriptor;
 
 axl_bool __turbulence_loop_read_first (TurbulenceLoop * loop)
@@ -193,14 +220,17 @@ void __turbulence_loop_descriptor_free (axlPointer __loop_descriptor)
 	return;
 }
 
-/* build file set to watch */
-int __turbulence_loop_build_watch_set (TurbulenceLoop * loop)
+/* build file set to watch, reporting on wait the period to wait
+ * (bounded by the first descriptor delayed to be resumed) */
+int __turbulence_loop_build_watch_set (TurbulenceLoop * loop, long * wait)
 {
 	int                        max_fds = 0;
 	TurbulenceLoopDescriptor * loop_descriptor;
+	long                       now     = turbulence_trace_now ();
 
 	/* reset descriptor set */
-	__vortex_io_waiting_default_clear (loop->fileset);
+	FD_ZERO (&loop->fileset);
+	(*wait) = TBC_LOOP_WAIT_PERIOD;
 	
 	/* reset cursor */
 	axl_list_cursor_first (loop->cursor);
@@ -208,15 +238,24 @@ int __turbulence_loop_build_watch_set (TurbulenceLoop * loop)
 		/* get loop descriptor */
 		loop_descriptor = axl_list_cursor_get (loop->cursor);
 
+		/* skip descriptors delayed by their handler, waking up
+		 * when the first of them must be watched again */
+		if (loop_descriptor->resume_at > now) {
+			if (loop_descriptor->resume_at - now < (*wait))
+				(*wait) = loop_descriptor->resume_at - now;
+			axl_list_cursor_next (loop->cursor);
+			continue;
+		} /* end if */
+
 		/* now add to the waiting socket */
-		if (! __vortex_io_waiting_default_add_to (loop_descriptor->descriptor, 
-							  NULL, 
-							  loop->fileset)) {
+		if (loop_descriptor->descriptor < 0 || loop_descriptor->descriptor >= FD_SETSIZE) {
 			
 			/* failed to add descriptor, close it and remove from wait list */
+			error ("unable to watch descriptor %d (out of select range), removing it", loop_descriptor->descriptor);
 			axl_list_cursor_remove (loop->cursor);
 			continue;
 		} /* end if */
+		FD_SET (loop_descriptor->descriptor, &loop->fileset);
 
 		/* compute max_fds */
 		max_fds    = (loop_descriptor->descriptor > max_fds) ? loop_descriptor->descriptor: max_fds;
@@ -242,7 +281,7 @@ void turbulence_loop_handle_descriptors (TurbulenceLoop * loop)
 		loop_descriptor = axl_list_cursor_get (loop->cursor);
 
 		/* check if the loop descriptor is set */
-		if (__vortex_io_waiting_default_is_set (loop_descriptor->descriptor, loop->fileset, NULL)) {
+		if (FD_ISSET (loop_descriptor->descriptor, &loop->fileset)) {
 			/* reset handlers and user pointers */
 			read_handler = NULL;
 			ptr          = NULL;
@@ -264,13 +303,16 @@ void turbulence_loop_handle_descriptors (TurbulenceLoop * loop)
 			}
 
 			/* call to notify descriptor (if no handler close descriptor to avoid infinite loops) */
+			loop->current = loop_descriptor;
 			if (read_handler == NULL || 
 			    (! read_handler (loop, loop->ctx, loop_descriptor->descriptor, ptr, ptr2))) {
 				/* function returned axl_false, remove
 				   descriptor from watch set */
+				loop->current = NULL;
 				axl_list_cursor_remove (loop->cursor);
 				continue;
 			} /* end if */
+			loop->current = NULL;
 
 		} /* end if */
 		
@@ -286,15 +328,15 @@ axlPointer __turbulence_loop_run (TurbulenceLoop * loop)
 {
 	int                       max_fds;
 	int                       result;
+	long                      wait;
+	struct timeval            timeout;
 	TurbulenceCtx           * ctx = loop->ctx;
 
-	/* init here list, its cursor, the fileset to watch fd for
-	 * changes and a queue to receive new registrations */
+	/* init here list and its cursor (the fileset to watch fd for
+	 * changes is part of the loop and new registrations are
+	 * received through the queue) */
 	loop->list    = axl_list_new (axl_list_always_return_1, __turbulence_loop_descriptor_free);
 	loop->cursor  = axl_list_cursor_new (loop->list);
-
-	/* force to use always default select(2) based implementation */
-	loop->fileset  = __vortex_io_waiting_default_create (turbulence_ctx_get_vortex_ctx (loop->ctx), READ_OPERATIONS);
 	
 	/* now loop watching content from the list */
 wait_for_first_item:
@@ -302,8 +344,17 @@ wait_for_first_item:
 		return NULL;
 	
 	while (axl_true) {
+		/* apply affinity configured (only the thread itself
+		 * can be bound) */
+		if (TBC_ATOMIC_LOAD (loop->affinity_pending)) {
+			/* clear before reading so a value set
+			 * meanwhile is applied on next iteration */
+			TBC_ATOMIC_STORE (loop->affinity_pending, axl_false);
+			turbulence_affinity_apply (ctx, TBC_ATOMIC_LOAD (loop->affinity));
+		} /* end if */
+
 		/* build file set to watch */
-		max_fds = __turbulence_loop_build_watch_set (loop);
+		max_fds = __turbulence_loop_build_watch_set (loop, &wait);
 
 		/* check if no descriptor must be watch */
 		if (axl_list_length (loop->list) == 0) {
@@ -311,22 +362,25 @@ wait_for_first_item:
 			goto wait_for_first_item;
 		} /* end if */
 		
-		/* perform IO wait operation */
-		result = __vortex_io_waiting_default_wait_on (loop->fileset, max_fds, READ_OPERATIONS);
+		/* perform IO wait operation (select(2) is used
+		 * directly because the wait is bounded by descriptors
+		 * delayed) */
+		timeout.tv_sec  = wait / 1000000;
+		timeout.tv_usec = wait % 1000000;
+		result = select (max_fds + 1, &loop->fileset, NULL, NULL, &timeout);
 		
 		/* check for timeout and errors */
-		if (result == -1 || result == -2) {
+		if (result < 0) {
 			if (errno == EBADF) {
 				error ("error received from wait on operation, result=%d, errno=%d (discarding broken descriptors)", result, errno);
 				__turbulence_loop_discard_broken (ctx, loop);
+			} else if (errno == EINVAL) {
+				error ("fatal error received from io-wait function, errno=%d, finishing turbulence loop manager..", errno);
+				return NULL;
 			} /* end if */
 
 			goto process_pending;
 		}
-		if (result == -3) {
-			error ("fatal error received from io-wait function, finishing turbulence loop manager..");
-			return NULL;
-		} /* end if */
 
 		/* transfer content found */
 		if (result > 0) {
@@ -505,6 +559,61 @@ void             turbulence_loop_unwatch_descriptor (TurbulenceLoop        * loo
 	return;
 }
 
+/** 
+ * @brief Allows to bind the thread running the provided loop to a
+ * set of cpus (see \ref turbulence_affinity_apply). The affinity is
+ * applied by the loop thread on its next iteration. Calls to this
+ * function on the same loop must not run concurrently.
+ *
+ * @param loop The loop to configure.
+ *
+ * @param cpus The cpu list (like "0-3,8").
+ */
+void             turbulence_loop_set_affinity (TurbulenceLoop * loop, const char * cpus)
+{
+	char * aux;
+
+	v_return_if_fail (loop && cpus);
+
+	/* publish the new value before flagging it pending. The
+	 * previous one is retired (not released) because the loop
+	 * thread may be applying it */
+	aux = loop->affinity;
+	TBC_ATOMIC_STORE (loop->affinity, axl_strdup (cpus));
+	TBC_ATOMIC_STORE (loop->affinity_pending, axl_true);
+	if (aux != NULL) {
+		if (loop->affinity_retired == NULL)
+			loop->affinity_retired = axl_list_new (axl_list_always_return_1, axl_free);
+		axl_list_append (loop->affinity_retired, aux);
+	} /* end if */
+
+	return;
+}
+
+/** 
+ * @brief Stops watching the descriptor being notified for the
+ * provided period. It must be called from the on read handler
+ * (\ref TurbulenceLoopOnRead) notifying the descriptor, for example,
+ * to delay reading from it to limit bandwidth. The loop wait is
+ * bounded by the first delayed descriptor to be resumed, so it is
+ * watched again as soon as its period expires.
+ *
+ * @param loop The loop where the descriptor is watched.
+ *
+ * @param descriptor The descriptor being notified.
+ *
+ * @param microseconds Period the descriptor is not watched.
+ */
+void             turbulence_loop_delay_descriptor (TurbulenceLoop        * loop,
+						   int                     descriptor,
+						   long                    microseconds)
+{
+	if (loop == NULL || loop->current == NULL || loop->current->descriptor != descriptor)
+		return;
+	loop->current->resume_at = turbulence_trace_now () + microseconds;
+	return;
+}
+
 /** 
  * @brief Allows to get how many descriptors are being watched on the
  * provided loop.
@@ -550,8 +659,10 @@ void             turbulence_loop_close (TurbulenceLoop * loop, axl_bool notify)
 	vortex_async_queue_unref (loop->queue);
 	loop->queue = NULL;
 
-	__vortex_io_waiting_default_destroy (loop->fileset);
-	loop->fileset = NULL;
+	axl_free (loop->affinity);
+	loop->affinity = NULL;
+	axl_list_free (loop->affinity_retired);
+	loop->affinity_retired = NULL;
 
 	axl_free (loop);
 
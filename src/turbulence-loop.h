@@ -63,6 +63,12 @@ void             turbulence_loop_unwatch_descriptor (TurbulenceLoop        * loo
 						     int                     descriptor,
 						     axl_bool                wait_until_unwatched);
 
+void             turbulence_loop_delay_descriptor (TurbulenceLoop        * loop,
+						   int                     descriptor,
+						   long                    microseconds);
+
+void             turbulence_loop_set_affinity (TurbulenceLoop * loop, const char * cpus);
+
 int              turbulence_loop_watching (TurbulenceLoop * loop);
 
 void             turbulence_loop_close (TurbulenceLoop * loop, 
@@ -61,20 +61,41 @@ struct _TurbulenceMediatorObject {
 	axlPointer      result;
 };
 
-typedef struct _TurbulenceMediatorPlug {
-	axl_bool                       is_api;
- 	char                         * entry_name;
-	char                         * entry_domain;
-	axlList                      * subscribers;
-	TurbulenceMediatorHandler      api_handler;
-	axlPointer                     user_data;
-} TurbulenceMediatorPlug;
-
 typedef struct _TurbulenceMediatorSubscriber {
 	TurbulenceMediatorHandler handler;
 	axlPointer                user_data;
 } TurbulenceMediatorSubscriber;
 
+/* immutable copy of the subscribers registered on a plug: it is
+ * replaced (never modified) each time a subscriber is added or
+ * removed, and retired until no notification can be using it */
+typedef struct _TurbulenceMediatorSubscribers TurbulenceMediatorSubscribers;
+struct _TurbulenceMediatorSubscribers {
+	int                             count;
+	TurbulenceMediatorSubscriber  * items;
+	/* next copy retired (see __turbulence_mediator_plug_publish) */
+	TurbulenceMediatorSubscribers * next;
+};
+
+struct _TurbulenceMediatorPlug {
+	TurbulenceCtx                 * ctx;
+	axl_bool                        is_api;
+ 	char                          * entry_name;
+	char                          * entry_domain;
+	/* subscribers registered (protected by mediator_hash_mutex)
+	 * and the copy used to notify them: published with a release
+	 * store and read with an acquire load by notifications, which
+	 * are counted on readers so copies replaced (retired, also
+	 * protected by mediator_hash_mutex) are released once no
+	 * notification is running */
+	axlList                       * subscribers;
+	TurbulenceMediatorSubscribers * current;
+	TurbulenceMediatorSubscribers * retired;
+	int                             readers;
+	TurbulenceMediatorHandler       api_handler;
+	axlPointer                      user_data;
+};
+
 /** 
  * @internal API used to initialize mediator module.
  * @param ctx The turbulence context where the mediator will be initialized.
@@ -94,6 +115,7 @@ void turbulence_mediator_init        (TurbulenceCtx * ctx)
 		turbulence_mediator_create_plug (ctx, "turbulence", "module-registered",
 						 /* do not subscribe */
 						 axl_false, NULL, NULL);
+		ctx->mediator_module_registered = turbulence_mediator_plug_get (ctx, "turbulence", "module-registered");
 		
 	} /* end if */
 	return;
@@ -159,10 +181,120 @@ void        turbulence_mediator_object_set_result (TurbulenceMediatorObject * ob
 	return;
 }
 
+/** 
+ * @internal Builds the lookup key for the provided plug into buffer
+ * (or into a new string if it does not fit, in that case the caller
+ * must release it).
+ */
+char * __turbulence_mediator_key (const char * entry_name, const char * entry_domain, char * buffer, int size)
+{
+	int name_length   = strlen (entry_name);
+	int domain_length = strlen (entry_domain);
+
+	if ((name_length + domain_length + 3) > size)
+		return axl_strdup_printf ("%s::%s", entry_name, entry_domain);
+
+	memcpy (buffer, entry_name, name_length);
+	memcpy (buffer + name_length, "::", 2);
+	memcpy (buffer + name_length + 2, entry_domain, domain_length + 1);
+	return buffer;
+}
+
+/** 
+ * @internal Releases the provided subscribers copy and those chained
+ * after it.
+ */
+void __turbulence_mediator_subscribers_free (TurbulenceMediatorSubscribers * subscribers)
+{
+	TurbulenceMediatorSubscribers * next;
+
+	while (subscribers) {
+		next = subscribers->next;
+		axl_free (subscribers->items);
+		axl_free (subscribers);
+		subscribers = next;
+	} /* end while */
+	return;
+}
+
+/** 
+ * @internal Replaces the subscribers copy used to notify the plug
+ * after the subscribers list was changed. Must be called with
+ * mediator_hash_mutex locked.
+ */
+void __turbulence_mediator_plug_publish (TurbulenceMediatorPlug * plug)
+{
+	TurbulenceMediatorSubscribers * subscribers = NULL;
+	TurbulenceMediatorSubscribers * previous;
+	TurbulenceMediatorSubscriber  * subscriber;
+	int                             count;
+	int                             iterator;
+
+	count = axl_list_length (plug->subscribers);
+	if (count > 0) {
+		subscribers = axl_new (TurbulenceMediatorSubscribers, 1);
+		if (subscribers == NULL)
+			return;
+		subscribers->items = axl_new (TurbulenceMediatorSubscriber, count);
+		if (subscribers->items == NULL) {
+			axl_free (subscribers);
+			return;
+		} /* end if */
+
+		iterator = 0;
+		while (iterator < count) {
+			subscriber = axl_list_get_nth (plug->subscribers, iterator);
+			if (subscriber && subscriber->handler) {
+				subscribers->items[subscribers->count].handler   = subscriber->handler;
+				subscribers->items[subscribers->count].user_data = subscriber->user_data;
+				subscribers->count++;
+			} /* end if */
+			iterator++;
+		} /* end while */
+	} /* end if */
+
+	/* swap: notifications starting from now get the new copy */
+	previous = plug->current;
+	TBC_ATOMIC_STORE (plug->current, subscribers);
+
+	/* retire the previous copy, and release all copies retired
+	 * if no notification is running (a notification starting
+	 * after the check below can only see the new copy) */
+	if (previous) {
+		previous->next = plug->retired;
+		plug->retired  = previous;
+	} /* end if */
+	TBC_ATOMIC_FENCE ();
+	if (TBC_ATOMIC_LOAD (plug->readers) == 0) {
+		__turbulence_mediator_subscribers_free (plug->retired);
+		plug->retired = NULL;
+	} /* end if */
+	return;
+}
+
+/** 
+ * @internal Creates an empty plug.
+ */
+TurbulenceMediatorPlug * __turbulence_mediator_plug_new (TurbulenceCtx * ctx, axl_bool is_api, const char * entry_name, const char * entry_domain)
+{
+	TurbulenceMediatorPlug * plug;
+
+	plug               = axl_new (TurbulenceMediatorPlug, 1);
+	if (plug == NULL)
+		return NULL;
+	plug->ctx          = ctx;
+	plug->is_api       = is_api;
+	plug->entry_name   = axl_strdup (entry_name);
+	plug->entry_domain = axl_strdup (entry_domain);
+	return plug;
+}
+
 void turbulence_mediator_plug_free (axlPointer _plug)
 {
 	TurbulenceMediatorPlug * plug = (TurbulenceMediatorPlug * ) _plug;
 
+	__turbulence_mediator_subscribers_free (plug->current);
+	__turbulence_mediator_subscribers_free (plug->retired);
 	axl_free      (plug->entry_domain);
 	axl_free      (plug->entry_name);
 	axl_list_free (plug->subscribers);
@@ -225,10 +357,12 @@ axl_bool turbulence_mediator_create_plug (TurbulenceCtx             * ctx,
 	plug      = axl_hash_get (ctx->mediator_hash, full_name);
 	if (plug == NULL) {
 		/* plug not found, create and register */
-		plug               = axl_new (TurbulenceMediatorPlug, 1);
-		plug->is_api       = axl_false;
-		plug->entry_name   = axl_strdup (entry_name);
-		plug->entry_domain = axl_strdup (entry_domain);
+		plug               = __turbulence_mediator_plug_new (ctx, axl_false, entry_name, entry_domain);
+		if (plug == NULL) {
+			vortex_mutex_unlock (&ctx->mediator_hash_mutex);
+			axl_free (full_name);
+			return axl_false;
+		} /* end if */
 		plug->subscribers  = axl_list_new (axl_list_always_return_1, axl_free);
 		
 		/* register */
@@ -255,6 +389,7 @@ axl_bool turbulence_mediator_create_plug (TurbulenceCtx             * ctx,
 
 	/* now subscribe */
 	axl_list_append (plug->subscribers, subscriber);
+	__turbulence_mediator_plug_publish (plug);
 
 	/* unlock */
 	vortex_mutex_unlock (&ctx->mediator_hash_mutex);
@@ -387,6 +522,7 @@ axl_bool turbulence_mediator_subscribe   (TurbulenceCtx             * ctx,
 
 	/* now subscribe */
 	axl_list_append (plug->subscribers, subscriber);
+	__turbulence_mediator_plug_publish (plug);
 
 	/* unlock */
 	vortex_mutex_unlock (&ctx->mediator_hash_mutex);
@@ -442,10 +578,12 @@ axl_bool     turbulence_mediator_create_api   (TurbulenceCtx             * ctx,
 	} /* end if */
 	
 	/* plug not found, create and register */
-	plug               = axl_new (TurbulenceMediatorPlug, 1);
-	plug->is_api       = axl_true;
-	plug->entry_name   = axl_strdup (entry_name);
-	plug->entry_domain = axl_strdup (entry_domain);
+	plug               = __turbulence_mediator_plug_new (ctx, axl_true, entry_name, entry_domain);
+	if (plug == NULL) {
+		vortex_mutex_unlock (&ctx->mediator_hash_mutex);
+		axl_free (full_name);
+		return axl_false;
+	} /* end if */
 	plug->api_handler  = handler;
 	plug->user_data    = user_data;
 		
@@ -523,6 +661,7 @@ void turbulence_mediator_remove_plug (TurbulenceCtx             * ctx,
 		if (subscriber->handler == handler && subscriber->user_data == user_data) {
 			/* found item */
 			axl_list_remove_at (plug->subscribers, iterator);
+			__turbulence_mediator_plug_publish (plug);
 
 			/* unlock */
 			vortex_mutex_unlock (&ctx->mediator_hash_mutex);
@@ -539,143 +678,175 @@ void turbulence_mediator_remove_plug (TurbulenceCtx             * ctx,
 	return;
 }
 
-axlPointer turbulence_mediator_common_call (TurbulenceCtx             * ctx,
-					    axl_bool                    is_api,
-					    const char                * entry_name,
-					    const char                * entry_domain,
-					    axlPointer                  event_data,
-					    axlPointer                  event_data2,
-					    axlPointer                  event_data3,
-					    axlPointer                  event_data4)
+/** 
+ * @brief Resolves the plug (event or API) registered with the
+ * provided entry name and domain, so events can be pushed (\ref
+ * turbulence_mediator_plug_push) or the API called (\ref
+ * turbulence_mediator_plug_call) without looking it up on each call.
+ *
+ * Plugs are never removed, so the reference returned remains valid
+ * until the mediator is finished (\ref turbulence_mediator_cleanup),
+ * and subscribers added or removed later are considered by the
+ * reference.
+ *
+ * @param ctx The turbulence context where the plug is registered.
+ * @param entry_name The plug entry name.
+ * @param entry_domain The plug entry domain.
+ *
+ * @return A reference to the plug or NULL if it is not registered.
+ */
+TurbulenceMediatorPlug * turbulence_mediator_plug_get  (TurbulenceCtx             * ctx,
+							 const char                * entry_name,
+							 const char                * entry_domain)
 {
-	char                         * full_name;
-	TurbulenceMediatorPlug       * plug;
-	TurbulenceMediatorSubscriber * subscriber;
-	int                            iterator;
-	TurbulenceMediatorHandler      handler;
-	TurbulenceMediatorObject     * object;
-	axlPointer                     result = NULL;
-	
-	
+	char                     buffer[128];
+	char                   * full_name;
+	TurbulenceMediatorPlug * plug;
+
 	v_return_val_if_fail (ctx, NULL);
 	v_return_val_if_fail (entry_name, NULL);
 	v_return_val_if_fail (entry_domain, NULL);
 
-	/* check that the plug is not already created */
-	full_name = axl_strdup_printf ("%s::%s", entry_name, entry_domain);
+	/* build lookup key */
+	full_name = __turbulence_mediator_key (entry_name, entry_domain, buffer, sizeof (buffer));
 	if (full_name == NULL)
 		return NULL;
 
-	/* lock */
+	/* get plug */
 	vortex_mutex_lock (&ctx->mediator_hash_mutex);
+	plug = axl_hash_get (ctx->mediator_hash, full_name);
+	vortex_mutex_unlock (&ctx->mediator_hash_mutex);
 
-	/* get plug */
-	plug      = axl_hash_get (ctx->mediator_hash, full_name);
+	if (full_name != buffer)
+		axl_free (full_name);
+	return plug;
+}
 
-	/* free no longer used entry key */
-	axl_free (full_name);
+/** 
+ * @brief Pushes an event on the provided plug (see \ref
+ * turbulence_mediator_push_event). Subscribers are notified from the
+ * set registered when the call starts: subscribers added or removed
+ * by handlers take effect on the next event.
+ *
+ * @param plug The event plug (see \ref turbulence_mediator_plug_get).
+ *
+ * @param event_data First pointer to be notified.
+ * @param event_data2 Second pointer to be notified.
+ * @param event_data3 Third pointer to be notified.
+ * @param event_data4 Fourth pointer to be notified.
+ */
+void           turbulence_mediator_plug_push    (TurbulenceMediatorPlug    * plug,
+						 axlPointer                  event_data,
+						 axlPointer                  event_data2,
+						 axlPointer                  event_data3,
+						 axlPointer                  event_data4)
+{
+	TurbulenceMediatorObject        object;
+	TurbulenceMediatorSubscribers * subscribers;
+	int                             iterator;
 
-	if (plug == NULL || (plug->is_api != is_api)) {
-		/* plug not found or it is an api */
-		vortex_mutex_unlock (&ctx->mediator_hash_mutex);
-		return NULL;
+	if (plug == NULL || plug->is_api)
+		return;
+
+	/* get current subscribers: the copy read can't be released
+	 * until readers is decremented */
+	TBC_ATOMIC_ADD (plug->readers, 1);
+	subscribers = TBC_ATOMIC_LOAD (plug->current);
+	if (subscribers == NULL) {
+		TBC_ATOMIC_ADD (plug->readers, -1);
+		return;
 	} /* end if */
 
 	/* prepare the mediator object */
-	object               = axl_new (TurbulenceMediatorObject, 1);
-	object->ctx          = ctx;
-	object->entry_name   = entry_name;
-	object->entry_domain = entry_domain;
-	object->event_data   = event_data;
-	object->event_data2  = event_data2;
-	object->event_data3  = event_data3;
-	object->event_data4  = event_data4;
-
-	if (plug->is_api) {
-		/* get references to handler and user data */
-		handler           = plug->api_handler;
-		object->user_data = plug->user_data;
-
-		/* unlock during the operation */
-		vortex_mutex_unlock (&ctx->mediator_hash_mutex);
-		
-		/* do the call operation */
-		handler (object);
-		
-		/* lock during the operation */
-		vortex_mutex_lock (&ctx->mediator_hash_mutex);
+	memset (&object, 0, sizeof (object));
+	object.ctx          = plug->ctx;
+	object.entry_name   = plug->entry_name;
+	object.entry_domain = plug->entry_domain;
+	object.event_data   = event_data;
+	object.event_data2  = event_data2;
+	object.event_data3  = event_data3;
+	object.event_data4  = event_data4;
+
+	/* notify each subscriber */
+	iterator = 0;
+	while (iterator < subscribers->count) {
+		object.user_data = subscribers->items[iterator].user_data;
+		subscribers->items[iterator].handler (&object);
 
-		/* get result */
-		result = object->result;
-		
-	} else {
-		/* Take a stable snapshot of the current subscribers under
-		 * the lock before notifying any of them. Handlers are
-		 * invoked with the lock released, so a re-entrant
-		 * subscribe()/remove_plug() issued from within a handler
-		 * must not be able to invalidate the iteration over the live
-		 * list (which could otherwise skip subscribers or touch
-		 * freed holders). Subscribers added during the notification
-		 * are intentionally not notified in the current round. */
-		int                            count;
-		TurbulenceMediatorSubscriber * snapshot;
-
-		count = axl_list_length (plug->subscribers);
-		if (count > 0) {
-			/* copy (handler, user_data) pairs into an
-			 * independent array owned by this call */
-			snapshot = axl_new (TurbulenceMediatorSubscriber, count);
-			iterator = 0;
-			while (iterator < count) {
-				/* get subscriber value */
-				subscriber = axl_list_get_nth (plug->subscribers, iterator);
-
-				/* check null reference */
-				if (subscriber == NULL) {
-					/* should not happen, stop copying here */
-					count = iterator;
-					break;
-				} /* end if */
-
-				snapshot[iterator].handler   = subscriber->handler;
-				snapshot[iterator].user_data = subscriber->user_data;
-
-				/* next iterator */
-				iterator++;
-			} /* end while */
-
-			/* unlock: notifications run against the snapshot */
-			vortex_mutex_unlock (&ctx->mediator_hash_mutex);
+		/* next iterator */
+		iterator++;
+	} /* end while */
 
-			/* notify each subscriber from the stable snapshot */
-			iterator = 0;
-			while (iterator < count) {
-				/* get references to handler and user data */
-				handler           = snapshot[iterator].handler;
-				object->user_data = snapshot[iterator].user_data;
+	TBC_ATOMIC_ADD (plug->readers, -1);
+	return;
+}
 
-				/* do the call operation */
-				handler (object);
+/** 
+ * @brief Calls the API provided by the plug (see \ref
+ * turbulence_mediator_call_api).
+ *
+ * @param plug The API plug (see \ref turbulence_mediator_plug_get).
+ *
+ * @param event_data First parameter to be passed to the API call.
+ * @param event_data2 Second parameter to be passed to the API call.
+ * @param event_data3 Third parameter to be passed to the API call.
+ * @param event_data4 Fourth parameter to be passed to the API call.
+ *
+ * @return A pointer to the result returned by the API call (NULL if
+ * the plug is not an API).
+ */
+axlPointer     turbulence_mediator_plug_call    (TurbulenceMediatorPlug    * plug,
+						 axlPointer                  event_data,
+						 axlPointer                  event_data2,
+						 axlPointer                  event_data3,
+						 axlPointer                  event_data4)
+{
+	TurbulenceMediatorObject object;
 
-				/* next iterator */
-				iterator++;
-			} /* end while */
+	if (plug == NULL || ! plug->is_api || plug->api_handler == NULL)
+		return NULL;
 
-			/* re-lock to keep the function tail unlock balanced */
-			vortex_mutex_lock (&ctx->mediator_hash_mutex);
+	/* prepare the mediator object (handler and user data never
+	 * change once the API is created) */
+	memset (&object, 0, sizeof (object));
+	object.ctx          = plug->ctx;
+	object.entry_name   = plug->entry_name;
+	object.entry_domain = plug->entry_domain;
+	object.user_data    = plug->user_data;
+	object.event_data   = event_data;
+	object.event_data2  = event_data2;
+	object.event_data3  = event_data3;
+	object.event_data4  = event_data4;
+
+	/* do the call operation */
+	plug->api_handler (&object);
+
+	return object.result;
+}
 
-			/* release the snapshot */
-			axl_free (snapshot);
-		} /* end if */
-	} /* end if */
+axlPointer turbulence_mediator_common_call (TurbulenceCtx             * ctx,
+					    axl_bool                    is_api,
+					    const char                * entry_name,
+					    const char                * entry_domain,
+					    axlPointer                  event_data,
+					    axlPointer                  event_data2,
+					    axlPointer                  event_data3,
+					    axlPointer                  event_data4)
+{
+	TurbulenceMediatorPlug * plug;
 
-	/* unlock */
-	vortex_mutex_unlock (&ctx->mediator_hash_mutex);
+	/* find the plug */
+	plug = turbulence_mediator_plug_get (ctx, entry_name, entry_domain);
+	if (plug == NULL || (plug->is_api != is_api)) {
+		/* plug not found or it is an api */
+		return NULL;
+	} /* end if */
 
-	/* release object */
-	axl_free (object);
+	if (is_api)
+		return turbulence_mediator_plug_call (plug, event_data, event_data2, event_data3, event_data4);
 
-	return result;
+	turbulence_mediator_plug_push (plug, event_data, event_data2, event_data3, event_data4);
+	return NULL;
 }
 
 /** 
@@ -760,6 +931,7 @@ void turbulence_mediator_cleanup      (TurbulenceCtx * ctx)
 	/* finish hash */
 	axl_hash_free (ctx->mediator_hash);
 	ctx->mediator_hash = NULL;
+	ctx->mediator_module_registered = NULL;
 
 	/* clear mutex */
 	vortex_mutex_destroy (&ctx->mediator_hash_mutex);
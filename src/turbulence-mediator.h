@@ -50,6 +50,13 @@
  */
 typedef struct _TurbulenceMediatorObject TurbulenceMediatorObject;
 
+/** 
+ * @brief Reference to a plug (event or API) registered at the
+ * mediator, resolved once with \ref turbulence_mediator_plug_get to
+ * push events or call APIs without looking them up on each call.
+ */
+typedef struct _TurbulenceMediatorPlug TurbulenceMediatorPlug;
+
 /** 
  * @brief Handler definition for the set of functions called to get a
  * notification that at registered event have ocurred. The set of data
@@ -169,6 +176,22 @@ axlPointer     turbulence_mediator_call_api     (TurbulenceCtx             * ctx
 						 axlPointer                  event_data3,
 						 axlPointer                  event_data4);
 
+TurbulenceMediatorPlug * turbulence_mediator_plug_get  (TurbulenceCtx             * ctx,
+							 const char                * entry_name,
+							 const char                * entry_domain);
+
+void           turbulence_mediator_plug_push    (TurbulenceMediatorPlug    * plug,
+						 axlPointer                  event_data,
+						 axlPointer                  event_data2,
+						 axlPointer                  event_data3,
+						 axlPointer                  event_data4);
+
+axlPointer     turbulence_mediator_plug_call    (TurbulenceMediatorPlug    * plug,
+						 axlPointer                  event_data,
+						 axlPointer                  event_data2,
+						 axlPointer                  event_data3,
+						 axlPointer                  event_data4);
+
 void     turbulence_mediator_cleanup      (TurbulenceCtx * ctx);
 
 #endif
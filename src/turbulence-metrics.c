@@ -0,0 +1,1171 @@
+/*  Turbulence BEEP application server
+ *  Copyright (C) 2025 Advanced Software Production Line, S.L.
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; version 2.1 of the
+ *  License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free
+ *  Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307 USA
+ *  
+ *  You may find a copy of the license under this software is released
+ *  at COPYING file. This is LGPL software: you are welcome to develop
+ *  proprietary applications using this library without any royalty or
+ *  fee but returning back any change, improvement or addition in the
+ *  form of source code, project image, documentation patches, etc.
+ *
+ *  For commercial support on build BEEP enabled solutions, supporting
+ *  turbulence based solutions, etc, contact us:
+ *          
+ *      Postal address:
+ *         Advanced Software Production Line, S.L.
+ *         C/ Antonio Suarez Nº10, Edificio Alius A, Despacho 102
+ *         Alcala de Henares, 28802 (MADRID)
+ *         Spain
+ *
+ *      Email address:
+ *         info@aspl.es - http://www.aspl.es/turbulence
+ */
+#include <turbulence.h>
+
+/* local include */
+#include <turbulence-ctx-private.h>
+
+#if defined(AXL_OS_UNIX)
+#include <netdb.h>
+#include <fcntl.h>
+#endif
+
+/** 
+ * \defgroup turbulence_metrics Turbulence Metrics: runtime counters, gauges and histograms
+ */
+
+/** 
+ * \addtogroup turbulence_metrics
+ * @{
+ */
+
+/**
+ * @internal Number of buckets used by histograms. Bucket N accounts
+ * values lower or equal to 2^N (so the last one is 2^23, about 8
+ * seconds when values are microseconds). Bigger values are only
+ * accounted by the +Inf bucket.
+ */
+#define TBC_METRICS_BUCKETS 24
+
+/**
+ * @internal Microseconds the master waits for childs to report their
+ * metrics.
+ */
+#define TBC_METRICS_CHILD_TIMEOUT 1000000
+
+/**
+ * @internal Metrics clients (accepted but whose request was not
+ * completely read yet) and time (microseconds) they have to send it.
+ */
+#define TBC_METRICS_MAX_CLIENTS   16
+#define TBC_METRICS_CLIENT_TIMEOUT 2000000
+
+/**
+ * @internal Profile used by the master to collect metrics from
+ * childs over the child<->master BEEP link.
+ */
+#define TBC_METRICS_URI "urn:aspl.es:beep:profiles:turbulence-metrics"
+
+struct _TurbulenceMetric {
+	TurbulenceMetricType   type;
+	char                 * name;
+	char                 * labels;
+	char                 * help;
+
+	/* counter and gauge value, or number of values observed
+	 * (histograms), only updated with TBC_ATOMIC_ADD or
+	 * TBC_ATOMIC_STORE so counters and gauges need no lock */
+	long                   value;
+
+	/* histograms: protects value, buckets and sum so they are
+	 * rendered consistently */
+	VortexMutex            mutex;
+	/* histograms: values observed by bucket (not cumulative) and
+	 * sum of all values observed */
+	long                   buckets[TBC_METRICS_BUCKETS];
+	long                   sum;
+};
+
+/**
+ * @internal Growable string used to render metrics.
+ */
+typedef struct _TurbulenceMetricsBuffer {
+	char * content;
+	int    length;
+	int    size;
+} TurbulenceMetricsBuffer;
+
+/**
+ * @internal A family of series (all samples sharing the same # TYPE
+ * line) collected while merging metrics from several processes.
+ */
+typedef struct _TurbulenceMetricsFamily {
+	char    * name;
+	char    * help;
+	char    * type;
+	/* series keys (owned by TurbulenceMetricsMerge values hash) */
+	axlList * series;
+} TurbulenceMetricsFamily;
+
+typedef struct _TurbulenceMetricsMerge {
+	axlList * families;
+	axlHash * families_hash;
+	/* series key -> long * */
+	axlHash * values;
+} TurbulenceMetricsMerge;
+
+/**
+ * @internal Metrics client: request read by the metrics loop and
+ * then served from the vortex thread pool.
+ */
+typedef struct _TurbulenceMetricsClient {
+	TurbulenceCtx * ctx;
+	/* descriptor watched by the loop and descriptor used by the
+	 * thread pool task */
+	VORTEX_SOCKET   watched;
+	VORTEX_SOCKET   socket;
+	char            request[1024];
+	int             size;
+	/* accept stamp (turbulence_trace_now) */
+	long            stamp;
+} TurbulenceMetricsClient;
+
+/**
+ * @internal Request sent to a child to collect its metrics.
+ */
+typedef struct _TurbulenceMetricsCall {
+	int                id;
+	VortexAsyncQueue * queue;
+	char             * reply;
+} TurbulenceMetricsCall;
+
+void __turbulence_metrics_append (TurbulenceMetricsBuffer * buffer, const char * format, ...)
+{
+	va_list   args;
+	char    * string;
+	char    * temp;
+	int       length;
+	int       size;
+
+	va_start (args, format);
+	string = axl_strdup_printfv (format, args);
+	va_end (args);
+	if (string == NULL)
+		return;
+	length = strlen (string);
+
+	/* grow buffer if required */
+	if (buffer->length + length + 1 > buffer->size) {
+		size = buffer->size > 0 ? buffer->size * 2 : 4096;
+		while (size < buffer->length + length + 1)
+			size = size * 2;
+		temp = axl_realloc (buffer->content, size);
+		if (temp == NULL) {
+			axl_free (string);
+			return;
+		} /* end if */
+		buffer->content = temp;
+		buffer->size    = size;
+	} /* end if */
+
+	memcpy (buffer->content + buffer->length, string, length + 1);
+	buffer->length += length;
+	axl_free (string);
+	return;
+}
+
+void __turbulence_metric_free (TurbulenceMetric * metric)
+{
+	axl_free (metric->name);
+	axl_free (metric->labels);
+	axl_free (metric->help);
+	vortex_mutex_destroy (&metric->mutex);
+	axl_free (metric);
+	return;
+}
+
+/** 
+ * @brief Gets the metric registered with the provided name and
+ * labels, creating it if it doesn't exist. Metrics are never removed
+ * from the registry, so the reference returned can be cached and used
+ * for the whole life of the context (which is the recommended way to
+ * use it on hot paths).
+ *
+ * Metrics registered are served (in text exposition format) by the
+ * master process at the port configured by <b>&lt;metrics></b>,
+ * aggregating values reported by all childs (see \ref
+ * turbulence_metrics_render).
+ *
+ * @param ctx The turbulence context.
+ * @param type The kind of metric.
+ *
+ * @param name The metric name (for example
+ * "turbulence_connections_accepted_total").
+ *
+ * @param labels Optional labels (already formated, for example
+ * <i>ppath="default"</i>, see \ref turbulence_metrics_label) or NULL.
+ *
+ * @param help Text describing the metric.
+ *
+ * @return A reference to the metric or NULL if it fails (or if the
+ * metric was registered with a different type).
+ */
+TurbulenceMetric * turbulence_metrics_get     (TurbulenceCtx        * ctx,
+					       TurbulenceMetricType   type,
+					       const char           * name,
+					       const char           * labels,
+					       const char           * help)
+{
+	TurbulenceMetric  * metric;
+	TurbulenceMetric ** temp;
+	char              * key;
+
+	v_return_val_if_fail (ctx && name, NULL);
+
+	if (labels && strlen (labels) == 0)
+		labels = NULL;
+	key = axl_strdup_printf ("%s{%s}", name, labels ? labels : "");
+	if (key == NULL)
+		return NULL;
+
+	vortex_mutex_lock (&ctx->metrics_mutex);
+
+	/* init registry */
+	if (ctx->metrics_hash == NULL) {
+		ctx->metrics_hash = axl_hash_new (axl_hash_string, axl_hash_equal_string);
+		if (ctx->metrics_hash == NULL) {
+			vortex_mutex_unlock (&ctx->metrics_mutex);
+			axl_free (key);
+			return NULL;
+		} /* end if */
+	} /* end if */
+
+	metric = axl_hash_get (ctx->metrics_hash, key);
+	if (metric != NULL) {
+		vortex_mutex_unlock (&ctx->metrics_mutex);
+		axl_free (key);
+		if (metric->type != type) {
+			error ("metric %s already registered with a different type", name);
+			return NULL;
+		} /* end if */
+		return metric;
+	} /* end if */
+
+	/* make room */
+	if (ctx->metrics_count == ctx->metrics_size) {
+		temp = axl_realloc (ctx->metrics, sizeof (TurbulenceMetric *) * (ctx->metrics_size + 32));
+		if (temp == NULL) {
+			vortex_mutex_unlock (&ctx->metrics_mutex);
+			axl_free (key);
+			return NULL;
+		} /* end if */
+		ctx->metrics       = temp;
+		ctx->metrics_size += 32;
+	} /* end if */
+
+	/* create the metric */
+	metric         = axl_new (TurbulenceMetric, 1);
+	if (metric == NULL) {
+		vortex_mutex_unlock (&ctx->metrics_mutex);
+		axl_free (key);
+		return NULL;
+	} /* end if */
+	metric->type   = type;
+	metric->name   = axl_strdup (name);
+	metric->labels = labels ? axl_strdup (labels) : NULL;
+	metric->help   = axl_strdup (help ? help : name);
+	vortex_mutex_create (&metric->mutex);
+
+	/* register */
+	ctx->metrics[ctx->metrics_count] = metric;
+	ctx->metrics_count++;
+	axl_hash_insert_full (ctx->metrics_hash, key, axl_free, metric, NULL);
+
+	vortex_mutex_unlock (&ctx->metrics_mutex);
+
+	return metric;
+}
+
+/** 
+ * @brief Adds the provided value to a counter or a gauge (use a
+ * negative value to decrease a gauge). The update is a single atomic
+ * addition, no lock is taken.
+ *
+ * @param metric The metric to update (NULL references are ignored).
+ * @param value The value to add.
+ */
+void               turbulence_metric_inc      (TurbulenceMetric * metric,
+					       long               value)
+{
+	if (metric == NULL)
+		return;
+	TBC_ATOMIC_ADD (metric->value, value);
+	return;
+}
+
+/** 
+ * @brief Sets the current value of a gauge (atomic store, no lock is
+ * taken).
+ *
+ * @param metric The metric to update (NULL references are ignored).
+ * @param value The value to set.
+ */
+void               turbulence_metric_set      (TurbulenceMetric * metric,
+					       long               value)
+{
+	if (metric == NULL)
+		return;
+	TBC_ATOMIC_STORE (metric->value, value);
+	return;
+}
+
+/** 
+ * @brief Records a value observed on a histogram.
+ *
+ * @param metric The histogram to update (NULL references are ignored).
+ * @param value The value observed (for latencies, in microseconds).
+ */
+void               turbulence_metric_observe  (TurbulenceMetric * metric,
+					       long               value)
+{
+	int bucket = 0;
+
+	if (metric == NULL)
+		return;
+
+	/* find the bucket */
+	while (bucket < TBC_METRICS_BUCKETS && value > (1L << bucket))
+		bucket++;
+
+	vortex_mutex_lock (&metric->mutex);
+	if (bucket < TBC_METRICS_BUCKETS)
+		metric->buckets[bucket]++;
+	metric->sum   += value;
+	TBC_ATOMIC_ADD (metric->value, 1);
+	vortex_mutex_unlock (&metric->mutex);
+	return;
+}
+
+/** 
+ * @brief Returns the current value of the metric (number of values
+ * observed for histograms).
+ *
+ * @param metric The metric to check.
+ *
+ * @return The value or 0 if NULL is received.
+ */
+long               turbulence_metric_value    (TurbulenceMetric * metric)
+{
+	if (metric == NULL)
+		return 0;
+	return TBC_ATOMIC_LOAD (metric->value);
+}
+
+/** 
+ * @brief Convenience function that returns the microseconds elapsed
+ * since the provided stamp (taken with gettimeofday), to be used with
+ * \ref turbulence_metric_observe.
+ *
+ * @param start The stamp taken when the operation started.
+ *
+ * @return Microseconds elapsed.
+ */
+long               turbulence_metrics_since   (struct timeval   * start)
+{
+	struct timeval now;
+
+	gettimeofday (&now, NULL);
+	return (now.tv_sec - start->tv_sec) * 1000000 + (now.tv_usec - start->tv_usec);
+}
+
+/** 
+ * @brief Builds a label (name="value") escaping the value as
+ * required by the text exposition format.
+ *
+ * @param name The label name.
+ * @param value The label value.
+ *
+ * @return A newly allocated string or NULL if it fails.
+ */
+char             * turbulence_metrics_label   (const char * name, 
+					       const char * value)
+{
+	char * result;
+	char * escaped;
+	int    iterator;
+	int    length = 0;
+
+	if (name == NULL)
+		return NULL;
+	if (value == NULL)
+		value = "";
+
+	escaped = axl_new (char, (strlen (value) * 2) + 1);
+	if (escaped == NULL)
+		return NULL;
+	for (iterator = 0; value[iterator]; iterator++) {
+		if (value[iterator] == '\n') {
+			escaped[length++] = '\\';
+			escaped[length++] = 'n';
+			continue;
+		} /* end if */
+		if (value[iterator] == '"' || value[iterator] == '\\')
+			escaped[length++] = '\\';
+		escaped[length++] = value[iterator];
+	} /* end for */
+
+	result = axl_strdup_printf ("%s=\"%s\"", name, escaped);
+	axl_free (escaped);
+	return result;
+}
+
+const char * __turbulence_metrics_type_name (TurbulenceMetricType type)
+{
+	switch (type) {
+	case TBC_METRIC_COUNTER:
+		return "counter";
+	case TBC_METRIC_GAUGE:
+		return "gauge";
+	case TBC_METRIC_HISTOGRAM:
+		return "histogram";
+	} /* end switch */
+	return "untyped";
+}
+
+void __turbulence_metrics_render_metric (TurbulenceMetricsBuffer * buffer, TurbulenceMetric * metric)
+{
+	const char * labels    = metric->labels ? metric->labels : "";
+	const char * separator = metric->labels ? "," : "";
+	long         cumulative = 0;
+	long         buckets[TBC_METRICS_BUCKETS];
+	long         value;
+	long         sum;
+	int          iterator;
+
+	if (metric->type != TBC_METRIC_HISTOGRAM) {
+		value = TBC_ATOMIC_LOAD (metric->value);
+		if (metric->labels)
+			__turbulence_metrics_append (buffer, "%s{%s} %ld\n", metric->name, labels, value);
+		else
+			__turbulence_metrics_append (buffer, "%s %ld\n", metric->name, value);
+		return;
+	} /* end if */
+
+	/* get a consistent copy */
+	vortex_mutex_lock (&metric->mutex);
+	value = metric->value;
+	sum   = metric->sum;
+	memcpy (buckets, metric->buckets, sizeof (buckets));
+	vortex_mutex_unlock (&metric->mutex);
+
+	for (iterator = 0; iterator < TBC_METRICS_BUCKETS; iterator++) {
+		cumulative += buckets[iterator];
+		__turbulence_metrics_append (buffer, "%s_bucket{%s%sle=\"%ld\"} %ld\n", 
+					     metric->name, labels, separator, (1L << iterator), cumulative);
+	} /* end for */
+	__turbulence_metrics_append (buffer, "%s_bucket{%s%sle=\"+Inf\"} %ld\n", metric->name, labels, separator, value);
+	if (metric->labels) {
+		__turbulence_metrics_append (buffer, "%s_sum{%s} %ld\n", metric->name, labels, sum);
+		__turbulence_metrics_append (buffer, "%s_count{%s} %ld\n", metric->name, labels, value);
+	} else {
+		__turbulence_metrics_append (buffer, "%s_sum %ld\n", metric->name, sum);
+		__turbulence_metrics_append (buffer, "%s_count %ld\n", metric->name, value);
+	} /* end if */
+	return;
+}
+
+/** 
+ * @internal Renders metrics registered at this process, grouping
+ * series by metric name.
+ */
+void __turbulence_metrics_render_local (TurbulenceCtx * ctx, TurbulenceMetricsBuffer * buffer)
+{
+	TurbulenceMetric * metric;
+	int                iterator;
+	int                iterator2;
+	axl_bool           rendered;
+
+	vortex_mutex_lock (&ctx->metrics_mutex);
+	for (iterator = 0; iterator < ctx->metrics_count; iterator++) {
+		metric = ctx->metrics[iterator];
+
+		/* skip families already rendered */
+		rendered = axl_false;
+		for (iterator2 = 0; iterator2 < iterator; iterator2++) {
+			if (axl_cmp (ctx->metrics[iterator2]->name, metric->name)) {
+				rendered = axl_true;
+				break;
+			} /* end if */
+		} /* end for */
+		if (rendered)
+			continue;
+
+		__turbulence_metrics_append (buffer, "# HELP %s %s\n", metric->name, metric->help);
+		__turbulence_metrics_append (buffer, "# TYPE %s %s\n", metric->name, __turbulence_metrics_type_name (metric->type));
+		for (iterator2 = iterator; iterator2 < ctx->metrics_count; iterator2++) {
+			if (axl_cmp (ctx->metrics[iterator2]->name, metric->name))
+				__turbulence_metrics_render_metric (buffer, ctx->metrics[iterator2]);
+		} /* end for */
+	} /* end for */
+	vortex_mutex_unlock (&ctx->metrics_mutex);
+
+	return;
+}
+
+void __turbulence_metrics_family_free (axlPointer _family)
+{
+	TurbulenceMetricsFamily * family = _family;
+
+	axl_free (family->name);
+	axl_free (family->help);
+	axl_free (family->type);
+	axl_list_free (family->series);
+	axl_free (family);
+	return;
+}
+
+TurbulenceMetricsFamily * __turbulence_metrics_merge_family (TurbulenceMetricsMerge * merge, const char * name)
+{
+	TurbulenceMetricsFamily * family;
+
+	family = axl_hash_get (merge->families_hash, (axlPointer) name);
+	if (family)
+		return family;
+
+	family         = axl_new (TurbulenceMetricsFamily, 1);
+	family->name   = axl_strdup (name);
+	family->series = axl_list_new (axl_list_always_return_1, NULL);
+	axl_list_append (merge->families, family);
+	axl_hash_insert (merge->families_hash, family->name, family);
+	return family;
+}
+
+/** 
+ * @internal Adds all series found in the provided text (as produced
+ * by __turbulence_metrics_render_local) into the merge, summing
+ * values of series found several times.
+ */
+void __turbulence_metrics_merge (TurbulenceMetricsMerge * merge, char * text)
+{
+	TurbulenceMetricsFamily * family = NULL;
+	char                    * line;
+	char                    * next;
+	char                    * name;
+	char                    * end;
+	char                    * separator;
+	long                    * value;
+
+	for (line = text; line && *line; line = next) {
+		/* get next line */
+		next = strchr (line, '\n');
+		if (next) {
+			*next = 0;
+			next++;
+		} /* end if */
+
+		/* comments: # HELP name text and # TYPE name type */
+		if (axl_memcmp (line, "# HELP ", 7) || axl_memcmp (line, "# TYPE ", 7)) {
+			name = line + 7;
+			end  = strchr (name, ' ');
+			if (end == NULL)
+				continue;
+			*end   = 0;
+			family = __turbulence_metrics_merge_family (merge, name);
+			*end   = ' ';
+			if (line[2] == 'H' && family->help == NULL)
+				family->help = axl_strdup (line);
+			else if (line[2] == 'T' && family->type == NULL)
+				family->type = axl_strdup (line);
+			continue;
+		} /* end if */
+		if (line[0] == '#' || line[0] == 0)
+			continue;
+
+		/* sample: series value */
+		separator = strrchr (line, ' ');
+		if (separator == NULL)
+			continue;
+		*separator = 0;
+
+		value = axl_hash_get (merge->values, line);
+		if (value) {
+			(*value) += strtol (separator + 1, NULL, 10);
+			continue;
+		} /* end if */
+
+		if (family == NULL)
+			family = __turbulence_metrics_merge_family (merge, line);
+
+		value    = axl_new (long, 1);
+		(*value) = strtol (separator + 1, NULL, 10);
+		name     = axl_strdup (line);
+		axl_hash_insert_full (merge->values, name, axl_free, value, axl_free);
+		axl_list_append (family->series, name);
+	} /* end for */
+
+	return;
+}
+
+/** 
+ * @internal Frame received by the master with a child reply.
+ */
+void __turbulence_metrics_child_reply (VortexChannel    * channel, 
+				       VortexConnection * conn, 
+				       VortexFrame      * frame, 
+				       axlPointer         user_data)
+{
+	TurbulenceCtx         * ctx     = VORTEX_TBC_CTX (CONN_CTX (conn));
+	const char            * payload = vortex_frame_get_payload (frame);
+	TurbulenceMetricsCall * call;
+	int                     id;
+
+	/* reply format: # turbulence-metrics <id>\n<metrics> */
+	if (ctx == NULL || payload == NULL || ! axl_memcmp (payload, "# turbulence-metrics ", 21))
+		return;
+	id = atoi (payload + 21);
+
+	vortex_mutex_lock (&ctx->metrics_mutex);
+	call = ctx->metrics_calls ? axl_hash_get (ctx->metrics_calls, INT_TO_PTR (id)) : NULL;
+	if (call && call->reply == NULL) {
+		call->reply = axl_strdup (payload);
+		vortex_async_queue_push (call->queue, call);
+	} /* end if */
+	vortex_mutex_unlock (&ctx->metrics_mutex);
+
+	return;
+}
+
+/** 
+ * @internal Sends the metrics request to the child, registering the
+ * call to receive the reply.
+ */
+axl_bool __turbulence_metrics_child_request (TurbulenceCtx * ctx, TurbulenceChild * child, TurbulenceMetricsCall * call)
+{
+	VortexConnection * conn;
+	VortexChannel    * channel;
+	char             * request;
+	axl_bool           result;
+
+	conn = child->conn_mgr;
+	if (! vortex_connection_ref (conn, "metrics request"))
+		return axl_false;
+
+	/* get the channel used to talk with the child (created on
+	 * first use and kept with the connection) */
+	channel = vortex_connection_get_data (conn, "tbc:metrics:channel");
+	if (channel == NULL) {
+		channel = vortex_channel_new (conn, 0, TBC_METRICS_URI, 
+					      /* no close handler */
+					      NULL, NULL,
+					      /* frame received */
+					      __turbulence_metrics_child_reply, NULL,
+					      /* no async notification */
+					      NULL, NULL);
+		if (channel == NULL) {
+			wrn ("unable to open metrics channel with child %d", child->pid);
+			vortex_connection_unref (conn, "metrics request");
+			return axl_false;
+		} /* end if */
+		vortex_connection_set_data (conn, "tbc:metrics:channel", channel);
+	} /* end if */
+
+	/* register call */
+	vortex_mutex_lock (&ctx->metrics_mutex);
+	if (ctx->metrics_calls == NULL)
+		ctx->metrics_calls = axl_hash_new (axl_hash_int, axl_hash_equal_int);
+	call->id = ++ctx->metrics_calls_next;
+	axl_hash_insert (ctx->metrics_calls, INT_TO_PTR (call->id), call);
+	vortex_mutex_unlock (&ctx->metrics_mutex);
+
+	/* send request */
+	request = axl_strdup_printf ("metrics %d", call->id);
+	result  = request && vortex_channel_send_msg (channel, request, strlen (request), NULL);
+	axl_free (request);
+
+	vortex_connection_unref (conn, "metrics request");
+	return result;
+}
+
+/** 
+ * @internal Collects metrics from all childs into the merge. Childs
+ * not replying in TBC_METRICS_CHILD_TIMEOUT are skipped.
+ */
+void __turbulence_metrics_collect_childs (TurbulenceCtx * ctx, TurbulenceMetricsMerge * merge)
+{
+	axlList               * childs;
+	TurbulenceMetricsCall * calls;
+	VortexAsyncQueue      * queue;
+	struct timeval          start;
+	long                    remaining;
+	int                     length;
+	int                     iterator;
+	int                     pending = 0;
+	char                  * content;
+
+	childs = turbulence_process_child_list (ctx);
+	length = childs ? axl_list_length (childs) : 0;
+	if (length == 0) {
+		axl_list_free (childs);
+		return;
+	} /* end if */
+
+	calls = axl_new (TurbulenceMetricsCall, length);
+	queue = vortex_async_queue_new ();
+	if (calls == NULL || queue == NULL) {
+		axl_free (calls);
+		if (queue)
+			vortex_async_queue_unref (queue);
+		axl_list_free (childs);
+		return;
+	} /* end if */
+
+	/* send requests to all childs without waiting */
+	gettimeofday (&start, NULL);
+	for (iterator = 0; iterator < length; iterator++) {
+		calls[iterator].queue = queue;
+		if (__turbulence_metrics_child_request (ctx, axl_list_get_nth (childs, iterator), &(calls[iterator])))
+			pending++;
+	} /* end for */
+
+	/* wait for replies */
+	while (pending > 0) {
+		remaining = TBC_METRICS_CHILD_TIMEOUT - turbulence_metrics_since (&start);
+		if (remaining <= 0 || vortex_async_queue_timedpop (queue, remaining) == NULL)
+			break;
+		pending--;
+	} /* end while */
+	if (pending > 0)
+		wrn ("%d childs did not report metrics in time", pending);
+
+	/* unregister calls: late replies are dropped from here */
+	vortex_mutex_lock (&ctx->metrics_mutex);
+	for (iterator = 0; iterator < length; iterator++) {
+		if (calls[iterator].id > 0)
+			axl_hash_remove (ctx->metrics_calls, INT_TO_PTR (calls[iterator].id));
+	} /* end for */
+	vortex_mutex_unlock (&ctx->metrics_mutex);
+
+	/* merge replies */
+	for (iterator = 0; iterator < length; iterator++) {
+		if (calls[iterator].reply == NULL)
+			continue;
+		content = strchr (calls[iterator].reply, '\n');
+		if (content)
+			__turbulence_metrics_merge (merge, content + 1);
+		axl_free (calls[iterator].reply);
+	} /* end for */
+
+	axl_free (calls);
+	vortex_async_queue_unref (queue);
+	axl_list_free (childs);
+	return;
+}
+
+/** 
+ * @brief Renders all metrics in text exposition format.
+ *
+ * @param ctx The turbulence context.
+ *
+ * @param include_childs If axl_true and ctx is the master process,
+ * metrics reported by all childs are added to the values of the
+ * master (series with the same name and labels are summed).
+ *
+ * @return A newly allocated string that must be released with
+ * axl_free or NULL if it fails.
+ */
+char             * turbulence_metrics_render  (TurbulenceCtx * ctx,
+					       axl_bool        include_childs)
+{
+	TurbulenceMetricsBuffer   buffer;
+	TurbulenceMetricsBuffer   result;
+	TurbulenceMetricsMerge    merge;
+	TurbulenceMetricsFamily * family;
+	int                       iterator;
+	int                       iterator2;
+	char                    * series;
+
+	v_return_val_if_fail (ctx, NULL);
+
+	memset (&buffer, 0, sizeof (buffer));
+	__turbulence_metrics_render_local (ctx, &buffer);
+
+	if (! include_childs || turbulence_ctx_is_child (ctx))
+		return buffer.content ? buffer.content : axl_strdup ("");
+
+	/* merge local metrics and metrics reported by childs */
+	merge.families      = axl_list_new (axl_list_always_return_1, __turbulence_metrics_family_free);
+	merge.families_hash = axl_hash_new (axl_hash_string, axl_hash_equal_string);
+	merge.values        = axl_hash_new (axl_hash_string, axl_hash_equal_string);
+	if (merge.families == NULL || merge.families_hash == NULL || merge.values == NULL) {
+		axl_list_free (merge.families);
+		axl_hash_free (merge.families_hash);
+		axl_hash_free (merge.values);
+		return buffer.content;
+	} /* end if */
+
+	if (buffer.content)
+		__turbulence_metrics_merge (&merge, buffer.content);
+	axl_free (buffer.content);
+	__turbulence_metrics_collect_childs (ctx, &merge);
+
+	/* render merge */
+	memset (&result, 0, sizeof (result));
+	for (iterator = 0; iterator < axl_list_length (merge.families); iterator++) {
+		family = axl_list_get_nth (merge.families, iterator);
+		if (family->help)
+			__turbulence_metrics_append (&result, "%s\n", family->help);
+		if (family->type)
+			__turbulence_metrics_append (&result, "%s\n", family->type);
+		for (iterator2 = 0; iterator2 < axl_list_length (family->series); iterator2++) {
+			series = axl_list_get_nth (family->series, iterator2);
+			__turbulence_metrics_append (&result, "%s %ld\n", series, *((long *) axl_hash_get (merge.values, series)));
+		} /* end for */
+	} /* end for */
+
+	axl_list_free (merge.families);
+	axl_hash_free (merge.families_hash);
+	axl_hash_free (merge.values);
+
+	return result.content ? result.content : axl_strdup ("");
+}
+
+/** 
+ * @internal Child side: only the master, through the child<->master
+ * link, is allowed to open the metrics channel.
+ */
+axl_bool __turbulence_metrics_child_start (int                channel_num, 
+					   VortexConnection * conn, 
+					   axlPointer         user_data)
+{
+	TurbulenceCtx * ctx = user_data;
+
+	return ctx->child && ctx->child->conn_mgr == conn;
+}
+
+/** 
+ * @internal Child side: replies to metrics requests received from the
+ * master.
+ */
+void __turbulence_metrics_child_request_received (VortexChannel    * channel, 
+						  VortexConnection * conn, 
+						  VortexFrame      * frame, 
+						  axlPointer         user_data)
+{
+	TurbulenceCtx * ctx     = user_data;
+	const char    * payload = vortex_frame_get_payload (frame);
+	char          * metrics;
+	char          * reply;
+
+	if (vortex_frame_get_type (frame) != VORTEX_FRAME_TYPE_MSG)
+		return;
+	if (payload == NULL || ! axl_memcmp (payload, "metrics ", 8)) {
+		vortex_channel_send_err (channel, "unsupported request", 19, vortex_frame_get_msgno (frame));
+		return;
+	} /* end if */
+
+	metrics = turbulence_metrics_render (ctx, axl_false);
+	reply   = axl_strdup_printf ("# turbulence-metrics %d\n%s", atoi (payload + 8), metrics ? metrics : "");
+	axl_free (metrics);
+	if (reply == NULL) {
+		vortex_channel_send_err (channel, "memory allocation failure", 25, vortex_frame_get_msgno (frame));
+		return;
+	} /* end if */
+
+	vortex_channel_send_rpy (channel, reply, strlen (reply), vortex_frame_get_msgno (frame));
+	axl_free (reply);
+	return;
+}
+
+#if defined(AXL_OS_UNIX)
+/** 
+ * @internal Thread pool task: renders metrics (waiting for childs to
+ * report them) and sends the response to the client.
+ */
+axlPointer __turbulence_metrics_serve (axlPointer _client)
+{
+	TurbulenceMetricsClient * client = _client;
+	TurbulenceCtx           * ctx    = client->ctx;
+	struct timeval            timeout;
+	char                    * content;
+	char                    * response;
+	axl_bool                  found;
+
+	/* only GET / and GET /metrics are served */
+	found = axl_memcmp (client->request, "GET /metrics ", 13) || axl_memcmp (client->request, "GET /metrics?", 13) || 
+		axl_memcmp (client->request, "GET / ", 6);
+	if (found) {
+		content  = turbulence_metrics_render (ctx, axl_true);
+		response = axl_strdup_printf ("HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\nConnection: close\r\n\r\n%s",
+					      content ? (int) strlen (content) : 0, content ? content : "");
+		axl_free (content);
+	} else {
+		response = axl_strdup ("HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+	} /* end if */
+
+	/* blocking send, but do not wait for ever */
+	fcntl (client->socket, F_SETFL, fcntl (client->socket, F_GETFL, 0) & ~O_NONBLOCK);
+	timeout.tv_sec  = 2;
+	timeout.tv_usec = 0;
+	setsockopt (client->socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof (timeout));
+	if (response && send (client->socket, response, strlen (response), 0) < 0)
+		wrn ("failed to send metrics response, error was: %s", vortex_errno_get_last_error ());
+	axl_free (response);
+
+	vortex_close_socket (client->socket);
+	axl_free (client);
+	return NULL;
+}
+
+/** 
+ * @internal Reads the request of a metrics client (socket is non
+ * blocking). Once the request line is received the client is handed
+ * to the thread pool, so the loop never waits for childs nor for
+ * slow clients. Returning axl_false closes the socket watched.
+ */
+axl_bool __turbulence_metrics_on_request (TurbulenceLoop * loop, 
+					  TurbulenceCtx  * ctx,
+					  int              descriptor, 
+					  axlPointer       ptr, 
+					  axlPointer       ptr2)
+{
+	TurbulenceMetricsClient * client = ptr;
+	int                       size;
+
+	size = recv (descriptor, client->request + client->size, sizeof (client->request) - 1 - client->size, 0);
+	if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+		return axl_true;
+	if (size <= 0 || (turbulence_trace_now () - client->stamp) > TBC_METRICS_CLIENT_TIMEOUT) 
+		goto finish;
+	client->size += size;
+	client->request[client->size] = 0;
+
+	/* wait for the request line (unless the buffer is full) */
+	if (strstr (client->request, "\r\n") == NULL && strchr (client->request, '\n') == NULL &&
+	    client->size < (int) sizeof (client->request) - 1)
+		return axl_true;
+
+	/* serve it from the thread pool with its own descriptor (the
+	 * one watched is closed by the loop) */
+	client->socket = dup (descriptor);
+	if (client->socket < 0)
+		goto finish;
+	fcntl (client->socket, F_SETFD, FD_CLOEXEC);
+	axl_list_unlink_ptr (ctx->metrics_clients, client);
+	vortex_thread_pool_new_task (TBC_VORTEX_CTX (ctx), __turbulence_metrics_serve, client);
+	return axl_false;
+
+ finish:
+	axl_list_unlink_ptr (ctx->metrics_clients, client);
+	axl_free (client);
+	return axl_false;
+}
+
+/** 
+ * @internal Accepts metrics clients (a plain HTTP GET) on the
+ * metrics listener, watching them on the same loop until their
+ * request is received.
+ */
+axl_bool __turbulence_metrics_on_accept (TurbulenceLoop * loop, 
+					 TurbulenceCtx  * ctx,
+					 int              descriptor, 
+					 axlPointer       ptr, 
+					 axlPointer       ptr2)
+{
+	VORTEX_SOCKET             _socket;
+	TurbulenceMetricsClient * client;
+	long                      now;
+	int                       iterator;
+
+	_socket = accept (descriptor, NULL, NULL);
+	if (_socket < 0) 
+		return axl_true;
+	fcntl (_socket, F_SETFD, FD_CLOEXEC);
+
+	/* clients that did not send their request in time: shut
+	 * them down so the loop notifies them (recv returns 0) and
+	 * they are released by __turbulence_metrics_on_request */
+	now = turbulence_trace_now ();
+	for (iterator = 0; iterator < axl_list_length (ctx->metrics_clients); iterator++) {
+		client = axl_list_get_nth (ctx->metrics_clients, iterator);
+		if ((now - client->stamp) > TBC_METRICS_CLIENT_TIMEOUT)
+			shutdown (client->watched, SHUT_RDWR);
+	} /* end for */
+
+	/* too many clients pending to send their request */
+	if (axl_list_length (ctx->metrics_clients) >= TBC_METRICS_MAX_CLIENTS) {
+		wrn ("too many metrics clients pending (%d), closing new one", axl_list_length (ctx->metrics_clients));
+		vortex_close_socket (_socket);
+		return axl_true;
+	} /* end if */
+
+	client = axl_new (TurbulenceMetricsClient, 1);
+	if (client == NULL) {
+		vortex_close_socket (_socket);
+		return axl_true;
+	} /* end if */
+	client->ctx     = ctx;
+	client->watched = _socket;
+	client->stamp   = now;
+	axl_list_append (ctx->metrics_clients, client);
+
+	fcntl (_socket, F_SETFL, fcntl (_socket, F_GETFL, 0) | O_NONBLOCK);
+	turbulence_loop_watch_descriptor (loop, _socket, __turbulence_metrics_on_request, client, NULL);
+	return axl_true;
+}
+
+/** 
+ * @internal Starts the metrics listener declared at
+ * <b>/turbulence/global-settings/metrics</b> (if any).
+ */
+void __turbulence_metrics_start_listener (TurbulenceCtx * ctx)
+{
+	axlNode         * node;
+	const char      * host;
+	const char      * port;
+	struct addrinfo   hints;
+	struct addrinfo * result = NULL;
+	VORTEX_SOCKET     _socket;
+	int               value  = 1;
+
+	node = axl_doc_get (turbulence_config_get (ctx), "/turbulence/global-settings/metrics");
+	if (node == NULL)
+		return;
+	host = ATTR_VALUE (node, "listen") ? ATTR_VALUE (node, "listen") : "127.0.0.1";
+	port = ATTR_VALUE (node, "port");
+
+	memset (&hints, 0, sizeof (struct addrinfo));
+	hints.ai_family   = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags    = AI_PASSIVE;
+	if (getaddrinfo (host, port, &hints, &result) != 0 || result == NULL) {
+		error ("unable to resolve metrics address %s:%s", host, port);
+		return;
+	} /* end if */
+
+	_socket = socket (result->ai_family, result->ai_socktype, result->ai_protocol);
+	if (_socket < 0) {
+		error ("unable to create metrics socket, error was: %s", vortex_errno_get_last_error ());
+		freeaddrinfo (result);
+		return;
+	} /* end if */
+	setsockopt (_socket, SOL_SOCKET, SO_REUSEADDR, &value, sizeof (value));
+	fcntl (_socket, F_SETFD, FD_CLOEXEC);
+
+	if (bind (_socket, result->ai_addr, result->ai_addrlen) != 0 || listen (_socket, 16) != 0) {
+		error ("unable to start metrics listener at %s:%s, error was: %s", host, port, vortex_errno_get_last_error ());
+		vortex_close_socket (_socket);
+		freeaddrinfo (result);
+		return;
+	} /* end if */
+	freeaddrinfo (result);
+
+	/* accepts are done only when the loop notifies */
+	fcntl (_socket, F_SETFL, fcntl (_socket, F_GETFL, 0) | O_NONBLOCK);
+
+	ctx->metrics_clients = axl_list_new (axl_list_always_return_1, axl_free);
+	ctx->metrics_loop    = turbulence_loop_create (ctx);
+	if (ctx->metrics_loop == NULL) {
+		vortex_close_socket (_socket);
+		return;
+	} /* end if */
+	turbulence_loop_watch_descriptor (ctx->metrics_loop, _socket, __turbulence_metrics_on_accept, NULL, NULL);
+
+	msg ("metrics served at http://%s:%s/metrics", host, port);
+	return;
+}
+#endif
+
+/** 
+ * @internal Registers metrics updated by turbulence core and starts
+ * the metrics listener (master process) or the profile used to
+ * report metrics to the master (childs).
+ */
+void               turbulence_metrics_init    (TurbulenceCtx * ctx)
+{
+	TurbulenceMetric ** builtin = ctx->metrics_builtin;
+
+	builtin[TBC_METRIC_CONNECTIONS_ACCEPTED] = turbulence_metrics_get (ctx, TBC_METRIC_COUNTER, "turbulence_connections_accepted_total", NULL, 
+									   "Connections accepted by listeners");
+	builtin[TBC_METRIC_CONNECTIONS]          = turbulence_metrics_get (ctx, TBC_METRIC_GAUGE, "turbulence_connections", NULL,
+									   "Connections currently registered");
+	builtin[TBC_METRIC_CHILDS_CREATED]       = turbulence_metrics_get (ctx, TBC_METRIC_COUNTER, "turbulence_childs_created_total", NULL,
+									   "Child processes created");
+	builtin[TBC_METRIC_HANDOFF_SPAWN]        = turbulence_metrics_get (ctx, TBC_METRIC_HISTOGRAM, "turbulence_handoff_latency_microseconds", "kind=\"spawn\"",
+									   "Time spent passing a connection to a child");
+	builtin[TBC_METRIC_HANDOFF_REUSE]        = turbulence_metrics_get (ctx, TBC_METRIC_HISTOGRAM, "turbulence_handoff_latency_microseconds", "kind=\"reuse\"",
+									   "Time spent passing a connection to a child");
+	builtin[TBC_METRIC_CHANNELS_STARTED]     = turbulence_metrics_get (ctx, TBC_METRIC_COUNTER, "turbulence_channels_started_total", NULL,
+									   "Channels started");
+	builtin[TBC_METRIC_LOG_RELAYED]          = turbulence_metrics_get (ctx, TBC_METRIC_COUNTER, "turbulence_log_relayed_bytes_total", NULL,
+									   "Bytes of child logs written by the master");
+	builtin[TBC_METRIC_LOG_BACKLOG]          = turbulence_metrics_get (ctx, TBC_METRIC_HISTOGRAM, "turbulence_log_backlog_bytes", NULL,
+									   "Bytes pending on child log pipes after each write");
+
+	if (turbulence_ctx_is_child (ctx)) {
+		/* register profile used by the master to collect
+		 * metrics */
+		vortex_profiles_register (TBC_VORTEX_CTX (ctx), TBC_METRICS_URI,
+					  /* start handler */
+					  __turbulence_metrics_child_start, ctx,
+					  /* no close handler */
+					  NULL, NULL,
+					  /* frame received */
+					  __turbulence_metrics_child_request_received, ctx);
+		return;
+	} /* end if */
+
+#if defined(AXL_OS_UNIX)
+	__turbulence_metrics_start_listener (ctx);
+#endif
+	return;
+}
+
+/** 
+ * @internal Stops the metrics listener and releases the registry.
+ */
+void               turbulence_metrics_cleanup (TurbulenceCtx * ctx)
+{
+	int iterator;
+
+	if (ctx->metrics_loop) {
+		turbulence_loop_close (ctx->metrics_loop, axl_true);
+		ctx->metrics_loop = NULL;
+	} /* end if */
+	/* clients still reading their request (the loop is stopped) */
+	axl_list_free (ctx->metrics_clients);
+	ctx->metrics_clients = NULL;
+
+	vortex_mutex_lock (&ctx->metrics_mutex);
+	for (iterator = 0; iterator < ctx->metrics_count; iterator++) 
+		__turbulence_metric_free (ctx->metrics[iterator]);
+	axl_free (ctx->metrics);
+	ctx->metrics       = NULL;
+	ctx->metrics_count = 0;
+	ctx->metrics_size  = 0;
+	axl_hash_free (ctx->metrics_hash);
+	ctx->metrics_hash  = NULL;
+	axl_hash_free (ctx->metrics_calls);
+	ctx->metrics_calls = NULL;
+	memset (ctx->metrics_builtin, 0, sizeof (ctx->metrics_builtin));
+	vortex_mutex_unlock (&ctx->metrics_mutex);
+
+	return;
+}
+
+/** 
+ * @}
+ */
@@ -0,0 +1,81 @@
+/*  Turbulence BEEP application server
+ *  Copyright (C) 2025 Advanced Software Production Line, S.L.
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; version 2.1 of the
+ *  License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free
+ *  Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307 USA
+ *  
+ *  You may find a copy of the license under this software is released
+ *  at COPYING file. This is LGPL software: you are welcome to develop
+ *  proprietary applications using this library without any royalty or
+ *  fee but returning back any change, improvement or addition in the
+ *  form of source code, project image, documentation patches, etc.
+ *
+ *  For commercial support on build BEEP enabled solutions, supporting
+ *  turbulence based solutions, etc, contact us:
+ *          
+ *      Postal address:
+ *         Advanced Software Production Line, S.L.
+ *         C/ Antonio Suarez Nº10, Edificio Alius A, Despacho 102
+ *         Alcala de Henares, 28802 (MADRID)
+ *         Spain
+ *
+ *      Email address:
+ *         info@aspl.es - http://www.aspl.es/turbulence
+ */
+#ifndef __TURBULENCE_METRICS_H__
+#define __TURBULENCE_METRICS_H__
+
+#include <turbulence.h>
+
+/** 
+ * \addtogroup turbulence_metrics
+ * @{
+ */
+
+TurbulenceMetric * turbulence_metrics_get     (TurbulenceCtx        * ctx,
+					       TurbulenceMetricType   type,
+					       const char           * name,
+					       const char           * labels,
+					       const char           * help);
+
+void               turbulence_metric_inc      (TurbulenceMetric * metric,
+					       long               value);
+
+void               turbulence_metric_set      (TurbulenceMetric * metric,
+					       long               value);
+
+void               turbulence_metric_observe  (TurbulenceMetric * metric,
+					       long               value);
+
+long               turbulence_metric_value    (TurbulenceMetric * metric);
+
+long               turbulence_metrics_since   (struct timeval   * start);
+
+char             * turbulence_metrics_label   (const char * name, 
+					       const char * value);
+
+char             * turbulence_metrics_render  (TurbulenceCtx * ctx,
+					       axl_bool        include_childs);
+
+/* internal API */
+void               turbulence_metrics_init    (TurbulenceCtx * ctx);
+
+void               turbulence_metrics_cleanup (TurbulenceCtx * ctx);
+
+/** 
+ * @}
+ */
+
+#endif
@@ -70,6 +70,19 @@ struct _TurbulenceModule {
 	axlList          * provided_profiles;
 };
 
+/** 
+ * @internal Copy of the modules registered implementing a handler. It
+ * is never modified: each (un)register replaces it, and copies
+ * replaced are kept (chained on next) until modules are cleaned up,
+ * because a notification may still be looping over them. Sets only
+ * change when modules are loaded or unloaded, so few are kept.
+ */
+struct _TurbulenceModuleSet {
+	int                   count;
+	TurbulenceModule   ** items;
+	TurbulenceModuleSet * next;
+};
+
 /** 
  * @internal Starts the turbulence module initializing all internal
  * variables.
@@ -81,6 +94,71 @@ void               turbulence_module_init      (TurbulenceCtx * ctx)
 						(axlDestroyFunc) turbulence_module_free);
 	/* init mutex */
 	vortex_mutex_create (&ctx->registered_modules_mutex);
+	ctx->ppath_selected_modules = NULL;
+	ctx->ppath_selected_retired = NULL;
+	return;
+}
+
+/** 
+ * @internal Releases the provided module set and those chained after
+ * it.
+ */
+void __turbulence_module_set_free (TurbulenceModuleSet * set)
+{
+	TurbulenceModuleSet * next;
+
+	while (set) {
+		next = set->next;
+		axl_free (set->items);
+		axl_free (set);
+		set = next;
+	} /* end while */
+	return;
+}
+
+/** 
+ * @internal Rebuilds the set of modules implementing ppath_selected
+ * after the registered modules list changed. Must be called with
+ * registered_modules_mutex locked.
+ */
+void __turbulence_module_publish (TurbulenceCtx * ctx)
+{
+	TurbulenceModuleSet * set = NULL;
+	TurbulenceModuleSet * previous;
+	TurbulenceModule    * module;
+	int                   count;
+	int                   iterator;
+
+	count = axl_list_length (ctx->registered_modules);
+	for (iterator = 0; iterator < count; iterator++) {
+		module = axl_list_get_nth (ctx->registered_modules, iterator);
+		if (module == NULL || module->def == NULL || module->def->ppath_selected == NULL)
+			continue;
+
+		/* create the set on first module found */
+		if (set == NULL) {
+			set = axl_new (TurbulenceModuleSet, 1);
+			if (set == NULL)
+				return;
+			set->items = axl_new (TurbulenceModule *, count);
+			if (set->items == NULL) {
+				axl_free (set);
+				return;
+			} /* end if */
+		} /* end if */
+		set->items[set->count] = module;
+		set->count++;
+	} /* end for */
+
+	/* swap: notifications read the set with an acquire load */
+	previous = ctx->ppath_selected_modules;
+	TBC_ATOMIC_STORE (ctx->ppath_selected_modules, set);
+
+	/* notifications still running may use the previous set */
+	if (previous) {
+		previous->next              = ctx->ppath_selected_retired;
+		ctx->ppath_selected_retired = previous;
+	} /* end if */
 	return;
 }
 
@@ -200,6 +278,7 @@ void               turbulence_module_unload       (TurbulenceCtx * ctx,
 
 			/* remove from registered modules */
 			axl_list_remove_at (ctx->registered_modules, iterator);
+			__turbulence_module_publish (ctx);
 
 			/* terminate it */
 			vortex_mutex_unlock (&ctx->registered_modules_mutex);
@@ -339,6 +418,7 @@ axl_bool             turbulence_module_register  (TurbulenceModule * module)
 	} /* end while */
 
 	axl_list_add (ctx->registered_modules, module);
+	__turbulence_module_publish (ctx);
 	msg ("Registered modules (%d, %p)", axl_list_length (ctx->registered_modules), ctx->registered_modules);
 	vortex_mutex_unlock (&ctx->registered_modules_mutex);
 
@@ -366,6 +446,7 @@ void               turbulence_module_unregister  (TurbulenceModule * module)
 	/* register the module */
 	vortex_mutex_lock (&ctx->registered_modules_mutex);
 	axl_list_unlink (ctx->registered_modules, module);
+	__turbulence_module_publish (ctx);
 	vortex_mutex_unlock (&ctx->registered_modules_mutex);
 
 	return;
@@ -436,9 +517,9 @@ TurbulenceModule           * turbulence_module_open_and_register (TurbulenceCtx
 	turbulence_module_register (module);
 
 	/* now the module is registered, publish this is done */
-	turbulence_mediator_push_event (ctx, "turbulence", "module-registered", 
-					/* publish name added */
-					(axlPointer) turbulence_module_name (module), NULL, NULL, NULL);
+	turbulence_mediator_plug_push (ctx->mediator_module_registered, 
+				       /* publish name added */
+				       (axlPointer) turbulence_module_name (module), NULL, NULL, NULL);
 	return module;
 }
 
@@ -513,6 +594,35 @@ void               turbulence_module_free (TurbulenceModule * module)
 	return;
 }
 
+/** 
+ * @internal Notifies profile path selection to modules implementing
+ * ppath_selected, stopping at the first one reporting failure.
+ */
+axl_bool __turbulence_module_notify_ppath_selected (TurbulenceCtx * ctx, axlPointer def, axlPointer conn)
+{
+	TurbulenceModuleSet * set;
+	TurbulenceModule    * module;
+	int                   iterator;
+	axl_bool              result = axl_true;
+
+	/* get current set (never released until modules cleanup) */
+	set = TBC_ATOMIC_LOAD (ctx->ppath_selected_modules);
+	if (set == NULL)
+		return axl_true;
+
+	for (iterator = 0; iterator < set->count && result; iterator++) {
+		module = set->items[iterator];
+		msg ("notifying profile path selected on module: %s (%s)", module->def->mod_name, module->path);
+		if (! module->def->ppath_selected (ctx, def, conn))  {
+			/* selection failed: stop notifying remaining modules */
+			wrn ("profile path selection for module: %s returned failure", module->def->mod_name);
+			result = axl_false;
+		} /* end if */
+	} /* end for */
+
+	return result;
+}
+
 /** 
  * @brief Allows to do a handler notification on all registered
  * modules.
@@ -545,11 +655,12 @@ axl_bool           turbulence_module_notify      (TurbulenceCtx         * ctx,
 	int                  iterator = 0;
 	axl_bool             result   = axl_true;
 
-	vortex_mutex_lock (&ctx->registered_modules_mutex);
-
-	/* load search paths here in case of TBC_PPATH_SELECTED_HANDLER */
+	/* profile path selection is notified once per connection: use
+	 * the set of modules implementing it */
 	if (handler == TBC_PPATH_SELECTED_HANDLER)
-		__turbulence_ppath_load_search_nodes (ctx, data);
+		return __turbulence_module_notify_ppath_selected (ctx, data, data2);
+
+	vortex_mutex_lock (&ctx->registered_modules_mutex);
 
 	/* Take a stable snapshot of the modules registered at this point.
 	 * Handlers are invoked with the lock released, so a handler that
@@ -612,15 +723,7 @@ axl_bool           turbulence_module_notify      (TurbulenceCtx         * ctx,
 			}
 			break;
 		case TBC_PPATH_SELECTED_HANDLER:
-			/* notify if defined ppath_selected function */
-			if (module->def->ppath_selected != NULL) {
-				msg ("notifying profile path selected on module: %s (%s)", module->def->mod_name, module->path);
-				if (! module->def->ppath_selected (ctx, data, data2))  {
-					/* selection failed: stop notifying remaining modules */
-					wrn ("profile path selection for module: %s returned failure", module->def->mod_name);
-					result = axl_false;
-				} /* end if */
-			}
+			/* handled by __turbulence_module_notify_ppath_selected */
 			break;
 		}
 
@@ -680,6 +783,12 @@ void               turbulence_module_cleanup   (TurbulenceCtx * ctx)
 	ctx->registered_modules = NULL;
 	vortex_mutex_destroy (&ctx->registered_modules_mutex);
 
+	/* release modules sets */
+	__turbulence_module_set_free (ctx->ppath_selected_modules);
+	__turbulence_module_set_free (ctx->ppath_selected_retired);
+	ctx->ppath_selected_modules = NULL;
+	ctx->ppath_selected_retired = NULL;
+
 	return;
 }
 
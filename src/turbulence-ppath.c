@@ -100,32 +100,97 @@
  */
 
 /* NOTE: TurbulencePPathState is declared at turbulence-ctx-private.h,
- * next to the rest of the profile path types. */
+ * next to the rest of the profile path types. It is allocated
+ * (along with requested_serverName) from the connection arena (see
+ * turbulence_conn_mgr_arena) so it is stored without destroy
+ * function: it is released with the connection. */
 
-void __turbulence_ppath_state_free (axlPointer _state) {
-	TurbulencePPathState * state = _state;
+struct _TurbulencePPath {
+	/* list of profile paths found */
+	TurbulencePPathDef ** items;
 
-	if (state == NULL)
+	/* all profile paths are selectable by address (src/dst) */
+	axl_bool              all_rules_address_based;
+
+	/* references held by the context (while installed) and by
+	 * threads iterating the set (see __turbulence_ppath_current),
+	 * protected by ctx->paths_mutex */
+	int                   ref_count;
+};
+
+/** 
+ * @internal Returns the profile paths currently installed (they are
+ * swapped on reload, see turbulence_ppath_install) with a reference
+ * acquired, so they are not released while the caller iterates
+ * them. The caller must release it with __turbulence_ppath_release.
+ */
+TurbulencePPath * __turbulence_ppath_current (TurbulenceCtx * ctx)
+{
+	TurbulencePPath * paths;
+
+	vortex_mutex_lock (&ctx->paths_mutex);
+	paths = ctx->paths;
+	if (paths)
+		paths->ref_count++;
+	vortex_mutex_unlock (&ctx->paths_mutex);
+
+	return paths;
+}
+
+/** 
+ * @internal Releases a reference on a set of profile paths, releasing
+ * it if it was the last one (definitions still referenced by
+ * connections or childs are kept, see __turbulence_ppath_def_unref).
+ */
+void __turbulence_ppath_release (TurbulenceCtx * ctx, TurbulencePPath * paths)
+{
+	axl_bool last;
+
+	if (paths == NULL)
 		return;
 
-	/* release allocation */
-	axl_free (state->requested_serverName);
+	vortex_mutex_lock (&ctx->paths_mutex);
+	paths->ref_count--;
+	last = (paths->ref_count == 0);
+	vortex_mutex_unlock (&ctx->paths_mutex);
+
+	if (last)
+		__turbulence_ppath_free (paths);
+	return;
+}
 
-	/* clear references */
-	state->requested_serverName = NULL;
-	state->path_selected = NULL;
-	state->ctx = NULL;
+void __turbulence_ppath_free_def (TurbulencePPathDef * def);
 
-	/* release node */
-	axl_free (state);
+/** 
+ * @internal Acquires a reference on the provided profile path
+ * definition.
+ */
+void __turbulence_ppath_def_ref (TurbulencePPathDef * def)
+{
+	if (def == NULL)
+		return;
+	TBC_ATOMIC_ADD (def->ref_count, 1);
 	return;
 }
 
-struct _TurbulencePPath {
-	/* list of profile paths found */
-	TurbulencePPathDef ** items;
-	
-};
+/** 
+ * @internal Releases a reference on the provided profile path
+ * definition. The last one releases it along with the reference it
+ * holds on the configuration document it was built from.
+ */
+void __turbulence_ppath_def_unref (TurbulencePPathDef * def)
+{
+	if (def == NULL)
+		return;
+
+	/* previous value was 1: last reference */
+	if (TBC_ATOMIC_ADD (def->ref_count, -1) > 1)
+		return;
+
+	turbulence_config_doc_unref (def->ctx, def->doc);
+	__turbulence_ppath_free_def (def);
+	return;
+}
 
 TurbulencePPathItem * __turbulence_ppath_get_item (TurbulenceCtx * ctx, axlNode * node, int * warnings)
 {
@@ -180,6 +245,25 @@ TurbulencePPathItem * __turbulence_ppath_get_item (TurbulenceCtx * ctx, axlNode
 			result->max_per_con = 0;
 	} /* end if */
 
+	/* get frame and message size limits */
+	if (HAS_ATTR (node, "max-frame-size")) {
+		result->max_frame_size = atoi (ATTR_VALUE (node, "max-frame-size"));
+		if (result->max_frame_size < 0)
+			result->max_frame_size = 0;
+	} /* end if */
+	if (HAS_ATTR (node, "max-message-size")) {
+		result->max_message_size = atoi (ATTR_VALUE (node, "max-message-size"));
+		if (result->max_message_size < 0)
+			result->max_message_size = 0;
+	} /* end if */
+
+	/* get bandwidth limit */
+	if (HAS_ATTR (node, "max-rate")) {
+		result->max_rate = atol (ATTR_VALUE (node, "max-rate"));
+		if (result->max_rate < 0)
+			result->max_rate = 0;
+	} /* end if */
+
 	/* configure the profile path item type */
 	if (NODE_CMP_NAME (node, "allow")) {
 		result->type = PROFILE_ALLOW;
@@ -226,6 +310,71 @@ TurbulencePPathItem * __turbulence_ppath_get_item (TurbulenceCtx * ctx, axlNode
 
 #define TURBULENCE_PPATH_STATE "tu::pp:st"
 
+/* connection key holding the reference on the profile path selected
+ * (the state is allocated from the connection arena, which may be
+ * released before it, so the reference is stored apart) */
+#define TURBULENCE_PPATH_REF   "tu::pp:rf"
+
+/** 
+ * @internal Records the provided definition as the profile path
+ * selected for the connection. The connection holds a reference on
+ * it, released along with the connection (or when another profile
+ * path is selected).
+ */
+void __turbulence_ppath_state_select (VortexConnection     * conn,
+				      TurbulencePPathState * state,
+				      TurbulencePPathDef   * def)
+{
+	__turbulence_ppath_def_ref (def);
+	state->path_selected = def;
+	vortex_connection_set_data_full (conn, 
+					 /* the key and its associated value */
+					 TURBULENCE_PPATH_REF, def,
+					 /* destroy functions */
+					 NULL, (axlDestroyFunc) __turbulence_ppath_def_unref);
+	return;
+}
+
+/** 
+ * @internal Records the limits declared by the item that accepted
+ * the channel so they are applied once it is added (see
+ * __turbulence_ppath_apply_limits).
+ *
+ * Limits are keyed by channel number and profile: the channel start
+ * may still be rejected after the mask accepted it (by other masks
+ * or the start handler), and nothing is notified in that case, so
+ * an entry left behind must never be applied to a later channel
+ * with the same number but another profile. A later acceptance of
+ * the same channel and profile replaces (or clears) that entry.
+ */
+void __turbulence_ppath_record_limits (VortexConnection    * connection, 
+				       int                   channel_num, 
+				       const char          * uri,
+				       TurbulencePPathItem * item)
+{
+	TurbulencePPathLimits * limits;
+	char                  * key;
+
+	if (connection == NULL || channel_num <= 0 || uri == NULL)
+		return;
+
+	key = axl_strdup_printf ("tbc:pp:lm:%d:%s", channel_num, uri);
+	if (item->max_frame_size == 0 && item->max_message_size == 0 && item->max_rate == 0) {
+		/* clear limits left by a previous start rejected */
+		if (vortex_connection_get_data (connection, key))
+			vortex_connection_set_data (connection, key, NULL);
+		axl_free (key);
+		return;
+	} /* end if */
+
+	limits                   = axl_new (TurbulencePPathLimits, 1);
+	limits->max_frame_size   = item->max_frame_size;
+	limits->max_message_size = item->max_message_size;
+	limits->max_rate         = item->max_rate;
+	vortex_connection_set_data_full (connection, key, limits, axl_free, axl_free);
+	return;
+}
+
 int  __turbulence_ppath_mask_items (TurbulenceCtx        * ctx,
 				    TurbulencePPathItem ** ppath_items, 
 				    TurbulencePPathState * state, 
@@ -339,6 +488,7 @@ int  __turbulence_ppath_mask_items (TurbulenceCtx        * ctx,
 		/* profile properly matched, including the serverName */
 		msg2 ("  <allow level=%d>: Profile path MATCHED, including serverName at <allow> level: channel_num=%d, profile=%s, serverName=%s", 
 		      level, channel_num, uri, serverName ? serverName : "");
+		__turbulence_ppath_record_limits (connection, channel_num, uri, item);
 		return axl_false;
 	} /* end while */
 
@@ -714,7 +864,7 @@ void __turbulence_ppath_still_not_selected (TurbulenceCtx * ctx, VortexConnectio
 	TurbulencePPathState * state;
 
 	/* create state object */
-	state                = axl_new (TurbulencePPathState, 1);
+	state                = TBC_ARENA_NEW (turbulence_conn_mgr_arena (ctx, connection), TurbulencePPathState);
 	if (state == NULL)
 		return;
 
@@ -724,7 +874,7 @@ void __turbulence_ppath_still_not_selected (TurbulenceCtx * ctx, VortexConnectio
 					 /* the key and its associated value */
 					 TURBULENCE_PPATH_STATE, state,
 					 /* destroy functions */
-					 NULL, __turbulence_ppath_state_free);
+					 NULL, NULL);
 	vortex_connection_set_profile_mask (connection, __turbulence_ppath_mask_temporal, state);
 
 	return;
@@ -745,16 +895,17 @@ void __turbulence_ppath_still_not_selected (TurbulenceCtx * ctx, VortexConnectio
  *
  * SEE NOTES AT THE TOP OF THE FILE.
  */
-axl_bool __turbulence_ppath_select (TurbulenceCtx      * ctx, 
-				    VortexConnection   * connection, 
-				    int                  channel_num,
-				    const char         * uri,
-				    const char         * profile_content,
-				    VortexEncoding       encoding,
-				    /* value requested through x-serverName (serverName) feature. */
-				    const char         * serverName, 
-				    VortexFrame        * frame,
-				    axl_bool             on_connect)
+axl_bool __turbulence_ppath_select_from (TurbulenceCtx      * ctx, 
+					 TurbulencePPath    * paths,
+					 VortexConnection   * connection, 
+					 int                  channel_num,
+					 const char         * uri,
+					 const char         * profile_content,
+					 VortexEncoding       encoding,
+					 /* value requested through x-serverName (serverName) feature. */
+					 const char         * serverName, 
+					 VortexFrame        * frame,
+					 axl_bool             on_connect)
 {
 	/* get turbulence context */
 	TurbulencePPathState * state;
@@ -772,8 +923,8 @@ axl_bool __turbulence_ppath_select (TurbulenceCtx      * ctx,
 		   only select if all profile path references to src=
 		   and dst= */
 		msg ("Profile path selection called at <on connect> (before any BEEP exchange) signaled and all_rules_address_based:%d", 
-		     ctx->all_rules_address_based);
-		if (! ctx->all_rules_address_based)  {
+		     paths->all_rules_address_based);
+		if (! paths->all_rules_address_based)  {
 			/* configure a profile mask to select an appropriate ppath state in the next channel
 			   start request where the remote BEEP peer has a chance to select a serverName value */
 			__turbulence_ppath_still_not_selected (ctx, connection);
@@ -789,9 +940,9 @@ axl_bool __turbulence_ppath_select (TurbulenceCtx      * ctx,
 	dst      = vortex_connection_get_local_addr (connection);
 	msg ("Checking: %-30s %-30s Profile path match for conn-id=%d", "Ppath. serverName", "requested serverName",
 	     vortex_connection_get_id (connection));
-	while (ctx->paths->items[iterator] != NULL) {
+	while (paths->items[iterator] != NULL) {
 		/* get the profile path def */
-		def = ctx->paths->items[iterator];
+		def = paths->items[iterator];
 
 		msg ("checking: %-30s %-30s %s",
 		     def->serverName ? __TBC_EXP_STR__(def->serverName) : "''",
@@ -850,23 +1001,37 @@ axl_bool __turbulence_ppath_select (TurbulenceCtx      * ctx,
 	   state created */
 	state  = vortex_connection_get_data (connection, TURBULENCE_PPATH_STATE);
 	if (state != NULL) {
-		state->path_selected = def;
+		__turbulence_ppath_state_select (connection, state, def);
 	} else {
 		/* create and store */
-		state                = axl_new (TurbulencePPathState, 1);
-		state->path_selected = def;
+		state                = TBC_ARENA_NEW (turbulence_conn_mgr_arena (ctx, connection), TurbulencePPathState);
+		if (state == NULL) {
+			error ("Unable to allocate profile path state for connection id=%d, rejecting connection",
+			       vortex_connection_get_id (connection));
+			return axl_false;
+		} /* end if */
+		__turbulence_ppath_state_select (connection, state, def);
 		state->ctx           = ctx;
 		vortex_connection_set_data_full (connection, 
 						 /* the key and its associated value */
 						 TURBULENCE_PPATH_STATE, state,
 						 /* destroy functions */
-						 NULL, __turbulence_ppath_state_free);
+						 NULL, NULL);
 		
 		/* now configure the profile path mask to handle how channels
 		 * and profiles are accepted */
 		vortex_connection_set_profile_mask (connection, __turbulence_ppath_mask, state);
 	} /* end if */
 
+	/* account profile path selected */
+	turbulence_metric_inc (def->metric_selected, 1);
+	turbulence_trace_mark (ctx, connection, TBC_TRACE_SELECTED);
+
+	/* bandwidth shaping is applied by the process reading from
+	 * the client: here unless the connection is sent to a child */
+	if (def->max_rate > 0 && (! def->separate || turbulence_conn_mgr_proxy_on_parent (connection)))
+		turbulence_shaper_conn_setup (ctx, connection, def, def->max_rate);
+
 	/* profile path selected but we have no way to configure the
 	 * serverName to be used on this connection until the first
 	 * channel is accepted (with the serverName configured). So
@@ -875,7 +1040,7 @@ axl_bool __turbulence_ppath_select (TurbulenceCtx      * ctx,
 	 * to this value. */
 	if (serverName && strlen (serverName) > 0) {
 		msg ("Setting requested serverName=%s but still first opened channel is required", serverName);
-		state->requested_serverName = axl_strdup (serverName);
+		state->requested_serverName = turbulence_arena_strdup (turbulence_conn_mgr_arena (ctx, connection), serverName);
 	} /* end if */
 		
 	/* check for process separation and apply operation here */
@@ -911,6 +1076,37 @@ axl_bool __turbulence_ppath_select (TurbulenceCtx      * ctx,
 	return axl_true;
 }
 
+/** 
+ * @internal Selects a profile path for the connection among the
+ * profile paths currently installed (see
+ * __turbulence_ppath_select_from), holding a reference on them so a
+ * reload does not release them meanwhile.
+ */
+axl_bool __turbulence_ppath_select (TurbulenceCtx      * ctx, 
+				    VortexConnection   * connection, 
+				    int                  channel_num,
+				    const char         * uri,
+				    const char         * profile_content,
+				    VortexEncoding       encoding,
+				    /* value requested through x-serverName (serverName) feature. */
+				    const char         * serverName, 
+				    VortexFrame        * frame,
+				    axl_bool             on_connect)
+{
+	TurbulencePPath * paths  = __turbulence_ppath_current (ctx);
+	axl_bool          result;
+
+	if (paths == NULL) {
+		error ("no profile paths installed, rejecting connection: id=%d", vortex_connection_get_id (connection));
+		return axl_false;
+	} /* end if */
+
+	result = __turbulence_ppath_select_from (ctx, paths, connection, channel_num, uri, profile_content,
+						 encoding, serverName, frame, on_connect);
+	__turbulence_ppath_release (ctx, paths);
+	return result;
+}
+
 /** 
  * @internal Function used to set connection profile path state to the
  * provided values. This is currently used after a fork operation to
@@ -935,15 +1131,19 @@ void   __turbulence_ppath_set_state (TurbulenceCtx    * ctx,
 	} /* end if */
 
 	/* create and store */
-	state                       = axl_new (TurbulencePPathState, 1);
-	state->path_selected        = def;
+	state                       = TBC_ARENA_NEW (turbulence_conn_mgr_arena (ctx, conn), TurbulencePPathState);
+	if (state == NULL) {
+		error ("Unable to allocate profile path state for connection id=%d", vortex_connection_get_id (conn));
+		return;
+	} /* end if */
+	__turbulence_ppath_state_select (conn, state, def);
 	state->ctx                  = ctx;
-	state->requested_serverName = requested_serverName ? axl_strdup (requested_serverName) : NULL;
+	state->requested_serverName = turbulence_arena_strdup (turbulence_conn_mgr_arena (ctx, conn), requested_serverName);
 	vortex_connection_set_data_full (conn, 
 					 /* the key and its associated value */
 					 TURBULENCE_PPATH_STATE, state,
 					 /* destroy functions */
-					 NULL, __turbulence_ppath_state_free);
+					 NULL, NULL);
 	
 	/* now configure the profile path mask to handle how channels
 	 * and profiles are accepted */
@@ -1058,6 +1258,9 @@ axl_bool  __turbulence_ppath_handle_connection_on_connect (VortexConnection * co
 	}
 
 	/*** THIRD PART ***/
+	/* connection lifecycle trace starts here */
+	turbulence_trace_mark (ctx, connection, TBC_TRACE_ACCEPT);
+
 	/* call to select a profile path: serverName = NULL ("") && on_connect = axl_true */
 	msg ("Call to select a profile path at connection time (pre <greetings />), conn-id=%d", 
 	     vortex_connection_get_id (connection));
@@ -1107,61 +1310,105 @@ void __turbulence_ppath_check_user (TurbulenceCtx      * ctx,
 
 
 /** 
- * @internal Prepares the runtime execution to provide profile path
- * support according to the current configuration.
- * 
+ * @internal Parses a size value (bytes, or with K, M or G suffix)
+ * returning it in kilobytes or -1 if it is not valid.
  */
-int  turbulence_ppath_init (TurbulenceCtx * ctx)
+long __turbulence_ppath_get_size_kb (const char * value)
+{
+	char * end = NULL;
+	long   size;
+
+	if (value == NULL)
+		return -1;
+	size = strtol (value, &end, 10);
+	if (size <= 0 || end == value)
+		return -1;
+	switch (end[0]) {
+	case 'k':
+	case 'K':
+		return size;
+	case 'm':
+	case 'M':
+		return size * 1024;
+	case 'g':
+	case 'G':
+		return size * 1024 * 1024;
+	case 0:
+		return size / 1024;
+	} /* end switch */
+	return -1;
+}
+
+/** 
+ * @internal Builds profile path definitions declared at the provided
+ * configuration document without installing them (see
+ * turbulence_ppath_install). This allows building them off to the
+ * side when configuration is reloaded.
+ *
+ * Profile path ids are assigned from 1, following the order in
+ * which they are declared, so they match the ids a child gets when
+ * it loads the same configuration file.
+ *
+ * @return A reference to the profile paths built or NULL if they
+ * couldn't be built. Definitions borrow values from the document
+ * provided and hold a reference on it (see
+ * turbulence_config_doc_ref): once they are built the document is
+ * released with its last reference.
+ */
+TurbulencePPath * turbulence_ppath_build (TurbulenceCtx * ctx, axlDoc * doc)
 {
 	/* get turbulence context */
 	axlNode             * node;
 	axlNode             * pdef;
+	TurbulencePPath     * paths;
 	TurbulencePPathDef  * definition;
 	TurbulencePPathItem * item;
 	int                   iterator;
 	int                   iterator2;
 	int                   warnings    = 0;
 	int                   total_items = 0;
-	VortexCtx           * vortex_ctx  = turbulence_ctx_get_vortex_ctx (ctx);
+	char                * label;
 
 	/* check turbulence context received */
-	v_return_val_if_fail (ctx, axl_false);
+	v_return_val_if_fail (ctx && doc, NULL);
 
-	/* init profile path attr alias hash */
-	ctx->profile_attr_alias = axl_hash_new (axl_hash_string, axl_hash_equal_string);
-	
 	/* parse all profile path configurations */
-	pdef = axl_doc_get (turbulence_config_get (ctx), "/turbulence/profile-path-configuration/path-def");
+	pdef = axl_doc_get (doc, "/turbulence/profile-path-configuration/path-def");
 	if (pdef == NULL) {
 		error ("No profile path configuration was found, you must set at least one profile path.");
-		return axl_false;
+		return NULL;
 	} /* end if */
 	
 	/* get the parent node */
 	node = axl_node_get_parent (pdef);
 	
 	/* create the turbulence ppath */
-	ctx->paths        = axl_new (TurbulencePPath, 1);
-	ctx->paths->items = axl_new (TurbulencePPathDef *, axl_node_get_child_num (node) + 1);
+	paths            = axl_new (TurbulencePPath, 1);
+	paths->items     = axl_new (TurbulencePPathDef *, axl_node_get_child_num (node) + 1);
+	paths->ref_count = 1;
 
 	/* flag profile path rules as only ip based and change this
 	   value as long as we read rules */
-	ctx->all_rules_address_based = axl_true;
+	paths->all_rules_address_based = axl_true;
 
 	/* now parse each profile path def found */
 	iterator = 0;
 	while (pdef != NULL) {
 
 		/* get the reference to the profile path */
-		ctx->paths->items[iterator] = axl_new (TurbulencePPathDef, 1);
-		definition                  = ctx->paths->items[iterator];
+		paths->items[iterator] = axl_new (TurbulencePPathDef, 1);
+		definition             = paths->items[iterator];
 
-		/* set unique ppath id */
-		definition->id              = ctx->ppath_next_id;
-		ctx->ppath_next_id++;
+		/* set unique ppath id, held by the set */
+		definition->id         = iterator + 1;
+		definition->ref_count  = 1;
 
-		/* set node */
+		/* set node (the document is referenced while the
+		 * definition is alive) */
 		definition->node = pdef;
+		definition->doc  = doc;
+		definition->ctx  = ctx;
+		turbulence_config_doc_ref (ctx, doc);
 
 		/* catch all data from the profile path def header */
 		if (HAS_ATTR (pdef, "path-name")) {
@@ -1192,7 +1439,7 @@ int  turbulence_ppath_init (TurbulenceCtx * ctx)
 		   posible to apply profile path policy on server
 		   accept handler rather waiting client greetings
 		   reception */
-		if (ctx->all_rules_address_based) {
+		if (paths->all_rules_address_based) {
 			/* A rule stops being address based as soon as it
 			   declares a server-name that is not ".*" (".*"
 			   means every serverName is allowed, including the
@@ -1201,7 +1448,7 @@ int  turbulence_ppath_init (TurbulenceCtx * ctx)
 
 			if ((HAS_ATTR (pdef, "server-name")) && 
 			    (! HAS_ATTR_VALUE (pdef, "server-name", ".*"))) {
-				ctx->all_rules_address_based = axl_false;
+				paths->all_rules_address_based = axl_false;
 			} /* end if */
 		} /* end if */
 
@@ -1230,12 +1477,84 @@ int  turbulence_ppath_init (TurbulenceCtx * ctx)
 		/* check for child reuse  */
 		definition->reuse    = HAS_ATTR_VALUE (pdef, "reuse", "yes");
 
+		/* check for number of reused childs */
+		definition->reuse_workers = 1;
+		if (HAS_ATTR (pdef, "reuse-workers")) {
+			definition->reuse_workers = vortex_support_strtod (ATTR_VALUE (pdef, "reuse-workers"), NULL);
+			if (definition->reuse_workers < 1) {
+				wrn ("PPATH: found reuse-workers=%s for profile path '%s', using 1",
+				     ATTR_VALUE (pdef, "reuse-workers"), definition->path_name ? definition->path_name : "");
+				definition->reuse_workers = 1;
+			} /* end if */
+		} /* end if */
+
 		/* set child limit if any */
 		if (HAS_ATTR (pdef, "child-limit")) 
 			definition->child_limit = vortex_support_strtod (ATTR_VALUE (pdef, "child-limit"), NULL);
 		else
 			definition->child_limit = -1;
 
+		/* child recycling: seconds an idle reused child waits
+		 * before finishing (by default 30) */
+		definition->idle_timeout = 30;
+		if (HAS_ATTR (pdef, "idle-timeout")) {
+			definition->idle_timeout = vortex_support_strtod (ATTR_VALUE (pdef, "idle-timeout"), NULL);
+			/* at least one second: a child finishing
+			 * right away may lose connections the master
+			 * is sending it */
+			if (definition->idle_timeout < 1) {
+				wrn ("PPATH: found idle-timeout=%s for profile path '%s', using 1",
+				     ATTR_VALUE (pdef, "idle-timeout"), definition->path_name ? definition->path_name : "");
+				definition->idle_timeout = 1;
+			} /* end if */
+		} /* end if */
+
+		/* child recycling: connections served or memory used
+		 * before a child is replaced (-1 no limit) */
+		definition->max_conn_served = -1;
+		if (HAS_ATTR (pdef, "max-connections-served")) 
+			definition->max_conn_served = vortex_support_strtod (ATTR_VALUE (pdef, "max-connections-served"), NULL);
+		definition->max_rss = -1;
+		if (HAS_ATTR (pdef, "max-rss")) {
+			definition->max_rss = __turbulence_ppath_get_size_kb (ATTR_VALUE (pdef, "max-rss"));
+			if (definition->max_rss <= 0) {
+				wrn ("PPATH: found wrong max-rss=%s for profile path '%s' (use bytes or a K, M or G suffix), ignoring",
+				     ATTR_VALUE (pdef, "max-rss"), definition->path_name ? definition->path_name : "");
+				definition->max_rss = -1;
+			} /* end if */
+		} /* end if */
+
+		/* check for cpu affinity and NUMA placement of childs */
+		definition->cpu_affinity = ATTR_VALUE (pdef, "cpu-affinity");
+		definition->numa_spread  = HAS_ATTR_VALUE (pdef, "numa-spread", "yes");
+
+		/* connections selected (the metric is shared with the
+		 * definition replaced on reload with the same name) */
+		label = turbulence_metrics_label ("ppath", definition->path_name);
+		definition->metric_selected = turbulence_metrics_get (ctx, TBC_METRIC_COUNTER, "turbulence_ppath_selected_total", label,
+								      "Connections selected by each profile path");
+		axl_free (label);
+
+		/* per stage latency from accept to the first channel */
+		turbulence_trace_ppath_init (ctx, definition);
+
+		/* bandwidth shaping: bytes per second read from each
+		 * connection and bytes accepted at once */
+		if (HAS_ATTR (pdef, "max-rate")) {
+			definition->max_rate = atol (ATTR_VALUE (pdef, "max-rate"));
+			if (definition->max_rate <= 0) {
+				wrn ("PPATH: found wrong max-rate=%s for profile path '%s' (use bytes per second), ignoring",
+				     ATTR_VALUE (pdef, "max-rate"), definition->path_name ? definition->path_name : "");
+				definition->max_rate = 0;
+			} /* end if */
+		} /* end if */
+		if (HAS_ATTR (pdef, "max-burst")) {
+			definition->max_burst = atol (ATTR_VALUE (pdef, "max-burst"));
+			if (definition->max_burst < 0)
+				definition->max_burst = 0;
+		} /* end if */
+		turbulence_shaper_ppath_init (ctx, definition);
+
 		/* check for chroot value */
 		definition->chroot   = ATTR_VALUE (pdef, "chroot");
 
@@ -1310,26 +1629,166 @@ int  turbulence_ppath_init (TurbulenceCtx * ctx)
 		pdef = axl_node_get_next (pdef);
 	} /* end while */
 
-	/* install server connection accepted */
-	vortex_listener_set_on_connection_accepted (vortex_ctx, 
-						    __turbulence_ppath_handle_connection_on_connect, 
-						    ctx); 
-	vortex_connection_set_connection_actions   (vortex_ctx,
-						    CONNECTION_STAGE_PROCESS_GREETINGS_FEATURES,
-						    __turbulence_ppath_handle_connection_on_greetings,
-						    ctx);
-	
 	/* report the final status of the operation so the administrator
 	 * can tell an accepted-and-fully-applied configuration from an
 	 * accepted-but-partially-ignored one */
 	if (warnings > 0) {
 		wrn ("PPATH: profile path definition loaded WITH %d warning(s): %d profile path(s), %d item(s), all rules address based status: %d (see the warnings above: that configuration is not being applied)",
-		     warnings, iterator, total_items, ctx->all_rules_address_based);
+		     warnings, iterator, total_items, paths->all_rules_address_based);
 	} else {
 		msg ("PPATH: profile path definition ok: %d profile path(s), %d item(s), all rules address based status: %d",
-		     iterator, total_items, ctx->all_rules_address_based);
+		     iterator, total_items, paths->all_rules_address_based);
 	} /* end if */
 
+	/* return profile paths built */
+	return paths;
+}
+
+/** 
+ * @internal Checks if both <path-def> nodes declare the same profile
+ * path (same attributes and childs).
+ */
+axl_bool __turbulence_ppath_node_equal (axlNode * a, axlNode * b)
+{
+	char     * content_a = NULL;
+	char     * content_b = NULL;
+	int        size_a    = 0;
+	int        size_b    = 0;
+	axl_bool   result;
+
+	if (a == NULL || b == NULL)
+		return axl_false;
+
+	result = axl_node_dump (a, &content_a, &size_a) && axl_node_dump (b, &content_b, &size_b) &&
+		size_a == size_b && memcmp (content_a, content_b, size_a) == 0;
+
+	axl_free (content_a);
+	axl_free (content_b);
+	return result;
+}
+
+/** 
+ * @internal Carries over definitions that were not changed by a
+ * reload: when the <path-def> found at the same position declares
+ * exactly the same, the definition already installed replaces the
+ * one just built (released here, it was never visible). This way
+ * connections, childs and modules referring to an unchanged profile
+ * path keep using it, and its id (position) does not change.
+ * Definitions that moved are considered changed because ids are
+ * positions (childs compute them from the configuration file).
+ *
+ * The definition carried is referenced by both sets. The previous
+ * set is not modified, so threads still iterating it are not
+ * affected.
+ *
+ * @return Number of definitions carried over.
+ */
+int __turbulence_ppath_carry_over (TurbulenceCtx * ctx, TurbulencePPath * previous, TurbulencePPath * paths)
+{
+	int iterator = 0;
+	int carried  = 0;
+
+	while (paths->items[iterator] != NULL && previous->items[iterator] != NULL) {
+		if (__turbulence_ppath_node_equal (previous->items[iterator]->node, paths->items[iterator]->node)) {
+			__turbulence_ppath_def_unref (paths->items[iterator]);
+			paths->items[iterator] = previous->items[iterator];
+			__turbulence_ppath_def_ref (paths->items[iterator]);
+			carried++;
+		} /* end if */
+		iterator++;
+	} /* end while */
+
+	return carried;
+}
+
+/** 
+ * @internal Installs the provided profile paths (built with
+ * turbulence_ppath_build) so new connections are selected against
+ * them.
+ *
+ * Definitions not changed (same <path-def> at the same position) are
+ * carried over from the profile paths installed, so a reload of an
+ * unchanged configuration keeps every definition (and the childs
+ * created for them). Profile paths previously installed are
+ * released once threads iterating them finish; connections already
+ * accepted and childs created keep a reference on the definitions
+ * they point to (TurbulencePPathState, TurbulenceChild), released
+ * with them.
+ */
+void turbulence_ppath_install (TurbulenceCtx * ctx, TurbulencePPath * paths)
+{
+	TurbulencePPath * previous;
+	int               iterator;
+	int               carried = 0;
+
+	v_return_if_fail (ctx && paths);
+
+	/* keep definitions not changed (only this function, serialized
+	 * by the reload, replaces ctx->paths) */
+	previous = __turbulence_ppath_current (ctx);
+	if (previous != NULL)
+		carried = __turbulence_ppath_carry_over (ctx, previous, paths);
+	__turbulence_ppath_release (ctx, previous);
+
+	/* next id to be assigned, registering search nodes of
+	 * profile paths handled by the master process (childs do it
+	 * at turbulence_child_post_init) before they are selectable */
+	iterator = 0;
+	while (paths->items[iterator] != NULL) {
+		if (ctx->child == NULL && ! paths->items[iterator]->separate)
+			__turbulence_ppath_load_search_nodes (ctx, paths->items[iterator]);
+		iterator++;
+	} /* end while */
+
+	/* swap */
+	vortex_mutex_lock (&ctx->paths_mutex);
+	previous                     = ctx->paths;
+	ctx->paths                   = paths;
+	ctx->all_rules_address_based = paths->all_rules_address_based;
+	ctx->ppath_next_id           = iterator + 1;
+	vortex_mutex_unlock (&ctx->paths_mutex);
+
+	if (previous == NULL) 
+		return;
+
+	/* release the reference held on previous profile paths */
+	__turbulence_ppath_release (ctx, previous);
+
+	msg ("PPATH: installed %d profile path(s), %d unchanged", iterator, carried);
+	return;
+}
+
+/** 
+ * @internal Prepares the runtime execution to provide profile path
+ * support according to the current configuration.
+ * 
+ */
+int  turbulence_ppath_init (TurbulenceCtx * ctx)
+{
+	TurbulencePPath * paths;
+	VortexCtx       * vortex_ctx  = turbulence_ctx_get_vortex_ctx (ctx);
+
+	/* check turbulence context received */
+	v_return_val_if_fail (ctx, axl_false);
+
+	/* init profile path attr alias hash */
+	ctx->profile_attr_alias = axl_hash_new (axl_hash_string, axl_hash_equal_string);
+
+	/* build and install profile paths */
+	paths = turbulence_ppath_build (ctx, turbulence_config_get (ctx));
+	if (paths == NULL)
+		return axl_false;
+	turbulence_ppath_install (ctx, paths);
+
+	/* install server connection accepted */
+	vortex_listener_set_on_connection_accepted (vortex_ctx, 
+						    __turbulence_ppath_handle_connection_on_connect, 
+						    ctx); 
+	vortex_connection_set_connection_actions   (vortex_ctx,
+						    CONNECTION_STAGE_PROCESS_GREETINGS_FEATURES,
+						    __turbulence_ppath_handle_connection_on_greetings,
+						    ctx);
+
 	/* return ok code */
 	return axl_true;
 }
@@ -1364,60 +1823,85 @@ void __turbulence_ppath_free_item (TurbulencePPathItem * item)
 }
 
 /** 
- * @internal Terminates the profile path module, cleanup all memory
- * used.
+ * @internal Releases a profile path definition.
  */
-void turbulence_ppath_cleanup (TurbulenceCtx * ctx)
+void __turbulence_ppath_free_def (TurbulencePPathDef * def)
 {
-	int iterator;
 	int iterator2;
-	TurbulencePPathDef * def;
-
-	/* terminate profile paths */
-	if (ctx->paths != NULL) {
-
-		/* for each profile path item iterator */
-		iterator = 0;
-		while (ctx->paths->items[iterator] != NULL) {
-			/* get the definition */
-			def       = ctx->paths->items[iterator];
-
-			/* free profile path name definition */
-			axl_free (def->path_name);
-			turbulence_expr_free (def->serverName);
-			turbulence_expr_free (def->src);
-			turbulence_expr_free (def->dst);
-
-			/* NOTE: def->ppath_items is only allocated by
-			 * turbulence_ppath_init when the <path-def> holds at
-			 * least one <allow>/<if-success> child. The DTD
-			 * accepts a <path-def> without any of them (and one
-			 * holding only <search> childs), so the array may
-			 * legitimately be NULL here. */
-			iterator2 = 0;
-			while (def->ppath_items != NULL && def->ppath_items[iterator2] != NULL) {
 
-				/* free the item */
-				__turbulence_ppath_free_item (def->ppath_items[iterator2]);
+	/* free profile path name definition */
+	axl_free (def->path_name);
+	turbulence_expr_free (def->serverName);
+	turbulence_expr_free (def->src);
+	turbulence_expr_free (def->dst);
+
+	/* NOTE: def->ppath_items is only allocated by
+	 * turbulence_ppath_build when the <path-def> holds at
+	 * least one <allow>/<if-success> child. The DTD
+	 * accepts a <path-def> without any of them (and one
+	 * holding only <search> childs), so the array may
+	 * legitimately be NULL here. */
+	iterator2 = 0;
+	while (def->ppath_items != NULL && def->ppath_items[iterator2] != NULL) {
+
+		/* free the item */
+		__turbulence_ppath_free_item (def->ppath_items[iterator2]);
+
+		/* next iterator */
+		iterator2++;
+	} /* end while */
 
-				/* next iterator */
-				iterator2++;
-			} /* end while */
+	/* free the definition itself and its items */
+	axl_free (def->ppath_items);
+	axl_free (def);
+	return;
+}
 
-			/* free the definition itself and its items */
-			axl_free (def->ppath_items);
-			axl_free (def);
-			
-			/* next profile path def */
-			iterator++;
-		} /* end if */
+/** 
+ * @internal Releases a set of profile paths built by
+ * turbulence_ppath_build (use __turbulence_ppath_release once it is
+ * installed). Definitions are released with their last reference
+ * (see __turbulence_ppath_def_unref).
+ */
+void __turbulence_ppath_free (axlPointer _paths)
+{
+	TurbulencePPath    * paths = _paths;
+	int                  iterator;
+
+	if (paths == NULL)
+		return;
 
-		/* free profile path array */
-		axl_free (ctx->paths->items);
-		axl_free (ctx->paths);
-		ctx->paths = NULL;
+	/* for each profile path item iterator */
+	iterator = 0;
+	while (paths->items[iterator] != NULL) {
+		__turbulence_ppath_def_unref (paths->items[iterator]);
+			
+		/* next profile path def */
+		iterator++;
 	} /* end if */
 
+	/* free profile path array */
+	axl_free (paths->items);
+	axl_free (paths);
+	return;
+}
+
+/** 
+ * @internal Terminates the profile path module, cleanup all memory
+ * used.
+ */
+void turbulence_ppath_cleanup (TurbulenceCtx * ctx)
+{
+	TurbulencePPath * paths;
+
+	/* terminate profile paths (definitions still referenced by
+	 * connections are released with them) */
+	vortex_mutex_lock (&ctx->paths_mutex);
+	paths      = ctx->paths;
+	ctx->paths = NULL;
+	vortex_mutex_unlock (&ctx->paths_mutex);
+	__turbulence_ppath_release (ctx, paths);
+
 	/* free profile attr alias hash */
 	axl_hash_free (ctx->profile_attr_alias);
 	ctx->profile_attr_alias = NULL;
@@ -1522,30 +2006,49 @@ TurbulencePPathDef * turbulence_ppath_selected (VortexConnection * conn)
 /** 
  * @brief Function used to find a profile path definition given its
  * unique identifier.
+ *
+ * The definition is looked up among the profile paths currently
+ * installed, so the reference returned is valid while they are not
+ * replaced by a reload (or while a connection selecting it is alive).
  */ 
 TurbulencePPathDef * turbulence_ppath_find_by_id (TurbulenceCtx * ctx, int ppath_id)
 {
-	int iterator;
+	TurbulencePPath    * paths;
+	TurbulencePPathDef * def = NULL;
+	int                  iterator;
 
 	if (ctx == NULL)
 		return NULL;
 
 	/* for each profile path item iterator */
+	paths    = __turbulence_ppath_current (ctx);
 	iterator = 0;
-	while (ctx->paths && ctx->paths->items && ctx->paths->items[iterator] != NULL) {
+	while (paths && paths->items && paths->items[iterator] != NULL) {
 		/* check profile path id */
-		if (ctx->paths->items[iterator]->id == ppath_id)
-			return ctx->paths->items[iterator];
+		if (paths->items[iterator]->id == ppath_id) {
+			def = paths->items[iterator];
+			break;
+		} /* end if */
 
 		/* next position */
 		iterator++;
 	}
+	__turbulence_ppath_release (ctx, paths);
 
-	return NULL;
+	return def;
 }
 
 /** 
  * @brief Allows to get the unique profile path identifier.
+ *
+ * Identifiers are positions (starting at 1) of the <path-def> inside
+ * the configuration, so exec'd childs compute the same ids from the
+ * file. They are kept across reloads for definitions not changed, but
+ * a changed definition gets a new TurbulencePPathDef under the same
+ * id. Modules keeping state indexed by id must rebuild it from their
+ * reload handler (called once the new profile paths are installed,
+ * see turbulence_reload_config).
+ *
  * @param ppath_def The profile path where the unique identifier will be retrieved.
  * @return The unique identifier or -1 if it fails.
  */
@@ -1653,10 +2156,52 @@ void                 __turbulence_ppath_set_selected (VortexConnection   * conn,
 
 	/* get current state and replace profile path */
 	state     = vortex_connection_get_data (conn, TURBULENCE_PPATH_STATE);
-	state->path_selected = ppath_def;
+	__turbulence_ppath_state_select (conn, state, ppath_def);
+	return;
+}
+
+/** 
+ * @internal Applies to the channel added the limits declared by the
+ * <allow> or <if-success> that accepted it: max-message-size is the
+ * complete frame limit (frames joined are dropped by the vortex
+ * reader once they exceed it) and max-frame-size the window
+ * advertised (the reader closes the connection if the remote peer
+ * sends beyond it).
+ */
+void                 __turbulence_ppath_apply_limits (TurbulenceCtx * ctx, VortexChannel * channel)
+{
+	VortexConnection      * conn = vortex_channel_get_connection (channel);
+	TurbulencePPathLimits * limits;
+	char                  * key;
+
+	key    = axl_strdup_printf ("tbc:pp:lm:%d:%s", vortex_channel_get_number (channel), vortex_channel_get_profile (channel));
+	limits = vortex_connection_get_data (conn, key);
+	if (limits == NULL) {
+		axl_free (key);
+		return;
+	} /* end if */
+
+	if (limits->max_message_size > 0)
+		vortex_channel_set_complete_frame_limit (channel, limits->max_message_size);
+	if (limits->max_frame_size > 0)
+		vortex_channel_set_window_size (channel, limits->max_frame_size);
+	if (limits->max_rate > 0)
+		turbulence_shaper_conn_setup (ctx, conn, turbulence_ppath_selected (conn), limits->max_rate);
+	msg ("channel=%d (%s) on conn-id=%d limited to max-frame-size=%d, max-message-size=%d, max-rate=%ld",
+	     vortex_channel_get_number (channel), vortex_channel_get_profile (channel), vortex_connection_get_id (conn),
+	     limits->max_frame_size, limits->max_message_size, limits->max_rate);
+
+	/* release limits recorded */
+	vortex_connection_set_data (conn, key, NULL);
+	axl_free (key);
 	return;
 }
 
+/** 
+ * @internal Registers <search> nodes declared by the provided profile
+ * path. Called once per profile path when it is installed (or when a
+ * child takes it) rather than on each connection selecting it.
+ */
 void  __turbulence_ppath_load_search_nodes (TurbulenceCtx * ctx, TurbulencePPathDef * def)
 {
 	axlNode * node;
@@ -41,6 +41,16 @@
 
 int  turbulence_ppath_init (TurbulenceCtx * ctx);
 
+TurbulencePPath * turbulence_ppath_build (TurbulenceCtx * ctx, axlDoc * doc);
+
+void turbulence_ppath_install (TurbulenceCtx * ctx, TurbulencePPath * paths);
+
+void __turbulence_ppath_free (axlPointer paths);
+
+void __turbulence_ppath_def_ref   (TurbulencePPathDef * def);
+
+void __turbulence_ppath_def_unref (TurbulencePPathDef * def);
+
 void turbulence_ppath_cleanup (TurbulenceCtx * ctx);
 
 axl_bool turbulence_ppath_change_user_id (TurbulenceCtx      * ctx,
@@ -69,6 +79,8 @@ void                 __turbulence_ppath_set_selected (VortexConnection   * conn,
 void                 __turbulence_ppath_load_search_nodes (TurbulenceCtx      * ctx, 
 							   TurbulencePPathDef * def);
 
+void                 __turbulence_ppath_apply_limits (TurbulenceCtx * ctx, VortexChannel * channel);
+
 void                 turbulence_ppath_add_profile_attr_alias (TurbulenceCtx * ctx,
 							      const char    * profile,
 							      const char    * conn_attr);
@@ -58,8 +58,33 @@ const char * turbulence_bin_path         = NULL;
  */
 const char * turbulence_child_cmd_prefix = NULL;
 
+/** 
+ * @internal Command line arguments used to start the current master
+ * process (used to run the new binary on upgrade).
+ */
+char      ** turbulence_argv             = NULL;
+
 extern axl_bool __turbulence_module_no_unmap;
 
+#if defined(ENABLE_SIGNALFD)
+/** 
+ * @internal Macro used to lock the mutex associated to child
+ * processes. SIGCHLD is kept blocked on the master process and
+ * handled by the supervision loop (turbulence_signal_sigchld) so
+ * there is no handler to block.
+ */
+#define TBC_PROCESS_LOCK_CHILD() do {                  \
+	vortex_mutex_lock (&ctx->child_process_mutex); \
+} while (0)
+
+/** 
+ * @internal Macro used to unlock the mutex associated to child
+ * processes, undoing TBC_PROCESS_LOCK_CHILD.
+ */
+#define TBC_PROCESS_UNLOCK_CHILD() do {                  \
+	vortex_mutex_unlock (&ctx->child_process_mutex); \
+} while (0)
+#else
 /** 
  * @internal Macro used to block sigchild and lock the mutex
  * associated to child processes.
@@ -77,6 +102,20 @@ extern axl_bool __turbulence_module_no_unmap;
 	vortex_mutex_unlock (&ctx->child_process_mutex); \
 	turbulence_signal_unblock (ctx, SIGCHLD);        \
 } while (0)
+#endif
+
+/** 
+ * @internal Childs finishing abnormally before living this amount of
+ * seconds are considered failed at startup and make the master to
+ * delay (backoff) creating new childs for the same profile path.
+ */
+#define TBC_CHILD_MIN_LIFETIME 5
+
+/** 
+ * @internal Max amount of seconds that child creation is delayed
+ * for a profile path whose childs keep failing.
+ */
+#define TBC_CHILD_MAX_BACKOFF  60
 
 /** 
  * @internal Function used to init process module (for its internal
@@ -115,7 +154,7 @@ axlPointer __turbulence_process_finished (TurbulenceCtx * ctx)
 {
 	VortexCtx        * vortex_ctx = ctx->vortex_ctx;
 	int                delay      = 1000000; /* 1seg */
-	int                tries      = 30; 
+	int                tries      = ctx->child->ppath->idle_timeout; 
 
 	while (tries > 0) {
 
@@ -174,8 +213,9 @@ void turbulence_process_check_for_finish (TurbulenceCtx * ctx)
 	}
 
 	/* check if the child process was configured with a reuse
-	   flag, if not, notify exit right now */
-	if (! ctx->child->ppath->reuse) {
+	   flag (or it was retired by the master, which will not send
+	   more connections), if not, notify exit right now */
+	if (! ctx->child->ppath->reuse || ctx->child->retired) {
 	        msg ("CHILD: unlocking listener to finish: %p..", ctx->vortex_ctx);
 		/* so it is a child process without reuse flag
 		   activated, exit now */
@@ -396,6 +436,14 @@ axl_bool turbulence_process_send_socket (VORTEX_SOCKET     socket,
 	int                  rv;
 	TurbulenceCtx      * ctx = child->ctx;
 
+	/* the receiver reads up to TBC_PROCESS_ANCILLARY_MAX - 1
+	 * bytes: the rest would be read as the next message */
+	if (ancillary_data && size > TBC_PROCESS_ANCILLARY_MAX - 1) {
+		error ("PARENT: Unable to send socket %d, ancillary data too long (%d bytes, max %d)", 
+		       socket, size, TBC_PROCESS_ANCILLARY_MAX - 1);
+		return axl_false;
+	} /* end if */
+
 	/* clear structures */
 	memset (&msg_hdr, 0, sizeof (struct msghdr));
 
@@ -463,7 +511,7 @@ axl_bool turbulence_process_receive_socket (VORTEX_SOCKET    * _socket,
 {
 	struct msghdr    msg_hdr;
 	struct iovec     iov;
-	char             buf[1024];
+	char             buf[TBC_PROCESS_ANCILLARY_MAX];
 	int              status;
 	char             ccmsg[CMSG_SPACE(sizeof(int))];
 	struct           cmsghdr *cmsg;
@@ -481,7 +529,7 @@ axl_bool turbulence_process_receive_socket (VORTEX_SOCKET    * _socket,
 	ctx = child->ctx;
 	
 	iov.iov_base = buf;
-	iov.iov_len = 1023;
+	iov.iov_len = sizeof (buf) - 1;
 
 	memset (&msg_hdr, 0, sizeof (struct msghdr));	
 	msg_hdr.msg_name       = 0;
@@ -671,6 +719,9 @@ void turbulence_process_send_connection_to_child (TurbulenceCtx    * ctx,
 		return;
 	} /* end if */
 
+	/* carry the connection lifecycle trace to the child */
+	conn_status = turbulence_trace_append (ctx, conn, conn_status);
+
 	msg ("Sending connection to child already created, ancillary data ('%s') size: %d", conn_status, (int) strlen (conn_status));
 
 	/* socket that is now handled by the child process */
@@ -750,6 +801,9 @@ axl_bool turbulence_process_send_proxy_connection_to_child (TurbulenceCtx    * c
 		return axl_false;
 	} /* end if */
 
+	/* carry the connection lifecycle trace to the child */
+	conn_status = turbulence_trace_append (ctx, conn, conn_status);
+
 	msg ("PARENT: (PROXY) Sending connection to child already created, ancillary data ('%s') size: %d", conn_status, (int) strlen (conn_status));
 
 	/* send the socket descriptor to the child to avoid holding a
@@ -1049,6 +1103,9 @@ VortexConnection * __turbulence_process_handle_connection_received (TurbulenceCt
 	const char       * remote_host        = NULL;
 	const char       * remote_port        = NULL;
 	const char       * remote_host_ip     = NULL;
+	long               trace[TBC_TRACE_STAGES];
+	axl_bool           proxied;
+	TurbulencePPathDef * selected;
 
 	/* check connection status after continue */
 	if (conn_status == NULL || strlen (conn_status) == 0) {
@@ -1058,8 +1115,12 @@ VortexConnection * __turbulence_process_handle_connection_received (TurbulenceCt
 		return NULL;
 	} /* end if */
 
-	/* call to recover data from string */
+	/* call to recover data from string (trace first: the string is
+	 * modified while recovering the status) */
 	msg ("CHILD: processing conn_status received: [%s]", conn_status);
+	turbulence_trace_parse (conn_status, trace);
+	/* last field: connection proxied by the parent */
+	proxied = conn_status[strlen (conn_status) - 1] == '1';
 	turbulence_process_connection_recover_status (conn_status, 
 						      &handle_start_reply,
 						      &channel_num,
@@ -1122,6 +1183,17 @@ VortexConnection * __turbulence_process_handle_connection_received (TurbulenceCt
 	/* set profile path state */
 	__turbulence_ppath_set_state (ctx, conn, ppath_id, serverName);
 
+	/* restore connection lifecycle trace */
+	turbulence_trace_restore (ctx, conn, trace);
+
+	/* bandwidth shaping: proxied connections are shaped by the
+	 * parent, which reads them from the client */
+	selected = turbulence_ppath_selected (conn);
+	if (proxied)
+		turbulence_shaper_conn_skip (conn);
+	else if (selected && selected->max_rate > 0)
+		turbulence_shaper_conn_setup (ctx, conn, selected, selected->max_rate);
+
 	/* set TLS status */
 	if (has_tls > 0) {
 		vortex_connection_set_data (conn, "tls-fication:status", INT_TO_PTR (axl_true));
@@ -1180,6 +1252,7 @@ axl_bool turbulence_process_parent_notify (TurbulenceLoop * loop,
 	TurbulenceChild  * child          = (TurbulenceChild *) ptr;
 	char             * ancillary_data = NULL;
 	const char       * label          = ctx->child ? "CHILD" : "PARENT";
+	int                items;
 	
 	msg ("%s: notification on control connection, read content", label);
 
@@ -1213,6 +1286,24 @@ axl_bool turbulence_process_parent_notify (TurbulenceLoop * loop,
 		     label, _socket, ancillary_data[0]);
 		__turbulence_process_handle_connection_received (ctx, child->ppath, _socket, ancillary_data + 1);
 		_socket = -1; /* avoid socket be closed */
+	} else if (ancillary_data[0] == 'l' && ctx->child) {
+		/* master process was upgraded: reconnect
+		   child<->master BEEP link to the port received (the
+		   socket received is just carried by the command and
+		   closed) */
+		__turbulence_process_relink_master (ctx, child, ancillary_data + 1);
+	} else if (ancillary_data[0] == 'r' && ctx->child) {
+		/* master process retired this child (recycling): no
+		   more connections will be received, finish once
+		   current connections are closed */
+		vortex_mutex_lock (&ctx->conn_mgr_mutex);
+		ctx->child->retired = axl_true;
+		items               = axl_hash_items (ctx->conn_mgr_hash);
+		vortex_mutex_unlock (&ctx->conn_mgr_mutex);
+
+		msg ("CHILD: retired by master process, finishing once current connections (%d) are closed", items);
+		if (ctx->started && items == 0)
+			turbulence_process_check_for_finish (ctx);
 	} else {
 		msg ("%s: Unknown command, socket received (%d), ancillary data: %s", 
 		     label, _socket, ancillary_data);
@@ -1395,6 +1486,18 @@ void __turbulence_process_prepare_logging (TurbulenceCtx * ctx, axl_bool is_pare
  * @return axl_true in the case the limit was reached and the
  * connection was closed, otherwise axl_false is returned.
  */
+/** 
+ * @internal Returns axl_true if child creation for the provided
+ * profile path is delayed because its childs are failing (see
+ * turbulence_process_reap_childs).
+ */
+axl_bool __turbulence_process_backing_off (TurbulencePPathDef * def)
+{
+	if (def == NULL || def->backoff_until == 0)
+		return axl_false;
+	return time (NULL) < def->backoff_until;
+}
+
 axl_bool turbulence_process_check_child_limit (TurbulenceCtx      * ctx,
 					       VortexConnection   * conn,
 					       TurbulencePPathDef * def)
@@ -1420,6 +1523,17 @@ axl_bool turbulence_process_check_child_limit (TurbulenceCtx      * ctx,
 		return axl_true; /* limit reached */
 	} /* end if */	
 
+	/* check if childs for this profile path are failing at
+	 * startup: delay creating new ones */
+	if (__turbulence_process_backing_off (def)) {
+		error ("Childs for profile path %s are failing (%d in a row, last exit status: %d), delaying child creation %d seconds, closing conn-id=%d",
+		       def->path_name ? def->path_name : "(empty)", def->failures_in_row, def->last_exit_status,
+		       (int) (def->backoff_until - time (NULL)), vortex_connection_get_id (conn));
+
+		vortex_connection_shutdown (conn);
+		return axl_true; /* limit reached */
+	} /* end if */
+
 	/* now check profile path limits */
 	if (def && def->child_limit > 0) {
 		/* check limits */
@@ -1435,6 +1549,212 @@ axl_bool turbulence_process_check_child_limit (TurbulenceCtx      * ctx,
 	return axl_false; /* limit NOT reached */
 }
 
+/** 
+ * @internal Checks if a connection for a profile path with reuse
+ * enabled must be sent to an already created child (axl_true) or if
+ * a new child must be created because less than reuse-workers childs
+ * are running (and limits allow creating it). Must be called with the
+ * child process mutex acquired.
+ */
+axl_bool __turbulence_process_reuse_child (TurbulenceCtx * ctx, TurbulencePPathDef * def)
+{
+	/* all reused childs created (retired childs are being
+	 * replaced) */
+	if (def->childs_running - def->childs_retired >= def->reuse_workers)
+		return axl_true;
+
+	/* limits reached: reuse childs already created rather than
+	 * closing the connection */
+	if (axl_hash_items (ctx->child_process) >= ctx->global_child_limit)
+		return axl_true;
+	if (def->child_limit > 0 && def->childs_running >= def->child_limit)
+		return axl_true;
+
+	/* childs are failing at startup: keep using the ones running */
+	if (def->childs_running > 0 && __turbulence_process_backing_off (def))
+		return axl_true;
+
+	return axl_false;
+}
+
+typedef struct _TurbulenceProcessNth {
+	TurbulencePPathDef * def;
+	int                  nth;
+	TurbulenceChild    * result;
+} TurbulenceProcessNth;
+
+/** 
+ * @internal Function used by __turbulence_process_next_reused_child
+ */
+axl_bool __find_ppath_nth (axlPointer key, axlPointer data, axlPointer user_data)
+{
+	TurbulenceProcessNth * search = user_data;
+	TurbulenceChild      * child  = data;
+
+	if (turbulence_ppath_get_id (child->ppath) != turbulence_ppath_get_id (search->def) || child->retired)
+		return axl_false; /* keep foreach looping */
+
+	/* record child and stop once the nth is reached */
+	search->result = child;
+	if (search->nth == 0)
+		return axl_true; /* found key, stop foreach */
+	search->nth--;
+	return axl_false; /* keep foreach looping */
+}
+
+/** 
+ * @internal Selects the next child (round robin) among childs
+ * running for the provided profile path, to spread connections over
+ * the reuse-workers childs configured. Must be called with the child
+ * process mutex acquired.
+ */
+TurbulenceChild * __turbulence_process_next_reused_child (TurbulenceCtx * ctx, TurbulencePPathDef * def)
+{
+	TurbulenceProcessNth search;
+	int                  active = def->childs_running - def->childs_retired;
+
+	if (active <= 1)
+		return turbulence_process_get_child_from_ppath (ctx, def, axl_false);
+
+	search.def    = def;
+	search.nth    = def->reuse_next % active;
+	search.result = NULL;
+	axl_hash_foreach (ctx->child_process, __find_ppath_nth, &search);
+
+	def->reuse_next++;
+	return search.result;
+}
+
+/** 
+ * @internal Returns the resident memory (in kilobytes) used by the
+ * provided process or -1 if it can't be found.
+ */
+long __turbulence_process_get_rss (int pid)
+{
+#if defined(AXL_OS_UNIX)
+	char * path;
+	FILE * file;
+	long   size     = -1;
+	long   resident = -1;
+
+	path = axl_strdup_printf ("/proc/%d/statm", pid);
+	file = fopen (path, "r");
+	axl_free (path);
+	if (file == NULL)
+		return -1;
+	if (fscanf (file, "%ld %ld", &size, &resident) != 2)
+		resident = -1;
+	fclose (file);
+
+	if (resident < 0)
+		return -1;
+	return resident * (sysconf (_SC_PAGESIZE) / 1024);
+#else
+	return -1;
+#endif
+}
+
+/** 
+ * @internal Retires the provided child: no more connections are sent
+ * to it (it finishes once its connections are closed) and a new child
+ * is created to replace it when the next connection arrives. Must be
+ * called with the child process mutex acquired.
+ */
+void __turbulence_process_retire_child (TurbulenceCtx * ctx, TurbulenceChild * child, const char * reason)
+{
+	if (child->retired)
+		return;
+
+	msg ("PARENT: retiring child pid=%d (ppath: %s), %s", 
+	     child->pid, turbulence_ppath_get_name (child->ppath) ? turbulence_ppath_get_name (child->ppath) : "(empty)", reason);
+	child->retired = axl_true;
+	child->ppath->childs_retired++;
+
+	/* notify the child. The control protocol always carries a
+	 * descriptor: the control socket itself is sent (the child
+	 * closes its copy) */
+	if (! turbulence_process_send_socket (child->child_connection, child, "r", 1))
+		error ("PARENT: failed to notify child pid=%d it was retired, it will finish when idle", child->pid);
+	return;
+}
+
+/** 
+ * @internal Selects the cpus (and NUMA node) the provided child will
+ * be bound to according to its profile path configuration. It is
+ * applied by the child process before running the turbulence binary
+ * (the affinity is kept across exec). Must be called with the child
+ * process mutex acquired.
+ */
+void __turbulence_process_child_affinity (TurbulenceCtx * ctx, TurbulencePPathDef * def, TurbulenceChild * child)
+{
+	int nodes;
+
+	/* spread childs over NUMA nodes (round robin) */
+	if (def->numa_spread) {
+		nodes = turbulence_affinity_numa_nodes (ctx);
+		if (nodes > 1) {
+			child->numa_node = def->numa_next % nodes;
+			def->numa_next++;
+
+			/* node cpus (limited to cpu-affinity if defined) */
+			child->affinity  = turbulence_affinity_numa_cpus (ctx, child->numa_node, def->cpu_affinity);
+			if (child->affinity)
+				return;
+			wrn ("PARENT: no cpu found for NUMA node %d (cpu-affinity=%s), not spreading child", 
+			     child->numa_node, def->cpu_affinity ? def->cpu_affinity : "");
+			child->numa_node = -1;
+		} /* end if */
+	} /* end if */
+
+	if (def->cpu_affinity)
+		child->affinity = axl_strdup (def->cpu_affinity);
+	return;
+}
+
+/** 
+ * @internal Accounts a connection sent to the provided child,
+ * retiring it if max-connections-served or max-rss limits configured
+ * on its profile path are reached. Must be called with the child
+ * process mutex acquired.
+ */
+void __turbulence_process_child_served (TurbulenceCtx * ctx, TurbulenceChild * child)
+{
+	TurbulencePPathDef * def = child->ppath;
+	long                 now;
+	long                 rss;
+	char               * reason;
+
+	child->connections_served++;
+
+	/* recycling only applies to reused childs */
+	if (! def->reuse || child->retired)
+		return;
+
+	if (def->max_conn_served > 0 && child->connections_served >= def->max_conn_served) {
+		reason = axl_strdup_printf ("served %d connections (max-connections-served=%d)", 
+					    child->connections_served, def->max_conn_served);
+		__turbulence_process_retire_child (ctx, child, reason);
+		axl_free (reason);
+		return;
+	} /* end if */
+
+	if (def->max_rss > 0) {
+		/* check memory at most once per second */
+		now = time (NULL);
+		if (child->rss_stamp == now)
+			return;
+		child->rss_stamp = now;
+
+		rss = __turbulence_process_get_rss (child->pid);
+		if (rss > def->max_rss) {
+			reason = axl_strdup_printf ("using %ldK of memory (max-rss=%ldK)", rss, def->max_rss);
+			__turbulence_process_retire_child (ctx, child, reason);
+			axl_free (reason);
+		} /* end if */
+	} /* end if */
+	return;
+}
+
 axl_bool __turbulence_process_show_conn_keys (axlPointer key, axlPointer data, axlPointer user_data)
 {
 	TurbulenceCtx * ctx = user_data;
@@ -1511,6 +1831,9 @@ axl_bool __turbulence_process_send_child_init_string (TurbulenceCtx       * ctx,
 		error ("PARENT: failed to create child, unable to allocate conn status string");
 		return axl_false;
 	}
+
+	/* carry the connection lifecycle trace to the child */
+	conn_status = turbulence_trace_append (ctx, conn, conn_status);
 	msg ("PARENT: conn_status value: %s (profile path id: %d, 7th field of 16)", conn_status, turbulence_ppath_get_id (def));
 
 	/* prepare child init string: 
@@ -1655,6 +1978,11 @@ void turbulence_process_create_child (TurbulenceCtx       * ctx,
 	axl_bool           enable_debug          = axl_false;
 	/* get current proxy on parent setting */
 	axl_bool           proxy_on_parent = turbulence_conn_mgr_proxy_on_parent (conn);
+	struct timeval     start;
+	sigset_t           mask;
+
+	/* handoff start stamp (turbulence_handoff_latency_microseconds) */
+	gettimeofday (&start, NULL);
 
 	if (ctx->is_exiting) {
 		error ("Unable to create child process, turbulence is finishing..");
@@ -1696,7 +2024,9 @@ void turbulence_process_create_child (TurbulenceCtx       * ctx,
 	/* check if child associated to the given profile path is
 	   defined and if reuse flag is enabled */
 	child = turbulence_process_get_child_from_ppath (ctx, def, axl_false);
-	if (def->reuse && child) {
+	if (def->reuse && child && __turbulence_process_reuse_child (ctx, def)) {
+		/* select next reused child (round robin) */
+		child = __turbulence_process_next_reused_child (ctx, def);
 		msg ("Found child process reuse flag and child already created (%p), sending connection id=%d, frame msgno=%d",
 		     child, vortex_connection_get_id (conn), vortex_frame_get_msgno (frame));
 
@@ -1717,7 +2047,12 @@ void turbulence_process_create_child (TurbulenceCtx       * ctx,
 								     profile, profile_content,
 								     encoding, serverName, frame);
 		} /* end if */
+
+		/* account connection (child recycling) */
+		__turbulence_process_child_served (ctx, child);
 		TBC_PROCESS_UNLOCK_CHILD ();
+
+		turbulence_metric_observe (ctx->metrics_builtin[TBC_METRIC_HANDOFF_REUSE], turbulence_metrics_since (&start));
 		return;
 	}
 
@@ -1733,8 +2068,8 @@ void turbulence_process_create_child (TurbulenceCtx       * ctx,
 		msg ("PARENT: Creating a child process (first instance), proxy_on_parent=%d, conn-id=%d", 
 		     proxy_on_parent, vortex_connection_get_id (conn));
 	else
- 		msg ("PARENT: Child defined, but not reusing child processes (reuse=no flag), proxy_on_parent=%d, conn-id=%d", 
-		     proxy_on_parent, vortex_connection_get_id (conn));
+ 		msg ("PARENT: Child defined, but not reusing child processes (reuse=no flag or reuse-workers=%d not reached), proxy_on_parent=%d, conn-id=%d", 
+		     def->reuse_workers, proxy_on_parent, vortex_connection_get_id (conn));
 
 	if (turbulence_log_is_enabled (ctx)) {
 		if (pipe (general_log) != 0)
@@ -1761,6 +2096,9 @@ void turbulence_process_create_child (TurbulenceCtx       * ctx,
 		return;
 	} /* end if */
 
+	/* select cpus and NUMA node for the child */
+	__turbulence_process_child_affinity (ctx, def, child);
+
 	/* report the temporal listener prepared for the child link */
 	msg ("PARENT: created temporal listener to prepare child management connection id=%d (socket: %d): %p (refs: %d)", 
 	     vortex_connection_get_id (child->conn_mgr), vortex_connection_get_socket (child->conn_mgr),
@@ -1789,6 +2127,7 @@ void turbulence_process_create_child (TurbulenceCtx       * ctx,
 		/* update child pid and additional data */
 		child->pid = pid;
 		child->ctx = ctx;
+		turbulence_trace_mark (ctx, conn, TBC_TRACE_SPAWNED);
 
 		/* create child connection socket */
 		if (! __turbulence_process_create_child_connection (child)) {
@@ -1863,6 +2202,15 @@ void turbulence_process_create_child (TurbulenceCtx       * ctx,
 		/* register pipes to receive child logs */
 		__turbulence_process_prepare_logging (ctx, axl_true, general_log, error_log, access_log, vortex_log);
 
+		/* remember read ends to pass them to a new binary on
+		 * upgrade */
+		if (turbulence_log_is_enabled (ctx) && ! ctx->use_syslog) {
+			child->log_pipes[0] = general_log[0];
+			child->log_pipes[1] = error_log[0];
+			child->log_pipes[2] = access_log[0];
+			child->log_pipes[3] = vortex_log[0];
+		} /* end if */
+
 		/* register the child process identifier */
 		axl_hash_insert_full (ctx->child_process,
 				      /* store child pid */
@@ -1873,8 +2221,14 @@ void turbulence_process_create_child (TurbulenceCtx       * ctx,
 		/* update number of childs running this profile path */
 		def->childs_running++;
 
+		/* account connection (child recycling) */
+		__turbulence_process_child_served (ctx, child);
+
 		TBC_PROCESS_UNLOCK_CHILD ();
 
+		turbulence_metric_inc (ctx->metrics_builtin[TBC_METRIC_CHILDS_CREATED], 1);
+		turbulence_metric_observe (ctx->metrics_builtin[TBC_METRIC_HANDOFF_SPAWN], turbulence_metrics_since (&start));
+
 		/* record child */
 		msg ("PARENT=%d: Created child process pid=%d (childs: %d)", getpid (), pid, turbulence_process_child_count (ctx));
 		return;
@@ -1885,6 +2239,21 @@ void turbulence_process_create_child (TurbulenceCtx       * ctx,
 	/* reconfigure pids */
 	ctx->pid = getpid ();
 
+	/* clear the signal mask inherited from the master (SIGCHLD is
+	 * blocked there), otherwise it is kept by the binary run
+	 * below and by every process it starts */
+	sigemptyset (&mask);
+	sigprocmask (SIG_SETMASK, &mask, NULL);
+
+	/* bind to cpus and NUMA node selected (kept by the turbulence
+	 * binary run below) */
+	if (child->affinity) {
+		msg ("CHILD: binding to cpus %s (numa node: %d)", child->affinity, child->numa_node);
+		turbulence_affinity_apply (ctx, child->affinity);
+	} /* end if */
+	if (child->numa_node >= 0)
+		turbulence_affinity_numa_prefer (ctx, child->numa_node);
+
 	/* release connections received from parent (including
 	   sockets) */
 	msg ("CHILD: calling to release all (parent) connections but conn-id=%d", 
@@ -1897,7 +2266,7 @@ void turbulence_process_create_child (TurbulenceCtx       * ctx,
 	     turbulence_bin_path ? turbulence_bin_path : "", child->socket_control_path, ctx->config_path);
 
 	/* get debug was requested */
-	enable_debug = ! PTR_TO_INT (turbulence_ctx_get_data (ctx, "debug-was-not-requested"));
+	enable_debug = ! PTR_TO_INT (turbulence_ctx_slot_get (ctx, ctx->debug_not_requested_slot));
 
 	/* prepare child cmd prefix if defined */
 	if (turbulence_child_cmd_prefix) {
@@ -2007,6 +2376,39 @@ void turbulence_process_create_child (TurbulenceCtx       * ctx,
 	return;
 }
 
+axl_bool __retire_stale_child (axlPointer key, axlPointer data, axlPointer user_data)
+{
+	TurbulenceCtx   * ctx   = user_data;
+	TurbulenceChild * child = data;
+
+	/* the child was created for a profile path that is no longer
+	 * installed: removed or changed (unchanged definitions are
+	 * carried over by turbulence_ppath_install, so childs using
+	 * them keep running) */
+	if (turbulence_ppath_find_by_id (ctx, child->ppath->id) != child->ppath)
+		__turbulence_process_retire_child (ctx, child, "its profile path was replaced by a configuration reload");
+	return axl_false; /* keep on iterating */
+}
+
+/** 
+ * @internal Retires all childs created for profile paths removed or
+ * changed by a configuration reload (see turbulence_ppath_install): no new
+ * connection is sent to them and they finish once the connections
+ * they are handling are closed.
+ */
+void turbulence_process_retire_stale_childs (TurbulenceCtx * ctx)
+{
+	/* only the master process has childs */
+	if (ctx->child)
+		return;
+
+	TBC_PROCESS_LOCK_CHILD ();
+	if (ctx->child_process)
+		axl_hash_foreach (ctx->child_process, __retire_stale_child, ctx);
+	TBC_PROCESS_UNLOCK_CHILD ();
+	return;
+}
+
 #if defined(DEFINE_KILL_PROTO)
 int kill (int pid, int signal);
 #endif
@@ -2032,29 +2434,26 @@ axl_bool __terminate_child (axlPointer key, axlPointer data, axlPointer user_dat
  */ 
 void turbulence_process_kill_childs  (TurbulenceCtx * ctx)
 {
-	axlNode * node;
-	int       pid;
-	int       status;
-	int       childs;
-
-	/* get user doc */
-	node = axl_doc_get (ctx->config, "/turbulence/global-settings/kill-childs-on-exit");
-	if (node == NULL) {
-		error ("Unable to find kill-childs-on-exit node, doing nothing..");
-		return;
-	}
+	TurbulenceConfigSnapshot * snapshot;
+	axl_bool                   kill_childs;
+	int                        pid;
+	int                        status;
+	int                        childs;
 
 	/* check if we have to kill childs */
-	if (! HAS_ATTR_VALUE (node, "value", "yes")) {
+	snapshot    = turbulence_config_snapshot (ctx);
+	kill_childs = snapshot && snapshot->kill_childs_on_exit;
+	turbulence_config_snapshot_unref (snapshot);
+	if (! kill_childs) {
 		error ("leaving childs running (kill-childs-on-exit not enabled)..");
 		return;
 	} /* end if */
 
-	/* disable signal handling because we are the parent and we
+	/* disable child supervision because we are the parent and we
 	   are killing childs (we know childs are stopping). The
-	   following is to avoid races with
-	   turbulence_signal_received for SIGCHLD */
-	signal (SIGCHLD, NULL);
+	   following is to avoid races with the supervision reaping
+	   childs (turbulence_process_reap_childs) */
+	turbulence_signal_sigchld (ctx, axl_false);
 
 	/* send a kill operation to all childs */
 	childs = axl_hash_items (ctx->child_process);
@@ -2086,6 +2485,129 @@ void turbulence_process_kill_childs  (TurbulenceCtx * ctx)
 	return;
 }
 
+/** 
+ * @internal Records how the child with the provided pid finished,
+ * removing it from the list of childs running and updating profile
+ * path supervision state (used to delay child creation when childs
+ * keep failing).
+ */
+void __turbulence_process_child_finished (TurbulenceCtx * ctx, int pid, int status)
+{
+	TurbulenceChild    * child;
+	TurbulencePPathDef * def;
+	long                 now      = time (NULL);
+	long                 lifetime = -1;
+	axl_bool             failed;
+	int                  backoff;
+
+	/* a child failed if it was killed or if it finished with a
+	 * non zero exit code */
+	failed = WIFSIGNALED (status) || (WIFEXITED (status) && WEXITSTATUS (status) != 0);
+
+	/* lock to remove */
+	vortex_mutex_lock (&ctx->child_process_mutex);
+
+	/* get child to reduce childs running */
+	child = axl_hash_get (ctx->child_process, INT_TO_PTR (pid));
+	if (child == NULL) {
+		vortex_mutex_unlock (&ctx->child_process_mutex);
+		msg ("process (%d) finished with status: %d (not a child registered)", pid, status);
+		return;
+	} /* end if */
+
+	lifetime = now - child->started_stamp;
+	def      = child->ppath;
+	if (def) {
+		/* decrease number of childs running */
+		def->childs_running--;
+		if (child->retired)
+			def->childs_retired--;
+
+		/* record how it finished */
+		def->childs_finished++;
+		def->last_exit_status = status;
+		def->last_exit_stamp  = now;
+		if (failed)
+			def->childs_failed++;
+
+		/* update backoff: only childs failing shortly after
+		 * being created delay next childs */
+		if (failed && lifetime < TBC_CHILD_MIN_LIFETIME) {
+			def->failures_in_row++;
+			/* 1, 2, 4, .. seconds up to the max */
+			backoff = TBC_CHILD_MAX_BACKOFF;
+			if (def->failures_in_row <= 6)
+				backoff = 1 << (def->failures_in_row - 1);
+			def->backoff_until = now + backoff;
+		} else {
+			def->failures_in_row = 0;
+			def->backoff_until   = 0;
+		} /* end if */
+	} /* end if */
+
+	/* report */
+	if (WIFSIGNALED (status))
+		error ("child process (%d) killed by signal %d after %ld seconds running (ppath: %s)",
+		       pid, WTERMSIG (status), lifetime, (def && def->path_name) ? def->path_name : "(empty)");
+	else if (failed)
+		error ("child process (%d) finished with exit code %d after %ld seconds running (ppath: %s)",
+		       pid, WEXITSTATUS (status), lifetime, (def && def->path_name) ? def->path_name : "(empty)");
+	else
+		msg ("child process (%d) finished with status: %d after %ld seconds running",
+		     pid, status, lifetime);
+	if (def && def->backoff_until > 0)
+		wrn ("childs for profile path %s failed %d times in a row, delaying new childs %d seconds",
+		     def->path_name ? def->path_name : "(empty)", def->failures_in_row, (int) (def->backoff_until - now));
+
+	/* remove pid from list */
+	axl_hash_remove (ctx->child_process, INT_TO_PTR (pid));
+
+	/* unlock */
+	vortex_mutex_unlock (&ctx->child_process_mutex);
+
+	return;
+}
+
+/** 
+ * @brief Reaps all child processes that have finished, removing them
+ * from the list of childs running and recording how they finished.
+ *
+ * The function does not block and collects all childs finished (a
+ * single SIGCHLD notification may represent several childs).
+ *
+ * @param ctx The context where the operation will take place
+ * (master process).
+ *
+ * @return The pid of the last child reaped or 0 if no child was
+ * finished.
+ */
+int               turbulence_process_reap_childs (TurbulenceCtx * ctx)
+{
+	int pid;
+	int last   = 0;
+	int status = 0;
+
+	if (ctx == NULL)
+		return 0;
+
+	while (axl_true) {
+		pid = waitpid (-1, &status, WNOHANG);
+		if (pid <= 0) {
+			/* no more childs finished (0), no childs at all
+			 * (ECHILD) or interrupted (EINTR, try again) */
+			if (pid < 0 && errno == EINTR)
+				continue;
+			break;
+		} /* end if */
+
+		/* record child finished */
+		__turbulence_process_child_finished (ctx, pid, status);
+		last = pid;
+	} /* end while */
+
+	return last;
+}
+
 /** 
  * @brief Allows to return the number of child processes  created. 
  *
@@ -2261,7 +2783,7 @@ axl_bool __find_ppath (axlPointer key, axlPointer data, axlPointer user_data, ax
 	TurbulenceChild     * child      = data;
 	TurbulenceChild    ** result     = user_data2;
 	
-	if (turbulence_ppath_get_id (child->ppath) == turbulence_ppath_get_id (ppath)) {
+	if (turbulence_ppath_get_id (child->ppath) == turbulence_ppath_get_id (ppath) && ! child->retired) {
 		/* found child associated, updating reference and
 		   signaling to stop search */
 		(*result) = child;
@@ -2310,6 +2832,9 @@ TurbulenceChild * turbulence_process_get_child_from_ppath (TurbulenceCtx * ctx,
  */
 void turbulence_process_cleanup      (TurbulenceCtx * ctx)
 {
+	/* stop child supervision */
+	turbulence_signal_sigchld (ctx, axl_false);
+
 	vortex_mutex_destroy (&ctx->child_process_mutex);
 	axl_hash_free (ctx->child_process);
 	return;
@@ -2338,3 +2863,448 @@ void              turbulence_process_set_child_cmd_prefix (const char * cmd_pref
 	turbulence_child_cmd_prefix = cmd_prefix;
 	return;
 }
+
+/** 
+ * @internal Set the command line arguments used to start the current
+ * master process, used to run the new binary on upgrade. You must
+ * pass an static value.
+ */
+void              turbulence_process_set_argv (char ** argv)
+{
+	turbulence_argv = argv;
+	return;
+}
+
+#if defined(AXL_OS_UNIX)
+/** 
+ * @internal Adds the provided descriptor into the set of descriptors
+ * that must survive the exec done on upgrade.
+ */
+void __turbulence_process_upgrade_keep (int ** keep, int * keep_num, int * keep_size, int descriptor)
+{
+	int * aux;
+
+	if (descriptor < 0)
+		return;
+
+	/* expand the set when required */
+	if ((*keep_num) == (*keep_size)) {
+		(*keep_size) = (*keep_size) == 0 ? 32 : (*keep_size) * 2;
+		aux = axl_realloc (*keep, sizeof (int) * (*keep_size));
+		if (aux == NULL)
+			return;
+		(*keep) = aux;
+	} /* end if */
+
+	(*keep)[(*keep_num)] = descriptor;
+	(*keep_num)++;
+
+	/* close on exec flag is cleared once all descriptors are
+	 * flagged (see turbulence_process_upgrade) */
+	return;
+}
+
+/** 
+ * @internal Appends the provided item to the upgrade string.
+ */
+void __turbulence_process_upgrade_append (char ** upgrade, char * item)
+{
+	char * aux = (*upgrade);
+
+	if (aux == NULL) {
+		(*upgrade) = item;
+		return;
+	} /* end if */
+
+	(*upgrade) = axl_strdup_printf ("%s;_;%s", aux, item);
+	axl_free (aux);
+	axl_free (item);
+	return;
+}
+#endif
+
+/** 
+ * @brief Replaces the current master process with the binary found
+ * at the path used to start it (usually a new version installed),
+ * without closing listeners and without stopping childs.
+ *
+ * Listener sockets, child control sockets and child log pipes are
+ * inherited by the new binary through exec. The new binary (started
+ * with --upgrade) keeps accepting on the same sockets and adopts
+ * running childs, which reconnect their child<->master BEEP link to
+ * it. Connections handled by the master process itself are closed,
+ * including connections proxied by the master for childs running
+ * with proxy-on-parent (the proxy runs inside the master image, so
+ * the child keeps running but those clients must reconnect).
+ *
+ * This function is called when SIGUSR2 is received by the master
+ * process, from the thread serving deferred signals (never inside
+ * the signal handler: it stops the child supervision loop, which
+ * joins its thread).
+ *
+ * @param ctx The turbulence context (master process).
+ *
+ * @return The function only returns (axl_false) if the upgrade
+ * failed and the current process keeps running.
+ */
+axl_bool          turbulence_process_upgrade (TurbulenceCtx * ctx)
+{
+#if defined(AXL_OS_UNIX)
+	char                     * upgrade   = NULL;
+	int                      * keep      = NULL;
+	int                        keep_num  = 0;
+	int                        keep_size = 0;
+	char                    ** argv;
+	int                        argc;
+	int                        iterator;
+	int                        fd;
+	int                        max_fd;
+	TurbulenceListenerSocket * listener;
+	TurbulenceChild          * child;
+	axlList                  * childs;
+	DIR                      * dir;
+	struct dirent            * entry;
+
+	/* only master processes can be upgraded */
+	if (ctx == NULL || ctx->child || turbulence_argv == NULL || turbulence_bin_path == NULL) {
+		error ("upgrade requested but it is not supported by this process (child or missing command line)");
+		return axl_false;
+	} /* end if */
+
+	if (ctx->listener_sockets == NULL || axl_list_length (ctx->listener_sockets) == 0) {
+		error ("upgrade requested but no listener socket was found, ignoring upgrade");
+		return axl_false;
+	} /* end if */
+
+	msg ("starting binary upgrade (pid: %d, binary: %s)..", getpid (), turbulence_bin_path);
+
+	/* listeners: l;-;socket;-;host;-;port */
+	iterator = 0;
+	while (iterator < axl_list_length (ctx->listener_sockets)) {
+		listener = axl_list_get_nth (ctx->listener_sockets, iterator);
+		__turbulence_process_upgrade_keep (&keep, &keep_num, &keep_size, listener->socket);
+		__turbulence_process_upgrade_append (&upgrade, axl_strdup_printf ("l;-;%d;-;%s;-;%s", 
+										   listener->socket, listener->host, listener->port));
+		iterator++;
+	} /* end while */
+
+	/* avoid childs finishing during the upgrade to be reaped by
+	 * this image (the new binary will do it) */
+	turbulence_signal_sigchld (ctx, axl_false);
+
+	/* childs: c;-;pid;-;ppath-id;-;control-socket;-;general;-;error;-;access;-;vortex */
+	childs = turbulence_process_child_list (ctx);
+	iterator = 0;
+	while (childs && iterator < axl_list_length (childs)) {
+		child = axl_list_get_nth (childs, iterator);
+		__turbulence_process_upgrade_keep (&keep, &keep_num, &keep_size, child->child_connection);
+		for (fd = 0; fd < 4; fd++)
+			__turbulence_process_upgrade_keep (&keep, &keep_num, &keep_size, child->log_pipes[fd]);
+		__turbulence_process_upgrade_append (&upgrade, axl_strdup_printf ("c;-;%d;-;%d;-;%d;-;%d;-;%d;-;%d;-;%d",
+										   child->pid, turbulence_ppath_get_id (child->ppath),
+										   child->child_connection, 
+										   child->log_pipes[0], child->log_pipes[1], 
+										   child->log_pipes[2], child->log_pipes[3]));
+		iterator++;
+	} /* end while */
+	axl_list_free (childs);
+
+	/* close on exec the rest of descriptors (connections handled
+	 * by the master, master<->child links, log files, ...): flag
+	 * all of them and then clear the flag on those kept */
+	dir = opendir ("/proc/self/fd");
+	if (dir != NULL) {
+		while ((entry = readdir (dir)) != NULL) {
+			fd = atoi (entry->d_name);
+			if (fd > 2)
+				fcntl (fd, F_SETFD, FD_CLOEXEC);
+		} /* end while */
+		closedir (dir);
+	} else {
+		/* no /proc: check every possible descriptor */
+		max_fd = sysconf (_SC_OPEN_MAX);
+		for (fd = 3; fd < max_fd; fd++)
+			fcntl (fd, F_SETFD, FD_CLOEXEC);
+	} /* end if */
+	for (iterator = 0; iterator < keep_num; iterator++)
+		fcntl (keep[iterator], F_SETFD, fcntl (keep[iterator], F_GETFD) & ~FD_CLOEXEC);
+
+	/* build new command line: same arguments without --detach
+	 * (the pid must be kept so childs are still ours) and
+	 * without previous --upgrade values */
+	argc = 0;
+	while (turbulence_argv[argc])
+		argc++;
+	argv     = axl_new (char *, argc + 3);
+	iterator = 0;
+	for (fd = 0; fd < argc; fd++) {
+		if (axl_cmp (turbulence_argv[fd], "--detach"))
+			continue;
+		if (axl_cmp (turbulence_argv[fd], "--upgrade")) {
+			fd++;
+			continue;
+		} /* end if */
+		argv[iterator] = turbulence_argv[fd];
+		iterator++;
+	} /* end for */
+	argv[iterator]     = "--upgrade";
+	argv[iterator + 1] = upgrade;
+	argv[iterator + 2] = NULL;
+
+	msg ("running new binary %s with --upgrade %s", turbulence_bin_path, upgrade);
+	execvp (turbulence_bin_path, argv);
+
+	/* exec failed, keep running */
+	error ("binary upgrade failed, unable to run %s, error found was: %d: errno: %s", 
+	       turbulence_bin_path, errno, vortex_errno_get_last_error ());
+	for (iterator = 0; iterator < keep_num; iterator++)
+		fcntl (keep[iterator], F_SETFD, FD_CLOEXEC);
+	turbulence_signal_sigchld (ctx, axl_true);
+	axl_free (argv);
+	axl_free (upgrade);
+	axl_free (keep);
+	return axl_false;
+#else
+	error ("binary upgrade is not supported on this platform");
+	return axl_false;
+#endif
+}
+
+/** 
+ * @internal Called by the new binary started by
+ * turbulence_process_upgrade to record listeners and childs
+ * inherited (from the --upgrade value) so they are adopted once the
+ * configuration is loaded.
+ */
+void              turbulence_process_upgrade_prepare (TurbulenceCtx * ctx, const char * upgrade)
+{
+	char                    ** items;
+	char                    ** fields;
+	TurbulenceListenerSocket * listener;
+	int                        iterator;
+
+	if (upgrade == NULL)
+		return;
+
+	/* signals blocked by the previous image while running the
+	 * upgrade are still blocked after exec (SIGCHLD is kept
+	 * blocked when it is received through a signalfd) */
+#if !defined(ENABLE_SIGNALFD)
+	turbulence_signal_unblock (ctx, SIGCHLD);
+#endif
+#if defined(AXL_OS_UNIX)
+	turbulence_signal_unblock (ctx, SIGUSR2);
+#endif
+
+	items = axl_split (upgrade, 1, ";_;");
+	if (items == NULL)
+		return;
+
+	ctx->inherited_listeners = axl_list_new (axl_list_always_return_1, __turbulence_run_listener_socket_free);
+	ctx->inherited_childs    = axl_list_new (axl_list_always_return_1, (axlDestroyFunc) axl_freev);
+
+	iterator = 0;
+	while (items[iterator]) {
+		fields = axl_split (items[iterator], 1, ";-;");
+		if (fields && fields[0] && axl_cmp (fields[0], "l") && axl_split_count (fields) == 4) {
+			/* inherited listener */
+			listener         = axl_new (TurbulenceListenerSocket, 1);
+			listener->socket = atoi (fields[1]);
+			listener->host   = axl_strdup (fields[2]);
+			listener->port   = axl_strdup (fields[3]);
+			axl_list_append (ctx->inherited_listeners, listener);
+			axl_freev (fields);
+		} else if (fields && fields[0] && axl_cmp (fields[0], "c") && axl_split_count (fields) == 8) {
+			/* inherited child */
+			axl_list_append (ctx->inherited_childs, fields);
+		} else {
+			error ("skipping wrong upgrade item received: %s", items[iterator]);
+			axl_freev (fields);
+		} /* end if */
+		iterator++;
+	} /* end while */
+	axl_freev (items);
+
+	msg ("upgrade: inherited %d listener sockets and %d childs from previous binary", 
+	     axl_list_length (ctx->inherited_listeners), axl_list_length (ctx->inherited_childs));
+	return;
+}
+
+/** 
+ * @internal Takes an inherited listener socket bound to the provided
+ * host and port.
+ *
+ * @return The socket or -1 if no more sockets are pending for the
+ * provided host and port.
+ */
+int               turbulence_process_upgrade_take_listener (TurbulenceCtx * ctx, const char * host, const char * port)
+{
+	TurbulenceListenerSocket * listener;
+	int                        iterator;
+	int                        _socket;
+
+	if (ctx->inherited_listeners == NULL)
+		return -1;
+
+	iterator = 0;
+	while (iterator < axl_list_length (ctx->inherited_listeners)) {
+		listener = axl_list_get_nth (ctx->inherited_listeners, iterator);
+		if (axl_cmp (listener->host, host) && axl_cmp (listener->port, port)) {
+			_socket = listener->socket;
+			axl_list_remove_at (ctx->inherited_listeners, iterator);
+			return _socket;
+		} /* end if */
+		iterator++;
+	} /* end while */
+
+	return -1;
+}
+
+/** 
+ * @internal Adopts childs inherited from a previous binary: they are
+ * registered as childs of this process and asked to reconnect their
+ * child<->master BEEP link. Inherited listeners no longer configured
+ * are closed.
+ */
+void              turbulence_process_upgrade_adopt_childs (TurbulenceCtx * ctx)
+{
+#if defined(AXL_OS_UNIX)
+	TurbulenceListenerSocket  * listener;
+	TurbulenceChild           * child;
+	TurbulencePPathDef        * def;
+	char                     ** fields;
+	char                      * command;
+	int                         iterator;
+	int                         pid;
+	int                         status;
+	int                         control;
+	int                         log_pipes[4];
+	int                         log_types[4] = {LOG_REPORT_GENERAL, LOG_REPORT_ERROR, LOG_REPORT_ACCESS, LOG_REPORT_VORTEX};
+	int                         fd;
+
+	/* close listeners not configured anymore */
+	iterator = 0;
+	while (ctx->inherited_listeners && iterator < axl_list_length (ctx->inherited_listeners)) {
+		listener = axl_list_get_nth (ctx->inherited_listeners, iterator);
+		wrn ("upgrade: closing inherited listener %s:%s (socket: %d), not found in current configuration", 
+		     listener->host, listener->port, listener->socket);
+		vortex_close_socket (listener->socket);
+		iterator++;
+	} /* end while */
+	axl_list_free (ctx->inherited_listeners);
+	ctx->inherited_listeners = NULL;
+
+	iterator = 0;
+	while (ctx->inherited_childs && iterator < axl_list_length (ctx->inherited_childs)) {
+		fields  = axl_list_get_nth (ctx->inherited_childs, iterator);
+		iterator++;
+		pid     = atoi (fields[1]);
+		control = atoi (fields[3]);
+		for (fd = 0; fd < 4; fd++)
+			log_pipes[fd] = atoi (fields[4 + fd]);
+
+		/* check the child is still running (it may have
+		 * finished during the upgrade) */
+		status = 0;
+		def    = turbulence_ppath_find_by_id (ctx, atoi (fields[2]));
+		if (waitpid (pid, &status, WNOHANG) == pid || def == NULL) {
+			if (def == NULL) {
+				error ("upgrade: unable to adopt child %d, profile path id=%s not found, finishing it", pid, fields[2]);
+				kill (pid, SIGTERM);
+			} else
+				wrn ("upgrade: child %d finished during upgrade (status: %d)", pid, status);
+			vortex_close_socket (control);
+			for (fd = 0; fd < 4; fd++) {
+				if (log_pipes[fd] >= 0)
+					vortex_close_socket (log_pipes[fd]);
+			} /* end for */
+			continue;
+		} /* end if */
+
+		/* create child object (this also starts a new master
+		 * listener for the child<->master BEEP link) */
+		child = turbulence_child_new (ctx, def);
+		if (child == NULL) {
+			error ("upgrade: unable to create child object to adopt child %d, finishing it", pid);
+			kill (pid, SIGTERM);
+			vortex_close_socket (control);
+			continue;
+		} /* end if */
+		child->pid              = pid;
+		child->child_connection = control;
+		fcntl (control, F_SETFD, FD_CLOEXEC);
+
+		/* register log pipes */
+		for (fd = 0; fd < 4; fd++) {
+			if (log_pipes[fd] < 0)
+				continue;
+			fcntl (log_pipes[fd], F_SETFD, FD_CLOEXEC);
+			child->log_pipes[fd] = log_pipes[fd];
+			turbulence_log_manager_register (ctx, log_types[fd], log_pipes[fd]);
+		} /* end for */
+
+		/* register child */
+		TBC_PROCESS_LOCK_CHILD ();
+		axl_hash_insert_full (ctx->child_process,
+				      INT_TO_PTR (pid), NULL,
+				      child, (axlDestroyFunc) turbulence_child_unref);
+		def->childs_running++;
+		TBC_PROCESS_UNLOCK_CHILD ();
+
+		/* ask the child to reconnect its BEEP link. The
+		 * control protocol always carries a descriptor: the
+		 * control socket itself is sent (the child closes its
+		 * copy) */
+		command = axl_strdup_printf ("l%s", vortex_connection_get_port (child->conn_mgr));
+		if (! turbulence_process_send_socket (child->child_connection, child, command, strlen (command))) 
+			error ("upgrade: failed to ask child %d to reconnect its child<->master BEEP link", pid);
+		else
+			msg ("upgrade: adopted child %d (ppath: %s), child<->master BEEP link moved to port %s", 
+			     pid, turbulence_ppath_get_name (def), vortex_connection_get_port (child->conn_mgr));
+		axl_free (command);
+	} /* end while */
+
+	/* start supervising childs adopted */
+	if (ctx->inherited_childs)
+		turbulence_signal_sigchld (ctx, axl_true);
+	axl_list_free (ctx->inherited_childs);
+	ctx->inherited_childs = NULL;
+#endif
+	return;
+}
+
+/** 
+ * @internal Child side: reconnects the child<->master BEEP link to
+ * the provided port (sent by a master adopting this child after an
+ * upgrade).
+ */
+void __turbulence_process_relink_master (TurbulenceCtx * ctx, TurbulenceChild * child, const char * port)
+{
+	VortexConnection * conn_mgr;
+
+	msg ("CHILD: master process was upgraded, reconnecting child<->master BEEP link to %s:%s", 
+	     child->init_string_items[12], port);
+
+	conn_mgr = vortex_connection_new (ctx->vortex_ctx, child->init_string_items[12], port, NULL, NULL);
+	if (! vortex_connection_is_ok (conn_mgr, axl_false)) {
+		error ("CHILD: failed to reconnect master<->child BEEP link to %s:%s, error reported %s (code: %d)..",
+		       child->init_string_items[12], port,
+		       vortex_connection_get_message (conn_mgr), vortex_connection_get_status (conn_mgr));
+		vortex_connection_close (conn_mgr);
+		return;
+	} /* end if */
+	turbulence_conn_mgr_unregister (ctx, conn_mgr);
+
+	/* release previous link (closed by the previous master) and
+	 * replace it */
+	vortex_connection_shutdown (child->conn_mgr);
+	vortex_connection_close (child->conn_mgr);
+	child->conn_mgr = conn_mgr;
+
+	/* remember the port for later upgrades */
+	axl_free (child->init_string_items[13]);
+	child->init_string_items[13] = axl_strdup (port);
+
+	msg ("CHILD: child<->master BEEP link reconnected..OK");
+	return;
+}
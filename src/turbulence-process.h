@@ -39,6 +39,13 @@
 
 #include <turbulence.h>
 
+/** 
+ * @internal Maximum size (including the NUL terminator) of the data
+ * sent along with a socket passed to a child (connection status
+ * string, see turbulence_process_send_socket).
+ */
+#define TBC_PROCESS_ANCILLARY_MAX (4096)
+
 void              turbulence_process_init         (TurbulenceCtx * ctx, 
 						   axl_bool        reinit);
 
@@ -57,6 +64,8 @@ void              turbulence_process_kill_childs  (TurbulenceCtx * ctx);
 
 int               turbulence_process_child_count  (TurbulenceCtx * ctx);
 
+int               turbulence_process_reap_childs  (TurbulenceCtx * ctx);
+
 axlList         * turbulence_process_child_list (TurbulenceCtx * ctx);
 
 TurbulenceChild * turbulence_process_child_by_id (TurbulenceCtx * ctx, int pid);
@@ -84,6 +93,25 @@ void              turbulence_process_set_file_path (const char * path);
 
 void              turbulence_process_set_child_cmd_prefix (const char * cmd_prefix);
 
+void              turbulence_process_set_argv (char ** argv);
+
+axl_bool          turbulence_process_upgrade (TurbulenceCtx * ctx);
+
+void              turbulence_process_upgrade_prepare (TurbulenceCtx * ctx, 
+						      const char    * upgrade);
+
+int               turbulence_process_upgrade_take_listener (TurbulenceCtx * ctx, 
+							    const char    * host, 
+							    const char    * port);
+
+void              turbulence_process_upgrade_adopt_childs (TurbulenceCtx * ctx);
+
+void              turbulence_process_retire_stale_childs (TurbulenceCtx * ctx);
+
+void              __turbulence_process_relink_master (TurbulenceCtx   * ctx, 
+						      TurbulenceChild * child, 
+						      const char      * port);
+
 axl_bool          __turbulence_process_create_parent_connection (TurbulenceChild * child);
 
 void              __turbulence_process_close_log_pipes (int * general_log,
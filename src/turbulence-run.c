@@ -41,6 +41,11 @@
 /* include inline dtd */
 #include <mod-turbulence.dtd.h>
 
+#if defined(AXL_OS_UNIX)
+#include <netdb.h>
+#include <fcntl.h>
+#endif
+
 /** 
  * \defgroup turbulence_run Turbulence runtime: runtime checkings 
  */
@@ -234,14 +239,371 @@ void turbulence_run_load_modules (TurbulenceCtx * ctx, axlDoc * doc)
 	return;
 }
 
+#if defined(AXL_OS_UNIX) && defined(SO_REUSEPORT)
+/** 
+ * @internal Creates a listening socket on the provided host and port
+ * with SO_REUSEPORT enabled so several sockets can be bound to the
+ * same address (the kernel load balances incoming connections
+ * between them).
+ *
+ * @return The socket created or -1 if it fails.
+ */
+VORTEX_SOCKET __turbulence_run_reuseport_socket (TurbulenceCtx * ctx, const char * host, const char * port)
+{
+	struct addrinfo   hints;
+	struct addrinfo * result = NULL;
+	VORTEX_SOCKET     _socket;
+	int               value  = 1;
+	int               backlog = 50;
+
+	memset (&hints, 0, sizeof (struct addrinfo));
+	hints.ai_family   = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags    = AI_PASSIVE;
+	if (getaddrinfo (host, port, &hints, &result) != 0 || result == NULL) {
+		error ("unable to resolve listener address %s:%s", host, port);
+		return -1;
+	} /* end if */
+
+	_socket = socket (result->ai_family, result->ai_socktype, result->ai_protocol);
+	if (_socket < 0) {
+		error ("unable to create listener socket for %s:%s, error was (code: %d) %s", 
+		       host, port, errno, vortex_errno_get_last_error ());
+		freeaddrinfo (result);
+		return -1;
+	} /* end if */
+
+	/* allow several sockets on the same port and do not leak
+	 * them into childs */
+	setsockopt (_socket, SOL_SOCKET, SO_REUSEADDR, &value, sizeof (value));
+	if (setsockopt (_socket, SOL_SOCKET, SO_REUSEPORT, &value, sizeof (value)) != 0) {
+		error ("unable to enable SO_REUSEPORT on listener socket for %s:%s, error was (code: %d) %s", 
+		       host, port, errno, vortex_errno_get_last_error ());
+		goto failed;
+	} /* end if */
+	fcntl (_socket, F_SETFD, FD_CLOEXEC);
+
+	if (bind (_socket, result->ai_addr, result->ai_addrlen) != 0) {
+		error ("unable to bind listener socket to %s:%s, error was (code: %d) %s", 
+		       host, port, errno, vortex_errno_get_last_error ());
+		goto failed;
+	} /* end if */
+
+	/* use same backlog configured for vortex listeners */
+	vortex_conf_get (TBC_VORTEX_CTX (ctx), VORTEX_LISTENER_BACKLOG, &backlog);
+	if (listen (_socket, backlog) != 0) {
+		error ("unable to listen on socket for %s:%s, error was (code: %d) %s", 
+		       host, port, errno, vortex_errno_get_last_error ());
+		goto failed;
+	} /* end if */
+
+	/* accepts are done until the queue is empty */
+	fcntl (_socket, F_SETFL, fcntl (_socket, F_GETFL, 0) | O_NONBLOCK);
+	
+	freeaddrinfo (result);
+	return _socket;
+ failed:
+	vortex_close_socket (_socket);
+	freeaddrinfo (result);
+	return -1;
+}
+
+#endif
+
+#if defined(AXL_OS_UNIX)
+/** 
+ * @internal Max number of connections accepted on each acceptor
+ * notification before returning to the loop.
+ */
+#define TBC_ACCEPTOR_BATCH 64
+
+/** 
+ * @internal Read handler used by each acceptor loop: accepts all
+ * connections pending on the listener socket and hands them to
+ * vortex as if they were accepted by a vortex listener.
+ */
+axl_bool __turbulence_run_acceptor_on_read (TurbulenceLoop * loop, 
+					    TurbulenceCtx  * ctx,
+					    int              descriptor, 
+					    axlPointer       ptr, 
+					    axlPointer       ptr2)
+{
+	VORTEX_SOCKET             _socket;
+	VortexConnection        * conn;
+	struct sockaddr_storage   address;
+	socklen_t                 address_len;
+	char                      host[NI_MAXHOST];
+	char                      port[NI_MAXSERV];
+	int                       iterator = 0;
+
+	while (iterator < TBC_ACCEPTOR_BATCH) {
+		address_len = sizeof (address);
+		_socket     = accept (descriptor, (struct sockaddr *) &address, &address_len);
+		if (_socket < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED) 
+				error ("failed to accept connection on listener socket %d, error was (code: %d) %s", 
+				       descriptor, errno, vortex_errno_get_last_error ());
+			break;
+		} /* end if */
+		iterator++;
+
+		/* do not accept connections while finishing */
+		if (ctx->is_exiting) {
+			vortex_close_socket (_socket);
+			continue;
+		} /* end if */
+
+		/* accepted socket must not be inherited by childs
+		 * (they receive it through handoff) */
+		fcntl (_socket, F_SETFD, FD_CLOEXEC);
+
+		conn = vortex_connection_new_empty (TBC_VORTEX_CTX (ctx), _socket, VortexRoleListener);
+		if (conn == NULL) {
+			error ("unable to create connection object for socket %d accepted", _socket);
+			vortex_close_socket (_socket);
+			continue;
+		} /* end if */
+
+		/* configure remote host and port */
+		if (getnameinfo ((struct sockaddr *) &address, address_len, host, sizeof (host), 
+				 port, sizeof (port), NI_NUMERICHOST | NI_NUMERICSERV) == 0)
+			vortex_connection_set_host_and_port (conn, host, port, host);
+
+		/* send greetings and register into the vortex reader
+		 * (this runs all on accept handlers installed) */
+		vortex_connection_set_close_socket (conn, axl_true);
+		vortex_listener_accept_connection (conn, axl_true);
+	} /* end while */
+
+	/* keep watching the listener socket */
+	return axl_true;
+}
+
+/** 
+ * @internal Releases an acceptor loop (closing its listener socket).
+ */
+void __turbulence_run_acceptor_close (axlPointer loop)
+{
+	turbulence_loop_close (loop, axl_true);
+	return;
+}
+#endif
+
+/** 
+ * @internal Releases a listener socket record (the socket is owned
+ * by vortex or by an acceptor loop, so it is not closed here).
+ */
+void __turbulence_run_listener_socket_free (axlPointer _listener)
+{
+	TurbulenceListenerSocket * listener = _listener;
+
+	axl_free (listener->host);
+	axl_free (listener->port);
+	axl_free (listener);
+	return;
+}
+
+/** 
+ * @internal Records a listening socket started so it can be passed
+ * to a new binary on upgrade (see turbulence_process_upgrade).
+ */
+void __turbulence_run_register_listener_socket (TurbulenceCtx    * ctx, 
+						 int                _socket, 
+						 const char       * host, 
+						 const char       * port,
+						 VortexConnection * conn_listener,
+						 TurbulenceLoop   * acceptor)
+{
+	TurbulenceListenerSocket * listener;
+
+	if (ctx->listener_sockets == NULL)
+		ctx->listener_sockets = axl_list_new (axl_list_always_return_1, __turbulence_run_listener_socket_free);
+
+	listener           = axl_new (TurbulenceListenerSocket, 1);
+	listener->socket   = _socket;
+	listener->host     = axl_strdup (host);
+	listener->port     = axl_strdup (port);
+	listener->listener = conn_listener;
+	listener->acceptor = acceptor;
+	axl_list_append (ctx->listener_sockets, listener);
+	return;
+}
+
+/** 
+ * @internal Starts an acceptor loop (thread) watching the provided
+ * listener socket.
+ */
+axl_bool __turbulence_run_watch_acceptor (TurbulenceCtx * ctx, VORTEX_SOCKET _socket, const char * host, const char * port)
+{
+#if defined(AXL_OS_UNIX)
+	TurbulenceLoop * loop;
+
+	/* init acceptors list */
+	if (ctx->acceptors == NULL)
+		ctx->acceptors = axl_list_new (axl_list_always_return_1, __turbulence_run_acceptor_close);
+
+	/* create an acceptor loop for this socket */
+	loop = turbulence_loop_create (ctx);
+	if (loop == NULL) 
+		return axl_false;
+	axl_list_append (ctx->acceptors, loop);
+	turbulence_loop_watch_descriptor (loop, _socket, __turbulence_run_acceptor_on_read, NULL, NULL);
+
+	/* record it for upgrades */
+	__turbulence_run_register_listener_socket (ctx, _socket, host, port, NULL, loop);
+	return axl_true;
+#else
+	return axl_false;
+#endif
+}
+
+/** 
+ * @internal Watches all listener sockets inherited from a previous
+ * binary for the provided host and port (see
+ * turbulence_process_upgrade).
+ *
+ * @return axl_true if at least one socket was adopted.
+ */
+axl_bool __turbulence_run_adopt_listeners (TurbulenceCtx * ctx, const char * host, const char * port)
+{
+	VORTEX_SOCKET _socket;
+	axl_bool      adopted = axl_false;
+
+	while ((_socket = turbulence_process_upgrade_take_listener (ctx, host, port)) >= 0) {
+#if defined(AXL_OS_UNIX)
+		/* accepts are done until the queue is empty */
+		fcntl (_socket, F_SETFL, fcntl (_socket, F_GETFL, 0) | O_NONBLOCK);
+		fcntl (_socket, F_SETFD, FD_CLOEXEC);
+#endif
+		if (! __turbulence_run_watch_acceptor (ctx, _socket, host, port)) {
+			vortex_close_socket (_socket);
+			continue;
+		} /* end if */
+		msg ("adopted listener at %s:%s (socket: %d) inherited from previous binary", host, port, _socket);
+		adopted = axl_true;
+	} /* end while */
+
+	return adopted;
+}
+
+/** 
+ * @internal Starts the number of SO_REUSEPORT listener sockets
+ * requested on the provided host and port, each one with its own
+ * acceptor loop (thread).
+ *
+ * @return axl_false if no socket was started (caller falls back to a
+ * vortex listener).
+ */
+axl_bool __turbulence_run_start_acceptors (TurbulenceCtx * ctx, const char * host, const char * port, int acceptors)
+{
+#if defined(AXL_OS_UNIX) && defined(SO_REUSEPORT)
+	VORTEX_SOCKET    _socket;
+	int              iterator;
+	int              started = 0;
+
+	for (iterator = 0; iterator < acceptors; iterator++) {
+		_socket = __turbulence_run_reuseport_socket (ctx, host, port);
+		if (_socket < 0)
+			break;
+
+		/* create an acceptor loop for this socket */
+		if (! __turbulence_run_watch_acceptor (ctx, _socket, host, port)) {
+			vortex_close_socket (_socket);
+			break;
+		} /* end if */
+		started++;
+
+		msg ("started listener at %s:%s (acceptor: %d, socket: %d, SO_REUSEPORT)...", host, port, iterator, _socket);
+	} /* end for */
+
+	if (started > 0 && started < acceptors) 
+		wrn ("only %d of %d acceptors were started at %s:%s", started, acceptors, host, port);
+
+	return started > 0;
+#else
+	wrn ("SO_REUSEPORT is not supported on this platform, ignoring acceptors=%d for %s:%s", acceptors, host, port);
+	return axl_false;
+#endif
+}
+
+/** 
+ * @internal Starts listening on the provided host and port: sockets
+ * inherited from a previous binary are adopted, otherwise the number
+ * of acceptors requested are started (or a vortex listener).
+ *
+ * @return axl_true if the host and port are being listened.
+ */
+axl_bool __turbulence_run_start_listener (TurbulenceCtx * ctx, const char * host, const char * port, int acceptors)
+{
+	VortexConnection * conn_listener;
+
+	/* reuse sockets inherited from a previous binary
+	 * (upgrade) instead of opening new ones */
+	if (__turbulence_run_adopt_listeners (ctx, host, port)) 
+		return axl_true;
+
+	/* start several sockets on the same port if requested */
+	if (acceptors > 1) {
+		if (__turbulence_run_start_acceptors (ctx, host, port, acceptors)) 
+			return axl_true;
+		wrn ("unable to start acceptors at %s:%s, falling back to a single listener", host, port);
+	} /* end if */
+
+	/* start the listener */
+	conn_listener = vortex_listener_new (
+		/* the context where the listener will
+		 * be started */
+		TBC_VORTEX_CTX (ctx),
+		/* listener name */
+		host,
+		/* port to use */
+		port,
+		/* on ready callbacks */
+		NULL, NULL);
+			
+	/* check the listener started */
+	if (! vortex_connection_is_ok (conn_listener, axl_false)) {
+		/* unable to start the server configuration */
+		error ("unable to start listener at %s:%s...", host, port);
+		return axl_false;
+	} /* end if */
+
+	msg ("started listener at %s:%s (id: %d, socket: %d)...",
+	     host, port, vortex_connection_get_id (conn_listener), vortex_connection_get_socket (conn_listener));
+
+	/* record it for upgrades */
+	__turbulence_run_register_listener_socket (ctx, vortex_connection_get_socket (conn_listener),
+						   host, port, conn_listener, NULL);
+	return axl_true;
+}
+
+/** 
+ * @internal Returns the number of acceptors declared at the provided
+ * <listener> node.
+ */
+int __turbulence_run_get_acceptors (TurbulenceCtx * ctx, axlNode * listener)
+{
+	int acceptors = 1;
+
+	/* get number of SO_REUSEPORT sockets per port */
+	if (HAS_ATTR (listener, "acceptors")) {
+		acceptors = atoi (ATTR_VALUE (listener, "acceptors"));
+		if (acceptors < 1) {
+			wrn ("found acceptors=%s on listener declaration, using 1", ATTR_VALUE (listener, "acceptors"));
+			acceptors = 1;
+		} /* end if */
+	} /* end if */
+
+	return acceptors;
+}
+
 axl_bool turbulence_run_config_start_listeners (TurbulenceCtx * ctx, axlDoc * doc)
 {
 	axlNode          * listener;
 	axl_bool           at_least_one_listener = axl_false;
 	axlNode          * name;
 	axlNode          * port;
-	VortexConnection * conn_listener;
-	VortexCtx        * vortex_ctx = turbulence_ctx_get_vortex_ctx (ctx);
+	int                acceptors;
 
 	/* check if this is a child process (it has no listeners, only
 	 * master process do) */
@@ -254,44 +616,20 @@ axl_bool turbulence_run_config_start_listeners (TurbulenceCtx * ctx, axlDoc * do
 
 		/* get the listener name configuration */
 		name = axl_node_get_child_called (listener, "name");
+
+		/* get number of SO_REUSEPORT sockets per port */
+		acceptors = __turbulence_run_get_acceptors (ctx, listener);
 		
 		/* get ports to be allocated */
 		port = axl_doc_get (doc, "/turbulence/global-settings/ports/port");
 		while (port != NULL) {
 
-			/* start the listener */
-			conn_listener = vortex_listener_new (
-				/* the context where the listener will
-				 * be started */
-				vortex_ctx,
-				/* listener name */
-				axl_node_get_content (name, NULL),
-				/* port to use */
-				axl_node_get_content (port, NULL),
-				/* on ready callbacks */
-				NULL, NULL);
-			
-			/* check the listener started */
-			if (! vortex_connection_is_ok (conn_listener, axl_false)) {
-				/* unable to start the server configuration */
-				error ("unable to start listener at %s:%s...", 
-				       /* server name */
-				       axl_node_get_content (name, NULL),
-				       /* server port */
-				       axl_node_get_content (port, NULL));
-
-				goto next;
-			} /* end if */
-
-			msg ("started listener at %s:%s (id: %d, socket: %d)...",
-			     axl_node_get_content (name, NULL),
-			     axl_node_get_content (port, NULL),
-			     vortex_connection_get_id (conn_listener), vortex_connection_get_socket (conn_listener));
+			/* start the listener and flag that at least
+			 * one listener was created */
+			if (__turbulence_run_start_listener (ctx, axl_node_get_content (name, NULL), 
+							     axl_node_get_content (port, NULL), acceptors))
+				at_least_one_listener = axl_true;
 
-			/* flag that at least one listener was
-			 * created */
-			at_least_one_listener = axl_true;
-		next:
 			/* get the next port */
 			port = axl_node_get_next_called (port, "port");
 			
@@ -311,6 +649,113 @@ axl_bool turbulence_run_config_start_listeners (TurbulenceCtx * ctx, axlDoc * do
 	return axl_true;
 }
 
+/** 
+ * @internal Checks if the provided host and port are declared as a
+ * listener in the provided configuration.
+ */
+axl_bool __turbulence_run_listener_declared (axlDoc * doc, const char * host, const char * port)
+{
+	axlNode * listener;
+	axlNode * port_node;
+
+	listener = axl_doc_get (doc, "/turbulence/global-settings/listener");
+	while (listener != NULL) {
+		if (axl_cmp (axl_node_get_content (axl_node_get_child_called (listener, "name"), NULL), host)) {
+			port_node = axl_doc_get (doc, "/turbulence/global-settings/ports/port");
+			while (port_node != NULL) {
+				if (axl_cmp (axl_node_get_content (port_node, NULL), port))
+					return axl_true;
+				port_node = axl_node_get_next_called (port_node, "port");
+			} /* end while */
+		} /* end if */
+		listener = axl_node_get_next_called (listener, "listener");
+	} /* end while */
+
+	return axl_false;
+}
+
+/** 
+ * @internal Checks if the provided host and port are already being
+ * listened.
+ */
+axl_bool __turbulence_run_listener_started (TurbulenceCtx * ctx, const char * host, const char * port)
+{
+	TurbulenceListenerSocket * listener;
+	int                        iterator;
+
+	iterator = 0;
+	while (ctx->listener_sockets && iterator < axl_list_length (ctx->listener_sockets)) {
+		listener = axl_list_get_nth (ctx->listener_sockets, iterator);
+		if (axl_cmp (listener->host, host) && axl_cmp (listener->port, port))
+			return axl_true;
+		iterator++;
+	} /* end while */
+
+	return axl_false;
+}
+
+/** 
+ * @internal Updates listeners according to the provided
+ * configuration (reloaded): listeners no longer declared are closed
+ * (connections already accepted through them are not touched) and
+ * listeners added are started. Listeners declared in both are kept
+ * as they are (a change in acceptors= requires a restart).
+ */
+void turbulence_run_reload_listeners (TurbulenceCtx * ctx, axlDoc * doc)
+{
+	TurbulenceListenerSocket * listener;
+	axlNode                  * node;
+	axlNode                  * name;
+	axlNode                  * port;
+	int                        acceptors;
+	int                        iterator;
+
+	/* childs have no listeners */
+	if (ctx->child)
+		return;
+
+	/* close listeners removed */
+	iterator = 0;
+	while (ctx->listener_sockets && iterator < axl_list_length (ctx->listener_sockets)) {
+		listener = axl_list_get_nth (ctx->listener_sockets, iterator);
+		if (__turbulence_run_listener_declared (doc, listener->host, listener->port)) {
+			iterator++;
+			continue;
+		} /* end if */
+
+		msg ("reload: closing listener %s:%s (socket: %d), no longer declared", 
+		     listener->host, listener->port, listener->socket);
+		if (listener->acceptor) {
+			/* release the acceptor loop (this closes the socket) */
+			axl_list_remove_ptr (ctx->acceptors, listener->acceptor);
+		} else if (listener->listener) 
+			vortex_connection_shutdown (listener->listener);
+		axl_list_remove_at (ctx->listener_sockets, iterator);
+	} /* end while */
+
+	/* start listeners added */
+	node = axl_doc_get (doc, "/turbulence/global-settings/listener");
+	while (node != NULL) {
+		name      = axl_node_get_child_called (node, "name");
+		acceptors = __turbulence_run_get_acceptors (ctx, node);
+
+		port = axl_doc_get (doc, "/turbulence/global-settings/ports/port");
+		while (port != NULL) {
+			if (! __turbulence_run_listener_started (ctx, axl_node_get_content (name, NULL), axl_node_get_content (port, NULL))) {
+				msg ("reload: starting listener %s:%s, added to configuration", 
+				     axl_node_get_content (name, NULL), axl_node_get_content (port, NULL));
+				__turbulence_run_start_listener (ctx, axl_node_get_content (name, NULL), 
+								 axl_node_get_content (port, NULL), acceptors);
+			} /* end if */
+			port = axl_node_get_next_called (port, "port");
+		} /* end while */
+
+		node = axl_node_get_next_called (node, "listener");
+	} /* end while */
+
+	return;
+}
+
 /** 
  * @internal Takes current configuration, and starts all settings
  * required to run the server.
@@ -463,15 +908,36 @@ int  turbulence_run_config    (TurbulenceCtx * ctx)
 	if (! turbulence_run_config_start_listeners (ctx, doc))
 		return axl_false;
 
+	/* adopt childs inherited from a previous binary (upgrade) */
+	turbulence_process_upgrade_adopt_childs (ctx);
+
 	/* turbulence started properly */
 	return axl_true;
 }
 
+/** 
+ * @internal Stops all acceptor loops started for listeners with
+ * several SO_REUSEPORT sockets, closing their sockets.
+ */
+void turbulence_run_stop_acceptors (TurbulenceCtx * ctx)
+{
+	axl_list_free (ctx->acceptors);
+	ctx->acceptors = NULL;
+	return;
+}
+
 /** 
  * @internal Allows to cleanup the module.
  */
 void turbulence_run_cleanup (TurbulenceCtx * ctx)
 {
+	/* stop acceptors (if not done yet) */
+	turbulence_run_stop_acceptors (ctx);
+
+	/* release listener sockets records */
+	axl_list_free (ctx->listener_sockets);
+	ctx->listener_sockets = NULL;
+
 	/* cleanup module dtd */
 	axl_dtd_free (ctx->module_dtd);
 	ctx->module_dtd = NULL;
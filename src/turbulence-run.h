@@ -48,6 +48,12 @@ int  turbulence_run_config    (TurbulenceCtx * ctx);
 
 void turbulence_run_cleanup   (TurbulenceCtx * ctx);
 
+void turbulence_run_stop_acceptors (TurbulenceCtx * ctx);
+
+void turbulence_run_reload_listeners (TurbulenceCtx * ctx, axlDoc * doc);
+
+void __turbulence_run_listener_socket_free (axlPointer listener);
+
 /** 
  * @brief Shutdown and closes the connection.
  * @param conn The connection to shutdown and close.
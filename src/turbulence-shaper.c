@@ -0,0 +1,595 @@
+/*  Turbulence BEEP application server
+ *  Copyright (C) 2025 Advanced Software Production Line, S.L.
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; version 2.1 of the
+ *  License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free
+ *  Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307 USA
+ *  
+ *  You may find a copy of the license under this software is released
+ *  at COPYING file. This is LGPL software: you are welcome to develop
+ *  proprietary applications using this library without any royalty or
+ *  fee but returning back any change, improvement or addition in the
+ *  form of source code, project image, documentation patches, etc.
+ *
+ *  For commercial support on build BEEP enabled solutions, supporting
+ *  turbulence based solutions, etc, contact us:
+ *          
+ *      Postal address:
+ *         Advanced Software Production Line, S.L.
+ *         C/ Antonio Suarez Nº10, Edificio Alius A, Despacho 102
+ *         Alcala de Henares, 28802 (MADRID)
+ *         Spain
+ *
+ *      Email address:
+ *         info@aspl.es - http://www.aspl.es/turbulence
+ */
+#include <turbulence.h>
+
+/* local include */
+#include <turbulence-ctx-private.h>
+
+/** 
+ * \defgroup turbulence_shaper Turbulence Shaper: bandwidth shaping
+ */
+
+/** 
+ * \addtogroup turbulence_shaper
+ * @{
+ */
+
+/**
+ * @internal Connection data key where the shaper installed by
+ * turbulence_shaper_conn_setup is stored.
+ */
+#define TBC_SHAPER_KEY      "tbc:shaper"
+
+/**
+ * @internal Connection data key flagging connections that must not
+ * be shaped by the current process (see turbulence_shaper_conn_skip).
+ */
+#define TBC_SHAPER_SKIP_KEY "tbc:shaper:skip"
+
+/**
+ * @internal Elapsed time (microseconds) after which the bucket is
+ * considered full without computing the tokens generated.
+ */
+#define TBC_SHAPER_MAX_ELAPSED (10000000L)
+
+struct _TurbulenceShaper {
+	TurbulenceCtx        * ctx;
+	VortexMutex            mutex;
+
+	/* references (the connection and, while blocked, the resume
+	 * thread) */
+	int                    refs;
+
+	/* bytes per second allowed and bytes that can be consumed
+	 * at once after an idle period */
+	long                   rate;
+	long                   burst;
+
+	/* tokens available (negative while the consumer is in debt)
+	 * and monotonic stamp of the last refill */
+	long                   tokens;
+	long                   stamp;
+
+	/* connection shaped and its receive handler replaced (only
+	 * for shapers installed by turbulence_shaper_conn_setup). While
+	 * blocked is set the connection is waiting at the resume thread
+	 * until resume_at. */
+	VortexConnection     * conn;
+	VortexReceiveHandler   receive;
+	axl_bool               blocked;
+	long                   resume_at;
+
+	/* counters of the profile path (owned by the metrics
+	 * registry: do not release) */
+	TurbulenceMetric     * metric_bytes_in;
+	TurbulenceMetric     * metric_bytes_out;
+	TurbulenceMetric     * metric_delays;
+	TurbulenceMetric     * metric_delay_usec;
+};
+
+/** 
+ * @brief Creates a token bucket that allows to consume rate bytes
+ * per second with bursts of up to burst bytes.
+ *
+ * @param ctx The turbulence context.
+ *
+ * @param rate Bytes per second allowed (> 0).
+ *
+ * @param burst Bytes that can be consumed at once after an idle
+ * period. If <= 0 it is set to rate (one second of traffic).
+ *
+ * @return A newly created shaper (release it with \ref
+ * turbulence_shaper_free) or NULL if it fails.
+ */
+TurbulenceShaper * turbulence_shaper_new          (TurbulenceCtx        * ctx,
+						   long                   rate,
+						   long                   burst)
+{
+	TurbulenceShaper * shaper;
+
+	if (rate <= 0)
+		return NULL;
+
+	shaper = axl_new (TurbulenceShaper, 1);
+	if (shaper == NULL)
+		return NULL;
+	shaper->ctx  = ctx;
+	shaper->refs = 1;
+	vortex_mutex_create (&shaper->mutex);
+	turbulence_shaper_set_rate (shaper, rate, burst);
+
+	/* start with the bucket full */
+	shaper->tokens = shaper->burst;
+	shaper->stamp  = turbulence_trace_now ();
+	return shaper;
+}
+
+/** 
+ * @brief Changes the rate (and burst) of the provided shaper. Tokens
+ * already available above the new burst are discarded.
+ *
+ * @param shaper The shaper to update.
+ *
+ * @param rate Bytes per second allowed (> 0).
+ *
+ * @param burst Bytes that can be consumed at once. If <= 0 it is set
+ * to rate.
+ */
+void               turbulence_shaper_set_rate     (TurbulenceShaper     * shaper,
+						   long                   rate,
+						   long                   burst)
+{
+	if (shaper == NULL || rate <= 0)
+		return;
+
+	vortex_mutex_lock (&shaper->mutex);
+	shaper->rate  = rate;
+	shaper->burst = (burst > 0) ? burst : rate;
+	if (shaper->tokens > shaper->burst)
+		shaper->tokens = shaper->burst;
+	vortex_mutex_unlock (&shaper->mutex);
+	return;
+}
+
+/** 
+ * @brief Returns the rate (bytes per second) configured on the
+ * shaper.
+ *
+ * @param shaper The shaper to check.
+ *
+ * @return The rate or -1 if a NULL reference is received.
+ */
+long               turbulence_shaper_get_rate     (TurbulenceShaper     * shaper)
+{
+	long rate;
+
+	if (shaper == NULL)
+		return -1;
+	vortex_mutex_lock (&shaper->mutex);
+	rate = shaper->rate;
+	vortex_mutex_unlock (&shaper->mutex);
+	return rate;
+}
+
+/** 
+ * @brief Accounts bytes transferred through the shaper. Bytes are
+ * always accepted: when they exceed the tokens available the shaper
+ * goes into debt and the function reports how long the caller must
+ * wait before transferring again so the rate configured is
+ * respected.
+ *
+ * @param shaper The shaper where bytes are accounted (NULL is
+ * accepted and reports no wait).
+ *
+ * @param bytes Bytes transferred.
+ *
+ * @param incoming axl_true if bytes were received from the remote
+ * peer, axl_false if they were sent (only used by counters).
+ *
+ * @return Microseconds to wait before the next transfer (0 if no
+ * wait is required).
+ */
+long               turbulence_shaper_consume      (TurbulenceShaper     * shaper,
+						   long                   bytes,
+						   axl_bool               incoming)
+{
+	long now;
+	long elapsed;
+	long added;
+	long wait = 0;
+
+	if (shaper == NULL || bytes <= 0)
+		return 0;
+
+	now = turbulence_trace_now ();
+	vortex_mutex_lock (&shaper->mutex);
+
+	/* refill with tokens generated since the last refill. The
+	 * stamp only advances by the time converted into tokens so
+	 * frequent calls do not lose the fraction pending */
+	elapsed = now - shaper->stamp;
+	if (elapsed >= TBC_SHAPER_MAX_ELAPSED) {
+		shaper->tokens = shaper->burst;
+		shaper->stamp  = now;
+	} else if (elapsed > 0) {
+		added = (long) ((double) elapsed * shaper->rate / 1000000.0);
+		if (added > 0) {
+			shaper->tokens += added;
+			shaper->stamp  += (long) ((double) added * 1000000.0 / shaper->rate);
+		} /* end if */
+		if (shaper->tokens >= shaper->burst) {
+			shaper->tokens = shaper->burst;
+			shaper->stamp  = now;
+		} /* end if */
+	} /* end if */
+
+	/* consume and compute the time required to pay the debt */
+	shaper->tokens -= bytes;
+	if (shaper->tokens < 0)
+		wait = (long) ((double) (- shaper->tokens) * 1000000.0 / shaper->rate);
+	vortex_mutex_unlock (&shaper->mutex);
+
+	/* update counters (atomic adds, no lock is taken) */
+	turbulence_metric_inc (incoming ? shaper->metric_bytes_in : shaper->metric_bytes_out, bytes);
+	if (wait > 0) {
+		turbulence_metric_inc (shaper->metric_delays, 1);
+		turbulence_metric_inc (shaper->metric_delay_usec, wait);
+	} /* end if */
+
+	return wait;
+}
+
+/** 
+ * @internal Acquires a reference to the shaper (released with
+ * turbulence_shaper_free).
+ */
+void               __turbulence_shaper_ref        (TurbulenceShaper     * shaper)
+{
+	vortex_mutex_lock (&shaper->mutex);
+	shaper->refs++;
+	vortex_mutex_unlock (&shaper->mutex);
+	return;
+}
+
+/** 
+ * @brief Releases the provided shaper. A shaper installed on a
+ * connection that is being delayed is kept by the resume thread
+ * until the connection is resumed.
+ *
+ * @param shaper The shaper to release.
+ */
+void               turbulence_shaper_free         (TurbulenceShaper     * shaper)
+{
+	if (shaper == NULL)
+		return;
+
+	vortex_mutex_lock (&shaper->mutex);
+	shaper->refs--;
+	if (shaper->refs > 0) {
+		vortex_mutex_unlock (&shaper->mutex);
+		return;
+	} /* end if */
+	vortex_mutex_unlock (&shaper->mutex);
+
+	vortex_mutex_destroy (&shaper->mutex);
+	axl_free (shaper);
+	return;
+}
+
+/** 
+ * @brief Returns the shaper installed on the connection by the
+ * profile path selected (max-rate attribute).
+ *
+ * @param conn The connection to check.
+ *
+ * @return The shaper or NULL if the connection is not shaped.
+ */
+TurbulenceShaper * turbulence_shaper_conn_get     (VortexConnection     * conn)
+{
+	if (conn == NULL)
+		return NULL;
+	return vortex_connection_get_data (conn, TBC_SHAPER_KEY);
+}
+
+/** 
+ * @internal Resume thread: keeps connections blocked by their
+ * shaper and unblocks them once their debt is paid. Shapers are
+ * received through ctx->shaper_queue holding a reference to
+ * themselves and to their connection (the connection data may be
+ * released meanwhile, so the shaper is not looked up from it).
+ */
+axlPointer __turbulence_shaper_run (TurbulenceCtx * ctx)
+{
+	axlList          * pending;
+	axlListCursor    * cursor;
+	VortexConnection * conn;
+	TurbulenceShaper * shaper;
+	axlPointer         item;
+	long               now;
+	long               next;
+	axl_bool           stop = axl_false;
+
+	pending = axl_list_new (axl_list_always_return_1, NULL);
+	cursor  = axl_list_cursor_new (pending);
+
+	while (axl_true) {
+		/* resume connections whose debt was paid and find the
+		 * next resume stamp */
+		now  = turbulence_trace_now ();
+		next = -1;
+		axl_list_cursor_first (cursor);
+		while (axl_list_cursor_has_item (cursor)) {
+			shaper = axl_list_cursor_get (cursor);
+			conn   = shaper->conn;
+
+			vortex_mutex_lock (&shaper->mutex);
+			if (! stop && shaper->resume_at > now) {
+				/* still in debt (it may have been
+				 * extended while blocked) */
+				if (next == -1 || shaper->resume_at < next)
+					next = shaper->resume_at;
+				vortex_mutex_unlock (&shaper->mutex);
+				axl_list_cursor_next (cursor);
+				continue;
+			} /* end if */
+			shaper->blocked = axl_false;
+			vortex_mutex_unlock (&shaper->mutex);
+
+			vortex_connection_block (conn, axl_false);
+			vortex_connection_unref (conn, "shaper");
+			turbulence_shaper_free (shaper);
+			axl_list_cursor_remove (cursor);
+		} /* end while */
+
+		if (stop)
+			break;
+
+		/* wait for new connections to hold or the next
+		 * resume */
+		if (next == -1)
+			item = vortex_async_queue_pop (ctx->shaper_queue);
+		else
+			item = vortex_async_queue_timedpop (ctx->shaper_queue, (next - now) > 0 ? (next - now) : 1);
+		if (item == NULL)
+			continue;
+		if (PTR_TO_INT (item) == -4) {
+			stop = axl_true;
+			continue;
+		} /* end if */
+		axl_list_append (pending, item);
+	} /* end while */
+
+	axl_list_cursor_free (cursor);
+	axl_list_free (pending);
+	return NULL;
+}
+
+/** 
+ * @internal Stops reading from the connection until the shaper debt
+ * is paid.
+ */
+void __turbulence_shaper_defer (TurbulenceShaper * shaper, long wait)
+{
+	TurbulenceCtx    * ctx  = shaper->ctx;
+	VortexConnection * conn = shaper->conn;
+	long               resume_at;
+
+	resume_at = turbulence_trace_now () + wait;
+	vortex_mutex_lock (&shaper->mutex);
+	if (resume_at > shaper->resume_at)
+		shaper->resume_at = resume_at;
+	if (shaper->blocked) {
+		/* already waiting: resume_at was extended */
+		vortex_mutex_unlock (&shaper->mutex);
+		return;
+	} /* end if */
+	shaper->blocked = axl_true;
+	vortex_mutex_unlock (&shaper->mutex);
+
+	/* start resume thread on first use */
+	vortex_mutex_lock (&ctx->shaper_mutex);
+	if (ctx->shaper_queue == NULL && ! ctx->is_exiting) {
+		ctx->shaper_queue = vortex_async_queue_new ();
+		if (! vortex_thread_create (&ctx->shaper_thread,
+					    (VortexThreadFunc) __turbulence_shaper_run,
+					    ctx,
+					    VORTEX_THREAD_CONF_END)) {
+			error ("unable to start bandwidth shaping resume thread, connections won't be delayed");
+			vortex_async_queue_unref (ctx->shaper_queue);
+			ctx->shaper_queue = NULL;
+		} /* end if */
+	} /* end if */
+
+	if (ctx->shaper_queue == NULL || ! vortex_connection_ref (conn, "shaper")) {
+		vortex_mutex_unlock (&ctx->shaper_mutex);
+		vortex_mutex_lock (&shaper->mutex);
+		shaper->blocked = axl_false;
+		vortex_mutex_unlock (&shaper->mutex);
+		return;
+	} /* end if */
+
+	/* stop reading and hand the connection to the resume thread */
+	__turbulence_shaper_ref (shaper);
+	vortex_connection_block (conn, axl_true);
+	vortex_async_queue_push (ctx->shaper_queue, shaper);
+	vortex_mutex_unlock (&ctx->shaper_mutex);
+	return;
+}
+
+/** 
+ * @internal Receive handler installed on shaped connections: reads
+ * with the handler previously installed (plain socket, TLS or
+ * WebSocket) and blocks the connection when it exceeds its rate.
+ */
+int __turbulence_shaper_receive (VortexConnection * conn, char * buffer, int buffer_len)
+{
+	TurbulenceShaper     * shaper = turbulence_shaper_conn_get (conn);
+	VortexReceiveHandler   receive;
+	int                    result;
+	long                   wait;
+
+	/* shaper released with the connection data: the connection
+	 * is being finished */
+	if (shaper == NULL)
+		return -1;
+
+	vortex_mutex_lock (&shaper->mutex);
+	receive = shaper->receive;
+	vortex_mutex_unlock (&shaper->mutex);
+
+	result = receive (conn, buffer, buffer_len);
+	if (result > 0) {
+		wait = turbulence_shaper_consume (shaper, result, axl_true);
+		if (wait > 0)
+			__turbulence_shaper_defer (shaper, wait);
+	} /* end if */
+
+	return result;
+}
+
+/** 
+ * @internal Installs a shaper on the connection limiting the content
+ * read from it to rate bytes per second (it is blocked until the
+ * debt is paid when exceeded). If the connection is already shaped
+ * the lowest rate applies (it is never raised again, even if the
+ * channel that lowered it is closed).
+ *
+ * @param ctx The turbulence context.
+ *
+ * @param conn The connection to shape.
+ *
+ * @param def The profile path selected by the connection (max-burst
+ * and counters), it may be NULL.
+ *
+ * @param rate Bytes per second allowed.
+ *
+ * @return axl_true if the connection is shaped, otherwise axl_false.
+ */
+axl_bool           turbulence_shaper_conn_setup   (TurbulenceCtx        * ctx,
+						   VortexConnection     * conn,
+						   TurbulencePPathDef   * def,
+						   long                   rate)
+{
+	TurbulenceShaper * shaper;
+
+	if (conn == NULL || rate <= 0)
+		return axl_false;
+
+	/* shaped by other process */
+	if (PTR_TO_INT (vortex_connection_get_data (conn, TBC_SHAPER_SKIP_KEY)))
+		return axl_false;
+
+	shaper = turbulence_shaper_conn_get (conn);
+	if (shaper != NULL) {
+		if (rate < turbulence_shaper_get_rate (shaper)) {
+			turbulence_shaper_set_rate (shaper, rate, 0);
+			msg ("conn-id=%d bandwidth lowered to max-rate=%ld bytes/sec", vortex_connection_get_id (conn), rate);
+		} /* end if */
+		return axl_true;
+	} /* end if */
+
+	shaper = turbulence_shaper_new (ctx, rate, def ? def->max_burst : 0);
+	if (shaper == NULL) {
+		error ("Unable to allocate bandwidth shaper for conn-id=%d", vortex_connection_get_id (conn));
+		return axl_false;
+	} /* end if */
+	if (def != NULL) {
+		shaper->metric_bytes_in   = def->metric_shaping_bytes[0];
+		shaper->metric_bytes_out  = def->metric_shaping_bytes[1];
+		shaper->metric_delays     = def->metric_shaping_delays;
+		shaper->metric_delay_usec = def->metric_shaping_delay;
+	} /* end if */
+
+	/* wrap current receive handler (released with the
+	 * connection, after the resume thread dropped its
+	 * reference). The mutex is held so a read running on other
+	 * thread does not find the previous handler unset */
+	shaper->conn    = conn;
+	vortex_connection_set_data_full (conn, TBC_SHAPER_KEY, shaper, NULL, (axlDestroyFunc) turbulence_shaper_free);
+	vortex_mutex_lock (&shaper->mutex);
+	shaper->receive = vortex_connection_set_receive_handler (conn, __turbulence_shaper_receive);
+	vortex_mutex_unlock (&shaper->mutex);
+
+	msg ("conn-id=%d shaped to max-rate=%ld bytes/sec (burst %ld)", vortex_connection_get_id (conn), rate, shaper->burst);
+	return axl_true;
+}
+
+/** 
+ * @internal Flags the connection so it is not shaped by the current
+ * process. Used by childs on connections proxied by the parent,
+ * which already shapes them while reading from the client.
+ *
+ * @param conn The connection to flag.
+ */
+void               turbulence_shaper_conn_skip    (VortexConnection     * conn)
+{
+	vortex_connection_set_data (conn, TBC_SHAPER_SKIP_KEY, INT_TO_PTR (axl_true));
+	return;
+}
+
+/** 
+ * @internal Registers shaping counters of the provided profile path.
+ */
+void               turbulence_shaper_ppath_init   (TurbulenceCtx        * ctx,
+						   TurbulencePPathDef   * def)
+{
+	char * ppath;
+	char * labels;
+
+	ppath = turbulence_metrics_label ("ppath", def->path_name);
+
+	labels = axl_strdup_printf ("%s,direction=\"in\"", ppath ? ppath : "");
+	def->metric_shaping_bytes[0] = turbulence_metrics_get (ctx, TBC_METRIC_COUNTER, "turbulence_shaping_bytes_total", labels,
+							       "Bytes accounted by bandwidth shaping on each profile path");
+	axl_free (labels);
+	labels = axl_strdup_printf ("%s,direction=\"out\"", ppath ? ppath : "");
+	def->metric_shaping_bytes[1] = turbulence_metrics_get (ctx, TBC_METRIC_COUNTER, "turbulence_shaping_bytes_total", labels,
+							       "Bytes accounted by bandwidth shaping on each profile path");
+	axl_free (labels);
+
+	def->metric_shaping_delays = turbulence_metrics_get (ctx, TBC_METRIC_COUNTER, "turbulence_shaping_delays_total", ppath,
+							     "Times shaped connections exceeded their rate and were delayed");
+	def->metric_shaping_delay  = turbulence_metrics_get (ctx, TBC_METRIC_COUNTER, "turbulence_shaping_delay_microseconds_total", ppath,
+							     "Time shaped connections were delayed to respect their rate");
+	axl_free (ppath);
+	return;
+}
+
+/** 
+ * @internal Stops the resume thread (if started) unblocking the
+ * connections it holds. Called before connections are released.
+ */
+void               turbulence_shaper_cleanup      (TurbulenceCtx        * ctx)
+{
+	VortexAsyncQueue * queue;
+
+	vortex_mutex_lock (&ctx->shaper_mutex);
+	queue             = ctx->shaper_queue;
+	ctx->shaper_queue = NULL;
+	vortex_mutex_unlock (&ctx->shaper_mutex);
+	if (queue == NULL)
+		return;
+
+	vortex_async_queue_push (queue, INT_TO_PTR (-4));
+	vortex_thread_destroy (&ctx->shaper_thread, axl_false);
+	vortex_async_queue_unref (queue);
+	return;
+}
+
+/** 
+ * @}
+ */
@@ -39,6 +39,12 @@
 #include <signal.h>
 #include <sys/wait.h>
 #include <stdlib.h>
+#if defined(AXL_OS_UNIX)
+#include <fcntl.h>
+#endif
+#if defined(ENABLE_SIGNALFD)
+#include <sys/signalfd.h>
+#endif
 
 /** 
  * \defgroup turbulence_signal Turbulence Signal : signal handling support for turbulence
@@ -49,10 +55,43 @@
  * @{
  */
 
+/** 
+ * @internal Writes the signal received into the self-pipe so it is
+ * handled by the signal loop (only write(2) is used, which is
+ * async-signal-safe).
+ *
+ * @return axl_true if the signal was deferred, axl_false if there is
+ * no self-pipe (the caller must handle it).
+ */
+axl_bool __turbulence_signal_defer (TurbulenceCtx * ctx, int _signal)
+{
+#if defined(AXL_OS_UNIX)
+	unsigned char value = (unsigned char) _signal;
+	int           saved = errno;
+
+	if (ctx->signal_pipe[1] < 0)
+		return axl_false;
+
+	if (write (ctx->signal_pipe[1], &value, 1) != 1) {
+		/* a full pipe (EAGAIN) already has signals pending */
+	} /* end if */
+	errno = saved;
+	return axl_true;
+#else
+	return axl_false;
+#endif
+}
+
 /** 
  * @brief Signal notify facility. This function is used to signal on
  * the appropriate \ref TurbulenceCtx, a particular signal received.
  *
+ * When called from the handler installed by \ref
+ * turbulence_signal_install, signals whose handling parses files and
+ * takes locks (SIGHUP reload, SIGUSR2 upgrade) are not handled inside the signal
+ * handler: they are written into a self-pipe and handled by a thread
+ * started at \ref turbulence_init.
+ *
  * @param ctx The turbulence context where the signal will be handled.
  * @param _signal The signal received.
  *
@@ -60,48 +99,45 @@
  */
 int turbulence_signal_received (TurbulenceCtx * ctx, int _signal)
 {
-	int exit_status = 0;
-	int pid;
-	TurbulenceChild * child;
-
 	if (_signal == SIGHUP) {
+		/* nothing to reload if finishing (the self-pipe is
+		 * closed by turbulence_exit) */
+		if (ctx->is_exiting)
+			return 0;
+#if defined(AXL_OS_UNIX)
+		/* reconfigure signal */
+		signal (SIGHUP, ctx->signal_handler);
+#endif
+		/* reload from the signal loop */
+		if (__turbulence_signal_defer (ctx, _signal))
+			return 0;
+
 		msg ("received reconf signal, handling..");
 		/* notify */
 		turbulence_reload_config (ctx, _signal);
-
+		return 0;
 #if defined(AXL_OS_UNIX)
+	} else if (_signal == SIGUSR2) {
 		/* reconfigure signal */
-		signal (SIGHUP, ctx->signal_handler);
-#endif
+		signal (SIGUSR2, ctx->signal_handler);
+
+		/* upgrade from the signal loop: it stops the child
+		 * supervision loop, joining its thread, which cannot
+		 * be done inside a signal handler */
+		if (! ctx->is_exiting && ! __turbulence_signal_defer (ctx, _signal))
+			error ("received upgrade signal but there is no signal loop to run it, ignoring");
 		return 0;
+#endif
 	} else if (_signal == SIGCHLD) {
-		/* do not get finished pid to let kill child process
-		 * to get it */
-		pid = wait (&exit_status);
-		msg ("child process (%d) finished with status: %d",
-		     pid, exit_status);
-
-		/* lock to remove */
-		vortex_mutex_lock (&ctx->child_process_mutex);
-
-		/* get child to reduce childs running */
-		child = axl_hash_get (ctx->child_process, INT_TO_PTR (pid));
-		if (child && child->ppath) {
-			/* decrease number of childs running */
-			child->ppath->childs_running--;
-		} /* end if */
-
-		/* remove pid from list */
-		axl_hash_remove (ctx->child_process, INT_TO_PTR (pid));
-
-		/* unlock */
-		vortex_mutex_unlock (&ctx->child_process_mutex);
-
-		/* reconfigure signal again */
+		/* reconfigure signal again (before reaping so no
+		 * child finished after is missed) */
 		signal (SIGCHLD, ctx->signal_handler);
-		
-		/* return child pid to allow management */
-		return pid;
+
+		/* reap all childs finished: several childs finishing
+		 * at the same time may be notified by a single
+		 * signal. Return last child pid to allow
+		 * management */
+		return turbulence_process_reap_childs (ctx);
 	} /* end if */
 
 	/* notify */
@@ -111,18 +147,189 @@ int turbulence_signal_received (TurbulenceCtx * ctx, int _signal)
 }
 
 
+#if defined(AXL_OS_UNIX)
 /** 
- * @brief Allows to enable sigchild handling.
+ * @internal Handler called by the signal loop when signals were
+ * deferred by turbulence_signal_received.
+ */
+axl_bool __turbulence_signal_deferred_on_read (TurbulenceLoop * loop, 
+					       TurbulenceCtx  * ctx,
+					       int              descriptor, 
+					       axlPointer       ptr, 
+					       axlPointer       ptr2)
+{
+	unsigned char _signal;
+	axl_bool      reload  = axl_false;
+	axl_bool      upgrade = axl_false;
+
+	/* consume all signals pending (descriptor is non blocking):
+	 * several HUP received meanwhile are served by one reload */
+	while (read (descriptor, &_signal, 1) == 1) {
+		if (_signal == SIGHUP)
+			reload = axl_true;
+		else if (_signal == SIGUSR2)
+			upgrade = axl_true;
+	} /* end while */
+
+	if (reload) {
+		msg ("received reconf signal, handling..");
+		turbulence_reload_config (ctx, SIGHUP);
+	} /* end if */
+
+	if (upgrade) {
+		msg ("received upgrade signal, handling..");
+		/* only returns if the upgrade failed */
+		turbulence_process_upgrade (ctx);
+	} /* end if */
+
+	return axl_true;
+}
+#endif
+
+/** 
+ * @internal Starts the thread handling signals deferred by the
+ * signal handler (see turbulence_signal_received). Called by
+ * turbulence_init once vortex is initialized; signals received before
+ * are kept in the self-pipe until then.
+ */
+void turbulence_signal_loop_start (TurbulenceCtx * ctx)
+{
+#if defined(AXL_OS_UNIX)
+	if (ctx->signal_pipe[0] < 0 || ctx->signal_loop)
+		return;
+
+	ctx->signal_loop = turbulence_loop_create (ctx);
+	if (ctx->signal_loop == NULL) {
+		error ("unable to start signal loop, signals like SIGHUP will be ignored");
+		return;
+	} /* end if */
+
+	/* the loop owns the read end (closed with the loop) */
+	turbulence_loop_watch_descriptor (ctx->signal_loop, ctx->signal_pipe[0], 
+					  __turbulence_signal_deferred_on_read, NULL, NULL);
+#endif
+	return;
+}
+
+/** 
+ * @internal Stops the signal loop (waiting for any deferred
+ * operation running) and closes the self-pipe.
+ */
+void turbulence_signal_loop_stop (TurbulenceCtx * ctx)
+{
+#if defined(AXL_OS_UNIX)
+	int descriptor;
+
+	if (ctx->signal_pipe[1] < 0)
+		return;
+
+	/* the process is exiting: ignore reload and upgrade requests
+	 * from now so the handler does not write into a closed
+	 * descriptor */
+	signal (SIGHUP, SIG_IGN);
+	signal (SIGUSR2, SIG_IGN);
+	descriptor          = ctx->signal_pipe[1];
+	ctx->signal_pipe[1] = -1;
+	if (descriptor >= 0)
+		vortex_close_socket (descriptor);
+
+	if (ctx->signal_loop) {
+		turbulence_loop_close (ctx->signal_loop, axl_true);
+		ctx->signal_loop = NULL;
+	} else if (ctx->signal_pipe[0] >= 0) {
+		vortex_close_socket (ctx->signal_pipe[0]);
+	} /* end if */
+	ctx->signal_pipe[0] = -1;
+#endif
+	return;
+}
+
+#if defined(ENABLE_SIGNALFD)
+/** 
+ * @internal Handler called by the child supervision loop when
+ * SIGCHLD is received through the signalfd.
+ */
+axl_bool __turbulence_signal_sigchld_on_read (TurbulenceLoop * loop, 
+					      TurbulenceCtx  * ctx,
+					      int              descriptor, 
+					      axlPointer       ptr, 
+					      axlPointer       ptr2)
+{
+	struct signalfd_siginfo info;
+
+	/* consume all notifications pending (descriptor is non
+	 * blocking): they are coalesced anyway so reap once */
+	while (read (descriptor, &info, sizeof (info)) == sizeof (info));
+
+	/* reap all childs finished */
+	turbulence_process_reap_childs (ctx);
+
+	return axl_true;
+}
+#endif
+
+/** 
+ * @brief Allows to enable child supervision (SIGCHLD handling) on
+ * the master process.
+ *
+ * When supported (signalfd), SIGCHLD is kept blocked on the master
+ * process (see \ref turbulence_signal_install) and received through
+ * a descriptor watched by a \ref TurbulenceLoop, so childs are reaped
+ * by a thread outside signal context. Otherwise a signal handler is
+ * installed. In both cases all childs finished are reaped on each
+ * notification (\ref turbulence_process_reap_childs).
+ *
+ * @param ctx The turbulence context (master process).
+ * @param enable axl_true to start supervision, axl_false to stop it.
  */
 void turbulence_signal_sigchld (TurbulenceCtx * ctx, axl_bool enable)
 {
-	msg ("Enabling SIGCHLD handling at turbulence main process");
+#if defined(ENABLE_SIGNALFD)
+	sigset_t mask;
+	int      descriptor;
+
+	if (enable) {
+		/* already enabled */
+		if (ctx->sigchld_loop)
+			return;
+
+		msg ("Enabling SIGCHLD handling at turbulence main process (signalfd)");
+
+		/* receive SIGCHLD through a descriptor */
+		sigemptyset (&mask);
+		sigaddset (&mask, SIGCHLD);
+		sigprocmask (SIG_BLOCK, &mask, NULL);
+		descriptor = signalfd (-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+		if (descriptor < 0) {
+			error ("Failed to create signalfd to supervise childs, falling back to signal handler, errno=%d:%s", 
+			       errno, vortex_errno_get_last_error ());
+			signal (SIGCHLD, ctx->signal_handler);
+			sigprocmask (SIG_UNBLOCK, &mask, NULL);
+			return;
+		} /* end if */
+
+		/* watch it (signals pending are reported too) */
+		ctx->sigchld_loop = turbulence_loop_create (ctx);
+		turbulence_loop_watch_descriptor (ctx->sigchld_loop, descriptor, 
+						  __turbulence_signal_sigchld_on_read, NULL, NULL);
+		return;
+	} /* end if */
+
+	/* stop supervision (closing the loop closes the signalfd) */
+	if (ctx->sigchld_loop) {
+		turbulence_loop_close (ctx->sigchld_loop, axl_true);
+		ctx->sigchld_loop = NULL;
+	} /* end if */
+	signal (SIGCHLD, NULL);
+#else
+	msg ("%s SIGCHLD handling at turbulence main process", enable ? "Enabling" : "Disabling");
 
 	/* check for sigchild */
 	if (enable)
 		signal (SIGCHLD, ctx->signal_handler);
 	else
 		signal (SIGCHLD, NULL);	
+#endif
 
 	return;
 }
@@ -136,6 +343,10 @@ void turbulence_signal_install (TurbulenceCtx           * ctx,
 				axl_bool                  enable_sighup,
 				TurbulenceSignalHandler   signal_handler)
 {
+#if defined(AXL_OS_UNIX)
+	int iterator;
+#endif
+
 	/* install default handlers */
 	/* check for sigint */
 	if (enable_sigint)
@@ -150,11 +361,43 @@ void turbulence_signal_install (TurbulenceCtx           * ctx,
 /*	signal (SIGKILL, signal_handler); */
 	signal (SIGQUIT, signal_handler);
 
-	/* check for sighup */
-	if (enable_sighup)
+	/* check for sighup (and sigusr2, binary upgrade, which is
+	 * also only handled by the master process) */
+	if (enable_sighup) {
+		/* self-pipe to defer reload and upgrade out of the
+		 * signal handler (read end watched by
+		 * turbulence_signal_loop_start) */
+		if (ctx->signal_pipe[0] < 0) {
+			if (pipe (ctx->signal_pipe) == 0) {
+				for (iterator = 0; iterator < 2; iterator++) {
+					fcntl (ctx->signal_pipe[iterator], F_SETFL, O_NONBLOCK);
+					fcntl (ctx->signal_pipe[iterator], F_SETFD, FD_CLOEXEC);
+				} /* end for */
+			} else {
+				error ("unable to create signal pipe, SIGHUP will be handled inside the signal handler and SIGUSR2 ignored, errno=%d", errno);
+				ctx->signal_pipe[0] = -1;
+				ctx->signal_pipe[1] = -1;
+			} /* end if */
+		} /* end if */
+
 		signal (SIGHUP,  signal_handler);
-	else
+		signal (SIGUSR2, signal_handler);
+	} else {
 		signal (SIGHUP, NULL);
+		signal (SIGUSR2, NULL);
+	} /* end if */
+#endif
+
+#if defined(ENABLE_SIGNALFD)
+	/* master process receives SIGCHLD through a signalfd
+	 * (turbulence_signal_sigchld): block it now, before threads
+	 * are created, so all of them inherit the mask and the signal
+	 * is never delivered to a thread. Childs (started with this
+	 * mask) restore it. */
+	if (enable_sighup)
+		turbulence_signal_block (ctx, SIGCHLD);
+	else
+		turbulence_signal_unblock (ctx, SIGCHLD);
 #endif
 
 	/* configure handlers received */
@@ -164,9 +407,9 @@ void turbulence_signal_install (TurbulenceCtx           * ctx,
 }
 
 #define CHECK_AND_REPORT_MAIL_TO(subject, body, file) do{		           \
-	if (HAS_ATTR (node, "mail-to")) {				           \
+	if (mail_to) {							           \
 		turbulence_support_simple_smtp_send (ctx,		           \
-						     ATTR_VALUE (node, "mail-to"), \
+						     mail_to,		           \
 						     subject, body, file);         \
 	} /* end if */							           \
 } while (0)
@@ -297,9 +540,10 @@ static axl_bool __turbulence_signal_is_fault (int _signal)
 void turbulence_signal_exit (TurbulenceCtx * ctx, int _signal)
 {
 	/* get turbulence context */
-	axlDoc           * doc;
-	axlNode          * node;
-	VortexAsyncQueue * queue;
+	TurbulenceBadSignalAction   action;
+	const char                * mail_to = NULL;
+	int                         slot;
+	VortexAsyncQueue          * queue;
 	char             * backtrace_file;
 
 	/* lock the mutex and check */
@@ -346,11 +590,19 @@ void turbulence_signal_exit (TurbulenceCtx * ctx, int _signal)
 		error ("caught %s, anomalous termination (this is an internal turbulence or module error)",
 		       _signal == SIGSEGV ? "SIGSEGV" : "SIGABRT");
 		
-		/* check current termination option */
-		doc  = turbulence_config_get (ctx);
-		node = axl_doc_get (doc, "/turbulence/global-settings/on-bad-signal");
-		error ("applying configured action %s", (node && HAS_ATTR (node, "action")) ? ATTR_VALUE (node, "action") : "not defined");
-		if (HAS_ATTR_VALUE (node, "action", "ignore")) {
+		/* check current termination option: values copied
+		 * when the snapshot was installed are used because a
+		 * snapshot can't be referenced from a fault handler
+		 * (a concurrent reload may release it) */
+		action  = TBC_ATOMIC_LOAD (ctx->bad_signal_action);
+		slot    = TBC_ATOMIC_LOAD (ctx->bad_signal_mail_to_slot);
+		mail_to = (slot == 0 || slot == 1) ? ctx->bad_signal_mail_to[slot] : NULL;
+		error ("applying configured action %s", 
+		       action == TBC_BAD_SIGNAL_HOLD ? "hold" :
+		       action == TBC_BAD_SIGNAL_IGNORE ? "ignore" :
+		       action == TBC_BAD_SIGNAL_BACKTRACE ? "backtrace" :
+		       action == TBC_BAD_SIGNAL_EXIT ? "exit" : "not defined");
+		if (action == TBC_BAD_SIGNAL_IGNORE) {
 			/* do notify if enabled */
 			CHECK_AND_REPORT_MAIL_TO ("Bad signal received at turbulence process, default action: ignore",
 						  "Received termination signal but it was ignored.",
@@ -370,7 +622,7 @@ void turbulence_signal_exit (TurbulenceCtx * ctx, int _signal)
 
 			/* ignore the signal emision */
 			return;
-		} else if (HAS_ATTR_VALUE (node, "action", "hold")) {
+		} else if (action == TBC_BAD_SIGNAL_HOLD) {
 			/* lock the process */
 			error ("Bad signal found, locking process, now you can attach or terminate pid: %d", 
 			       getpid ());
@@ -380,7 +632,7 @@ void turbulence_signal_exit (TurbulenceCtx * ctx, int _signal)
 			queue = vortex_async_queue_new ();
 			vortex_async_queue_pop (queue);
 			return;
-		} else if (HAS_ATTR_VALUE (node, "action", "backtrace")) {
+		} else if (action == TBC_BAD_SIGNAL_BACKTRACE) {
 			/* create temporal file */
 			error ("Bad signal found, creating backtrace for current process: %d", getpid ());
 			backtrace_file = turbulence_support_get_backtrace (ctx, getpid ());
@@ -46,6 +46,10 @@ void turbulence_signal_install (TurbulenceCtx           * ctx,
 
 void turbulence_signal_sigchld (TurbulenceCtx * ctx, axl_bool enable);
 
+void turbulence_signal_loop_start (TurbulenceCtx * ctx);
+
+void turbulence_signal_loop_stop  (TurbulenceCtx * ctx);
+
 int turbulence_signal_received (TurbulenceCtx * ctx, 
 				int            _signal);
 
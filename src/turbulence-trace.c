@@ -0,0 +1,394 @@
+/*  Turbulence BEEP application server
+ *  Copyright (C) 2025 Advanced Software Production Line, S.L.
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; version 2.1 of the
+ *  License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free
+ *  Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307 USA
+ *  
+ *  You may find a copy of the license under this software is released
+ *  at COPYING file. This is LGPL software: you are welcome to develop
+ *  proprietary applications using this library without any royalty or
+ *  fee but returning back any change, improvement or addition in the
+ *  form of source code, project image, documentation patches, etc.
+ *
+ *  For commercial support on build BEEP enabled solutions, supporting
+ *  turbulence based solutions, etc, contact us:
+ *          
+ *      Postal address:
+ *         Advanced Software Production Line, S.L.
+ *         C/ Antonio Suarez Nº10, Edificio Alius A, Despacho 102
+ *         Alcala de Henares, 28802 (MADRID)
+ *         Spain
+ *
+ *      Email address:
+ *         info@aspl.es - http://www.aspl.es/turbulence
+ */
+#if defined(__linux__)
+/* required for clock_gettime and CLOCK_MONOTONIC with -ansi */
+#define _GNU_SOURCE
+#endif
+#include <turbulence.h>
+#include <time.h>
+
+/* local include */
+#include <turbulence-ctx-private.h>
+
+/** 
+ * \defgroup turbulence_trace Turbulence Trace: connection lifecycle latency
+ */
+
+/** 
+ * \addtogroup turbulence_trace
+ * @{
+ */
+
+/**
+ * @internal Connection data key where the trace is stored.
+ */
+#define TBC_TRACE_KEY "tbc:trace"
+
+/**
+ * @internal Trace attached to a connection: monotonic stamps (in
+ * microseconds) for each stage reached (0 if not reached). The trace
+ * is allocated from the connection arena.
+ */
+typedef struct _TurbulenceTrace {
+	long stamps[TBC_TRACE_STAGES];
+} TurbulenceTrace;
+
+/** 
+ * @brief Returns current monotonic time in microseconds. Values are
+ * comparable between master and childs (same host) but have no
+ * relation with wall clock time.
+ *
+ * @return Current monotonic stamp.
+ */
+long               turbulence_trace_now          (void)
+{
+#if defined(CLOCK_MONOTONIC)
+	struct timespec now;
+
+	if (clock_gettime (CLOCK_MONOTONIC, &now) != 0)
+		return 0;
+	return (now.tv_sec * 1000000L) + (now.tv_nsec / 1000);
+#else
+	struct timeval now;
+
+	gettimeofday (&now, NULL);
+	return (now.tv_sec * 1000000L) + now.tv_usec;
+#endif
+}
+
+/** 
+ * @internal Gets the trace associated to the connection, optionally
+ * creating it.
+ */
+TurbulenceTrace * __turbulence_trace_get (TurbulenceCtx * ctx, VortexConnection * conn, axl_bool create)
+{
+	TurbulenceTrace * trace;
+
+	trace = vortex_connection_get_data (conn, TBC_TRACE_KEY);
+	if (trace != NULL || ! create)
+		return trace;
+
+	/* released with the arena, so no destroy function */
+	trace = TBC_ARENA_NEW (turbulence_conn_mgr_arena (ctx, conn), TurbulenceTrace);
+	if (trace == NULL)
+		return NULL;
+	vortex_connection_set_data_full (conn, TBC_TRACE_KEY, trace, NULL, NULL);
+	return trace;
+}
+
+/** 
+ * @internal Reports stage latencies once the connection reached its
+ * first channel.
+ */
+void __turbulence_trace_report (TurbulenceCtx * ctx, VortexConnection * conn, TurbulenceTrace * trace)
+{
+	TurbulencePPathDef * def;
+	long                 previous;
+	long                 elapsed;
+	int                  stage;
+
+	def      = turbulence_ppath_selected (conn);
+	previous = trace->stamps[TBC_TRACE_ACCEPT];
+	if (def == NULL || previous == 0)
+		return;
+
+	/* each stage accounts the time since the previous stage reached */
+	for (stage = TBC_TRACE_SELECTED; stage < TBC_TRACE_STAGES; stage++) {
+		if (trace->stamps[stage] == 0)
+			continue;
+		elapsed  = trace->stamps[stage] - previous;
+		turbulence_metric_observe (def->metric_stages[stage], elapsed > 0 ? elapsed : 0);
+		previous = trace->stamps[stage];
+	} /* end for */
+
+	/* total time */
+	elapsed = trace->stamps[TBC_TRACE_FIRST_CHANNEL] - trace->stamps[TBC_TRACE_ACCEPT];
+	turbulence_metric_observe (def->metric_stages[0], elapsed > 0 ? elapsed : 0);
+
+	msg2 ("conn-id=%d first channel %ld us after accept (profile path: %s)",
+	      vortex_connection_get_id (conn), elapsed, turbulence_ppath_get_name (def));
+	return;
+}
+
+/** 
+ * @brief Records the provided stage as reached by the connection. Only
+ * the first call for each stage is considered. Connections are traced
+ * from \ref TBC_TRACE_ACCEPT: other stages are ignored on connections
+ * without trace. Reaching \ref TBC_TRACE_FIRST_CHANNEL reports the
+ * latency of every stage into the profile path histograms
+ * (turbulence_connection_stage_microseconds).
+ *
+ * @param ctx The turbulence context.
+ * @param conn The connection reaching the stage.
+ * @param stage The stage reached.
+ */
+void               turbulence_trace_mark         (TurbulenceCtx        * ctx,
+						  VortexConnection     * conn,
+						  TurbulenceTraceStage   stage)
+{
+	TurbulenceTrace * trace;
+
+	if (ctx == NULL || conn == NULL || stage < 0 || stage >= TBC_TRACE_STAGES)
+		return;
+
+	trace = __turbulence_trace_get (ctx, conn, stage == TBC_TRACE_ACCEPT);
+	if (trace == NULL || trace->stamps[stage] != 0)
+		return;
+	trace->stamps[stage] = turbulence_trace_now ();
+
+	if (stage == TBC_TRACE_FIRST_CHANNEL)
+		__turbulence_trace_report (ctx, conn, trace);
+	return;
+}
+
+/** 
+ * @brief Returns the monotonic stamp when the connection reached the
+ * provided stage.
+ *
+ * @param conn The connection to check.
+ * @param stage The stage to check.
+ *
+ * @return The stamp (see \ref turbulence_trace_now) or 0 if the stage
+ * was not reached or the connection is not traced.
+ */
+long               turbulence_trace_get          (VortexConnection     * conn,
+						  TurbulenceTraceStage   stage)
+{
+	TurbulenceTrace * trace;
+
+	if (conn == NULL || stage < 0 || stage >= TBC_TRACE_STAGES)
+		return 0;
+	trace = vortex_connection_get_data (conn, TBC_TRACE_KEY);
+	return trace ? trace->stamps[stage] : 0;
+}
+
+/** 
+ * @brief Returns the name used to report the provided stage (stage
+ * label of turbulence_connection_stage_microseconds). \ref
+ * TBC_TRACE_ACCEPT is reported as "total".
+ *
+ * @param stage The stage.
+ *
+ * @return The stage name or NULL if the stage is not valid.
+ */
+const char       * turbulence_trace_stage_name   (TurbulenceTraceStage   stage)
+{
+	switch (stage) {
+	case TBC_TRACE_ACCEPT:
+		return "total";
+	case TBC_TRACE_SELECTED:
+		return "select";
+	case TBC_TRACE_SPAWNED:
+		return "spawn";
+	case TBC_TRACE_HANDOFF:
+		return "handoff";
+	case TBC_TRACE_CHILD_READY:
+		return "child-init";
+	case TBC_TRACE_RECEIVED:
+		return "transfer";
+	case TBC_TRACE_FIRST_CHANNEL:
+		return "first-channel";
+	default:
+		break;
+	} /* end switch */
+	return NULL;
+}
+
+/** 
+ * @internal Registers the per stage histograms of the provided
+ * profile path.
+ */
+void               turbulence_trace_ppath_init   (TurbulenceCtx        * ctx,
+						  TurbulencePPathDef   * def)
+{
+	char * ppath;
+	char * labels;
+	int    stage;
+
+	ppath = turbulence_metrics_label ("ppath", def->path_name);
+	for (stage = 0; stage < TBC_TRACE_STAGES; stage++) {
+		labels = axl_strdup_printf ("%s,stage=\"%s\"", ppath ? ppath : "", turbulence_trace_stage_name (stage));
+		def->metric_stages[stage] = turbulence_metrics_get (ctx, TBC_METRIC_HISTOGRAM, "turbulence_connection_stage_microseconds", labels,
+								    "Time spent by connections on each stage from accept to the first channel");
+		axl_free (labels);
+	} /* end for */
+	axl_free (ppath);
+	return;
+}
+
+/** 
+ * @internal Records \ref TBC_TRACE_HANDOFF and adds the connection
+ * trace to the conn_status string sent to the child (see
+ * turbulence_process_connection_status_string). The trace is placed
+ * as the field before the last one: the child checks the last
+ * character (skip_conn_recover) and parses fields up to
+ * remote_host_ip, so both remain unchanged.
+ *
+ * @param ctx The turbulence context.
+ * @param conn The connection being sent.
+ * @param conn_status The status string to extend (released if a new
+ * string is returned).
+ *
+ * @return The conn_status string to send.
+ */
+char             * turbulence_trace_append       (TurbulenceCtx        * ctx,
+						  VortexConnection     * conn,
+						  char                 * conn_status)
+{
+	TurbulenceTrace * trace;
+	char              field[TBC_TRACE_STAGES * 22 + 2];
+	char            * result;
+	int               length;
+	int               iterator;
+	int               stage;
+
+	if (conn_status == NULL)
+		return NULL;
+
+	turbulence_trace_mark (ctx, conn, TBC_TRACE_HANDOFF);
+	trace = __turbulence_trace_get (ctx, conn, axl_false);
+	if (trace == NULL)
+		return conn_status;
+
+	/* find last field */
+	iterator = strlen (conn_status) - 3;
+	while (iterator >= 0 && ! axl_memcmp (conn_status + iterator, ";-;", 3))
+		iterator--;
+	if (iterator < 0)
+		return conn_status;
+
+	/* t<stamp>,<stamp>,... */
+	field[0] = 't';
+	length   = 1;
+	for (stage = 0; stage < TBC_TRACE_STAGES; stage++) 
+		length += sprintf (field + length, stage == 0 ? "%ld" : ",%ld", trace->stamps[stage]);
+
+	/* skip the trace if the status would not fit into the data
+	 * passed along with the socket (TBC_PROCESS_ANCILLARY_MAX) */
+	if ((int) strlen (conn_status) + length + 3 > TBC_PROCESS_ANCILLARY_MAX - 1)
+		return conn_status;
+
+	/* place it before the last field */
+	result = axl_strdup_printf ("%.*s;-;%s%s", iterator, conn_status, field, conn_status + iterator);
+	if (result == NULL)
+		return conn_status;
+	axl_free (conn_status);
+	return result;
+}
+
+/** 
+ * @internal Recovers trace stamps from the conn_status string
+ * received from the master (see turbulence_trace_append). It must
+ * be called before turbulence_process_connection_recover_status
+ * because that function modifies the string.
+ *
+ * @param conn_status The status string received.
+ *
+ * @param stamps Array of TBC_TRACE_STAGES items where stamps are
+ * placed (all 0 if the string has no trace).
+ */
+void               turbulence_trace_parse        (const char           * conn_status,
+						  long                 * stamps)
+{
+	int    last;
+	int    iterator;
+	int    stage;
+	char * end;
+
+	memset (stamps, 0, sizeof (long) * TBC_TRACE_STAGES);
+	if (conn_status == NULL)
+		return;
+
+	/* find last field and the one before it */
+	last = strlen (conn_status) - 3;
+	while (last >= 0 && ! axl_memcmp (conn_status + last, ";-;", 3))
+		last--;
+	iterator = last - 3;
+	while (iterator >= 0 && ! axl_memcmp (conn_status + iterator, ";-;", 3))
+		iterator--;
+	if (last < 0 || iterator < 0 || conn_status[iterator + 3] != 't')
+		return;
+
+	/* parse stamps */
+	conn_status += iterator + 4;
+	for (stage = 0; stage < TBC_TRACE_STAGES; stage++) {
+		stamps[stage] = strtol (conn_status, &end, 10);
+		if (*end != ',')
+			break;
+		conn_status = end + 1;
+	} /* end for */
+	return;
+}
+
+/** 
+ * @internal Child side: installs on the connection restored the
+ * trace received from the master and records \ref
+ * TBC_TRACE_RECEIVED. The connection that caused the child creation
+ * also gets \ref TBC_TRACE_CHILD_READY.
+ *
+ * @param ctx The turbulence context.
+ * @param conn The connection restored.
+ * @param stamps Stamps recovered by turbulence_trace_parse.
+ */
+void               turbulence_trace_restore      (TurbulenceCtx        * ctx,
+						  VortexConnection     * conn,
+						  long                 * stamps)
+{
+	TurbulenceTrace * trace;
+
+	if (ctx == NULL || conn == NULL || stamps == NULL || stamps[TBC_TRACE_ACCEPT] == 0)
+		return;
+
+	trace = __turbulence_trace_get (ctx, conn, axl_true);
+	if (trace == NULL)
+		return;
+	memcpy (trace->stamps, stamps, sizeof (trace->stamps));
+
+	/* child startup is only reported once, with the connection
+	 * that caused the child to be created */
+	if (ctx->child && ctx->child->trace_ready && trace->stamps[TBC_TRACE_SPAWNED]) {
+		trace->stamps[TBC_TRACE_CHILD_READY] = ctx->child->trace_ready;
+		ctx->child->trace_ready              = 0;
+	} /* end if */
+
+	turbulence_trace_mark (ctx, conn, TBC_TRACE_RECEIVED);
+	return;
+}
+
+/** 
+ * @}
+ */
@@ -77,6 +77,116 @@ typedef struct _TurbulenceModule TurbulenceModule;
  */
 typedef struct _TurbulenceChild  TurbulenceChild;
 
+/** 
+ * @brief Type representing the configuration compiled into typed
+ * values. See \ref turbulence_config_snapshot.
+ */
+typedef struct _TurbulenceConfigSnapshot TurbulenceConfigSnapshot;
+
+/** 
+ * @brief Memory pool used to allocate state that is released all at
+ * once. See \ref turbulence_arena.
+ */
+typedef struct _TurbulenceArena TurbulenceArena;
+
+/** 
+ * @brief A metric registered at the turbulence metrics registry. See
+ * \ref turbulence_metrics.
+ */
+typedef struct _TurbulenceMetric TurbulenceMetric;
+
+/** 
+ * @brief Token bucket used to limit the bandwidth of a
+ * connection. See \ref turbulence_shaper.
+ */
+typedef struct _TurbulenceShaper TurbulenceShaper;
+
+/** 
+ * @brief Kinds of metrics supported by \ref turbulence_metrics_get.
+ */
+typedef enum {
+	/** 
+	 * @brief Value that only increases (number of events).
+	 */
+	TBC_METRIC_COUNTER   = 1,
+	/** 
+	 * @brief Value that can go up and down.
+	 */
+	TBC_METRIC_GAUGE     = 2,
+	/** 
+	 * @brief Distribution of values observed, accounted into
+	 * power of two buckets (1, 2, 4, 8...).
+	 */
+	TBC_METRIC_HISTOGRAM = 3
+} TurbulenceMetricType;
+
+/** 
+ * @brief Stages a connection goes through from accept to its first
+ * channel. See \ref turbulence_trace.
+ */
+typedef enum {
+	/** 
+	 * @brief Connection accepted by the master process.
+	 */
+	TBC_TRACE_ACCEPT        = 0,
+	/** 
+	 * @brief Profile path selected for the connection.
+	 */
+	TBC_TRACE_SELECTED      = 1,
+	/** 
+	 * @brief Child process created (fork) to handle the
+	 * connection (only when a new child is created).
+	 */
+	TBC_TRACE_SPAWNED       = 2,
+	/** 
+	 * @brief Connection state prepared to be sent to the child.
+	 */
+	TBC_TRACE_HANDOFF       = 3,
+	/** 
+	 * @brief Child process running and linked to the master
+	 * (only when a new child is created).
+	 */
+	TBC_TRACE_CHILD_READY   = 4,
+	/** 
+	 * @brief Connection restored at the child.
+	 */
+	TBC_TRACE_RECEIVED      = 5,
+	/** 
+	 * @brief First channel accepted on the connection.
+	 */
+	TBC_TRACE_FIRST_CHANNEL = 6,
+	/** 
+	 * @internal Number of stages.
+	 */
+	TBC_TRACE_STAGES        = 7
+} TurbulenceTraceStage;
+
+/** 
+ * @brief Actions that can be configured at <b>&lt;on-bad-signal></b>.
+ */
+typedef enum {
+	/** 
+	 * @brief No action was configured.
+	 */
+	TBC_BAD_SIGNAL_NOT_DEFINED = 0,
+	/** 
+	 * @brief action="hold"
+	 */
+	TBC_BAD_SIGNAL_HOLD        = 1,
+	/** 
+	 * @brief action="ignore"
+	 */
+	TBC_BAD_SIGNAL_IGNORE      = 2,
+	/** 
+	 * @brief action="backtrace"
+	 */
+	TBC_BAD_SIGNAL_BACKTRACE   = 3,
+	/** 
+	 * @brief action="quit" or action="exit"
+	 */
+	TBC_BAD_SIGNAL_EXIT        = 4
+} TurbulenceBadSignalAction;
+
 /** 
  * @brief Set of handlers that are supported by modules. This handler
  * descriptors are used by some functions to notify which handlers to
@@ -71,71 +71,45 @@ int fsync (int fd);
 
 void __turbulence_thread_pool_conf (TurbulenceCtx * ctx)
 {
-	int        max_limit   = 40;
-	int        step_period = 5;
-	int        step_add    = 1;
-	int        value;
-
-	/* get max limit for the pool */
-	value = turbulence_config_get_number (ctx, "/turbulence/global-settings/thread-pool", "max-limit");
-	if (value > 0)
-		max_limit = value;
-
-	/* get step period */
-	value = turbulence_config_get_number (ctx, "/turbulence/global-settings/thread-pool", "step-period");
-	if (value > 0)
-		step_period = value;
-
-	/* get step-add */
-	value = turbulence_config_get_number (ctx, "/turbulence/global-settings/thread-pool", "step-add");
-	if (value > 0)
-		step_add = value;
+	TurbulenceConfigSnapshot * snapshot = turbulence_config_snapshot (ctx);
 
 	/* configure the pool */
-	msg ("Setting thread pool to max-limit=%d, step-add=%d, step-period=%d", max_limit, step_add, step_period);
-	vortex_thread_pool_setup (ctx->vortex_ctx, max_limit, step_add, step_period, axl_true);
+	msg ("Setting thread pool to max-limit=%d, step-add=%d, step-period=%d", 
+	     snapshot->thread_pool_max_limit, snapshot->thread_pool_step_add, snapshot->thread_pool_step_period);
+	vortex_thread_pool_setup (ctx->vortex_ctx, snapshot->thread_pool_max_limit, 
+				  snapshot->thread_pool_step_add, snapshot->thread_pool_step_period, axl_true);
 
+	turbulence_config_snapshot_unref (snapshot);
 	return;
 }
 
 /* configure here back log */
 void __turbulence_server_backlog (TurbulenceCtx * ctx)
 {
-	int        backlog     = 50;
-	int        value;
-
-	/* get the TCP backlog configured */
-	value = turbulence_config_get_number (ctx, "/turbulence/global-settings/server-backlog", "value");
-	if (value > 0)
-		backlog = value;
+	TurbulenceConfigSnapshot * snapshot = turbulence_config_snapshot (ctx);
 
 	/* configure backlog */
-	msg ("Configuring server TCP backlog: %d", backlog);
-	vortex_conf_set (ctx->vortex_ctx, VORTEX_LISTENER_BACKLOG, backlog, NULL);
+	msg ("Configuring server TCP backlog: %d", snapshot->server_backlog);
+	vortex_conf_set (ctx->vortex_ctx, VORTEX_LISTENER_BACKLOG, snapshot->server_backlog, NULL);
+
+	turbulence_config_snapshot_unref (snapshot);
 	return;
 }
 
 /* configure several limits */
 void __turbulence_acquire_limits (TurbulenceCtx * ctx)
 {
-	int        value;
+	TurbulenceConfigSnapshot * snapshot = turbulence_config_snapshot (ctx);
 
 	/* get global child limit */
-	value = turbulence_config_get_number (ctx, "/turbulence/global-settings/global-child-limit", "value");
-	if (value > 0)
-		ctx->global_child_limit = value;
-	else
-		ctx->global_child_limit = 100;
+	ctx->global_child_limit = snapshot->global_child_limit;
 	msg ("Configured global-child-limit=%d", ctx->global_child_limit);
 
 	/* get max size allowed for an incoming complete frame */
-	value = turbulence_config_get_number (ctx, "/turbulence/global-settings/max-incoming-complete-frame-limit", "value");
-	if (value > 0)
-		ctx->max_complete_flag_limit = value;
-	else
-		ctx->max_complete_flag_limit = 32768;
+	ctx->max_complete_flag_limit = snapshot->max_complete_flag_limit;
 	msg ("Configured max-incoming-complete-frame-limit=%d", ctx->max_complete_flag_limit);
 
+	turbulence_config_snapshot_unref (snapshot);
 	return;
 }
 
@@ -263,10 +237,63 @@ axl_bool  turbulence_init (TurbulenceCtx * ctx,
 	/* init connection manager: reinit=axl_false */
 	turbulence_conn_mgr_init (ctx, axl_false);
 
+	/* register core metrics and start serving them (if
+	 * configured) */
+	turbulence_metrics_init (ctx);
+
+	/* handle signals deferred by the signal handler (reload) */
+	turbulence_signal_loop_start (ctx);
+
 	/* init ok */
 	return axl_true;
 }
 
+/** 
+ * @internal Loads the configuration file again and, if it is valid,
+ * replaces the running configuration and profile paths. Everything
+ * is built off to the side, so in the case of failure the running
+ * configuration is not touched. A configuration that did not change
+ * (same content as the running one) is not installed again.
+ */
+axl_bool __turbulence_reload_running_config (TurbulenceCtx * ctx)
+{
+	axlDoc          * doc;
+	TurbulencePPath * paths;
+
+	/* load and validate */
+	doc = turbulence_config_parse (ctx, ctx->config_path);
+	if (doc == NULL) {
+		error ("reload: configuration at %s is not valid, keeping running configuration", ctx->config_path);
+		return axl_false;
+	} /* end if */
+
+	/* nothing to install if it did not change */
+	if (turbulence_config_is_running (ctx, doc)) {
+		msg ("reload: configuration %s not changed, keeping running configuration", ctx->config_path);
+		axl_doc_free (doc);
+		return axl_false;
+	} /* end if */
+
+	/* build profile paths */
+	paths = turbulence_ppath_build (ctx, doc);
+	if (paths == NULL) {
+		error ("reload: unable to build profile paths from %s, keeping running configuration", ctx->config_path);
+		axl_doc_free (doc);
+		return axl_false;
+	} /* end if */
+
+	/* swap: from here new connections are selected against the
+	 * new profile paths while connections already accepted keep
+	 * their profile path state (previous definitions and the
+	 * document they borrow from are released with the last
+	 * connection or child referencing them) */
+	turbulence_config_replace (ctx, doc);
+	turbulence_ppath_install (ctx, paths);
+
+	msg ("reload: configuration %s installed", ctx->config_path);
+	return axl_true;
+}
+
 /** 
  * @brief Function that performs a reload operation for the current
  * turbulence instance (represented by the provided TurbulenceCtx).
@@ -280,6 +307,8 @@ axl_bool  turbulence_init (TurbulenceCtx * ctx,
  */
 void     turbulence_reload_config       (TurbulenceCtx * ctx, int value)
 {
+	axl_bool reloaded = axl_false;
+
 	msg ("caught HUP signal, reloading configuration");
 	/* reconfigure signal received, notify turbulence modules the
 	 * signal. The exit_mutex serializes concurrent reloads (and against
@@ -289,12 +318,38 @@ void     turbulence_reload_config       (TurbulenceCtx * ctx, int value)
 	/* call to reload logs */
 	__turbulence_log_reopen (ctx);
 
+	/* load configuration file again and swap profile paths (only
+	 * the master process: childs keep the configuration they
+	 * were created with) */
+	if (! turbulence_ctx_is_child (ctx))
+		reloaded = __turbulence_reload_running_config (ctx);
+
 	/* reload turbulence here, before modules
 	 * reloading */
 	turbulence_db_list_reload_module ();
 	
-	/* reload modules */
+	/* reload modules: new profile paths are already installed so
+	 * modules can rebuild state indexed by profile path id */
 	turbulence_module_notify_reload_conf (ctx);
+
+	/* compile a new configuration snapshot (after modules have
+	 * reloaded so schemas registered by them see their new
+	 * configuration) and install it. Readers using the previous
+	 * snapshot finish with it */
+	turbulence_config_snapshot_rebuild (ctx);
+
+	if (reloaded) {
+		/* apply limits and thread pool settings */
+		__turbulence_acquire_limits (ctx);
+		__turbulence_thread_pool_conf (ctx);
+
+		/* close listeners removed and start listeners added */
+		turbulence_run_reload_listeners (ctx, turbulence_config_get (ctx));
+
+		/* childs created for previous profile paths finish
+		 * once their connections are closed */
+		turbulence_process_retire_stale_childs (ctx);
+	} /* end if */
 	vortex_mutex_unlock (&ctx->exit_mutex);
 
 	return;
@@ -318,6 +373,13 @@ void turbulence_exit (TurbulenceCtx * ctx,
 
 	msg ("%s: turbulence_exit: called, finishing turbulence (TurbulenceCtx: %p)..", turbulence_ctx_is_child (ctx) ? "CHILD" : "MASTER", ctx);
 
+	/* stop handling deferred signals (waits for a reload
+	 * running) */
+	turbulence_signal_loop_stop (ctx);
+
+	/* stop accepting connections on SO_REUSEPORT listeners */
+	turbulence_run_stop_acceptors (ctx);
+
 	/* check to kill childs */
 	turbulence_process_kill_childs (ctx);
 
@@ -325,6 +387,9 @@ void turbulence_exit (TurbulenceCtx * ctx,
 	 * once connections have been unrefered) */
 	turbulence_config_cleanup (ctx);
 
+	/* resume connections delayed by bandwidth shaping */
+	turbulence_shaper_cleanup (ctx);
+
 	/* unref all connections (before calling to terminate vortex) */
 	turbulence_conn_mgr_cleanup (ctx);
 
@@ -364,6 +429,10 @@ void turbulence_exit (TurbulenceCtx * ctx,
 	/* terminate proxy loop (if started) */
 	turbulence_loop_close (ctx->proxy_loop, axl_true);
 
+	/* release metrics (vortex is already stopped so no handler
+	 * can update them) */
+	turbulence_metrics_cleanup (ctx);
+
 	/* free mutex */
 	vortex_mutex_destroy (&ctx->exit_mutex);
 
@@ -1631,6 +1700,7 @@ void            turbulence_sleep           (TurbulenceCtx * ctx,
  *   - \ref turbulence_db_list_management "2.7 Turbulence Db-List management"
  *   - \ref turbulence_configure_system_paths
  *   - \ref turbulence_configure_splitting
+ *   - \ref turbulence_configure_metrics
  *
  * <b>Section 3: BEEP profile management</b>
  *
@@ -1783,6 +1853,20 @@ void            turbulence_sleep           (TurbulenceCtx * ctx,
  * href="beep-applications-and-ports.html">Building wrong port
  * oriented network applications</a>). 
  *
+ * On platforms supporting SO_REUSEPORT (Linux 3.9 or later), the
+ * <b>&lt;listener></b> node accepts an <b>acceptors</b> attribute
+ * to open several listening sockets on each port, each one serviced
+ * by its own acceptor thread. The kernel load balances new
+ * connections between them, which helps to absorb reconnect storms
+ * that otherwise overflow the single socket backlog (see
+ * <b>&lt;server-backlog></b>, which applies to each socket):
+ *
+ * \code
+ *  <listener acceptors="4">
+ *    <name>0.0.0.0</name>
+ *  </listener>
+ * \endcode
+ *
  * 
  * Alternatively, during development or when it is found a turbulence
  * bug, it is handy to configure the default action to take on server
@@ -1933,6 +2017,69 @@ void            turbulence_sleep           (TurbulenceCtx * ctx,
  * Previous declaration import all content from files found in
  * <b>/etc/turbulence/profile.d</b> replacing the <b>include</b> node.
  *
+ * \section turbulence_configure_metrics 2.9 Exposing runtime metrics
+ *
+ * Turbulence keeps a set of counters, gauges and histograms about
+ * its activity (connections accepted, profile path selections,
+ * childs created, handoff latency, channels started, SASL outcomes,
+ * log relay backlog..). They can be read by any tool supporting the
+ * Prometheus text exposition format by placing the following inside
+ * <b><global-settings></b>:
+ *
+ * \code
+ * <metrics listen="127.0.0.1" port="9464" />
+ * \endcode
+ *
+ * The master process will then answer <b>GET /metrics</b> requests
+ * on that address (<b>listen</b> is optional and defaults to
+ * 127.0.0.1). Values reported by childs are requested over the
+ * master-child link and added to master values, so the output
+ * always covers the whole server. Childs not answering in time are
+ * skipped.
+ *
+ * The listener provides no authentication, so keep it bound to a
+ * local or otherwise protected address.
+ *
+ * Each profile path also reports how long connections take from
+ * accept to their first channel, split by stage
+ * (<b>turbulence_connection_stage_microseconds</b>, label
+ * <b>stage</b>):
+ *
+ * - <b>select</b>: until a profile path is selected (this includes
+ * waiting for the first channel start request when the profile path
+ * depends on serverName).
+ * - <b>spawn</b>: creating the child process (only when a new child is created).
+ * - <b>handoff</b>: until the connection is ready to be sent to the child.
+ * - <b>child-init</b>: until the new child is running and linked to the master.
+ * - <b>transfer</b>: until the connection is restored at the child.
+ * - <b>first-channel</b>: until the first channel is accepted.
+ * - <b>total</b>: from accept to the first channel.
+ *
+ * Stages not reached by a connection are not reported (for example,
+ * connections sent to an already running child have no
+ * <b>spawn</b> or <b>child-init</b> values). Comparing these values
+ * helps deciding whether to keep childs running (reuse) for
+ * a profile path.
+ *
+ * To measure a configuration under load, <b>tbc-bench</b> opens
+ * connections against a running server and reports throughput and
+ * latency percentiles as a JSON document. Each scenario is selected
+ * by command line options (connections, concurrency, connection
+ * rate, channels, message size and rate, TLS and SASL logins) while
+ * profile path behaviour (<b>separate</b>, <b>reuse</b>, proxy on
+ * parent..) comes from the server configuration, picking the profile
+ * path with <b>--server-name</b>. By default channels are opened with
+ * the echo profile provided by <b>mod-test</b>:
+ *
+ * \code
+ * >> tbc-bench --port 602 --server-name bench.separate --scenario separate \
+ *              -c 1000 -j 16 --channels 2 -m 50 -s 1024 -o separate.json
+ * \endcode
+ *
+ * Keys reported are stable across versions, so reports from two runs
+ * can be compared to spot regressions. The tool exits with 1 if any
+ * connection or message failed.
+ *
  * \section profile_path_configuration 3.1 Profile path configuration
  *
  * Profile Path is a feature that allows to configure which profiles
@@ -2014,6 +2161,61 @@ void            turbulence_sleep           (TurbulenceCtx * ctx,
  * connection associated to a profile path, next connections are sent
  * to that child rather creating a new child process.</li>
  *
+ * <li><b>reuse-workers</b>: [child number] Default 1. Requires
+ * reuse="yes". Number of childs created and reused to handle
+ * connections for this profile path. Connections are spread over
+ * them (round robin) and all channels of a connection are handled by
+ * the same child. Useful to run single threaded engines (like
+ * mod-python apps) on several cores.</li>
+ *
+ * <li><b>idle-timeout</b>: [seconds] Default 30. Requires
+ * reuse="yes". Seconds a reused child without connections waits for
+ * new ones before finishing. The minimum is 1: the wait covers
+ * connections already accepted by the master that are still being
+ * sent to the child.</li>
+ *
+ * <li><b>max-connections-served</b>: [number] Requires
+ * reuse="yes". Once a reused child has been sent this number of
+ * connections, it is retired: the master stops sending it new
+ * connections, the child finishes as soon as its current connections
+ * are closed, and a new child is created for the next connection.</li>
+ *
+ * <li><b>max-rss</b>: [size, for example 512M] Requires
+ * reuse="yes". Retires a reused child (like max-connections-served)
+ * once its resident memory is bigger than the provided size (bytes
+ * or a K, M or G suffix). Useful with modules whose memory usage
+ * grows with time.</li>
+ *
+ * <li><b>cpu-affinity</b>: [cpu list, for example 0-3,8] Requires
+ * separate="yes". Binds childs created for this profile path to the
+ * provided cpus.</li>
+ *
+ * <li><b>numa-spread</b>: [yes|no] Default no. Requires
+ * separate="yes". Childs created for this profile path are spread
+ * over the NUMA nodes of the system (round robin): each one is bound
+ * to the cpus of its node (limited to cpu-affinity if it is defined)
+ * and allocates its memory preferably from that node. The affinity
+ * applied to each child is shown by mod-radmin <b>show childs</b>
+ * command.</li>
+ *
+ * <li><b>max-rate</b>: [bytes per second] Limits the bandwidth of
+ * each connection handled by this profile path using a token
+ * bucket. Content read from the connection is accounted and, once the
+ * rate is exceeded, the connection isn't read again until the excess
+ * is paid. The process reading from the client applies it: the
+ * master for connections served by it or proxied to a child (in that
+ * case content sent by the child to the client is also limited), and
+ * the child for connections sent to it. Content sent on connections
+ * served by vortex isn't limited, and the limit is lost if the
+ * connection is upgraded to TLS after being accepted. Counters are
+ * reported per profile path as <b>turbulence_shaping_bytes_total</b>,
+ * <b>turbulence_shaping_delays_total</b> and
+ * <b>turbulence_shaping_delay_microseconds_total</b>.</li>
+ *
+ * <li><b>max-burst</b>: [bytes] Requires max-rate. Bytes accepted
+ * at once after an idle period. By default max-rate (one second of
+ * traffic).</li>
+ *
  * <li><b>run-as-user</b>: [user name| user id]. Makes current process to change its
  * executing user to the provided value. Requires Turbulence startup
  * user to have permissions to run this system operation. Note this
@@ -2091,7 +2293,35 @@ void            turbulence_sleep           (TurbulenceCtx * ctx,
  * connection instance. <br>SUPPORTED: &lt;allow>,
  * &lt;if-success></p></li>
  *
+ * <li><p><b>max-message-size</b>: maximum size (bytes) of a message
+ * (frames joined) received on channels running the profile. It
+ * replaces, for these channels, the global
+ * <b>max-incoming-complete-frame-limit</b>, and it is enforced by
+ * the reader while joining frames, before the message reaches the
+ * profile handler. <br>SUPPORTED: &lt;allow>, &lt;if-success></p></li>
+ *
+ * <li><p><b>max-frame-size</b>: maximum size (bytes) of a frame
+ * received on channels running the profile. It is advertised to the
+ * remote peer as the channel window (so it also limits data in
+ * flight) and a peer sending beyond it has its connection closed by
+ * the reader. <br>SUPPORTED: &lt;allow>, &lt;if-success></p></li>
+ *
+ * <li><p><b>max-rate</b>: bandwidth (bytes per second) the
+ * connection is limited to once a channel running the profile is
+ * accepted (see max-rate on &lt;path-def>). If the connection is
+ * already limited, the lowest rate applies. The rate is lowered for
+ * the rest of the connection life: it isn't restored when the channel
+ * that lowered it is closed. It isn't applied to
+ * connections proxied by the master (channels are accepted by the
+ * child). <br>SUPPORTED: &lt;allow>, &lt;if-success></p></li>
+ *
  * </ol>
+ *
+ * For example, to accept small requests on a profile:
+ *
+ * \code
+ * <allow profile="urn:example:control" max-frame-size="4096" max-message-size="65536" />
+ * \endcode
  * 
  * <p>So, a good question at this point is "how are those marks
  * created?". These marks are profile dependant and are created using
@@ -2143,6 +2373,47 @@ void            turbulence_sleep           (TurbulenceCtx * ctx,
  * killed. This is configured with <b><kill-childs-on-exit value="yes" /></b>
  * inside <global-settings> node.
  *
+ * Threads used by the master process to transfer child logs and to
+ * proxy connections (proxy-on-parent) can be bound to a set of cpus
+ * with <b><loop-affinity log-manager="0" proxy="1" /></b> inside
+ * <global-settings> node (each attribute is optional).
+ *
+ * To upgrade the turbulence binary without stopping the service,
+ * install the new binary at the same location and send SIGUSR2 to
+ * the master process. The master runs the new binary (keeping its
+ * pid) passing it the listener sockets and the control sockets of
+ * running childs. The new binary keeps accepting on the same
+ * listeners (connections pending are not lost) and adopts childs,
+ * which reconnect their child<->master BEEP link to it. Connections
+ * served by childs are not affected. Connections handled by the
+ * master process itself are closed and their clients must reconnect.
+ *
+ * \code
+ * >> kill -USR2 `cat /var/run/turbulence.pid`
+ * \endcode
+ *
+ * Profile paths, listeners and limits can be changed without
+ * restarting by sending SIGHUP to the master process. The
+ * configuration file is loaded and validated again and, only if it
+ * is correct, new profile paths are installed: new connections are
+ * selected against them while connections already accepted keep the
+ * profile path they were using. Listeners no longer declared are
+ * closed, listeners added are started and childs created for
+ * previous profile paths finish once their connections are closed.
+ * If the configuration is not valid, the running one is kept.
+ *
+ * \code
+ * >> kill -HUP `cat /var/run/turbulence.pid`
+ * \endcode
+ *
+ * The master process reaps childs as they finish, logging their exit
+ * status and how long they were running. If childs created for a
+ * profile path keep failing shortly after being started (killed by a
+ * signal or finished with an error code in less than 5 seconds), new
+ * childs for that profile path are delayed (1, 2, 4.. up to 60
+ * seconds) while connections are sent to the childs still running
+ * (if reuse is enabled) or closed.
+ *
  * \section turbulence_starting_without_profiles 3.5 Making turbulence to start without profiles defined
  *
  * By default Turbulence checks after module start up (init method) if
@@ -2256,7 +2527,12 @@ void            turbulence_sleep           (TurbulenceCtx * ctx,
  *  - \ref turbulence_run
  *  - \ref turbulence_expr
  *  - \ref turbulence_loop
+ *  - \ref turbulence_affinity
+ *  - \ref turbulence_arena
  *  - \ref turbulence_mediator
+ *  - \ref turbulence_metrics
+ *  - \ref turbulence_trace
+ *  - \ref turbulence_shaper
  *  - \ref turbulence_module
  *  - \ref turbulence_ppath
  *  - \ref turbulence_support
@@ -65,6 +65,11 @@
 #include <turbulence-conn-mgr.h>
 #include <turbulence-process.h>
 #include <turbulence-loop.h>
+#include <turbulence-affinity.h>
+#include <turbulence-arena.h>
+#include <turbulence-metrics.h>
+#include <turbulence-trace.h>
+#include <turbulence-shaper.h>
 #include <turbulence-mediator.h>
 #include <turbulence-child.h>
 
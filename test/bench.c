@@ -0,0 +1,529 @@
+/*  Turbulence BEEP application server
+ *  Copyright (C) 2025 Advanced Software Production Line, S.L.
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; version 2.1 of the
+ *  License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free
+ *  Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307 USA
+ *  
+ *  You may find a copy of the license under this software is released
+ *  at COPYING file. This is LGPL software: you are welcome to develop
+ *  proprietary applications using this library without any royalty or
+ *  fee but returning back any change, improvement or addition in the
+ *  form of source code, project image, documentation patches, etc.
+ *
+ *  For commercial support on build BEEP enabled solutions, supporting
+ *  turbulence based solutions, etc, contact us:
+ *          
+ *      Postal address:
+ *         Advanced Software Production Line, S.L.
+ *         C/ Antonio Suarez Nº10, Edificio Alius A, Despacho 102
+ *         Alcala de Henares, 28802 (MADRID)
+ *         Spain
+ *
+ *      Email address:
+ *         info@aspl.es - http://www.aspl.es/turbulence
+ */
+
+/* include local turbulence header */
+#include <turbulence.h>
+
+/* include private turbulence headers */
+#include <turbulence-ctx-private.h>
+
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/** 
+ * Microbenchmarks for turbulence hot paths. Each benchmark builds a
+ * synthetic configuration, repeats the operation until it runs for
+ * at least bench_min_time and reports the cost per operation. Output
+ * is one line per measurement:
+ *
+ *   <benchmark> <param>=<value>.. iterations=<n> ns_per_op=<cost>
+ *
+ * so runs can be compared line by line. Usage:
+ *
+ *   ./bench [benchmark-filter]
+ */
+
+/* prototype for the internal profile path item matcher (not published
+ * in a public header) */
+extern int __turbulence_ppath_mask_items (TurbulenceCtx        * ctx,
+					  TurbulencePPathItem ** ppath_items,
+					  TurbulencePPathState * state,
+					  const char           * uri,
+					  const char           * serverName,
+					  int                    channel_num,
+					  VortexConnection     * connection,
+					  const char           * profile_content,
+					  int                    level);
+
+typedef void (* BenchFunc) (axlPointer data);
+
+/* min time (microseconds) each measurement runs */
+long         bench_min_time = 200000;
+const char * bench_filter   = NULL;
+
+typedef struct _BenchPPath {
+	TurbulenceCtx        * ctx;
+	VortexConnection     * conn;
+	TurbulencePPathDef   * def;
+	TurbulencePPathState   state;
+	char                 * uri;
+} BenchPPath;
+
+typedef struct _BenchExpr {
+	TurbulenceExpr       * expr;
+	const char           * subject;
+} BenchExpr;
+
+typedef struct _BenchDbList {
+	TurbulenceDbList     * list;
+	const char           * value;
+} BenchDbList;
+
+/** 
+ * @internal Runs the provided function until it takes at least
+ * bench_min_time and reports its cost.
+ */
+void bench_run (const char * name, const char * params, BenchFunc func, axlPointer data)
+{
+	long   iterations = 1;
+	long   iterator;
+	long   start;
+	long   elapsed;
+
+	while (axl_true) {
+		start = turbulence_trace_now ();
+		for (iterator = 0; iterator < iterations; iterator++)
+			func (data);
+		elapsed = turbulence_trace_now () - start;
+		if (elapsed >= bench_min_time || iterations >= 100000000)
+			break;
+		iterations *= 2;
+	} /* end while */
+
+	printf ("%-22s %-26s iterations=%-10ld ns_per_op=%.1f\n", 
+		name, params, iterations, (double) elapsed * 1000 / iterations);
+	fflush (stdout);
+	return;
+}
+
+axl_bool bench_enabled (const char * name)
+{
+	return bench_filter == NULL || strstr (name, bench_filter) != NULL;
+}
+
+/** 
+ * @internal Creates a connection over a loopback TCP socket, that is
+ * not watched by vortex reader (so no BEEP exchange takes place).
+ * The peer socket is returned on peer.
+ */
+VortexConnection * bench_conn_new (VortexCtx * vCtx, int * peer)
+{
+	struct sockaddr_in   addr;
+	socklen_t            addr_len = sizeof (addr);
+	int                  listener;
+	int                  accepted;
+
+	(*peer)  = -1;
+	listener = socket (AF_INET, SOCK_STREAM, 0);
+	if (listener < 0)
+		return NULL;
+
+	memset (&addr, 0, sizeof (addr));
+	addr.sin_family      = AF_INET;
+	addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+	addr.sin_port        = 0;
+	if (bind (listener, (struct sockaddr *) &addr, sizeof (addr)) != 0 ||
+	    listen (listener, 1) != 0 ||
+	    getsockname (listener, (struct sockaddr *) &addr, &addr_len) != 0) {
+		close (listener);
+		return NULL;
+	} /* end if */
+
+	(*peer) = socket (AF_INET, SOCK_STREAM, 0);
+	if ((*peer) < 0 || connect ((*peer), (struct sockaddr *) &addr, sizeof (addr)) != 0) {
+		close (listener);
+		return NULL;
+	} /* end if */
+	accepted = accept (listener, NULL, NULL);
+	close (listener);
+	if (accepted < 0)
+		return NULL;
+
+	return vortex_connection_new_empty (vCtx, accepted, VortexRoleListener);
+}
+
+void bench_conn_free (VortexConnection * conn, int peer)
+{
+	if (conn) {
+		vortex_connection_shutdown (conn);
+		vortex_connection_unref (conn, "bench");
+	} /* end if */
+	if (peer >= 0)
+		close (peer);
+	return;
+}
+
+/** 
+ * @internal Writes a configuration with the provided number of
+ * profile paths, each one with items <allow> entries. Profile paths
+ * are matched by src so only the last one matches the loopback
+ * connections used.
+ */
+axl_bool bench_write_config (const char * path, int paths, int items)
+{
+	FILE * file = fopen (path, "w");
+	int    iterator;
+	int    item;
+
+	if (file == NULL)
+		return axl_false;
+
+	fprintf (file, 
+		 "<?xml version='1.0' ?>\n<turbulence>\n  <global-settings>\n"
+		 "    <ports><port>44010</port></ports>\n"
+		 "    <listener><name>0.0.0.0</name></listener>\n"
+		 "    <log-reporting enabled='no'>\n"
+		 "      <general-log file='/var/log/turbulence/main.log' />\n"
+		 "      <error-log  file='/var/log/turbulence/error.log' />\n"
+		 "      <access-log file='/var/log/turbulence/access.log' />\n"
+		 "      <vortex-log file='/var/log/turbulence/vortex.log' />\n"
+		 "    </log-reporting>\n"
+		 "    <tls-support enabled='no' />\n"
+		 "    <on-bad-signal action='hold' />\n"
+		 "    <clean-start value='no' />\n"
+		 "    <connections><max-connections hard-limit='4096' soft-limit='4096'/></connections>\n"
+		 "    <kill-childs-on-exit value='yes' />\n"
+		 "    <allow-start-without-profiles value='yes' />\n"
+		 "  </global-settings>\n"
+		 "  <modules></modules>\n"
+		 "  <profile-path-configuration>\n");
+	for (iterator = 0; iterator < paths; iterator++) {
+		if (iterator == paths - 1)
+			fprintf (file, "    <path-def src='127\\.0\\.0\\.1' path-name='bench-%d'>\n", iterator);
+		else
+			fprintf (file, "    <path-def src='192\\.0\\.2\\.%d' path-name='bench-%d'>\n", iterator % 256, iterator);
+		for (item = 0; item < items; item++)
+			fprintf (file, "      <allow profile='urn:bench:profile:%d' />\n", item);
+		fprintf (file, "    </path-def>\n");
+	} /* end for */
+	fprintf (file, "  </profile-path-configuration>\n</turbulence>\n");
+	fclose (file);
+
+	return axl_true;
+}
+
+axl_bool bench_init (VortexCtx ** vCtx, TurbulenceCtx ** tCtx, int paths, int items)
+{
+	if (! bench_write_config ("bench.conf", paths, items)) {
+		printf ("ERROR: unable to write bench.conf\n");
+		return axl_false;
+	} /* end if */
+
+	(*vCtx) = vortex_ctx_new ();
+	vortex_support_init ((*vCtx));
+	(*tCtx) = turbulence_ctx_new ();
+	if (! turbulence_init ((*tCtx), (*vCtx), "bench.conf")) {
+		printf ("ERROR: unable to init turbulence with bench.conf (%d paths, %d items)\n", paths, items);
+		turbulence_ctx_free ((*tCtx));
+		return axl_false;
+	} /* end if */
+
+	return axl_true;
+}
+
+void bench_exit (VortexCtx * vCtx, TurbulenceCtx * tCtx)
+{
+	turbulence_exit (tCtx, axl_false, axl_false);
+	turbulence_ctx_free (tCtx);
+	vortex_ctx_free (vCtx);
+	unlink ("bench.conf");
+	return;
+}
+
+void bench_ppath_select (axlPointer _data)
+{
+	BenchPPath * data = _data;
+
+	__turbulence_ppath_select (data->ctx, data->conn, 0, NULL, NULL, EncodingNone, NULL, NULL, axl_false);
+	return;
+}
+
+void bench_ppath_mask_items (axlPointer _data)
+{
+	BenchPPath * data = _data;
+
+	__turbulence_ppath_mask_items (data->ctx, data->def->ppath_items, &data->state, data->uri, "", 1, NULL, NULL, 1);
+	return;
+}
+
+/** 
+ * @internal Profile path selection (scans paths until the last one
+ * matches) or item masking (the profile requested is the last item).
+ */
+void bench_ppath (int paths, int items, axl_bool select)
+{
+	VortexCtx     * vCtx;
+	TurbulenceCtx * tCtx;
+	BenchPPath      data;
+	char            params[128];
+	int             peer;
+
+	if (! bench_init (&vCtx, &tCtx, paths, items))
+		return;
+
+	memset (&data, 0, sizeof (data));
+	data.ctx  = tCtx;
+	data.def  = turbulence_ppath_find_by_id (tCtx, paths);
+	data.uri  = axl_strdup_printf ("urn:bench:profile:%d", items - 1);
+	data.conn = bench_conn_new (vCtx, &peer);
+	data.state.path_selected = data.def;
+	data.state.ctx           = tCtx;
+	sprintf (params, "paths=%d items=%d", paths, items);
+
+	if (data.def == NULL || data.conn == NULL) {
+		printf ("ERROR: unable to prepare profile path benchmark (%s)\n", params);
+	} else if (select) {
+		if (! __turbulence_ppath_select (tCtx, data.conn, 0, NULL, NULL, EncodingNone, NULL, NULL, axl_false))
+			printf ("ERROR: profile path selection failed (%s)\n", params);
+		else
+			bench_run ("ppath_select", params, bench_ppath_select, &data);
+	} else {
+		if (__turbulence_ppath_mask_items (tCtx, data.def->ppath_items, &data.state, data.uri, "", 1, NULL, NULL, 1))
+			printf ("ERROR: expected %s to be allowed (%s)\n", data.uri, params);
+		else
+			bench_run ("ppath_mask_items", params, bench_ppath_mask_items, &data);
+	} /* end if */
+
+	bench_conn_free (data.conn, peer);
+	axl_free (data.uri);
+	bench_exit (vCtx, tCtx);
+	return;
+}
+
+void bench_expr_match (axlPointer _data)
+{
+	BenchExpr * data = _data;
+
+	turbulence_expr_match (data->expr, data->subject);
+	return;
+}
+
+/** 
+ * @internal Expression matching: literal, wildcard, anchored pattern
+ * and alternations of growing size (subject matches the last one).
+ */
+void bench_expr (TurbulenceCtx * tCtx)
+{
+	BenchExpr   data;
+	char      * pattern;
+	char      * temp;
+	char        params[128];
+	int         sizes[] = {10, 100, 1000, -1};
+	int         iterator;
+	int         item;
+
+	data.subject = "bench-host.example.com";
+	data.expr    = turbulence_expr_compile (tCtx, "bench-host.example.com", NULL);
+	bench_run ("expr_match", "pattern=literal", bench_expr_match, &data);
+	turbulence_expr_free (data.expr);
+
+	data.expr    = turbulence_expr_compile (tCtx, ".*", NULL);
+	bench_run ("expr_match", "pattern=wildcard", bench_expr_match, &data);
+	turbulence_expr_free (data.expr);
+
+	data.expr    = turbulence_expr_compile (tCtx, "^bench-[a-z]+\\.example\\.(com|org)$", NULL);
+	bench_run ("expr_match", "pattern=anchored", bench_expr_match, &data);
+	turbulence_expr_free (data.expr);
+
+	for (iterator = 0; sizes[iterator] > 0; iterator++) {
+		/* build (host-0|host-1|...) */
+		pattern = axl_strdup ("host-0");
+		for (item = 1; item < sizes[iterator]; item++) {
+			temp    = axl_strdup_printf ("%s|host-%d", pattern, item);
+			axl_free (pattern);
+			pattern = temp;
+		} /* end for */
+		temp    = axl_strdup_printf ("^(%s)$", pattern);
+		axl_free (pattern);
+		pattern = temp;
+
+		data.subject = temp = axl_strdup_printf ("host-%d", sizes[iterator] - 1);
+		data.expr    = turbulence_expr_compile (tCtx, pattern, NULL);
+		sprintf (params, "alternatives=%d", sizes[iterator]);
+		if (data.expr)
+			bench_run ("expr_match", params, bench_expr_match, &data);
+		turbulence_expr_free (data.expr);
+		axl_free (pattern);
+		axl_free (temp);
+	} /* end for */
+	return;
+}
+
+void bench_db_list_exists (axlPointer _data)
+{
+	BenchDbList * data = _data;
+
+	turbulence_db_list_exists (data->list, data->value);
+	return;
+}
+
+/** 
+ * @internal db-list lookups for the last item and a missing item.
+ */
+void bench_db_list (TurbulenceCtx * tCtx)
+{
+	BenchDbList   data;
+	axlError    * err = NULL;
+	FILE        * file;
+	char          params[128];
+	char          last[64];
+	int           sizes[] = {10, 100, 1000, 10000, -1};
+	int           iterator;
+	int           item;
+
+	for (iterator = 0; sizes[iterator] > 0; iterator++) {
+		/* write list */
+		file = fopen ("bench-db-list.xml", "w");
+		if (file == NULL) {
+			printf ("ERROR: unable to write bench-db-list.xml\n");
+			return;
+		} /* end if */
+		fprintf (file, "<?xml version='1.0' ?>\n<turbulence-db-list>\n");
+		for (item = 0; item < sizes[iterator]; item++)
+			fprintf (file, "  <item value='item-%d' />\n", item);
+		fprintf (file, "</turbulence-db-list>\n");
+		fclose (file);
+
+		data.list = turbulence_db_list_open (tCtx, &err, "bench-db-list.xml", NULL);
+		if (data.list == NULL) {
+			printf ("ERROR: unable to open db list: %s\n", axl_error_get (err));
+			axl_error_free (err);
+			unlink ("bench-db-list.xml");
+			return;
+		} /* end if */
+
+		sprintf (last, "item-%d", sizes[iterator] - 1);
+		data.value = last;
+		sprintf (params, "entries=%d lookup=last", sizes[iterator]);
+		bench_run ("db_list_exists", params, bench_db_list_exists, &data);
+
+		data.value = "missing";
+		sprintf (params, "entries=%d lookup=missing", sizes[iterator]);
+		bench_run ("db_list_exists", params, bench_db_list_exists, &data);
+
+		turbulence_db_list_close (data.list);
+		unlink ("bench-db-list.xml");
+	} /* end for */
+	return;
+}
+
+void bench_conn_mgr_broadcast_msg (axlPointer _data)
+{
+	TurbulenceCtx * tCtx = _data;
+
+	turbulence_conn_mgr_broadcast_msg (tCtx, "bench", 5, "urn:bench:no-channel", NULL, NULL);
+	return;
+}
+
+/** 
+ * @internal Broadcast over a growing number of registered
+ * connections (with no channel running the profile, so it measures
+ * the snapshot and iteration cost).
+ */
+void bench_conn_mgr (VortexCtx * vCtx, TurbulenceCtx * tCtx)
+{
+	VortexConnection ** conns;
+	int               * peers;
+	char                params[128];
+	int                 sizes[] = {10, 100, 1000, -1};
+	int                 iterator;
+	int                 count;
+	int                 item;
+
+	for (iterator = 0; sizes[iterator] > 0; iterator++) {
+		conns = axl_new (VortexConnection *, sizes[iterator]);
+		peers = axl_new (int, sizes[iterator]);
+		for (count = 0; count < sizes[iterator]; count++) {
+			conns[count] = bench_conn_new (vCtx, &peers[count]);
+			if (conns[count] == NULL)
+				break;
+			turbulence_conn_mgr_register (tCtx, conns[count]);
+		} /* end for */
+
+		if (count == sizes[iterator]) {
+			sprintf (params, "connections=%d", turbulence_conn_mgr_count (tCtx));
+			bench_run ("conn_mgr_broadcast_msg", params, bench_conn_mgr_broadcast_msg, tCtx);
+		} else
+			printf ("ERROR: unable to create %d connections (check file descriptor limits)\n", sizes[iterator]);
+
+		for (item = 0; item < count; item++) {
+			turbulence_conn_mgr_unregister (tCtx, conns[item]);
+			bench_conn_free (conns[item], peers[item]);
+		} /* end for */
+		if (count < sizes[iterator] && peers[count] >= 0)
+			close (peers[count]);
+		axl_free (conns);
+		axl_free (peers);
+	} /* end for */
+	return;
+}
+
+int main (int argc, char ** argv)
+{
+	VortexCtx     * vCtx;
+	TurbulenceCtx * tCtx;
+	struct rlimit   limit;
+	int             sizes[] = {1, 10, 100, 1000, -1};
+	int             iterator;
+
+	if (argc > 1)
+		bench_filter = argv[1];
+
+	/* connections benchmarks need two descriptors per connection */
+	if (getrlimit (RLIMIT_NOFILE, &limit) == 0) {
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit (RLIMIT_NOFILE, &limit);
+	} /* end if */
+
+	/* profile path selection against number of profile paths and
+	 * masking against number of items */
+	if (bench_enabled ("ppath_select")) {
+		for (iterator = 0; sizes[iterator] > 0; iterator++)
+			bench_ppath (sizes[iterator], 10, axl_true);
+	} /* end if */
+	if (bench_enabled ("ppath_mask_items")) {
+		for (iterator = 0; sizes[iterator] > 0; iterator++)
+			bench_ppath (1, sizes[iterator], axl_false);
+	} /* end if */
+
+	if (! bench_enabled ("expr_match") && ! bench_enabled ("db_list_exists") && ! bench_enabled ("conn_mgr_broadcast_msg"))
+		return 0;
+
+	if (! bench_init (&vCtx, &tCtx, 1, 1))
+		return -1;
+	if (bench_enabled ("expr_match"))
+		bench_expr (tCtx);
+	if (bench_enabled ("db_list_exists"))
+		bench_db_list (tCtx);
+	if (bench_enabled ("conn_mgr_broadcast_msg"))
+		bench_conn_mgr (vCtx, tCtx);
+	bench_exit (vCtx, tCtx);
+
+	return 0;
+}
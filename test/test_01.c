@@ -52,6 +52,10 @@
 #include <mod_sasl_mysql_conf.h>
 #include <mysql.sasl.dtd.h>
 
+/* serverName matching of mod-tls <certificate-select>: exercised by
+ * test_22b without OpenSSL */
+#include <mod_tls_select.h>
+
 /* used by test_signal_block to inspect the process signal mask */
 #include <signal.h>
 
@@ -1141,6 +1145,417 @@ axl_bool test_09c (void)
 	return axl_true;
 }
 
+/**
+ * @brief Check arena allocations: small requests share the embedded
+ * chunk, oversized requests get their own chunk and everything is
+ * released by turbulence_arena_free.
+ */
+axl_bool test_09d (void)
+{
+	TurbulenceArena * arena;
+	char            * first;
+	char            * second;
+	char            * big;
+	int               bytes;
+
+	arena = turbulence_arena_new (0);
+	if (arena == NULL) {
+		printf ("ERROR: failed to create arena\n");
+		return axl_false;
+	} /* end if */
+	bytes = turbulence_arena_bytes (arena);
+
+	first  = turbulence_arena_strdup (arena, "test.server");
+	second = turbulence_arena_alloc (arena, 3);
+	if (first == NULL || second == NULL || ! axl_cmp (first, "test.server")) {
+		printf ("ERROR: expected to allocate from the arena\n");
+		return axl_false;
+	} /* end if */
+
+	/* memory must be zeroed and not overlapping */
+	if (second[0] != 0 || second[2] != 0 || (second > first && second < (first + 12))) {
+		printf ("ERROR: expected zeroed and not overlapping allocations\n");
+		return axl_false;
+	} /* end if */
+
+	/* small allocations must not reserve more memory */
+	if (turbulence_arena_bytes (arena) != bytes) {
+		printf ("ERROR: expected small allocations to use the embedded chunk (%d != %d)\n",
+			turbulence_arena_bytes (arena), bytes);
+		return axl_false;
+	} /* end if */
+
+	/* oversized allocation */
+	big = turbulence_arena_alloc (arena, 8192);
+	if (big == NULL || turbulence_arena_bytes (arena) < (bytes + 8192)) {
+		printf ("ERROR: expected oversized allocation to reserve a new chunk\n");
+		return axl_false;
+	} /* end if */
+	memset (big, 1, 8192);
+
+	/* the embedded chunk keeps serving small requests */
+	bytes = turbulence_arena_bytes (arena);
+	if (turbulence_arena_strdup (arena, "another") == NULL || turbulence_arena_bytes (arena) != bytes) {
+		printf ("ERROR: expected small allocation after an oversized one to use the current chunk\n");
+		return axl_false;
+	} /* end if */
+
+	turbulence_arena_free (arena);
+
+	/* the first chunk is sized from the hint, not a full chunk */
+	arena = turbulence_arena_new (32);
+	bytes = turbulence_arena_bytes (arena);
+	if (arena == NULL || bytes >= 512) {
+		printf ("ERROR: expected a small arena to reserve little memory (%d bytes)\n", bytes);
+		return axl_false;
+	} /* end if */
+
+	/* once exhausted, a new chunk is reserved */
+	if (turbulence_arena_alloc (arena, 32) == NULL || turbulence_arena_alloc (arena, 32) == NULL ||
+	    turbulence_arena_bytes (arena) <= bytes) {
+		printf ("ERROR: expected a new chunk once the first one is exhausted\n");
+		return axl_false;
+	} /* end if */
+
+	turbulence_arena_free (arena);
+
+	return axl_true;
+}
+
+axl_bool test_09e (void)
+{
+	TurbulenceCtx    * ctx = turbulence_ctx_new ();
+	TurbulenceMetric * counter;
+	TurbulenceMetric * histogram;
+	char             * content;
+
+	/* register and update a counter */
+	counter = turbulence_metrics_get (ctx, TBC_METRIC_COUNTER, "test_requests_total", "kind=\"a\"", "Test requests");
+	if (counter == NULL) {
+		printf ("ERROR: failed to register counter\n");
+		return axl_false;
+	} /* end if */
+	turbulence_metric_inc (counter, 2);
+	turbulence_metric_inc (counter, 3);
+
+	/* same name and labels must return the same metric */
+	if (turbulence_metrics_get (ctx, TBC_METRIC_COUNTER, "test_requests_total", "kind=\"a\"", NULL) != counter) {
+		printf ("ERROR: expected to get the same metric reference\n");
+		return axl_false;
+	} /* end if */
+
+	/* a different type must be rejected */
+	if (turbulence_metrics_get (ctx, TBC_METRIC_GAUGE, "test_requests_total", "kind=\"a\"", NULL) != NULL) {
+		printf ("ERROR: expected to reject a metric registered with a different type\n");
+		return axl_false;
+	} /* end if */
+
+	/* histogram */
+	histogram = turbulence_metrics_get (ctx, TBC_METRIC_HISTOGRAM, "test_latency", NULL, "Test latency");
+	turbulence_metric_observe (histogram, 3);
+	turbulence_metric_observe (histogram, 100);
+	if (turbulence_metric_value (counter) != 5 || turbulence_metric_value (histogram) != 2) {
+		printf ("ERROR: expected counter=5 and histogram count=2 but found %ld and %ld\n",
+			turbulence_metric_value (counter), turbulence_metric_value (histogram));
+		return axl_false;
+	} /* end if */
+
+	/* render */
+	content = turbulence_metrics_render (ctx, axl_false);
+	if (content == NULL ||
+	    strstr (content, "# TYPE test_requests_total counter\n") == NULL ||
+	    strstr (content, "test_requests_total{kind=\"a\"} 5\n") == NULL ||
+	    strstr (content, "test_latency_bucket{le=\"2\"} 0\n") == NULL ||
+	    strstr (content, "test_latency_bucket{le=\"4\"} 1\n") == NULL ||
+	    strstr (content, "test_latency_bucket{le=\"128\"} 2\n") == NULL ||
+	    strstr (content, "test_latency_sum 103\n") == NULL ||
+	    strstr (content, "test_latency_count 2\n") == NULL) {
+		printf ("ERROR: unexpected metrics content:\n%s\n", content ? content : "(null)");
+		return axl_false;
+	} /* end if */
+	axl_free (content);
+
+	turbulence_metrics_cleanup (ctx);
+	turbulence_ctx_free (ctx);
+
+	return axl_true;
+}
+
+axl_bool test_09f (void)
+{
+	char            * conn_status;
+	char            * traced;
+	long              stamps[TBC_TRACE_STAGES];
+	axl_bool          handle_start_reply;
+	int               channel_num;
+	const char      * profile;
+	const char      * profile_content;
+	VortexEncoding    encoding;
+	const char      * serverName;
+	int               msg_no;
+	int               seq_no;
+	int               seq_no_expected;
+	int               ppath_id;
+	int               has_tls;
+	int               fix_server_name;
+	const char      * remote_host;
+	const char      * remote_port;
+	const char      * remote_host_ip;
+	int               length;
+
+	/* status without trace */
+	conn_status = turbulence_process_connection_status_string (axl_true, 3, "urn:aspl.es:beep:profiles:reg-test:profile-15", NULL,
+								   EncodingNone, "test-15.server", 17, 42301, 1234, 37, 1, 0, 
+								   "localhost", "1233", "127.0.0.1", 1);
+	turbulence_trace_parse (conn_status + 1, stamps);
+	if (stamps[TBC_TRACE_ACCEPT] != 0) {
+		printf ("ERROR: expected no trace on status without trace field (found %ld)\n", stamps[TBC_TRACE_ACCEPT]);
+		return axl_false;
+	} /* end if */
+
+	/* place the trace as the field before the last one (as done
+	 * by turbulence_trace_append) */
+	length = strlen (conn_status);
+	traced = axl_strdup_printf ("%.*s;-;t1000,1200,0,1500,0,0,0;-;1", length - 4, conn_status);
+	axl_free (conn_status);
+
+	turbulence_trace_parse (traced + 1, stamps);
+	if (stamps[TBC_TRACE_ACCEPT] != 1000 || stamps[TBC_TRACE_SELECTED] != 1200 || 
+	    stamps[TBC_TRACE_SPAWNED] != 0 || stamps[TBC_TRACE_HANDOFF] != 1500) {
+		printf ("ERROR: unexpected stamps recovered: %ld, %ld, %ld, %ld\n", 
+			stamps[TBC_TRACE_ACCEPT], stamps[TBC_TRACE_SELECTED], stamps[TBC_TRACE_SPAWNED], stamps[TBC_TRACE_HANDOFF]);
+		return axl_false;
+	} /* end if */
+
+	/* skip_conn_recover must still be the last character */
+	if (traced[strlen (traced) - 1] != '1') {
+		printf ("ERROR: expected skip_conn_recover to be the last character: %s\n", traced);
+		return axl_false;
+	} /* end if */
+
+	/* the rest of the status must be recovered as usual */
+	turbulence_process_connection_recover_status (traced + 1, &handle_start_reply, &channel_num, &profile, &profile_content,
+						      &encoding, &serverName, &msg_no, &seq_no, &seq_no_expected, &ppath_id,
+						      &fix_server_name, &remote_host, &remote_port, &remote_host_ip, &has_tls);
+	if (ppath_id != 37 || has_tls != 1 || ! axl_cmp (remote_host, "localhost") || 
+	    ! axl_cmp (remote_port, "1233") || ! axl_cmp (remote_host_ip, "127.0.0.1")) {
+		printf ("ERROR: unexpected status recovered with trace (ppath_id=%d, has_tls=%d, host=%s, port=%s, ip=%s)\n",
+			ppath_id, has_tls, remote_host ? remote_host : "", remote_port ? remote_port : "", remote_host_ip ? remote_host_ip : "");
+		return axl_false;
+	} /* end if */
+	axl_free (traced);
+
+	/* monotonic clock */
+	if (turbulence_trace_now () <= 0) {
+		printf ("ERROR: expected a monotonic stamp\n");
+		return axl_false;
+	} /* end if */
+
+	return axl_true;
+}
+
+int test_09g_released = 0;
+
+void test_09g_release (axlPointer data)
+{
+	test_09g_released++;
+	return;
+}
+
+axl_bool test_09g (void)
+{
+	TurbulenceCtx * ctx = turbulence_ctx_new ();
+	int             slot;
+	int             other;
+	int             thread_slot;
+
+	/* reserve slots */
+	slot  = turbulence_ctx_slot_new (ctx, test_09g_release);
+	other = turbulence_ctx_slot_new (ctx, NULL);
+	if (slot < 0 || other < 0 || slot == other) {
+		printf ("ERROR: expected two different slots but found %d and %d\n", slot, other);
+		return axl_false;
+	} /* end if */
+
+	/* store and read */
+	if (turbulence_ctx_slot_get (ctx, slot) != NULL) {
+		printf ("ERROR: expected empty slot after reserving it\n");
+		return axl_false;
+	} /* end if */
+	turbulence_ctx_slot_set (ctx, slot, INT_TO_PTR (3));
+	turbulence_ctx_slot_set (ctx, other, INT_TO_PTR (4));
+	if (PTR_TO_INT (turbulence_ctx_slot_get (ctx, slot)) != 3 || PTR_TO_INT (turbulence_ctx_slot_get (ctx, other)) != 4) {
+		printf ("ERROR: unexpected values stored on slots\n");
+		return axl_false;
+	} /* end if */
+
+	/* not reserved slots */
+	if (turbulence_ctx_slot_get (ctx, TBC_CTX_MAX_SLOTS) != NULL || turbulence_ctx_slot_get (ctx, -1) != NULL) {
+		printf ("ERROR: expected NULL for slots not reserved\n");
+		return axl_false;
+	} /* end if */
+
+	/* per thread slot */
+	thread_slot = turbulence_ctx_thread_slot_new (ctx, NULL);
+	if (thread_slot < 0 || turbulence_ctx_thread_slot_get (ctx, thread_slot) != NULL) {
+		printf ("ERROR: expected an empty thread slot (%d)\n", thread_slot);
+		return axl_false;
+	} /* end if */
+	turbulence_ctx_thread_slot_set (ctx, thread_slot, INT_TO_PTR (5));
+	if (PTR_TO_INT (turbulence_ctx_thread_slot_get (ctx, thread_slot)) != 5) {
+		printf ("ERROR: unexpected value stored on thread slot\n");
+		return axl_false;
+	} /* end if */
+	turbulence_ctx_thread_slot_set (ctx, thread_slot, NULL);
+
+	/* destroy handler called on finish */
+	turbulence_ctx_free (ctx);
+	if (test_09g_released != 1) {
+		printf ("ERROR: expected slot data to be released once but found %d\n", test_09g_released);
+		return axl_false;
+	} /* end if */
+
+	return axl_true;
+}
+
+axl_bool test_09h (void)
+{
+	TurbulenceCtx    * ctx = turbulence_ctx_new ();
+	TurbulenceShaper * shaper;
+	long               wait;
+
+	/* 1000 bytes per second with a burst of 500 bytes */
+	if (turbulence_shaper_new (ctx, 0, 0) != NULL) {
+		printf ("ERROR: expected no shaper for a rate of 0\n");
+		return axl_false;
+	} /* end if */
+	shaper = turbulence_shaper_new (ctx, 1000, 500);
+	if (turbulence_shaper_get_rate (shaper) != 1000) {
+		printf ("ERROR: unexpected rate %ld\n", turbulence_shaper_get_rate (shaper));
+		return axl_false;
+	} /* end if */
+
+	/* burst is accepted without waiting */
+	wait = turbulence_shaper_consume (shaper, 500, axl_true);
+	if (wait != 0) {
+		printf ("ERROR: expected no wait within the burst but found %ld\n", wait);
+		return axl_false;
+	} /* end if */
+
+	/* 250 bytes beyond the burst: about 250ms to pay the debt */
+	wait = turbulence_shaper_consume (shaper, 250, axl_true);
+	if (wait < 200000 || wait > 250000) {
+		printf ("ERROR: expected to wait about 250ms but found %ld us\n", wait);
+		return axl_false;
+	} /* end if */
+
+	/* after the wait, the debt is paid */
+	turbulence_sleep (ctx, wait + 10000);
+	wait = turbulence_shaper_consume (shaper, 1, axl_false);
+	if (wait > 1000) {
+		printf ("ERROR: expected the debt to be paid but found a wait of %ld us\n", wait);
+		return axl_false;
+	} /* end if */
+
+	/* lower the rate: 200 bytes take about two seconds (minus the
+	 * few tokens left) */
+	turbulence_shaper_set_rate (shaper, 100, 0);
+	wait = turbulence_shaper_consume (shaper, 200, axl_true);
+	if (wait < 1800000 || wait > 2000000) {
+		printf ("ERROR: expected to wait about 2s at 100 bytes/sec but found %ld us\n", wait);
+		return axl_false;
+	} /* end if */
+
+	/* NULL shaper never waits */
+	if (turbulence_shaper_consume (NULL, 1000, axl_true) != 0) {
+		printf ("ERROR: expected no wait without shaper\n");
+		return axl_false;
+	} /* end if */
+
+	turbulence_shaper_free (shaper);
+	turbulence_ctx_free (ctx);
+	return axl_true;
+}
+
+axl_bool test_09i (void)
+{
+	VortexCtx        * vCtx;
+	TurbulenceCtx    * tCtx;
+	VortexConnection * conn;
+	int                fds[2];
+	char               buffer[1500];
+	int                bytes;
+
+	/* vortex is only required to handle the connection (no
+	 * turbulence configuration) */
+	vCtx = vortex_ctx_new ();
+	if (! vortex_init_ctx (vCtx)) {
+		printf ("ERROR: unable to init vortex context\n");
+		return axl_false;
+	} /* end if */
+	tCtx = turbulence_ctx_new ();
+	turbulence_ctx_set_vortex_ctx (tCtx, vCtx);
+
+	/* connection over a socket pair, not watched by the reader */
+	if (socketpair (AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+		printf ("ERROR: unable to create socket pair\n");
+		return axl_false;
+	} /* end if */
+	conn = vortex_connection_new_empty (vCtx, fds[0], VortexRoleListener);
+
+	/* 1000 bytes per second (burst 1000) */
+	if (! turbulence_shaper_conn_setup (tCtx, conn, NULL, 1000) || turbulence_shaper_conn_get (conn) == NULL) {
+		printf ("ERROR: expected connection to be shaped\n");
+		return axl_false;
+	} /* end if */
+
+	/* read 1500 bytes through the receive wrapper: about 500ms
+	 * in debt so the connection is handed to the resume thread
+	 * (which holds a reference) */
+	memset (buffer, 'a', sizeof (buffer));
+	if (write (fds[1], buffer, sizeof (buffer)) != sizeof (buffer)) {
+		printf ("ERROR: unable to write content to the socket pair\n");
+		return axl_false;
+	} /* end if */
+	bytes = vortex_frame_receive_raw (conn, buffer, sizeof (buffer));
+	if (bytes != sizeof (buffer)) {
+		printf ("ERROR: expected to read %d bytes through the shaper but found %d\n", (int) sizeof (buffer), bytes);
+		return axl_false;
+	} /* end if */
+	if (vortex_connection_ref_count (conn) != 2) {
+		printf ("ERROR: expected connection to be delayed (refs 2) but found refs %d\n", vortex_connection_ref_count (conn));
+		return axl_false;
+	} /* end if */
+
+	/* once the debt is paid it is resumed */
+	test_common_microwait (800000);
+	if (vortex_connection_ref_count (conn) != 1) {
+		printf ("ERROR: expected connection to be resumed (refs 1) but found refs %d\n", vortex_connection_ref_count (conn));
+		return axl_false;
+	} /* end if */
+
+	/* delay it again and stop the resume thread: connections
+	 * held are resumed */
+	if (write (fds[1], buffer, sizeof (buffer)) != sizeof (buffer) ||
+	    vortex_frame_receive_raw (conn, buffer, sizeof (buffer)) != sizeof (buffer)) {
+		printf ("ERROR: unable to read content through the shaper\n");
+		return axl_false;
+	} /* end if */
+	turbulence_shaper_cleanup (tCtx);
+	if (vortex_connection_ref_count (conn) != 1) {
+		printf ("ERROR: expected connection to be resumed on cleanup but found refs %d\n", vortex_connection_ref_count (conn));
+		return axl_false;
+	} /* end if */
+
+	/* release (shaper is released with the connection) */
+	vortex_connection_shutdown (conn);
+	vortex_connection_unref (conn, "test_09i");
+	close (fds[1]);
+	turbulence_ctx_free (tCtx);
+	vortex_exit_ctx (vCtx, axl_true);
+	return axl_true;
+}
+
 /**
  * @brief Regression test: turbulence_signal_block / _unblock must operate
  * on the signal passed as argument. The implementation used to hardcode
@@ -2163,6 +2578,86 @@ axl_bool test_05_b (void) {
 	return axl_true;
 }
 
+axl_bool test_05_c (void) {
+	TurbulenceCtx          * ctx;
+	TurbulenceMediatorPlug * plug;
+	TurbulenceMediatorPlug * api;
+	axlList                * list;
+
+	/* reset counters */
+	test_05_b_h1_calls   = 0;
+	test_05_b_h2_calls   = 0;
+
+	ctx = turbulence_ctx_new ();
+	turbulence_mediator_init (ctx);
+
+	/* unknown plugs are not resolved */
+	if (turbulence_mediator_plug_get (ctx, "test-05c", "entry") != NULL) {
+		printf ("ERROR (05c.1): expected NULL reference for a plug not registered..\n");
+		return axl_false;
+	} /* end if */
+
+	/* create plug and resolve it before subscribing */
+	turbulence_mediator_create_plug (ctx, "test-05c", "entry", axl_false, NULL, NULL);
+	plug = turbulence_mediator_plug_get (ctx, "test-05c", "entry");
+	if (plug == NULL) {
+		printf ("ERROR (05c.2): expected to resolve plug test-05c/entry..\n");
+		return axl_false;
+	} /* end if */
+
+	/* no subscribers yet */
+	turbulence_mediator_plug_push (plug, NULL, NULL, NULL, NULL);
+
+	/* subscribers added later are notified through the reference */
+	turbulence_mediator_subscribe (ctx, "test-05c", "entry", test_05_b_h1, NULL);
+	turbulence_mediator_subscribe (ctx, "test-05c", "entry", test_05_b_h2, NULL);
+	turbulence_mediator_plug_push (plug, NULL, NULL, NULL, NULL);
+	if (test_05_b_h1_calls != 1 || test_05_b_h2_calls != 1) {
+		printf ("ERROR (05c.3): expected h1/h2 called once, found h1=%d h2=%d..\n", test_05_b_h1_calls, test_05_b_h2_calls);
+		return axl_false;
+	} /* end if */
+
+	/* removed subscribers are not */
+	turbulence_mediator_remove_plug (ctx, "test-05c", "entry", test_05_b_h1, NULL);
+	turbulence_mediator_plug_push (plug, NULL, NULL, NULL, NULL);
+	turbulence_mediator_push_event (ctx, "test-05c", "entry", NULL, NULL, NULL, NULL);
+	if (test_05_b_h1_calls != 1 || test_05_b_h2_calls != 3) {
+		printf ("ERROR (05c.4): expected h1=1 and h2=3, found h1=%d h2=%d..\n", test_05_b_h1_calls, test_05_b_h2_calls);
+		return axl_false;
+	} /* end if */
+
+	/* events are not pushed on apis and apis are not called on events */
+	turbulence_mediator_create_api (ctx, "test-05c", "api", test_05_handler3, INT_TO_PTR (9));
+	api = turbulence_mediator_plug_get (ctx, "test-05c", "api");
+	if (turbulence_mediator_plug_call (plug, INT_TO_PTR (20), NULL, NULL, NULL) != NULL) {
+		printf ("ERROR (05c.5): expected NULL result when calling an event plug..\n");
+		return axl_false;
+	} /* end if */
+	if (PTR_TO_INT (turbulence_mediator_plug_call (api, INT_TO_PTR (20), NULL, NULL, NULL)) != 29) {
+		printf ("ERROR (05c.6): expected 29 result from api call..\n");
+		return axl_false;
+	} /* end if */
+
+	/* long names (key built out of the stack buffer) */
+	list = axl_list_new (axl_list_equal_int, NULL);
+	turbulence_mediator_create_plug (ctx, "test-05c-a-very-long-entry-name-used-to-check-keys-bigger-than-the-lookup-buffer", 
+					 "a-very-long-entry-domain-used-to-check-keys-bigger-than-the-lookup-buffer", 
+					 axl_true, test_05_handler, INT_TO_PTR (5));
+	turbulence_mediator_push_event (ctx, "test-05c-a-very-long-entry-name-used-to-check-keys-bigger-than-the-lookup-buffer", 
+					"a-very-long-entry-domain-used-to-check-keys-bigger-than-the-lookup-buffer", list, NULL, NULL, NULL);
+	if (axl_list_length (list) != 1) {
+		printf ("ERROR (05c.7): expected one item notified on plug with a long name, found %d..\n", axl_list_length (list));
+		return axl_false;
+	} /* end if */
+	axl_list_free (list);
+
+	/* cleanup */
+	turbulence_mediator_cleanup (ctx);
+	turbulence_ctx_free (ctx);
+
+	return axl_true;
+}
+
 
 axl_bool __turbulence_get_system_id_info (TurbulenceCtx * ctx, const char * value, int * system_id, const char * path);
 
@@ -6132,6 +6627,120 @@ axl_bool test_16 (void) {
 	return axl_true;
 }
 
+int test_16a_get_pid (VortexCtx * vCtx, VortexConnection ** conn)
+{
+	VortexChannel    * channel;
+	VortexFrame      * frame;
+	VortexAsyncQueue * queue;
+	int                pid;
+
+	/* create a connection handled by a child process */
+	(*conn) = vortex_connection_new_full (vCtx, "127.0.0.1", "44010",
+					      CONN_OPTS(VORTEX_SERVERNAME_FEATURE, "test-16a.server", VORTEX_OPTS_END),
+					      NULL, NULL);
+	if (! vortex_connection_is_ok (*conn, axl_false)) {
+		printf ("ERROR (1): expected to find proper connection but found an error..\n");
+		return -1;
+	} /* end if */
+
+	channel = SIMPLE_CHANNEL_CREATE_WITH_CONN ((*conn), "urn:aspl.es:beep:profiles:reg-test:profile-16");
+	if (channel == NULL) {
+		printf ("ERROR (2): expected to find proper channel creation but a failure was found..\n");
+		return -1;
+	}
+
+	/* get process id handling the connection */
+	queue = vortex_async_queue_new ();
+	vortex_channel_set_received_handler (channel, vortex_channel_queue_reply, queue);
+	vortex_channel_send_msg (channel, "process-id", 10, NULL);
+	frame = vortex_channel_get_reply (channel, queue);
+	pid   = atoi ((const char *) vortex_frame_get_payload (frame));
+	vortex_frame_unref (frame);
+	vortex_async_queue_unref (queue);
+
+	return pid;
+}
+
+axl_bool test_16a (void) {
+	
+	TurbulenceCtx    * tCtx;
+	VortexCtx        * vCtx;
+	VortexConnection * conns[3];
+	int                pids[3];
+	int                iterator;
+
+	/* FIRST PART: init vortex and turbulence */
+	if (! test_common_init (&vCtx, &tCtx, "test_16a.conf")) 
+		return axl_false;
+
+	/* run configuration */
+	if (! turbulence_run_config (tCtx)) 
+		return axl_false;
+
+	/* the first two connections are handled by the same child
+	 * (reuse=yes) which is retired after the second one
+	 * (max-connections-served=2) */
+	iterator = 0;
+	while (iterator < 3) {
+		pids[iterator] = test_16a_get_pid (vCtx, &conns[iterator]);
+		if (pids[iterator] <= 0)
+			return axl_false;
+		printf ("Test 16-a: connection %d handled by child pid=%d..\n", iterator, pids[iterator]);
+		iterator++;
+	} /* end while */
+
+	if (pids[0] != pids[1]) {
+		printf ("ERROR (3): expected to find the same child reused for the second connection (%d != %d)..\n",
+			pids[0], pids[1]);
+		return axl_false;
+	} /* end if */
+
+	/* the third connection must be sent to a new child */
+	if (pids[1] == pids[2]) {
+		printf ("ERROR (4): expected to find a new child replacing the retired one but found the same pid (%d)..\n",
+			pids[2]);
+		return axl_false;
+	} /* end if */
+
+	if (turbulence_process_child_count (tCtx) != 2) {
+		printf ("ERROR (5): expected to find 2 childs (retired and new one) but found: %d..\n",
+			turbulence_process_child_count (tCtx));
+		return axl_false;
+	} /* end if */
+
+	/* close connections handled by the retired child: it must
+	 * finish without waiting the idle timeout */
+	vortex_connection_close (conns[0]);
+	vortex_connection_close (conns[1]);
+
+	printf ("Test 16-a: waiting for retired child to exit..\n");
+	iterator = 0;
+	while (iterator < 4000) {
+		/* wait a bit */
+		turbulence_sleep (tCtx, 1000);
+
+		/* check child count */
+		if (turbulence_process_child_count (tCtx) == 1) 
+			break;
+
+		/* next */
+		iterator++;
+	}
+
+	if (turbulence_process_child_count (tCtx) != 1) {
+		printf ("ERROR (6): expected to find 1 child after the retired one finished but found: %d..\n",
+			turbulence_process_child_count (tCtx));
+		return axl_false;
+	} /* end if */
+
+	vortex_connection_close (conns[2]);
+	
+	/* finish turbulence */
+	test_common_exit (vCtx, tCtx);
+
+	return axl_true;
+}
+
 axl_bool test_17_result = axl_true;
 
 axlPointer test_17_thread (VortexCtx * ctx)
@@ -6886,6 +7495,98 @@ axl_bool test_22_a (void) {
 	return axl_true;
 }
 
+/** 
+ * @brief Test 22-b: serverName matching of mod-tls
+ * <certificate-select> declarations: exact names, "*.domain"
+ * wildcards (one label only) and "*", the first in document order
+ * winning.
+ */
+axl_bool test_22_b (void) {
+	ModTlsSelect * selection;
+	const char   * result;
+	int            iterator;
+	/* pattern, serverName, expected match */
+	const char   * matches[][3] = {
+		{"*",               "www.aspl.es",      "yes"},
+		{"*",               NULL,               "yes"},
+		{"www.aspl.es",     "www.aspl.es",      "yes"},
+		{"www.aspl.es",     "aspl.es",          "no"},
+		{"www.aspl.es",     NULL,               "no"},
+		{"*.aspl.es",       "www.aspl.es",      "yes"},
+		{"*.aspl.es",       "aspl.es",          "no"},
+		{"*.aspl.es",       "a.www.aspl.es",    "no"},
+		{"*.aspl.es",       ".aspl.es",         "no"},
+		{"*.aspl.es",       "www.aspl.es.com",  "no"},
+		{"*.",              "www.",             "no"},
+		{NULL,              "www.aspl.es",      "no"},
+		{NULL,              NULL,               NULL}};
+	/* serverName, declaration expected */
+	const char   * lookups[][2] = {
+		{"www.aspl.es",     "exact"},
+		{"mail.aspl.es",    "wildcard"},
+		/* declared after *.aspl.es */
+		{"ftp.aspl.es",     "wildcard"},
+		{"a.www.aspl.es",   "any"},
+		{"aspl.es",         "any"},
+		/* *.other.com is declared after "*" */
+		{"www.other.com",   "any"},
+		{NULL,              "any"},
+		{NULL,              NULL}};
+
+	/* name matching */
+	for (iterator = 0; matches[iterator][2] != NULL; iterator++) {
+		if (mod_tls_name_matches (matches[iterator][0], matches[iterator][1]) != axl_cmp (matches[iterator][2], "yes")) {
+			printf ("ERROR (1): expected pattern=%s %s serverName=%s\n", 
+				matches[iterator][0] ? matches[iterator][0] : "NULL",
+				axl_cmp (matches[iterator][2], "yes") ? "to match" : "to not match",
+				matches[iterator][1] ? matches[iterator][1] : "NULL");
+			return axl_false;
+		} /* end if */
+	} /* end for */
+
+	/* empty index: nothing is selected */
+	selection = mod_tls_select_new ();
+	if (mod_tls_select_lookup (selection, "www.aspl.es") != NULL) {
+		printf ("ERROR (2): expected to find no declaration on an empty index\n");
+		return axl_false;
+	} /* end if */
+
+	/* declarations in document order: the first matching one
+	 * wins, no matter if it is exact, wildcard or "*" */
+	mod_tls_select_add (selection, "www.aspl.es",  "exact");
+	mod_tls_select_add (selection, "*.aspl.es",    "wildcard");
+	mod_tls_select_add (selection, "www.aspl.es",  "exact (repeated)");
+	mod_tls_select_add (selection, "*.aspl.es",    "wildcard (repeated)");
+	mod_tls_select_add (selection, "*",            "any");
+	mod_tls_select_add (selection, "ftp.aspl.es",  "ftp exact");
+	mod_tls_select_add (selection, "*.other.com",  "other wildcard");
+	mod_tls_select_add (selection, "*",            "any (repeated)");
+	mod_tls_select_add (selection, NULL,           "ignored");
+
+	for (iterator = 0; lookups[iterator][1] != NULL; iterator++) {
+		result = mod_tls_select_lookup (selection, lookups[iterator][0]);
+		if (! axl_cmp (result, lookups[iterator][1])) {
+			printf ("ERROR (3): expected serverName=%s to select '%s' but found '%s'\n",
+				lookups[iterator][0] ? lookups[iterator][0] : "NULL", lookups[iterator][1], result ? result : "NULL");
+			return axl_false;
+		} /* end if */
+	} /* end for */
+	mod_tls_select_free (selection);
+
+	/* an exact name declared after "*" is never selected */
+	selection = mod_tls_select_new ();
+	mod_tls_select_add (selection, "*",            "any");
+	mod_tls_select_add (selection, "www.aspl.es",  "exact");
+	result = mod_tls_select_lookup (selection, "www.aspl.es");
+	if (! axl_cmp (result, "any")) {
+		printf ("ERROR (4): expected \"*\" declared first to be selected but found '%s'\n", result ? result : "NULL");
+		return axl_false;
+	} /* end if */
+	mod_tls_select_free (selection);
+
+	return axl_true;
+}
+
 axl_bool test_23 (void) {
 	TurbulenceCtx    * tCtx;
 	VortexCtx        * vCtx;
@@ -7303,6 +8004,136 @@ axl_bool test_28 (void) {
 
 #endif
 
+void test_29_frame_received (VortexChannel    * channel,
+			     VortexConnection * connection,
+			     VortexFrame      * frame,
+			     axlPointer         user_data)
+{
+	VortexAsyncQueue * queue = user_data;
+
+	/* report the size of the message received */
+	vortex_async_queue_push (queue, INT_TO_PTR (vortex_frame_get_payload_size (frame)));
+	return;
+}
+
+axl_bool test_29_reject_start (int                channel_num,
+			       VortexConnection * connection,
+			       axlPointer         user_data)
+{
+	return axl_false;
+}
+
+/** 
+ * @brief Checks max-frame-size and max-message-size declared on
+ * <allow>: a message over the limit is not delivered, and limits
+ * recorded for a channel whose start was rejected after the profile
+ * path accepted it are not applied to a later channel using the same
+ * number.
+ */
+axl_bool test_29 (void) {
+	TurbulenceCtx    * tCtx;
+	VortexCtx        * vCtx;
+	VortexConnection * conn;
+	VortexChannel    * channel;
+	VortexAsyncQueue * queue;
+	char             * content;
+	int                size;
+
+	/* FIRST PART: init vortex and turbulence */
+	if (! test_common_init (&vCtx, &tCtx, "test_29.conf")) 
+		return axl_false;
+
+	/* register profiles: all of them report messages received */
+	queue = vortex_async_queue_new ();
+	vortex_profiles_register (vCtx, "urn:aspl.es:beep:profiles:reg-test:profile-29",
+				  NULL, NULL, NULL, NULL, test_29_frame_received, queue);
+	vortex_profiles_register (vCtx, "urn:aspl.es:beep:profiles:reg-test:profile-29-plain",
+				  NULL, NULL, NULL, NULL, test_29_frame_received, queue);
+	vortex_profiles_register (vCtx, "urn:aspl.es:beep:profiles:reg-test:profile-29-rejected",
+				  test_29_reject_start, NULL, NULL, NULL, test_29_frame_received, queue);
+
+	/* run configuration */
+	if (! turbulence_run_config (tCtx)) 
+		return axl_false;
+
+	conn = vortex_connection_new (vCtx, "127.0.0.1", "44010", NULL, NULL);
+	if (! vortex_connection_is_ok (conn, axl_false)) {
+		printf ("ERROR (1): expected proper connection creation (%d, %s)\n", 
+			vortex_connection_get_status (conn), vortex_connection_get_message (conn));
+		return axl_false;
+	} /* end if */
+
+	content = axl_new (char, 4097);
+	memset (content, 'a', 4096);
+
+	/* the profile path accepts channel 5 (recording its limits)
+	 * but the start handler rejects it */
+	channel = vortex_channel_new (conn, 5, "urn:aspl.es:beep:profiles:reg-test:profile-29-rejected", NULL, NULL, NULL, NULL, NULL, NULL);
+	if (channel != NULL) {
+		printf ("ERROR (2): expected channel start to be rejected..\n");
+		return axl_false;
+	} /* end if */
+
+	/* the same channel number without limits must not get the
+	 * 16 bytes limit recorded for the rejected one */
+	channel = vortex_channel_new (conn, 5, "urn:aspl.es:beep:profiles:reg-test:profile-29-plain", NULL, NULL, NULL, NULL, NULL, NULL);
+	if (channel == NULL) {
+		printf ("ERROR (3): expected to create channel 5 without limits..\n");
+		return axl_false;
+	} /* end if */
+	if (! vortex_channel_send_msg (channel, content, 4096, NULL)) {
+		printf ("ERROR (4): failed to send message..\n");
+		return axl_false;
+	} /* end if */
+	size = PTR_TO_INT (vortex_async_queue_timedpop (queue, 3000000));
+	if (size != 4096) {
+		printf ("ERROR (5): expected to receive 4096 bytes on a channel without limits but found %d..\n", size);
+		return axl_false;
+	} /* end if */
+
+	/* now a limited channel: a message under max-message-size is
+	 * delivered (in frames of max-frame-size at most) */
+	channel = SIMPLE_CHANNEL_CREATE ("urn:aspl.es:beep:profiles:reg-test:profile-29");
+	if (channel == NULL) {
+		printf ("ERROR (6): expected to create limited channel..\n");
+		return axl_false;
+	} /* end if */
+	if (! vortex_channel_send_msg (channel, content, 800, NULL)) {
+		printf ("ERROR (7): failed to send message..\n");
+		return axl_false;
+	} /* end if */
+	size = PTR_TO_INT (vortex_async_queue_timedpop (queue, 3000000));
+	if (size != 800) {
+		printf ("ERROR (8): expected to receive 800 bytes under the limit but found %d..\n", size);
+		return axl_false;
+	} /* end if */
+
+	/* and a message over max-message-size is not */
+	if (! vortex_channel_send_msg (channel, content, 4096, NULL)) {
+		printf ("ERROR (9): failed to send message..\n");
+		return axl_false;
+	} /* end if */
+	size = PTR_TO_INT (vortex_async_queue_timedpop (queue, 1000000));
+	if (size != 0) {
+		printf ("ERROR (10): expected message over max-message-size to be dropped but %d bytes were received..\n", size);
+		return axl_false;
+	} /* end if */
+
+	axl_free (content);
+
+	/* ok, now close the connection */
+	vortex_connection_shutdown (conn);
+	vortex_connection_close (conn);
+
+	/* finish turbulence */
+	test_common_exit (vCtx, tCtx);
+
+	/* finish queue */
+	vortex_async_queue_unref (queue);
+	
+	return axl_true;
+}
+
 typedef axl_bool (* TurbulenceTestHandler) (void);
 
 /** 
@@ -7396,8 +8227,8 @@ int main (int argc, char ** argv)
 	printf ("** Providing --run-test=NAME will run only the provided regression test.\n");
 	printf ("** Available tests: test_01, test_01, test_01a, test_0b, test_02, test_03, test_03a, test_04, test_05, test_05a, test_06, test_06a\n");
 	printf ("**                  test_07, test_07a, test_08, test_09, test_10prev, test_10, test_10a, test_10f, test_10b, test_10c, test_10d, test_10e, test_10g, test_11, test_12,\n");
-	printf ("**                  test_12a, test_12b, test_12c, test_12d, test_12e, test_13, test_13a, test_13b, test_14, test_15, test_15a, test_16, test_17, test_18,\n");
-	printf ("**                  test_19, test_20, test_21, test_22, test_22a, test_23, test_24, test_25, test_26, test_27, test_28\n");
+	printf ("**                  test_12a, test_12b, test_12c, test_12d, test_12e, test_13, test_13a, test_13b, test_14, test_15, test_15a, test_16, test_16a, test_17, test_18,\n");
+	printf ("**                  test_19, test_20, test_21, test_22, test_22a, test_22b, test_23, test_24, test_25, test_26, test_27, test_28, test_29\n");
 	printf ("** Report bugs to:\n**\n");
 	printf ("**     <vortex@lists.aspl.es> Vortex/Turbulence Mailing list\n**\n");
 
@@ -7465,6 +8296,24 @@ int main (int argc, char ** argv)
 	CHECK_TEST("test_09c")
 	run_test (test_09c, "Test 09-c: profile path serverName enforcement on channel start");
 
+	CHECK_TEST("test_09d")
+	run_test (test_09d, "Test 09-d: arena allocation and accounting");
+
+	CHECK_TEST("test_09e")
+	run_test (test_09e, "Test 09-e: metrics registry and text exposition");
+
+	CHECK_TEST("test_09f")
+	run_test (test_09f, "Test 09-f: connection lifecycle trace carried on conn_status");
+
+	CHECK_TEST("test_09g")
+	run_test (test_09g, "Test 09-g: slot indexed and per thread context data");
+
+	CHECK_TEST("test_09h")
+	run_test (test_09h, "Test 09-h: token bucket bandwidth shaping");
+
+	CHECK_TEST("test_09i")
+	run_test (test_09i, "Test 09-i: shaped connection delayed and resumed");
+
 	CHECK_TEST("test_signal_mask")
 	run_test (test_signal_mask, "Test 02-s: signal block/unblock honours the signal argument");
 
@@ -7486,6 +8335,9 @@ int main (int argc, char ** argv)
 	CHECK_TEST("test_05_b")
 	run_test (test_05_b, "Test 05-b: mediator snapshot stable under re-entrant subscribe/remove");
 
+	CHECK_TEST("test_05_c")
+	run_test (test_05_c, "Test 05-c: mediator plug references (push/call without lookups)");
+
 	CHECK_TEST("test_05a")
 	run_test (test_05_a, "Test 05-a: Check system user/group id resolving..");
 	
@@ -7592,6 +8444,9 @@ int main (int argc, char ** argv)
 	CHECK_TEST("test_16")
 	run_test (test_16, "Test 16: Connections that were working, must not be available at childs..");
 
+	CHECK_TEST("test_16a")
+	run_test (test_16a, "Test 16-a: reused child retired after max-connections-served..");
+
 	CHECK_TEST("test_17")
 	run_test (test_17, "Test 17: many connections at the same time for a profile path with separate=yes and reuse=yes");
 
@@ -7613,12 +8468,18 @@ int main (int argc, char ** argv)
 	CHECK_TEST("test_22a")
 	run_test (test_22_a, "Test 22-a: check TLS module (no child).."); 
 
+	CHECK_TEST("test_22b")
+	run_test (test_22_b, "Test 22-b: check TLS module certificate-select serverName matching.."); 
+
 	CHECK_TEST("test_23")
 	run_test (test_23, "Test 23: check TLS module on child process without serverName.."); 
 
 	CHECK_TEST("test_24")
 	run_test (test_24, "Test 24: try to trick TLS profile.."); 
 
+	CHECK_TEST("test_29")
+	run_test (test_29, "Test 29: check max-frame-size and max-message-size profile limits.."); 
+
 #if defined(ENABLE_WEBSOCKET_SUPPORT)
 	CHECK_TEST("test_25")
 	run_test (test_25, "Test 25: test connecting BEEP over secure websocket (1602) ..");   
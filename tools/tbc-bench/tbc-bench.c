@@ -0,0 +1,626 @@
+/*  Turbulence BEEP application server
+ *  Copyright (C) 2025 Advanced Software Production Line, S.L.
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; version 2.1 of the
+ *  License.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this program; if not, write to the Free
+ *  Software Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307 USA
+ *  
+ *  You may find a copy of the license under this software is released
+ *  at COPYING file. This is LGPL software: you are welcome to develop
+ *  proprietary applications using this library without any royalty or
+ *  fee but returning back any change, improvement or addition in the
+ *  form of source code, project image, documentation patches, etc.
+ *
+ *  For commercial support on build BEEP enabled solutions, supporting
+ *  turbulence based solutions, etc, contact us:
+ *          
+ *      Postal address:
+ *         Advanced Software Production Line, S.L.
+ *         C/ Antonio Suarez Nº10, Edificio Alius A, Despacho 102
+ *         Alcala de Henares, 28802 (MADRID)
+ *         Spain
+ *
+ *      Email address:
+ *         info@aspl.es - http://www.aspl.es/turbulence
+ */
+
+/* include axl support */
+#include <axl.h>
+
+/* include exarg support */
+#include <exarg.h>
+
+/* include turbulence */
+#include <turbulence.h>
+
+/* include sasl and tls support */
+#include <vortex_sasl.h>
+#include <vortex_tls.h>
+
+#define HELP_HEADER "tbc-bench: a BEEP load generator to benchmark turbulence\n\
+Copyright (C) 2025 Advanced Software Production Line, S.L.\n\n"
+
+#define POST_HEADER "\n\
+Connects to a running turbulence and reports throughput and latency\n\
+percentiles (microseconds) as a JSON document. Profile path scenarios\n\
+(separate or not, proxy on parent or socket passing) are defined by the\n\
+server configuration: use --server-name to select the profile path.\n\n"
+
+/** 
+ * @brief Echo profile provided by mod-test, used by default.
+ */
+#define TBC_BENCH_ECHO_URI "http://turbulence.ws/profiles/echo"
+
+/** 
+ * @brief Operations measured.
+ */
+typedef enum {
+	TBC_BENCH_CONNECT = 0,
+	TBC_BENCH_TLS     = 1,
+	TBC_BENCH_SASL    = 2,
+	TBC_BENCH_CHANNEL = 3,
+	TBC_BENCH_MESSAGE = 4,
+	TBC_BENCH_OPS     = 5
+} TbcBenchOp;
+
+/** 
+ * @brief Latency samples (microseconds) collected for an operation.
+ */
+typedef struct _TbcBenchSamples {
+	const char  * name;
+	VortexMutex   mutex;
+	long        * items;
+	int           count;
+	int           size;
+} TbcBenchSamples;
+
+/** 
+ * @brief Default turbulence and vortex context.
+ */
+TurbulenceCtx    * ctx;
+VortexCtx        * vortex_ctx;
+
+/* scenario configuration */
+const char       * host          = "localhost";
+const char       * port          = "602";
+const char       * server_name   = NULL;
+const char       * profile       = TBC_BENCH_ECHO_URI;
+const char       * scenario      = "default";
+int                connections   = 100;
+int                concurrency   = 1;
+int                conn_rate     = 0;
+int                channels      = 1;
+int                messages      = 10;
+int                message_size  = 64;
+int                message_rate  = 0;
+axl_bool           enable_tls    = axl_false;
+axl_bool           enable_sasl   = axl_false;
+
+/* run state */
+VortexMutex        bench_mutex;
+int                next_conn     = 0;
+long               bench_start   = 0;
+int                conn_ok       = 0;
+int                conn_failed   = 0;
+int                msg_ok        = 0;
+int                msg_failed    = 0;
+double             bytes_echoed  = 0;
+char             * payload       = NULL;
+TbcBenchSamples    samples[TBC_BENCH_OPS];
+
+/** 
+ * @internal Records the time elapsed since start for the provided
+ * operation.
+ */
+void tbc_bench_sample (TbcBenchOp op, long start)
+{
+	TbcBenchSamples * s     = &samples[op];
+	long              value = turbulence_trace_now () - start;
+	long            * items;
+
+	vortex_mutex_lock (&s->mutex);
+	if (s->count == s->size) {
+		items = axl_realloc (s->items, sizeof (long) * (s->size + 4096));
+		if (items == NULL) {
+			/* drop sample */
+			vortex_mutex_unlock (&s->mutex);
+			return;
+		} /* end if */
+		s->items  = items;
+		s->size  += 4096;
+	} /* end if */
+	s->items[s->count] = value;
+	s->count++;
+	vortex_mutex_unlock (&s->mutex);
+	return;
+}
+
+/** 
+ * @internal Updates the provided run counter.
+ */
+void tbc_bench_count (int * counter, int bytes)
+{
+	vortex_mutex_lock (&bench_mutex);
+	(*counter)++;
+	bytes_echoed += bytes;
+	vortex_mutex_unlock (&bench_mutex);
+	return;
+}
+
+/** 
+ * @internal Blocks the caller until the provided stamp (see
+ * turbulence_trace_now) is reached.
+ */
+void tbc_bench_wait_until (long stamp)
+{
+	long now = turbulence_trace_now ();
+	if (stamp > now)
+		turbulence_sleep (ctx, stamp - now);
+	return;
+}
+
+/** 
+ * @internal Runs the scenario over a single connection: connect,
+ * optional TLS and SASL, and then channels requested exchanging
+ * messages with the echo profile.
+ */
+axl_bool tbc_bench_run_connection (void)
+{
+	VortexConnection * conn;
+	VortexChannel    * channel;
+	VortexAsyncQueue * queue;
+	VortexFrame      * frame;
+	VortexStatus       status;
+	char             * status_message = NULL;
+	long               start;
+	long               next_msg;
+	int                iterator;
+	int                count;
+	axl_bool           result = axl_true;
+
+	/* connect (includes greetings exchange) */
+	start = turbulence_trace_now ();
+	if (server_name)
+		conn = vortex_connection_new_full (vortex_ctx, host, port,
+						   CONN_OPTS (VORTEX_SERVERNAME_FEATURE, server_name, VORTEX_OPTS_END),
+						   NULL, NULL);
+	else
+		conn = vortex_connection_new (vortex_ctx, host, port, NULL, NULL);
+	if (! vortex_connection_is_ok (conn, axl_false)) {
+		error ("connection to %s:%s failed: %s", host, port, vortex_connection_get_message (conn));
+		vortex_connection_close (conn);
+		return axl_false;
+	} /* end if */
+	tbc_bench_sample (TBC_BENCH_CONNECT, start);
+
+	/* TLS */
+	if (enable_tls) {
+		start = turbulence_trace_now ();
+		conn  = vortex_tls_start_negotiation_sync (conn, server_name, &status, &status_message);
+		if (status != VortexOk) {
+			error ("TLS negotiation failed: %s", status_message);
+			vortex_connection_close (conn);
+			return axl_false;
+		} /* end if */
+		tbc_bench_sample (TBC_BENCH_TLS, start);
+	} /* end if */
+
+	/* SASL */
+	if (enable_sasl) {
+		vortex_sasl_set_propertie (conn, VORTEX_SASL_AUTH_ID, exarg_get_string ("sasl-user"), NULL);
+		vortex_sasl_set_propertie (conn, VORTEX_SASL_PASSWORD, exarg_get_string ("sasl-password"), NULL);
+		start = turbulence_trace_now ();
+		vortex_sasl_start_auth_sync (conn, VORTEX_SASL_PLAIN, &status, &status_message);
+		if (status != VortexOk) {
+			error ("SASL authentication failed: %s", status_message);
+			vortex_connection_close (conn);
+			return axl_false;
+		} /* end if */
+		tbc_bench_sample (TBC_BENCH_SASL, start);
+	} /* end if */
+
+	/* channels and messages */
+	queue = vortex_async_queue_new ();
+	for (iterator = 0; iterator < channels && result; iterator++) {
+		start   = turbulence_trace_now ();
+		channel = vortex_channel_new (conn, 0, profile,
+					      /* no close handler */
+					      NULL, NULL,
+					      /* replies are queued */
+					      vortex_channel_queue_reply, queue,
+					      NULL, NULL);
+		if (channel == NULL) {
+			error ("failed to create channel running %s", profile);
+			result = axl_false;
+			break;
+		} /* end if */
+		tbc_bench_sample (TBC_BENCH_CHANNEL, start);
+
+		next_msg = turbulence_trace_now ();
+		for (count = 0; count < messages; count++) {
+			/* pace messages if requested */
+			if (message_rate > 0) {
+				tbc_bench_wait_until (next_msg);
+				next_msg += 1000000 / message_rate;
+			} /* end if */
+
+			start = turbulence_trace_now ();
+			if (! vortex_channel_send_msg (channel, payload, message_size, NULL)) {
+				tbc_bench_count (&msg_failed, 0);
+				result = axl_false;
+				break;
+			} /* end if */
+			frame = vortex_channel_get_reply (channel, queue);
+			if (frame == NULL || vortex_frame_get_type (frame) != VORTEX_FRAME_TYPE_RPY) {
+				tbc_bench_count (&msg_failed, 0);
+				if (frame)
+					vortex_frame_unref (frame);
+				result = axl_false;
+				break;
+			} /* end if */
+			tbc_bench_sample (TBC_BENCH_MESSAGE, start);
+			tbc_bench_count (&msg_ok, vortex_frame_get_payload_size (frame));
+			vortex_frame_unref (frame);
+		} /* end for */
+	} /* end for */
+
+	/* close connection (and channels) */
+	vortex_connection_close (conn);
+	vortex_async_queue_unref (queue);
+
+	return result;
+}
+
+/** 
+ * @internal Worker thread: takes connections to run until the number
+ * of connections requested is reached.
+ */
+axlPointer tbc_bench_worker (axlPointer data)
+{
+	int index;
+
+	while (axl_true) {
+		/* next connection */
+		vortex_mutex_lock (&bench_mutex);
+		index = next_conn;
+		next_conn++;
+		vortex_mutex_unlock (&bench_mutex);
+		if (index >= connections)
+			break;
+
+		/* pace connections if requested */
+		if (conn_rate > 0)
+			tbc_bench_wait_until (bench_start + (long) ((double) index * 1000000 / conn_rate));
+
+		if (tbc_bench_run_connection ())
+			tbc_bench_count (&conn_ok, 0);
+		else
+			tbc_bench_count (&conn_failed, 0);
+	} /* end while */
+
+	return NULL;
+}
+
+int tbc_bench_compare (const void * a, const void * b)
+{
+	long la = *((const long *) a);
+	long lb = *((const long *) b);
+
+	return (la > lb) - (la < lb);
+}
+
+/** 
+ * @internal Returns the provided percentile (in per mille units,
+ * nearest rank) from sorted samples.
+ */
+long tbc_bench_percentile (TbcBenchSamples * s, int per_mille)
+{
+	int index;
+
+	if (s->count == 0)
+		return 0;
+	index = (int) (((double) per_mille * s->count + 999) / 1000) - 1;
+	if (index < 0)
+		index = 0;
+	if (index >= s->count)
+		index = s->count - 1;
+	return s->items[index];
+}
+
+/** 
+ * @internal Writes the provided string as a JSON value.
+ */
+void tbc_bench_report_string (FILE * out, const char * value)
+{
+	if (value == NULL) {
+		fprintf (out, "null");
+		return;
+	} /* end if */
+
+	fputc ('"', out);
+	while (*value) {
+		if (*value == '"' || *value == '\\')
+			fputc ('\\', out);
+		if ((unsigned char) (*value) >= 0x20)
+			fputc (*value, out);
+		value++;
+	} /* end while */
+	fputc ('"', out);
+	return;
+}
+
+void tbc_bench_report_op (FILE * out, TbcBenchSamples * s, axl_bool last)
+{
+	double total = 0;
+	int    iterator;
+
+	qsort (s->items, s->count, sizeof (long), tbc_bench_compare);
+	for (iterator = 0; iterator < s->count; iterator++)
+		total += s->items[iterator];
+
+	fprintf (out, "    \"%s\": {\"count\": %d, \"min\": %ld, \"mean\": %.1f, \"p50\": %ld, \"p90\": %ld, \"p99\": %ld, \"p999\": %ld, \"max\": %ld}%s\n",
+		 s->name, s->count, 
+		 s->count ? s->items[0] : 0, 
+		 s->count ? total / s->count : 0.0,
+		 tbc_bench_percentile (s, 500), tbc_bench_percentile (s, 900),
+		 tbc_bench_percentile (s, 990), tbc_bench_percentile (s, 999),
+		 s->count ? s->items[s->count - 1] : 0,
+		 last ? "" : ",");
+	return;
+}
+
+/** 
+ * @internal Writes the JSON report. Keys are stable so reports from
+ * different runs can be compared.
+ */
+void tbc_bench_report (FILE * out, long elapsed)
+{
+	double seconds = elapsed > 0 ? (double) elapsed / 1000000 : 1;
+	int    iterator;
+
+	fprintf (out, "{\n  \"tool\": \"tbc-bench\",\n  \"version\": \"%s\",\n  \"scenario\": ", VERSION);
+	tbc_bench_report_string (out, scenario);
+	fprintf (out, ",\n  \"config\": {\n    \"host\": ");
+	tbc_bench_report_string (out, host);
+	fprintf (out, ",\n    \"port\": ");
+	tbc_bench_report_string (out, port);
+	fprintf (out, ",\n    \"server_name\": ");
+	tbc_bench_report_string (out, server_name);
+	fprintf (out, ",\n    \"profile\": ");
+	tbc_bench_report_string (out, profile);
+	fprintf (out, ",\n    \"connections\": %d,\n    \"concurrency\": %d,\n    \"conn_rate\": %d,\n"
+		 "    \"channels\": %d,\n    \"messages\": %d,\n    \"message_size\": %d,\n    \"message_rate\": %d,\n"
+		 "    \"tls\": %s,\n    \"sasl\": %s\n  },\n",
+		 connections, concurrency, conn_rate, channels, messages, message_size, message_rate,
+		 enable_tls ? "true" : "false", enable_sasl ? "true" : "false");
+	fprintf (out, "  \"elapsed_us\": %ld,\n", elapsed);
+	fprintf (out, "  \"connections\": {\"ok\": %d, \"failed\": %d},\n", conn_ok, conn_failed);
+	fprintf (out, "  \"messages\": {\"ok\": %d, \"failed\": %d},\n", msg_ok, msg_failed);
+	fprintf (out, "  \"throughput\": {\"connections_per_sec\": %.2f, \"messages_per_sec\": %.2f, \"bytes_per_sec\": %.2f},\n",
+		 conn_ok / seconds, msg_ok / seconds, bytes_echoed / seconds);
+	fprintf (out, "  \"latency_us\": {\n");
+	for (iterator = 0; iterator < TBC_BENCH_OPS; iterator++)
+		tbc_bench_report_op (out, &samples[iterator], iterator == TBC_BENCH_OPS - 1);
+	fprintf (out, "  }\n}\n");
+	return;
+}
+
+/** 
+ * @internal Reads scenario configuration from command line.
+ */
+axl_bool tbc_bench_configure (void)
+{
+	if (exarg_is_defined ("host"))
+		host = exarg_get_string ("host");
+	if (exarg_is_defined ("port"))
+		port = exarg_get_string ("port");
+	if (exarg_is_defined ("server-name"))
+		server_name = exarg_get_string ("server-name");
+	if (exarg_is_defined ("profile"))
+		profile = exarg_get_string ("profile");
+	if (exarg_is_defined ("scenario"))
+		scenario = exarg_get_string ("scenario");
+	if (exarg_is_defined ("connections"))
+		connections = exarg_get_int ("connections");
+	if (exarg_is_defined ("concurrency"))
+		concurrency = exarg_get_int ("concurrency");
+	if (exarg_is_defined ("conn-rate"))
+		conn_rate = exarg_get_int ("conn-rate");
+	if (exarg_is_defined ("channels"))
+		channels = exarg_get_int ("channels");
+	if (exarg_is_defined ("messages"))
+		messages = exarg_get_int ("messages");
+	if (exarg_is_defined ("message-size"))
+		message_size = exarg_get_int ("message-size");
+	if (exarg_is_defined ("message-rate"))
+		message_rate = exarg_get_int ("message-rate");
+	enable_tls  = exarg_is_defined ("tls");
+	enable_sasl = exarg_is_defined ("sasl-user");
+
+	if (connections < 1 || concurrency < 1 || channels < 0 || messages < 0 || 
+	    message_size < 1 || conn_rate < 0 || message_rate < 0) {
+		error ("invalid scenario: connections, concurrency and message-size must be > 0 and the rest >= 0");
+		return axl_false;
+	} /* end if */
+	if (enable_sasl && ! exarg_is_defined ("sasl-password")) {
+		error ("--sasl-user requires --sasl-password");
+		return axl_false;
+	} /* end if */
+	if (enable_tls && ! vortex_tls_init (vortex_ctx)) {
+		error ("failed to initialize TLS support");
+		return axl_false;
+	} /* end if */
+	if (enable_sasl && ! vortex_sasl_init (vortex_ctx)) {
+		error ("failed to initialize SASL support");
+		return axl_false;
+	} /* end if */
+
+	return axl_true;
+}
+
+int main (int argc, char ** argv)
+{
+	VortexThread * workers;
+	FILE         * out = stdout;
+	long           elapsed;
+	int            iterator;
+	int            result;
+
+	/* install headers for help */
+	exarg_add_usage_header  (HELP_HEADER);
+	exarg_add_help_header   (HELP_HEADER);
+	exarg_post_help_header  (POST_HEADER);
+	exarg_post_usage_header (POST_HEADER);
+
+	/* install exarg options */
+	exarg_install_arg ("version", "v", EXARG_NONE,
+			   "Provides tool version");
+	exarg_install_arg ("host", "h", EXARG_STRING, 
+			   "Turbulence host location (default localhost)");
+	exarg_install_arg ("port", "p", EXARG_STRING, 
+			   "Turbulence port location (default 602)");
+	exarg_install_arg ("server-name", "n", EXARG_STRING, 
+			   "serverName requested on each connection (selects the profile path to benchmark)");
+	exarg_install_arg ("profile", NULL, EXARG_STRING, 
+			   "Profile used to open channels, it must reply each message (default: " TBC_BENCH_ECHO_URI ", provided by mod-test)");
+	exarg_install_arg ("scenario", NULL, EXARG_STRING, 
+			   "Label reported for this run (default: default)");
+	exarg_install_arg ("connections", "c", EXARG_INT, 
+			   "Total connections to create (default 100)");
+	exarg_install_arg ("concurrency", "j", EXARG_INT, 
+			   "Connections running at the same time (default 1)");
+	exarg_install_arg ("conn-rate", "r", EXARG_INT, 
+			   "Connections started per second, 0 for as fast as possible (default 0)");
+	exarg_install_arg ("channels", NULL, EXARG_INT, 
+			   "Channels opened on each connection (default 1)");
+	exarg_install_arg ("messages", "m", EXARG_INT, 
+			   "Messages exchanged on each channel (default 10)");
+	exarg_install_arg ("message-size", "s", EXARG_INT, 
+			   "Message size in bytes (default 64)");
+	exarg_install_arg ("message-rate", NULL, EXARG_INT, 
+			   "Messages sent per second on each channel, 0 for as fast as possible (default 0)");
+	exarg_install_arg ("tls", "t", EXARG_NONE, 
+			   "Negotiate TLS on each connection");
+	exarg_install_arg ("sasl-user", "u", EXARG_STRING, 
+			   "Do a SASL PLAIN login on each connection with the provided user");
+	exarg_install_arg ("sasl-password", NULL, EXARG_STRING, 
+			   "Password used with --sasl-user");
+	exarg_install_arg ("output", "o", EXARG_STRING, 
+			   "Write the report into the provided file (default stdout)");
+	exarg_install_arg ("debug", "d", EXARG_NONE,
+			   "Allows to configure to enable log");
+	exarg_install_arg ("debug2", NULL, EXARG_NONE,
+			   "Allows to configure to enable second level log");
+	exarg_install_arg ("color-debug", NULL, EXARG_NONE,
+			   "Allows to configure color debug");
+
+	/* call to parse arguments */
+	exarg_parse (argc, argv);
+
+	/* init turbulence context */
+	ctx        = turbulence_ctx_new ();
+	vortex_ctx = vortex_ctx_new ();
+
+	/* init vortex */
+	if (! vortex_init_ctx (vortex_ctx))  {
+		error ("Unable to initialize vortex context.."); 
+		return -1;
+	}
+	
+	/* bind vortex ctx */
+	turbulence_ctx_set_vortex_ctx (ctx, vortex_ctx);
+
+	/* configure context debug according to values received */
+	turbulence_log_enable  (ctx, exarg_is_defined ("debug"));
+	turbulence_log2_enable (ctx, exarg_is_defined ("debug2"));
+
+	/* check console color debug */
+	turbulence_color_log_enable (ctx, exarg_is_defined ("color-debug"));
+
+	/* check version argument */
+	if (exarg_is_defined ("version")) {
+		printf ("%s version: %s\n", argv[0], VERSION);
+		result = 0;
+		goto finish;
+	} /* end if */
+
+	/* get scenario */
+	if (! tbc_bench_configure ()) {
+		result = -1;
+		goto finish;
+	} /* end if */
+
+	/* prepare output */
+	if (exarg_is_defined ("output")) {
+		out = fopen (exarg_get_string ("output"), "w");
+		if (out == NULL) {
+			error ("unable to open %s to write the report", exarg_get_string ("output"));
+			result = -1;
+			goto finish;
+		} /* end if */
+	} /* end if */
+
+	/* prepare payload and samples */
+	payload = axl_new (char, message_size);
+	memset (payload, 'x', message_size);
+	samples[TBC_BENCH_CONNECT].name = "connect";
+	samples[TBC_BENCH_TLS].name     = "tls";
+	samples[TBC_BENCH_SASL].name    = "sasl";
+	samples[TBC_BENCH_CHANNEL].name = "channel";
+	samples[TBC_BENCH_MESSAGE].name = "message";
+	for (iterator = 0; iterator < TBC_BENCH_OPS; iterator++)
+		vortex_mutex_create (&samples[iterator].mutex);
+	vortex_mutex_create (&bench_mutex);
+
+	/* run workers */
+	workers     = axl_new (VortexThread, concurrency);
+	bench_start = turbulence_trace_now ();
+	for (iterator = 0; iterator < concurrency; iterator++) {
+		if (! vortex_thread_create (&workers[iterator], tbc_bench_worker, NULL, VORTEX_THREAD_CONF_END)) {
+			error ("unable to create worker thread %d, running with %d workers", iterator, iterator);
+			break;
+		} /* end if */
+	} /* end for */
+	concurrency = iterator;
+	for (iterator = 0; iterator < concurrency; iterator++)
+		vortex_thread_destroy (&workers[iterator], axl_false);
+	elapsed = turbulence_trace_now () - bench_start;
+
+	/* report */
+	tbc_bench_report (out, elapsed);
+	if (out != stdout)
+		fclose (out);
+	result = (conn_failed == 0 && msg_failed == 0 && concurrency > 0) ? 0 : 1;
+
+	/* release */
+	axl_free (workers);
+	axl_free (payload);
+	for (iterator = 0; iterator < TBC_BENCH_OPS; iterator++) {
+		axl_free (samples[iterator].items);
+		vortex_mutex_destroy (&samples[iterator].mutex);
+	} /* end for */
+	vortex_mutex_destroy (&bench_mutex);
+
+ finish:
+	/* free context */
+	turbulence_ctx_free (ctx);
+
+	/* finish vortex */
+	vortex_exit_ctx (vortex_ctx, axl_true);
+
+	/* finish exarg */
+	exarg_end ();
+
+	return result;
+}
@@ -513,43 +513,18 @@ void tbc_ctl_update_commands_available (void)
 	return;
 }
 
-void tbc_ctl_print_content_received_table (axlDoc * doc)
+/** 
+ * @internal Updates column lengths with content found on the rows of
+ * the provided table.
+ */
+void tbc_ctl_table_update_lengths (axlDoc * doc, int * col_lengths)
 {
 	axlNode    * node;
 	axlNode    * node2;
-	int          num_columns = 0;
 	int          size;
-	int          length;
-	int          col_lengths[20];
 	int          iterator;
 	char       * content;
 
-	/* print title */
-	node = axl_doc_get (doc, "/table/title");
-	if (node) 
-		printf (">>> %s <<<\n", axl_node_get_content (node, &size));
-
-	/* get initial column header sizes */
-	node     = axl_doc_get (doc, "/table/column-description/column");
-	iterator = 0;
-	while (node) {
-		/* get initial column length */
-		col_lengths[iterator] = strlen (ATTR_VALUE (node, "name"));
-
-		/* get next column */
-		node = axl_node_get_next_called (node, "column");
-
-		/* increase number of columns found */
-		num_columns++;
-
-		/* next iterator */
-		iterator++;
-
-	} /* end while */
-
-	if (num_columns > 0)
-		printf ("\n");
-
 	/* now ensure we have maximum lengths */
 	node = axl_doc_get (doc, "/table/content/row");
 	while (node) {
@@ -578,6 +553,22 @@ void tbc_ctl_print_content_received_table (axlDoc * doc)
 		node = axl_node_get_next_called (node, "row");
 	} /* end if */
 
+	return;
+}
+
+/** 
+ * @internal Prints column headers and separators of the provided
+ * table.
+ */
+void tbc_ctl_table_print_header (axlDoc * doc, int num_columns, int * col_lengths)
+{
+	axlNode    * node;
+	int          length;
+	int          iterator;
+
+	if (num_columns > 0)
+		printf ("\n");
+
 	/* now print column headers */
 	node     = axl_doc_get (doc, "/table/column-description/column");
 	iterator = 0;
@@ -624,6 +615,19 @@ void tbc_ctl_print_content_received_table (axlDoc * doc)
 	if (num_columns > 0)
 		printf ("\n");
 
+	return;
+}
+
+/** 
+ * @internal Prints rows of the provided table.
+ */
+void tbc_ctl_table_print_rows (axlDoc * doc, int * col_lengths)
+{
+	axlNode    * node;
+	axlNode    * node2;
+	int          size;
+	int          iterator;
+
 	/* now print the content */
 	node = axl_doc_get (doc, "/table/content/row");
 	while (node) {
@@ -657,6 +661,101 @@ void tbc_ctl_print_content_received_table (axlDoc * doc)
 	return;
 }
 
+/** 
+ * @internal Gets the number of columns and initial column lengths
+ * (column names) from the provided table, printing its title.
+ */
+int tbc_ctl_table_prepare (axlDoc * doc, int * col_lengths)
+{
+	axlNode    * node;
+	int          num_columns = 0;
+	int          size;
+
+	/* print title */
+	node = axl_doc_get (doc, "/table/title");
+	if (node) 
+		printf (">>> %s <<<\n", axl_node_get_content (node, &size));
+
+	/* get initial column header sizes */
+	node     = axl_doc_get (doc, "/table/column-description/column");
+	while (node && num_columns < 20) {
+		/* get initial column length */
+		col_lengths[num_columns] = strlen (ATTR_VALUE (node, "name"));
+
+		/* get next column */
+		node = axl_node_get_next_called (node, "column");
+
+		/* increase number of columns found */
+		num_columns++;
+	} /* end while */
+
+	return num_columns;
+}
+
+void tbc_ctl_print_content_received_table (axlDoc * doc)
+{
+	int          num_columns;
+	int          col_lengths[20];
+
+	/* print title and get initial column lengths */
+	num_columns = tbc_ctl_table_prepare (doc, col_lengths);
+
+	/* now ensure we have maximum lengths */
+	tbc_ctl_table_update_lengths (doc, col_lengths);
+
+	/* now print column headers and content */
+	tbc_ctl_table_print_header (doc, num_columns, col_lengths);
+	tbc_ctl_table_print_rows (doc, col_lengths);
+
+	return;
+}
+
+/** 
+ * @internal State used to print a table received as a series of ANS
+ * frames (streamed listings).
+ */
+typedef struct _TbcCtlStreamTable {
+	axlDoc   * header;
+	int        num_columns;
+	int        col_lengths[20];
+	axl_bool   header_printed;
+} TbcCtlStreamTable;
+
+/** 
+ * @internal Prints a part of a streamed table as soon as it is
+ * received. The first part holds title and column description, next
+ * ones hold rows and, optionally, the cursor to get the next page.
+ * Column widths are computed from rows received so far.
+ */
+void tbc_ctl_print_stream_chunk (TbcCtlStreamTable * table, axlDoc * doc)
+{
+	axlNode * node;
+
+	/* header received */
+	if (table->header == NULL && axl_doc_get (doc, "/table/column-description")) {
+		table->header      = axl_doc_copy (doc);
+		table->num_columns = tbc_ctl_table_prepare (doc, table->col_lengths);
+	} /* end if */
+
+	/* rows received */
+	if (axl_doc_get (doc, "/table/content/row")) {
+		tbc_ctl_table_update_lengths (doc, table->col_lengths);
+		if (! table->header_printed && table->header) {
+			tbc_ctl_table_print_header (table->header, table->num_columns, table->col_lengths);
+			table->header_printed = axl_true;
+		} /* end if */
+		tbc_ctl_table_print_rows (doc, table->col_lengths);
+		fflush (stdout);
+	} /* end if */
+
+	/* cursor received */
+	node = axl_doc_get (doc, "/table/cursor");
+	if (node)
+		printf ("\n-- more results available, repeat the command adding: from=%s\n", ATTR_VALUE (node, "next"));
+
+	return;
+}
+
 void tbc_ctl_print_content_received (axlDoc * doc)
 {
 	axlNode * node = axl_doc_get_root (doc);
@@ -671,11 +770,11 @@ void tbc_ctl_print_content_received (axlDoc * doc)
 
 void tbc_ctl_command_send (const char * command)
 {
-	VortexChannel * channel;
-	WaitReplyData * wait_reply;
-	int             msg_no;
-	VortexFrame   * frame;
-	axlDoc        * doc;
+	VortexChannel     * channel;
+	VortexAsyncQueue  * queue;
+	VortexFrame       * frame;
+	axlDoc            * doc;
+	TbcCtlStreamTable   table;
 
 	if (command == NULL || strlen (command) == 0)
 		return;
@@ -689,32 +788,72 @@ void tbc_ctl_command_send (const char * command)
 		return;
 	} /* end if */
 
-	/* create wait reply to handle this particular reply out of
-	   the usual context */
-	wait_reply = vortex_channel_create_wait_reply ();
+	/* queue replies received: some commands reply with a series of
+	   ANS frames that are printed as they are received */
+	queue = vortex_async_queue_new ();
+	vortex_channel_set_received_handler (channel, vortex_channel_queue_reply, queue);
+	memset (&table, 0, sizeof (TbcCtlStreamTable));
 
 	/* send command */
-	if (! vortex_channel_send_msg_and_waitv (channel, &msg_no, wait_reply, "<request operation='%s' />", command)) {
+	if (! vortex_channel_send_msgv (channel, NULL, "<request operation='%s' />", command)) {
 		error ("Unable to send commands available request..");
-		return;
+		goto finish;
 	}
 
-	/* wait for reply */
-	frame = vortex_channel_wait_reply (channel, msg_no, wait_reply);
+	while (axl_true) {
+		/* wait for reply */
+		frame = vortex_channel_get_reply (channel, queue);
+		if (frame == NULL) {
+			error ("No reply received for command %s..", command);
+			break;
+		} /* end if */
 
-	if (debug_was_enabled)  
-		printf ("DEBUG: content received: %s\n", frame ? (char *) vortex_frame_get_payload (frame) : "null frame received");
+		if (debug_was_enabled)  
+			printf ("DEBUG: content received: %s\n", (char *) vortex_frame_get_payload (frame));
+
+		/* last frame of a series of ANS */
+		if (vortex_frame_get_type (frame) == VORTEX_FRAME_TYPE_NUL) {
+			/* print header if no row was received */
+			if (table.header && ! table.header_printed) 
+				tbc_ctl_table_print_header (table.header, table.num_columns, table.col_lengths);
+			vortex_frame_unref (frame);
+			break;
+		} /* end if */
 	
-	/* parse content received and check errors */
-	doc = tbc_ctl_parse_content_and_check_errors (frame);
-	if (doc == NULL) 
-		return;
+		/* parse content received and check errors */
+		doc = tbc_ctl_parse_content_and_check_errors (frame);
+		if (doc == NULL) {
+			/* keep on reading until NUL is received */
+			if (vortex_frame_get_type (frame) == VORTEX_FRAME_TYPE_ANS) {
+				vortex_frame_unref (frame);
+				continue;
+			} /* end if */
+			vortex_frame_unref (frame);
+			break;
+		} /* end if */
 
-	/* content received */
-	tbc_ctl_print_content_received (doc);
+		if (vortex_frame_get_type (frame) == VORTEX_FRAME_TYPE_ANS) {
+			/* partial content received */
+			tbc_ctl_print_stream_chunk (&table, doc);
+			axl_doc_free (doc);
+			vortex_frame_unref (frame);
+			continue;
+		} /* end if */
 
-	/* free document received */
-	axl_doc_free (doc);
+		/* content received */
+		tbc_ctl_print_content_received (doc);
+
+		/* free document received */
+		axl_doc_free (doc);
+		vortex_frame_unref (frame);
+		break;
+	} /* end while */
+
+ finish:
+	/* restore default frame received handler */
+	vortex_channel_set_received_handler (channel, tbc_ctl_frame_received, NULL);
+	vortex_async_queue_unref (queue);
+	axl_doc_free (table.header);
 
 	return;
 }